@@ -7,16 +7,14 @@
 #include <string>
 //#include "Decoder.h"
 #include <assert.h>
-//#include "VideoScaler.h"
+#include "inc/ImageScaler.h"
 
 using namespace SOA::Mirror::Render;
 using namespace zRender;
 
 BigScreenBackground::BigScreenBackground( const char* imageFileName, int bigscreenWidth, int bigscreenHeight, 
 										  const Size& cellRsolution, zRender::PIXFormat pixfomat )
-										  : m_decodedData(NULL)
-										  , m_decodedDataLen(0)
-										  , m_bigScreenWidth(bigscreenWidth)
+										  : m_bigScreenWidth(bigscreenWidth)
 										  , m_bigScreenHeight(bigscreenHeight)
 										  , m_imageWidth(0)
 										  , m_imageHeight(0)
@@ -44,14 +42,10 @@ void BigScreenBackground::allocBackgroundContentForBigscreenCell()
 
 void SOA::Mirror::Render::BigScreenBackground::freeBackgroundContent()
 {
-	if(m_decodedData!=NULL)
-	{
-		delete[] m_decodedData;
-		m_decodedData = NULL;
-		m_decodedDataLen = 0;
-	}
+	m_decodedFrame.reset();
 	for(int i=0; i<m_regions.size(); i++)
 	{
+		m_regions[i].frame.reset();
 		IDisplayContentProvider* dcp = m_regions[i].m_dcproviders;
 		if(dcp)
 		{
@@ -76,6 +70,11 @@ const byte* BigScreenBackground::getDataOfBigscreenCell( int XOfBigScreen, int Y
 	int index = YOfBigScreen * m_bigScreenWidth + XOfBigScreen;
 	if(m_regions.size()<(index+1))
 		return NULL;
+	if(m_regions[index].frame.valid())
+	{
+		bufLen = m_regions[index].frame.size();
+		return m_regions[index].frame.data();
+	}
 	bufLen = m_regions[index].dataLength;
 	return m_regions[index].pData;
 }
@@ -165,19 +164,17 @@ void BigScreenBackground::decodeBackgroundImageFile( const char* imageFileName,
 		return;
 	}
 
-	m_decodedData = new byte[datalength];
-	m_decodedDataLen = datalength;
-	assert(m_decodedData);
-
-	if( SOA::Mirror::Decoder::SUCCESS != decoder->getDecodedData(m_decodedData, m_decodedDataLen) )
+	zRender::FrameRef decodedFrame = zRender::FrameRef::allocate(pixfomat, mp.videoParam.width, mp.videoParam.height);
+	int decodedDataLen = decodedFrame.size();
+	if( !decodedFrame.valid()
+		|| SOA::Mirror::Decoder::SUCCESS != decoder->getDecodedData(decodedFrame.mutableData(), decodedDataLen) )
 	{
 		delete decoder;
-		delete[] m_decodedData;
-		m_decodedDataLen = 0;
 		OutputDebugString("BigScreenBackground::decodeBackgroundImageFile failed to get decoded data.\n");
 		return;
 	}
 
+	m_decodedFrame = decodedFrame;
 	m_imageWidth = mp.videoParam.width;
 	m_imageHeight = mp.videoParam.height;
 	delete decoder;
@@ -197,7 +194,8 @@ void BigScreenBackground::initBigScreenCellPaintRegion(const Size& cellRsolution
 
 void BigScreenBackground::scaleTheImageFile( int dstImageWidth, int dstImageHeight )
 {
-	/*
+	if(!m_decodedFrame.valid() || m_imageWidth<=0 || m_imageHeight<=0 || dstImageWidth<=0 || dstImageHeight<=0)
+		return;
 	float rateX = (float)m_imageWidth / dstImageWidth;
 	float rateY = (float)m_imageHeight / dstImageHeight;
 	if(rateX>1 || rateY>1)
@@ -206,28 +204,23 @@ void BigScreenBackground::scaleTheImageFile( int dstImageWidth, int dstImageHeig
 		float rate = rateX>rateY ? rateX : rateY;
 		int scaledImageWidth = m_imageWidth / rate;
 		int scaledImageHeight = m_imageHeight / rate;
-		int disWidth = scaledImageWidth - dstImageWidth;
-		int disHeight = scaledImageHeight - dstImageHeight;
-		int dis = disWidth>disHeight ? disWidth : disHeight;
-		dis = dis<0 ? 0 : dis;
-		SOA::Mirror::Decoder::IVideoScaler* scaler = SOA::Mirror::Decoder::IVideoScaler::createVideoScaler(scaledImageWidth-dis, scaledImageHeight-dis, (SOA::Mirror::PIXFormat)m_pixformat);
-		int scaledImageBufferLen = (scaledImageHeight-dis) * (scaledImageWidth-dis) * SizeOfPixel[m_pixformat];
-		byte* scaledImageBuffer = new byte[scaledImageBufferLen];
-		assert(scaledImageBuffer);
-		SOA::Mirror::Decoder::DecodeResult result = scaler->scale(m_decodedData, m_imageWidth, m_imageHeight, (SOA::Mirror::PIXFormat)m_pixformat, scaledImageBuffer);
-		if(result!=SOA::Mirror::Decoder::SUCCESS)
+		scaledImageWidth = scaledImageWidth<=0 ? 1 : scaledImageWidth;
+		scaledImageHeight = scaledImageHeight<=0 ? 1 : scaledImageHeight;
+		zRender::FrameRef scaledImage = zRender::FrameRef::allocate(m_pixformat, scaledImageWidth, scaledImageHeight);
+		if(!scaledImage.valid())
+			return;
+		//ֻСƽ˲ڴСʱ޻
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo(&sysInfo);
+		int ret = zRender::scaleImage(m_pixformat, m_decodedFrame.data(), m_imageWidth, m_imageHeight,
+									  scaledImage.mutableData(), scaledImageWidth, scaledImageHeight,
+									  zRender::SCALE_FILTER_AREA, (int)sysInfo.dwNumberOfProcessors);
+		if(ret==0)
 		{
-			delete[] scaledImageBuffer;
+			//ѾֵľͼƬɴãֻǲٳ
+			m_decodedFrame = scaledImage;
+			m_imageWidth = scaledImageWidth;
+			m_imageHeight = scaledImageHeight;
 		}
-		else
-		{
-			delete[] m_decodedData;
-			m_decodedData = scaledImageBuffer;
-			m_decodedDataLen = scaledImageBufferLen;
-			m_imageWidth = scaledImageWidth - dis;
-			m_imageHeight = scaledImageHeight - dis;
-		}
-		delete scaler;
 	}
-	*/
 }
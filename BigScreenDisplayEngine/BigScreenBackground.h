@@ -13,6 +13,7 @@
 #include "BSFDataType.h"
 #include "DxRenderCommon.h"
 #include "IDisplayContentProvider.h"
+#include "inc/FrameRef.h"
 #include <vector>
 
 namespace SOA
@@ -117,6 +118,7 @@ namespace Render
 			SOA::Mirror::Render::RectCoordinate paintRegion;
 			byte* pData;
 			int dataLength;
+			zRender::FrameRef frame;		//ıͼֱöʱЧ
 			zRender::IDisplayContentProvider* m_dcproviders;
 			zRender::RECT_f displayReg;
 
@@ -170,8 +172,7 @@ namespace Render
 		void initBigScreenCellPaintRegion(const Size& cellRsolution);
 
 	protected:
-		byte* m_decodedData;								//׵ַ
-		int m_decodedDataLen;								//ݳ
+		zRender::FrameRef m_decodedFrame;					//ݣź滻Ϊµ֡õľ֡ڴͷźͷ
 		int m_bigScreenWidth;								//ǽĿ4*3
 		int m_bigScreenHeight;								//ǽĸߣ4*3
 		int m_imageWidth;									//ͼĿ
@@ -134,10 +134,17 @@ HANDLE startThreadToPeekMessage()
 	return thread;
 }
 
+//the frame clock of all the cells
+struct RenderClock
+{
+	Screen* screen;
+	std::vector<HANDLE> timerHandles;
+};
+
 DWORD WINAPI renderTimerThreadWork(LPVOID param)
 {
 	//HANDLE timeHandle = (HANDLE) param;
-	HANDLE* pTimeHandle = (HANDLE*)param;
+	RenderClock* clock = (RenderClock*)param;
 	UINT createDeviceFlags = 0;
 #if defined(DEBUG) || defined(_DEBUG)  
     //createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
@@ -146,10 +153,12 @@ DWORD WINAPI renderTimerThreadWork(LPVOID param)
 	while(true)
 	{
 		Sleep(16);
+		//the layout published becomes the one of this frame, before any cell wakes
+		clock->screen->tick();
 		//ReleaseSemaphore(timeHandle, 4, 0);
-		for(int i=0; i<4; i++)
+		for(size_t i=0; i<clock->timerHandles.size(); i++)
 		{
-			SetEvent(*(pTimeHandle+i));
+			SetEvent(clock->timerHandles[i]);
 		}
 	}
 
@@ -386,7 +395,9 @@ int _tmain(int argc, _TCHAR* argv[])
 
 	//HANDLE peedMsgTh = startThreadToPeekMessage();
 	HANDLE timerHandle = CreateSemaphore(NULL, 0, 4, NULL);
-	std::vector<HANDLE> timerHandleVec;
+	RenderClock renderClock;
+	renderClock.screen = screen;
+	std::vector<HANDLE>& timerHandleVec = renderClock.timerHandles;
 	/*timerHandleVec.push_back(CreateEvent(NULL, false, false, NULL));
 	timerHandleVec.push_back(CreateEvent(NULL, false, false, NULL));
 	timerHandleVec.push_back(CreateEvent(NULL, false, false, NULL));
@@ -423,7 +434,7 @@ int _tmain(int argc, _TCHAR* argv[])
 	wm4->showWindow();*/
 	
 	//HANDLE timerThread = CreateThread(NULL, 0, renderTimerThreadWork, timerHandle, 0, 0);
-	HANDLE timerThread = CreateThread(NULL, 0, renderTimerThreadWork, &timerHandleVec[0], 0, 0);
+	HANDLE timerThread = CreateThread(NULL, 0, renderTimerThreadWork, &renderClock, 0, 0);
 	Sleep(1000);
 	//system("pause");
 
@@ -457,13 +468,21 @@ int _tmain(int argc, _TCHAR* argv[])
 	{
 		const TCHAR* fileName = _T("D:\\InsideMoveVtc.yuv");
 		zRender::RawFileSource* videoFileSrc = new zRender::RawFileSource(dxrender);
-		if (videoFileSrc->open(fileName, zRender::PIXFMT_YUY2, 1920, 1080))
+		if (videoFileSrc->open(fileName, zRender::PIXFMT_YUY2, 1920, 1080, true))
 		{
 			BigView* videoView = videoFileSrc->createSourceView();
 			if (videoView)
 			{
 				backVideoViewport->attachView(videoView);
 			}
+			//the same video in a thumbnail: the worker reading the file converts every YUY2 frame once to BGRX
+			//with convertYUVToBGRA, the partitions of the thumbnail upload it from memory
+			BigViewport* thumbViewport = screen->createViewport(zRender::RECT_f(0.75, 1, 0, 0.25), 160);
+			BigView* thumbView = thumbViewport ? videoFileSrc->createMultiplexedView(zRender::RECT_f(0, 1, 0, 1), zRender::PIXFMT_B8G8R8X8) : NULL;
+			if (thumbView)
+			{
+				thumbViewport->attachView(thumbView);
+			}
 			videoFileSrc->start(25);
 		}
 		else
@@ -474,7 +493,12 @@ int _tmain(int argc, _TCHAR* argv[])
 
 	zRender::RawFileSource* fileSrc = new zRender::RawFileSource(dxrender);
 	//fileSrc->open(_T("D:\\InsideMoveVtc.yuv"), zRender::PIXFMT_YUY2, 1920, 1080);
-	fileSrc->open(_T("D:\\transImag_500_282.rgb32"), zRender::PIXFMT_R8G8B8A8, 500, 282);
+	if (fileSrc->open(_T("D:\\transImag_500_282.rgb32"), zRender::PIXFMT_R8G8B8A8, 500, 282))
+	{
+		//a still picture, looped once a second only its first frame is uploaded
+		fileSrc->enableDamageDetection(true);
+		fileSrc->start(1);
+	}
 	
 	BigView* view = fileSrc->createSourceView();
 	//BigView* view = new BigView(zRender::RECT_f(0.0, 1, 0.0, 1));
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include "YUVTexture_Packed.h"
 #include "VideoTextureDataSource.h"
+#include "inc/FrameLayout.h"
 
 using namespace SOA::Mirror::Render;
 using namespace zRender;
@@ -167,7 +168,6 @@ public:
 #endif
 				return -2;
 			}
-			int dataPitch = FRAMEPITCH(m_frameWidth, m_framePixFmt);
 			//float fStartPosHrz = m_frameWidth * m_effectiveReg.left + actual_width * textureReg.left + 0.5;
 			//float fStartPosVtc = m_frameHeight * m_effectiveReg.top + actual_height * textureReg.top + 0.5;
 			float fStartPosHrz = m_frameWidth * (m_effectiveReg.left + m_effectiveReg.width()*textureReg.left) + 0.5;
@@ -176,9 +176,12 @@ public:
 			int iStartPosVtc = fStartPosVtc;
 			int iEndPosVtc = iStartPosVtc+actual_height;
 			int dataLenCopyed = FRAMEPITCH(actual_width, m_framePixFmt);//actual_width*2;
+			//ֻһƽ棬ʽ֡ݡFRAMEPITCHƽʽֻYпYUY2ȡض
+			//ʼλ¶뵽YUY2ضԣFRAMEPITCH(iStartPosHrz)xȡһض
+			FrameLayout layout = FrameLayout::create(m_framePixFmt, m_frameWidth, m_frameHeight);
 			for(int iVtc=iStartPosVtc; iVtc<iEndPosVtc; iVtc++)
 			{				
-				int dataPos = iVtc * dataPitch + FRAMEPITCH(iStartPosHrz, m_framePixFmt);
+				int dataPos = layout.pixelOffset(0, iStartPosHrz, iVtc);
 				unsigned char* pVtcData = m_frameData + dataPos;
 				memcpy(dstTextureData, pVtcData, dataLenCopyed);
 				dstTextureData += pitch;
@@ -255,11 +258,13 @@ BigView::BigView(const zRender::RECT_f& effectiveReg)
 	: m_effectiveReg(effectiveReg)
 	, m_contentProvider(NULL)
 {
+	InitializeCriticalSection(&m_authorizationLock);
 }
 
 BigView::~BigView()
 {
 	releaseContentProvider();
+	DeleteCriticalSection(&m_authorizationLock);
 }
 
 zRender::IDisplayContentProvider* BigView::applyAuthorization(BigViewportPartition* bvpp)
@@ -273,18 +278,24 @@ zRender::IDisplayContentProvider* BigView::applyAuthorization(BigViewportPartiti
 #endif
 		return NULL;
 	}
-	if(m_contentProvider==NULL)
-		if(0!=createContentProvider())
-			return NULL;
+	EnterCriticalSection(&m_authorizationLock);
+	if(m_contentProvider==NULL && 0!=createContentProvider())
+	{
+		LeaveCriticalSection(&m_authorizationLock);
+		return NULL;
+	}
 	m_authorizatedViewportPartion.push_back(bvpp);
 	m_contentProvider->increaseAuthorization();
-	return m_contentProvider;
+	IDisplayContentProvider* contentProvider = m_contentProvider;
+	LeaveCriticalSection(&m_authorizationLock);
+	return contentProvider;
 }
 
 int BigView::releaseAutorization(BigViewportPartition* bvpp)
 {
 	bool isFinded = false;
-	std::list<BigViewportPartition*>::const_iterator iter = m_authorizatedViewportPartion.begin();
+	EnterCriticalSection(&m_authorizationLock);
+	std::list<BigViewportPartition*>::iterator iter = m_authorizatedViewportPartion.begin();
 	for (; iter!=m_authorizatedViewportPartion.end(); iter++)
 	{
 		if(*iter==bvpp)
@@ -295,6 +306,7 @@ int BigView::releaseAutorization(BigViewportPartition* bvpp)
 			break;
 		}
 	}
+	LeaveCriticalSection(&m_authorizationLock);
 	return isFinded ? 0 : -1;
 }
 
@@ -307,6 +319,7 @@ int BigView::setEffectiveReg(const zRender::RECT_f& effectiveReg)
 bool BigView::isNeedShow() const
 {
 	bool isNeedShow = false;
+	EnterCriticalSection(&m_authorizationLock);
 	std::list<BigViewportPartition*>::const_iterator iter = m_authorizatedViewportPartion.begin();
 	for (; iter!=m_authorizatedViewportPartion.end(); iter++)
 	{
@@ -317,14 +330,17 @@ bool BigView::isNeedShow() const
 			break;
 		}
 	}
+	LeaveCriticalSection(&m_authorizationLock);
 	return isNeedShow;
 }
 
 bool SOA::Mirror::Render::BigView::attachTextureSource(zRender::TextureDataSource * textureDataSrc)
 {
-	if (m_contentProvider == NULL)
-		if (0 != createContentProvider())
-			return false;
+	EnterCriticalSection(&m_authorizationLock);
+	int ret = m_contentProvider == NULL ? createContentProvider() : 0;
+	LeaveCriticalSection(&m_authorizationLock);
+	if (0 != ret)
+		return false;
 	if (m_contentProvider)
 	{
 		VideoContentProvider* vcp = dynamic_cast<VideoContentProvider*>(m_contentProvider);
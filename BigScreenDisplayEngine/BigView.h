@@ -40,6 +40,7 @@ namespace Render
 		std::list<BigViewportPartition*> m_authorizatedViewportPartion;
 		zRender::RECT_f m_effectiveReg;
 		zRender::IDisplayContentProvider* m_contentProvider;
+		mutable CRITICAL_SECTION m_authorizationLock;	//m_authorizatedViewportPartionm_contentProviderĴȾ߳ͬʱͷȨ
 	};
 }//namespace Render
 }//namespace Mirror
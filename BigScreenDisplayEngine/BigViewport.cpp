@@ -3,64 +3,168 @@
 #include "Screen.h"
 #include "BigViewportPartition.h"
 #include <assert.h>
+#include <map>
 #include "RenderDrawing.h"
 
 using namespace SOA::Mirror::Render;
 using namespace zRender;
 
 BigViewport::BigViewport(const zRender::RECT_f& regOfScreen, int zIndex, const Screen& parentSc)
-	: m_parentSc(parentSc)
+	: m_parentSc(parentSc), m_scene(parentSc.getSceneState())
+	, m_regOfScreen(regOfScreen), m_zIndex(zIndex), m_view(NULL), m_crop(0, 1, 0, 1)
 {
 	if (regOfScreen.width() <= 0 || regOfScreen.height() <= 0 || zIndex < 0)
 		throw std::exception("Invalid Argument.");
-	int xPosStart = static_cast<int>(regOfScreen.left);
-	int xPosEnd = regOfScreen.right - static_cast<int>(regOfScreen.right) > 0.001 ? static_cast<int>(regOfScreen.right) : static_cast<int>(regOfScreen.right) - 1;
-	int yPosStart = static_cast<int>(regOfScreen.top);
-	int yPosEnd = regOfScreen.bottom - static_cast<int>(regOfScreen.bottom) > 0.001 ? static_cast<int>(regOfScreen.bottom) : static_cast<int>(regOfScreen.bottom) - 1;
-	for (int yIndex = yPosStart; yIndex <= yPosEnd; yIndex++)
+	const SceneViewport layout = getLayout();
+	std::vector<PartitionRegion> regions;
+	splitRegion(layout, regions);
+	SceneSnapshot* next = m_scene->beginUpdate();
+	for (size_t i = 0; i < regions.size(); i++)
 	{
-		float top = yIndex == yPosStart ? regOfScreen.top : yIndex;
-		float bottom = yIndex == yPosEnd ? regOfScreen.bottom : yIndex + 1;
-		for (int xIndex = xPosStart; xIndex <= xPosEnd; xIndex++)
-		{
-			ScreenRender* scRender = parentSc.getScreenRender(xIndex, yIndex);
-			RenderDrawing* rd = NULL;
-			if (!scRender || (rd=scRender->getRenderDrawing())==NULL)
-			{
-				printf("Have Not create ScreenRender obj for (%d, %d) Cell.\n", xIndex, yIndex);
-				continue;
-			}
-			float left = xIndex == xPosStart ? regOfScreen.left : xIndex;
-			float right = xIndex == xPosEnd ? regOfScreen.right : xIndex + 1;
-			RECT_f vppRegOfSc(left, right, top, bottom);
-			float leftOfvp = (left - regOfScreen.left) / regOfScreen.width();
-			float rightOfvp = (right - regOfScreen.left) / regOfScreen.width();
-			float topOfvp = (top - regOfScreen.top) / regOfScreen.height();
-			float bottomOfvp = (bottom - regOfScreen.top) / regOfScreen.height();
-			RECT_f vppRegOfVp(leftOfvp, rightOfvp, topOfvp, bottomOfvp);
-			BigViewportPartition* vpp = new BigViewportPartition(vppRegOfSc, vppRegOfVp, rd);
-			assert(vpp);
-			rd->addBigViewportPartition(vpp);
-			vpp->setZIndex(zIndex);
+		BigViewportPartition* vpp = createPartition(regions[i], next->getEpoch());
+		if (vpp)
 			m_partitions.push_back(vpp);
-		}
 	}
+	next->setViewport(layout);
+	m_scene->endUpdate();
 }
 
 BigViewport::~BigViewport()
 {
+	//the render threads still draw them until they adopt the snapshot without this viewport, then delete them
+	SceneSnapshot* next = m_scene->beginUpdate();
 	for (size_t i = 0; i < m_partitions.size(); i++)
 	{
-		delete m_partitions[i];
+		m_partitions[i]->retire(next->getEpoch());
 	}
+	next->removeViewport(this);
+	m_scene->endUpdate();
 	m_partitions.clear();
 }
 
 bool BigViewport::attachView(BigView* bigview)
 {
+	m_view = bigview;
+	publishLayout();
+	return true;
+}
+
+int BigViewport::move(const zRender::RECT_f& regOfScreen)
+{
+	if (regOfScreen.width() <= 0 || regOfScreen.height() <= 0)
+		return -1;
+	SceneViewport layout = getLayout();
+	layout.regOfScreen = regOfScreen;
+	std::vector<PartitionRegion> regions;
+	splitRegion(layout, regions);
+	//a cell holds one partition of the viewport at most, the partitions are known by the RenderDrawing of their cell
+	std::map<RenderDrawing*, BigViewportPartition*> current;
 	for (size_t i = 0; i < m_partitions.size(); i++)
 	{
-		m_partitions[i]->attachBigView(bigview);
+		current[m_partitions[i]->getRenderDrawing()] = m_partitions[i];
 	}
-	return true;
-}
\ No newline at end of file
+	SceneSnapshot* next = m_scene->beginUpdate();
+	const LONG epoch = next->getEpoch();
+	std::vector<BigViewportPartition*> partitions;
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		std::map<RenderDrawing*, BigViewportPartition*>::iterator iter = current.find(regions[i].renderDrawing);
+		if (iter != current.end())
+		{
+			//moved by the render thread of its cell when it adopts the snapshot
+			partitions.push_back(iter->second);
+			current.erase(iter);
+			continue;
+		}
+		BigViewportPartition* vpp = createPartition(regions[i], epoch);
+		if (vpp)
+			partitions.push_back(vpp);
+	}
+	//the cells left, the render thread of each cell deletes the partition with its DisplayElement
+	std::map<RenderDrawing*, BigViewportPartition*>::iterator iter = current.begin();
+	for (; iter != current.end(); iter++)
+	{
+		iter->second->retire(epoch);
+	}
+	m_partitions.swap(partitions);
+	m_regOfScreen = regOfScreen;
+	next->setViewport(layout);
+	m_scene->endUpdate();
+	return 0;
+}
+
+int BigViewport::setZIndex(int zIndex)
+{
+	if (zIndex < 0)
+		return -1;
+	m_zIndex = zIndex;
+	publishLayout();
+	return 0;
+}
+
+int BigViewport::setCrop(const zRender::RECT_f& crop)
+{
+	if (crop.left < 0 || crop.top < 0 || crop.right > 1 || crop.bottom > 1 || crop.width() <= 0 || crop.height() <= 0)
+		return -1;
+	m_crop = crop;
+	publishLayout();
+	return 0;
+}
+
+SceneViewport BigViewport::getLayout() const
+{
+	SceneViewport layout;
+	layout.viewport = this;
+	layout.regOfScreen = m_regOfScreen;
+	layout.zIndex = m_zIndex;
+	layout.view = m_view;
+	layout.crop = m_crop;
+	return layout;
+}
+
+void BigViewport::publishLayout()
+{
+	SceneSnapshot* next = m_scene->beginUpdate();
+	next->setViewport(getLayout());
+	m_scene->endUpdate();
+}
+
+void BigViewport::splitRegion(const SceneViewport& layout, std::vector<PartitionRegion>& regions) const
+{
+	const RECT_f& regOfScreen = layout.regOfScreen;
+	int xPosStart = static_cast<int>(regOfScreen.left);
+	int yPosStart = static_cast<int>(regOfScreen.top);
+	for (int yIndex = yPosStart; yIndex <= static_cast<int>(regOfScreen.bottom); yIndex++)
+	{
+		for (int xIndex = xPosStart; xIndex <= static_cast<int>(regOfScreen.right); xIndex++)
+		{
+			PartitionRegion region;
+			if (!layout.partitionOf(xIndex, yIndex, region.regOfScreen, region.regOfTexture))
+				continue;
+			ScreenRender* scRender = m_parentSc.getScreenRender(xIndex, yIndex);
+			if (!scRender || (region.renderDrawing=scRender->getRenderDrawing())==NULL)
+			{
+				printf("Have Not create ScreenRender obj for (%d, %d) Cell.\n", xIndex, yIndex);
+				continue;
+			}
+			regions.push_back(region);
+		}
+	}
+}
+
+BigViewportPartition* BigViewport::createPartition(const PartitionRegion& region, LONG epoch)
+{
+	BigViewportPartition* vpp = new BigViewportPartition(region.regOfScreen, region.regOfTexture, region.renderDrawing, this);
+	assert(vpp);
+	//set before the DisplayElement is created, it is created at this z
+	vpp->setZIndex(m_zIndex);
+	//hidden until the cells adopt the snapshot of this change, the view is attached by the render thread then
+	vpp->showFrom(epoch);
+	if (0 != region.renderDrawing->addBigViewportPartition(vpp))
+	{
+		//the render thread never got it, nobody else deletes it
+		delete vpp;
+		return NULL;
+	}
+	return vpp;
+}
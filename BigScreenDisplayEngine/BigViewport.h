@@ -3,6 +3,7 @@
 #define _SOA_MIRROR_RENDER_BIGVIEWPORT_H_
 
 #include "DxRenderCommon.h"
+#include "SceneState.h"
 #include <vector>
 
 namespace SOA
@@ -14,16 +15,74 @@ namespace Render
 	class Screen;
 	class BigView;
 	class BigViewportPartition;
+	class RenderDrawing;
 
 	class BigViewport
 	{
 	public:
 		BigViewport(const zRender::RECT_f& regOfScreen, int zIndex, const Screen& parentSc);
+
+		/**
+		 *	@brief	the partitions are hidden from the next snapshot on and released by the render threads of their cells
+		 **/
 		~BigViewport();
 
+		/**
+		 *	@brief	the view is attached by the render threads of the cells once they adopt the snapshot published
+		 **/
 		bool attachView(BigView* bigview);
+
+		/**
+		 *	@name		move
+		 *	@brief		move or resize the viewport to regOfScreen.
+		 *				The partitions of the cells still covered are moved and keep their DisplayElement and texture,
+		 *				partitions are only created for the cells entered and released for the cells left.
+		 *				Every cell shows the change from the same frame, the one adopting the snapshot published
+		 *	@return		int 0:success -1:regOfScreen is empty
+		 **/
+		int move(const zRender::RECT_f& regOfScreen);
+
+		/**
+		 *	@return		int 0:success -1:zIndex <0
+		 **/
+		int setZIndex(int zIndex);
+
+		/**
+		 *	@name		setCrop
+		 *	@brief		region of the view shown by the viewport, relative coordinates in [0,1], the whole view by default
+		 *	@return		int 0:success -1:the region is empty or not inside [0,1]
+		 **/
+		int setCrop(const zRender::RECT_f& crop);
+
+		zRender::RECT_f getRegOfScreen() const { return m_regOfScreen; }
+		int getZIndex() const { return m_zIndex; }
+		zRender::RECT_f getCrop() const { return m_crop; }
 	private:
+		/**
+		 *	@brief	the piece of the viewport shown by one cell
+		 **/
+		struct PartitionRegion
+		{
+			RenderDrawing* renderDrawing;
+			zRender::RECT_f regOfScreen;
+			zRender::RECT_f regOfTexture;
+		};
+
+		void splitRegion(const SceneViewport& layout, std::vector<PartitionRegion>& regions) const;
+		BigViewportPartition* createPartition(const PartitionRegion& region, LONG epoch);
+		SceneViewport getLayout() const;
+
+		/**
+		 *	@brief	write the layout of the viewport into the snapshot being built and publish it
+		 **/
+		void publishLayout();
+
 		const Screen& m_parentSc;
+		SceneState* m_scene;
+		zRender::RECT_f m_regOfScreen;
+		int m_zIndex;
+		BigView* m_view;
+		zRender::RECT_f m_crop;
 		std::vector<BigViewportPartition*> m_partitions;
 	};
 }
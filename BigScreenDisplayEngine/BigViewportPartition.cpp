@@ -2,15 +2,17 @@
 #include <assert.h>
 #include "DisplayElement.h"
 #include "BigView.h"
+#include "RenderDrawing.h"
 
 using namespace SOA::Mirror::Render;
 using namespace zRender;
 
-BigViewportPartition::BigViewportPartition(const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport, RenderDrawing* rd)
+BigViewportPartition::BigViewportPartition(const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport, RenderDrawing* rd, const BigViewport* viewport)
 	: m_regOfBigScreen(regOfBigScreen), m_regOfBigViewport(regOfBigViewport)
 	, m_renderDrawing(rd), m_attachedDE(NULL), m_attachedView(NULL)
 	, m_cttProvider(NULL), m_curDrawedVertexIdentify(0), m_curDrawedTextureIdentify(0)
-	, m_ZIndex(0)
+	, m_ZIndex(0), m_occluded(false)
+	, m_viewport(viewport), m_shownFrom(0), m_hiddenFrom(0)
 {
 }
 
@@ -57,6 +59,8 @@ int BigViewportPartition::attachBigView(BigView* view)
 
 int BigViewportPartition::disattachView()
 {
+	//the authorization given up while occluded is taken back, BigView releases one
+	setOccluded(false);
 	if(m_cttProvider)
 	{
 		m_cttProvider = NULL;
@@ -82,10 +86,30 @@ RenderDrawing* BigViewportPartition::getRenderDrawing() const
 	return m_renderDrawing;
 }
 
-int BigViewportPartition::move(const const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport)
+int BigViewportPartition::move(const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport)
 {
-	throw "Not implement";
-	return -1;
+	if(regOfBigScreen.width()<=0 || regOfBigScreen.height()<=0 || regOfBigViewport.width()<=0 || regOfBigViewport.height()<=0)
+	{
+#ifdef _DEBUG
+		printf("Error in BigViewportPartition::move : param invalid.\n");
+#endif
+		return -1;
+	}
+	//the world matrix of the DisplayElement only, its vertexs and texture stay
+	if(m_attachedDE && 0!=m_attachedDE->setDisplayRegion(regOfBigScreen, m_ZIndex))
+		return -2;
+	m_regOfBigScreen = regOfBigScreen;
+	m_regOfBigViewport = regOfBigViewport;
+	//the texture opened holds the whole frame of the source, the crop of the source is all that changes
+	if(m_attachedDE && m_cttProvider && m_curDrawedTextureIdentify>0)
+	{
+		TextureDataSource* tds = m_cttProvider->getTextureDataSource();
+		if(tds)
+			m_attachedDE->setTextureDataSource(tds, m_regOfBigViewport);
+	}
+	if(m_renderDrawing)
+		m_renderDrawing->updatePartitionRegion(this);
+	return 0;
 }
 
 int BigViewportPartition::update()
@@ -136,10 +160,17 @@ void BigViewportPartition::updateTexture()
 		ret = tds->getTextureProfile(m_regOfBigViewport, dataLen, pitch, uPitch, vPitch, width, height, pixelFmt);
 		if(ret!=0 || dataLen==0 || pixelFmt==0 || width==0 || height==0)
 			return;
-		//m_attachedDE->setTexture(pixelFmt, width, height);
-		zRender::TextureDataSource* texDataSrc = m_cttProvider->getTextureDataSource();
-		zRender::IRawFrameTexture* rawTexture = texDataSrc->getTexture();
-		m_attachedDE->openSharedTexture(rawTexture);
+		if (tds->getTexture())
+		{
+			//opened again once the source creates a new shared texture, see DisplayElement::openSharedTexture
+			m_attachedDE->openSharedTexture(tds);
+		}
+		else
+		{
+			//frames in memory, e.g. a MultiplexedSource: the partition uploads its region into a texture of its own,
+			//created again by createRenderResource when the format or the size of the region changes
+			m_attachedDE->setTexture(pixelFmt, width, height);
+		}
 		if (pixelFmt == PIXFMT_A8R8G8B8 || PIXFMT_R8G8B8A8 == pixelFmt || PIXFMT_B8G8R8A8 == pixelFmt)
 		{
 			m_attachedDE->enableTransparent(true);
@@ -168,6 +199,27 @@ bool BigViewportPartition::isValid() const
 	return true;
 }
 
+bool BigViewportPartition::isOpaque() const
+{
+	if(m_attachedDE==NULL || m_cttProvider==NULL || m_curDrawedTextureIdentify<=0)
+		return false;
+	return !m_attachedDE->isEnableTransparent();
+}
+
+void BigViewportPartition::setOccluded(bool occluded)
+{
+	if(m_occluded==occluded)
+		return;
+	m_occluded = occluded;
+	if(m_cttProvider==NULL)
+		return;
+	//the frames of the source wait for the authorized partitions to draw them, a hidden one never does
+	if(occluded)
+		m_cttProvider->decreaseAuthorization();
+	else
+		m_cttProvider->increaseAuthorization();
+}
+
 void BigViewportPartition::setZIndex(int zIndex)
 {
 	m_ZIndex = zIndex;
@@ -25,11 +25,12 @@ namespace Render
 {
 	class RenderDrawing;
 	class BigView;
+	class BigViewport;
 
 	class BigViewportPartition
 	{
 	public:
-		BigViewportPartition(const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport, RenderDrawing* rd);
+		BigViewportPartition(const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport, RenderDrawing* rd, const BigViewport* viewport = NULL);
 		~BigViewportPartition();
 
 		int attachDisplayElement(zRender::DisplayElement* de);
@@ -40,7 +41,15 @@ namespace Render
 		BigView* getAttachedView() const;
 
 		RenderDrawing* getRenderDrawing() const;
-		int move(const const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport);
+
+		/**
+		 *	@name		move
+		 *	@brief		ƶıСBigViewportڸôеĲ֣ѴDisplayElementԼ򿪵ֻ޸ʾλ
+		 *	@param[in]	const zRender::RECT_f& regOfBigScreen µBigScreenе򣬱λRenderDrawingĴ
+		 *	@param[in]	const zRender::RECT_f& regOfBigViewport µBigViewportе
+		 *	@return		int 0--ɹ -1--Ϊ -2--RenderDrawingĴ
+		 **/
+		int move(const zRender::RECT_f& regOfBigScreen, const zRender::RECT_f& regOfBigViewport);
 
 		int update();
 		int notifyToRelease();
@@ -72,6 +81,47 @@ namespace Render
 		 *				 zOfWindowzOfViewportȡֵΧΪ [0,1000]
 		 **/
 		int getZIndex() const  { return m_ZIndex; }
+
+		/**
+		 *	@name		isOpaque
+		 *	@brief		Ƿȫڵ·ݣѾʾҲǿ͸RGBAʽ
+		 **/
+		bool isOpaque() const;
+
+		/**
+		 *	@name		setOccluded
+		 *	@brief		ǷZߵĲ͸ȫڵRenderDrawingÿһ֡ĿɼԼ
+		 *				ڵʱҲϴBigViewʾȨԴȴòֵĻ
+		 *				¿ɼʱָȨһupdateȡµ
+		 **/
+		void setOccluded(bool occluded);
+		bool isOccluded() const { return m_occluded; }
+
+		/**
+		 *	@name		getViewport
+		 *	@brief		BigViewportSceneSnapshotв䲼֣Ⱦ̲߳ʸö
+		 **/
+		const BigViewport* getViewport() const { return m_viewport; }
+
+		/**
+		 *	@name		showFrom
+		 *	@brief		ôһSceneSnapshotepochʼʾӵRenderDrawing֮ǰ
+		 *				ڸepochд֮ǰʾӶͬһβ޸е仯ͬʱ
+		 **/
+		void showFrom(LONG epoch) { m_shownFrom = epoch; }
+
+		/**
+		 *	@name		retire
+		 *	@brief		ôһSceneSnapshotepochʼʾȾ̲߳øepochʱͷŸö
+		 **/
+		void retire(LONG epoch) { m_hiddenFrom = epoch; }
+
+		/**
+		 *	@name		isShownAt
+		 *	@brief		Ⱦ̲߳õSceneSnapshotepochǷʾ
+		 **/
+		bool isShownAt(LONG epoch) const { return epoch >= m_shownFrom && !isRetiredAt(epoch); }
+		bool isRetiredAt(LONG epoch) const { return m_hiddenFrom != 0 && epoch >= m_hiddenFrom; }
 	private:
 		void updateVertex();
 		void updateTexture();
@@ -85,6 +135,10 @@ namespace Render
 		zRender::IDisplayContentProvider* m_cttProvider;
 		int m_curDrawedVertexIdentify;
 		int m_curDrawedTextureIdentify;
+		bool m_occluded;
+		const BigViewport* m_viewport;
+		volatile LONG m_shownFrom;
+		volatile LONG m_hiddenFrom;		//0--ûбͷ
 	};
 }
 }
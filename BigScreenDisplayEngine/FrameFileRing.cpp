@@ -0,0 +1,184 @@
+#include "FrameFileRing.h"
+#include <limits.h>
+
+using namespace SOA::Mirror::Render;
+
+FrameFileRing::FrameFileRing()
+	: m_frameLen(0), m_ringDepth(0), m_prefetch(0)
+	, m_readSlot(0), m_writeSlot(0), m_filled(0), m_underruns(0), m_pinCount(0), m_advanced(0)
+	, m_running(false), m_thread(NULL), m_slotFreed(NULL), m_unpinned(NULL)
+{
+}
+
+FrameFileRing::~FrameFileRing()
+{
+	close();
+}
+
+int FrameFileRing::open(const char* fileName, int frameLen, int ringDepth, int prefetch)
+{
+	if(NULL==fileName || frameLen<=0 || ringDepth<3)
+		return -1;
+	if(m_buffer.valid())
+		return -2;
+	m_file.open(fileName, std::ios::binary | std::ios::in);
+	if(!m_file)
+		return -3;
+	if(frameLen > INT_MAX / ringDepth || !m_buffer.allocate(frameLen * ringDepth))
+	{
+		m_file.close();
+		return -4;
+	}
+	m_frameLen = frameLen;
+	m_ringDepth = ringDepth;
+	m_prefetch = prefetch < 1 ? 1 : (prefetch > ringDepth - 2 ? ringDepth - 2 : prefetch);
+	//the first frame is there when open returns, the thread only reads ahead
+	if(!readFrame(m_buffer.data()))
+	{
+		close();
+		return -5;
+	}
+	m_readSlot = 0;
+	m_writeSlot = 1;
+	m_filled = 0;
+	m_underruns = 0;
+	m_pins.assign(ringDepth, 0);
+	m_pinCount = 0;
+	m_advanced = 0;
+	m_slotFreed = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_unpinned = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_running = true;
+	m_thread = m_slotFreed && m_unpinned ? CreateThread(NULL, 0, readThread, this, 0, NULL) : NULL;
+	if(NULL==m_thread)
+	{
+		close();
+		return -6;
+	}
+	return 0;
+}
+
+void FrameFileRing::close()
+{
+	//the pinned slots are read by the holders of the FrameRefs, the buffer stays until they are done.
+	//The event may be left set by a FrameRef released before, the count is checked again
+	while(m_pinCount>0)
+		WaitForSingleObject(m_unpinned, INFINITE);
+	m_running = false;
+	if(m_thread)
+	{
+		SetEvent(m_slotFreed);
+		WaitForSingleObject(m_thread, INFINITE);
+		CloseHandle(m_thread);
+		m_thread = NULL;
+	}
+	if(m_slotFreed)
+	{
+		CloseHandle(m_slotFreed);
+		m_slotFreed = NULL;
+	}
+	if(m_unpinned)
+	{
+		CloseHandle(m_unpinned);
+		m_unpinned = NULL;
+	}
+	if(m_file.is_open())
+		m_file.close();
+	m_buffer.reset();
+	m_frameLen = 0;
+	m_ringDepth = 0;
+	m_filled = 0;
+	m_pins.clear();
+}
+
+unsigned char* FrameFileRing::currentFrame() const
+{
+	if(!m_buffer.valid())
+		return NULL;
+	return m_buffer.data() + (size_t)m_readSlot * m_frameLen;
+}
+
+zRender::FrameRef FrameFileRing::currentFrameRef(const zRender::FrameLayout& layout)
+{
+	if(!m_buffer.valid() || layout.size()>m_frameLen)
+		return zRender::FrameRef();
+	int slot = m_readSlot;
+	for(;;)
+	{
+		InterlockedIncrement(&m_pins[slot]);
+		//still the current slot or the one before it, the reader has not been able to choose it since it was read
+		const int readSlot = m_readSlot;
+		if(slot==readSlot || slot==(readSlot + m_ringDepth - 1) % m_ringDepth)
+			break;
+		InterlockedDecrement(&m_pins[slot]);
+		slot = readSlot;
+	}
+	InterlockedIncrement(&m_pinCount);
+	unsigned char* frame = m_buffer.data() + (size_t)slot * m_frameLen;
+	zRender::FrameRef ref = zRender::FrameRef::wrap(frame, m_frameLen, layout, m_advanced, unpinSlot, this);
+	if(!ref.valid())
+		unpinSlot(frame, this);
+	return ref;
+}
+
+void FrameFileRing::unpinSlot(unsigned char* frame, void* param)
+{
+	FrameFileRing* ring = reinterpret_cast<FrameFileRing*>(param);
+	const int slot = (int)((frame - ring->m_buffer.data()) / ring->m_frameLen);
+	InterlockedDecrement(&ring->m_pins[slot]);
+	SetEvent(ring->m_slotFreed);
+	if(0==InterlockedDecrement(&ring->m_pinCount))
+		SetEvent(ring->m_unpinned);
+}
+
+bool FrameFileRing::advance()
+{
+	if(!m_buffer.valid())
+		return false;
+	if(m_filled<=0)
+	{
+		InterlockedIncrement(&m_underruns);
+		return false;
+	}
+	m_readSlot = (m_readSlot + 1) % m_ringDepth;
+	m_advanced++;
+	InterlockedDecrement(&m_filled);
+	SetEvent(m_slotFreed);
+	return true;
+}
+
+DWORD WINAPI FrameFileRing::readThread(LPVOID param)
+{
+	FrameFileRing* ring = reinterpret_cast<FrameFileRing*>(param);
+	if(ring)
+		ring->doReadAhead();
+	return 0;
+}
+
+void FrameFileRing::doReadAhead()
+{
+	while(m_running)
+	{
+		//m_writeSlot is m_filled+1 slots after the current frame, never the current slot or the one before it
+		if(m_filled>=m_prefetch || m_pins[m_writeSlot]>0)
+		{
+			WaitForSingleObject(m_slotFreed, INFINITE);
+			continue;
+		}
+		if(!readFrame(m_buffer.data() + (size_t)m_writeSlot * m_frameLen))
+			break;
+		m_writeSlot = (m_writeSlot + 1) % m_ringDepth;
+		InterlockedIncrement(&m_filled);
+	}
+}
+
+bool FrameFileRing::readFrame(unsigned char* dst)
+{
+	m_file.read((char*)dst, m_frameLen);
+	if(m_file.gcount()==m_frameLen)
+		return true;
+	//the end of the file, a partial last frame is skipped and the file played again
+	m_file.clear();
+	m_file.seekg(0, std::ios::beg);
+	m_file.read((char*)dst, m_frameLen);
+	return m_file.gcount()==m_frameLen;
+}
@@ -0,0 +1,108 @@
+/**
+ *	@name		FrameFileRing.h
+ *	@brief		fixed ring of frames filled from a file of raw frames by a read-ahead thread
+ */
+#pragma once
+#ifndef _SOA_MIRROR_RENDER_FRAME_FILE_RING_H_
+#define _SOA_MIRROR_RENDER_FRAME_FILE_RING_H_
+
+#include <Windows.h>
+#include <fstream>
+#include <vector>
+#include "inc/FramePool.h"
+#include "inc/FrameRef.h"
+
+namespace SOA
+{
+namespace Mirror
+{
+namespace Render
+{
+	/**
+	 *	@name		FrameFileRing
+	 *	@brief		the memory used is ringDepth frames whatever the length of the file, the file is read in a loop.
+	 *				One thread consumes the frames with advance(), any thread reads the current frame.
+	 *				The slot of the current frame and the one before it are never written by the reader,
+	 *				so a frame being copied while the consumer advances stays intact.
+	 *				A slot handed out by currentFrameRef() is not written either until its last FrameRef goes,
+	 *				the reader waits for it when the slot comes round again instead of reading ahead.
+	 **/
+	class FrameFileRing
+	{
+	public:
+		enum { DEFAULT_RING_DEPTH = 8, DEFAULT_PREFETCH_DISTANCE = 4 };
+
+		FrameFileRing();
+		~FrameFileRing();
+
+		/**
+		 *	@name		open
+		 *	@brief		read the first frame and start the read-ahead thread
+		 *	@param[in]	int frameLen bytes of one frame in the file
+		 *	@param[in]	int ringDepth frames held in memory, at least 3
+		 *	@param[in]	int prefetch frames read ahead of the current one, clamped to [1, ringDepth-2]
+		 *	@return		int 0:success <0:failed, e.g. the file is shorter than one frame
+		 **/
+		int open(const char* fileName, int frameLen, int ringDepth = DEFAULT_RING_DEPTH, int prefetch = DEFAULT_PREFETCH_DISTANCE);
+		void close();
+
+		bool valid() const { return m_buffer.valid(); }
+		int frameLen() const { return m_frameLen; }
+
+		/**
+		 *	@brief	the frame shown now, NULL when not opened
+		 **/
+		unsigned char* currentFrame() const;
+
+		/**
+		 *	@name		currentFrameRef
+		 *	@brief		the frame shown now, the reader waits before writing its slot while the FrameRef or a copy of it is alive.
+		 *				close() waits until every FrameRef is gone, they must be released before the ring is closed
+		 *	@param[in]	const zRender::FrameLayout& layout planes of the frame, its size is at most frameLen()
+		 *	@return		zRender::FrameRef empty when not opened or the layout does not fit, the pts is the count of frames advanced
+		 **/
+		zRender::FrameRef currentFrameRef(const zRender::FrameLayout& layout);
+
+		/**
+		 *	@name		advance
+		 *	@brief		the next frame becomes the current one and its slot is given back to the reader
+		 *	@return		bool false when the reader is behind, the current frame stays
+		 **/
+		bool advance();
+
+		/**
+		 *	@brief	frames advance() could not move to because the reader was behind
+		 **/
+		long getUnderrunCount() const { return m_underruns; }
+
+	private:
+		FrameFileRing(const FrameFileRing&);
+		FrameFileRing& operator=(const FrameFileRing&);
+
+		static DWORD WINAPI readThread(LPVOID param);
+		void doReadAhead();
+		bool readFrame(unsigned char* dst);
+		static void unpinSlot(unsigned char* frame, void* ring);
+
+		std::ifstream m_file;
+		zRender::FrameBuffer m_buffer;	//ringDepth frames from the FramePool, the ring of the next file of this size reuses it
+		int m_frameLen;
+		int m_ringDepth;
+		int m_prefetch;
+		volatile int m_readSlot;		//slot of the current frame, written by the consumer
+		int m_writeSlot;				//next slot the reader fills
+		volatile LONG m_filled;			//frames read after the current one
+		volatile LONG m_underruns;
+		std::vector<LONG> m_pins;		//FrameRefs alive per slot
+		volatile LONG m_pinCount;		//FrameRefs alive in all the slots
+		LONGLONG m_advanced;			//frames advanced since open, the pts of the current frame
+		volatile bool m_running;
+		HANDLE m_thread;
+		HANDLE m_slotFreed;
+		HANDLE m_unpinned;				//set when the last FrameRef of all the slots goes, close() waits for it
+	};
+}
+}
+}
+
+#endif //_SOA_MIRROR_RENDER_FRAME_FILE_RING_H_
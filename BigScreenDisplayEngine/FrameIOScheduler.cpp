@@ -0,0 +1,402 @@
+#include "FrameIOScheduler.h"
+#include <algorithm>
+
+using namespace zRender;
+
+namespace
+{
+	struct LaterDeadline
+	{
+		template<typename T>
+		bool operator()(const T& a, const T& b) const { return a.deadline > b.deadline; }
+	};
+
+	class PerformanceCounterClock : public IMasterClock
+	{
+	public:
+		PerformanceCounterClock()
+		{
+			LARGE_INTEGER freq = { 0 };
+			QueryPerformanceFrequency(&freq);
+			m_freq = freq.QuadPart > 0 ? freq.QuadPart : 1000;
+		}
+		virtual LONGLONG now() const
+		{
+			LARGE_INTEGER counter = { 0 };
+			QueryPerformanceCounter(&counter);
+			return counter.QuadPart;
+		}
+		virtual LONGLONG frequency() const { return m_freq; }
+	private:
+		LONGLONG m_freq;
+	};
+
+	IMasterClock* defaultClock()
+	{
+		static PerformanceCounterClock clock;
+		return &clock;
+	}
+}
+
+FrameIOScheduler& FrameIOScheduler::instance()
+{
+	static FrameIOScheduler scheduler;
+	return scheduler;
+}
+
+FrameIOScheduler::FrameIOScheduler()
+	: m_clock(defaultClock()), m_workerCount(DEFAULT_WORKER_COUNT), m_running(false)
+	, m_timer(NULL), m_wakeTimer(NULL), m_jobSemaphore(NULL)
+{
+	InitializeCriticalSection(&m_lock);
+	m_serviceDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+}
+
+FrameIOScheduler::~FrameIOScheduler()
+{
+	shutdown();
+	if (m_serviceDone)
+		CloseHandle(m_serviceDone);
+	DeleteCriticalSection(&m_lock);
+}
+
+int FrameIOScheduler::addSource(IFrameIOClient* client, const FrameRate& rate, LONGLONG epoch)
+{
+	if (NULL == client || !rate.valid())
+		return -1;
+	EnterCriticalSection(&m_lock);
+	if (findSource(client))
+	{
+		LeaveCriticalSection(&m_lock);
+		return -2;
+	}
+	if (NULL == m_timer && 0 != startThreads())
+	{
+		LeaveCriticalSection(&m_lock);
+		return -3;
+	}
+	Source src;
+	src.client = client;
+	src.epoch = epoch < 0 ? m_clock->now() : epoch;
+	src.ticksPerUnit = m_clock->frequency() * rate.den;
+	src.rate = rate;
+	src.nextPts = 0;
+	src.queued = false;
+	src.running = false;
+	m_sources.push_back(src);
+	LeaveCriticalSection(&m_lock);
+	//the first frame is due now, the timer may be waiting for a later deadline
+	SetEvent(m_wakeTimer);
+	return 0;
+}
+
+void FrameIOScheduler::removeSource(IFrameIOClient* client)
+{
+	for (;;)
+	{
+		EnterCriticalSection(&m_lock);
+		Source* src = findSource(client);
+		if (NULL == src)
+		{
+			LeaveCriticalSection(&m_lock);
+			return;
+		}
+		//queued reads are dropped, the counts left in the semaphore wake a worker finding nothing
+		size_t kept = 0;
+		for (size_t i = 0; i < m_jobs.size(); i++)
+		{
+			if (m_jobs[i].client != client)
+				m_jobs[kept++] = m_jobs[i];
+		}
+		if (kept != m_jobs.size())
+		{
+			m_jobs.resize(kept);
+			std::make_heap(m_jobs.begin(), m_jobs.end(), LaterDeadline());
+		}
+		if (!src->running)
+		{
+			m_sources.erase(m_sources.begin() + (src - &m_sources[0]));
+			LeaveCriticalSection(&m_lock);
+			return;
+		}
+		//a worker is in serviceFrame() of the client, at most the time of one read.
+		//Reset under the lock the worker sets it under, the end of that call cannot be missed.
+		//Another removeSource() may reset it again, the end of its own call wakes this one too
+		ResetEvent(m_serviceDone);
+		LeaveCriticalSection(&m_lock);
+		WaitForSingleObject(m_serviceDone, INFINITE);
+	}
+}
+
+void FrameIOScheduler::setMasterClock(IMasterClock* clock)
+{
+	EnterCriticalSection(&m_lock);
+	if (m_sources.empty())
+		m_clock = clock ? clock : defaultClock();
+	LeaveCriticalSection(&m_lock);
+}
+
+IMasterClock* FrameIOScheduler::getMasterClock() const
+{
+	EnterCriticalSection(&m_lock);
+	IMasterClock* clock = m_clock;
+	LeaveCriticalSection(&m_lock);
+	return clock;
+}
+
+void FrameIOScheduler::setWorkerCount(int count)
+{
+	EnterCriticalSection(&m_lock);
+	if (NULL == m_timer && count > 0)
+		m_workerCount = count;
+	LeaveCriticalSection(&m_lock);
+}
+
+int FrameIOScheduler::getQueueDepth() const
+{
+	EnterCriticalSection(&m_lock);
+	int depth = (int)m_jobs.size();
+	LeaveCriticalSection(&m_lock);
+	return depth;
+}
+
+bool FrameIOScheduler::getSourceStats(IFrameIOClient* client, FrameIOStats& stats) const
+{
+	EnterCriticalSection(&m_lock);
+	const Source* src = findSource(client);
+	if (src)
+		stats = src->stats;
+	LeaveCriticalSection(&m_lock);
+	return src != NULL;
+}
+
+void FrameIOScheduler::shutdown()
+{
+	EnterCriticalSection(&m_lock);
+	if (NULL == m_timer)
+	{
+		LeaveCriticalSection(&m_lock);
+		return;
+	}
+	m_running = false;
+	LeaveCriticalSection(&m_lock);
+	SetEvent(m_wakeTimer);
+	ReleaseSemaphore(m_jobSemaphore, (LONG)m_workers.size(), NULL);
+	WaitForSingleObject(m_timer, INFINITE);
+	CloseHandle(m_timer);
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		WaitForSingleObject(m_workers[i], INFINITE);
+		CloseHandle(m_workers[i]);
+	}
+	EnterCriticalSection(&m_lock);
+	m_timer = NULL;
+	m_workers.clear();
+	m_jobs.clear();
+	m_sources.clear();
+	CloseHandle(m_wakeTimer);
+	CloseHandle(m_jobSemaphore);
+	m_wakeTimer = NULL;
+	m_jobSemaphore = NULL;
+	LeaveCriticalSection(&m_lock);
+}
+
+int FrameIOScheduler::startThreads()
+{
+	m_wakeTimer = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_jobSemaphore = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+	if (NULL == m_wakeTimer || NULL == m_jobSemaphore)
+	{
+		if (m_wakeTimer) CloseHandle(m_wakeTimer);
+		if (m_jobSemaphore) CloseHandle(m_jobSemaphore);
+		m_wakeTimer = NULL;
+		m_jobSemaphore = NULL;
+		return -1;
+	}
+	m_running = true;
+	for (int i = 0; i < m_workerCount; i++)
+	{
+		HANDLE worker = CreateThread(NULL, 0, workerThread, this, 0, NULL);
+		if (NULL == worker)
+			break;
+		m_workers.push_back(worker);
+	}
+	m_timer = m_workers.empty() ? NULL : CreateThread(NULL, 0, timerThread, this, 0, NULL);
+	if (NULL == m_timer)
+	{
+		m_running = false;
+		ReleaseSemaphore(m_jobSemaphore, (LONG)m_workers.size() + 1, NULL);
+		for (size_t i = 0; i < m_workers.size(); i++)
+		{
+			WaitForSingleObject(m_workers[i], INFINITE);
+			CloseHandle(m_workers[i]);
+		}
+		m_workers.clear();
+		CloseHandle(m_wakeTimer);
+		CloseHandle(m_jobSemaphore);
+		m_wakeTimer = NULL;
+		m_jobSemaphore = NULL;
+		return -2;
+	}
+	return 0;
+}
+
+DWORD WINAPI FrameIOScheduler::timerThread(LPVOID param)
+{
+	FrameIOScheduler* scheduler = reinterpret_cast<FrameIOScheduler*>(param);
+	if (scheduler)
+		scheduler->doTimer();
+	return 0;
+}
+
+DWORD WINAPI FrameIOScheduler::workerThread(LPVOID param)
+{
+	FrameIOScheduler* scheduler = reinterpret_cast<FrameIOScheduler*>(param);
+	if (scheduler)
+		scheduler->doWork();
+	return 0;
+}
+
+LONGLONG FrameIOScheduler::deadlineOf(const Source& src, LONGLONG pts)
+{
+	//from the epoch every time, the rounding of one frame is not added up.
+	//Whole units of rate.num frames first, ticksPerUnit * pts alone overflows after days
+	const LONGLONG num = src.rate.num;
+	return src.epoch + pts / num * src.ticksPerUnit + ((pts % num) * src.ticksPerUnit + num - 1) / num;
+}
+
+LONGLONG FrameIOScheduler::ptsAt(const Source& src, LONGLONG time)
+{
+	//the last pts whose deadline is not after time, -1 before the epoch
+	const LONGLONG elapsed = time - src.epoch;
+	if (elapsed < 0)
+		return -1;
+	return elapsed / src.ticksPerUnit * src.rate.num + (elapsed % src.ticksPerUnit) * src.rate.num / src.ticksPerUnit;
+}
+
+void FrameIOScheduler::doTimer()
+{
+	while (m_running)
+	{
+		LONGLONG earliest = -1;
+		LONG queuedJobs = 0;
+		EnterCriticalSection(&m_lock);
+		const LONGLONG now = m_clock->now();
+		const LONGLONG freq = m_clock->frequency();
+		for (size_t i = 0; i < m_sources.size(); i++)
+		{
+			Source& src = m_sources[i];
+			//only the newest due frame is read, the ones before it are dropped.
+			//A clock stalled or gone back queues nothing, the frame on the screen is repeated
+			const LONGLONG duePts = ptsAt(src, now);
+			if (duePts >= src.nextPts)
+			{
+				if (src.queued)
+				{
+					//the reader is behind, every frame due is dropped and the read queued goes on
+					src.stats.dropped += duePts - src.nextPts + 1;
+				}
+				else
+				{
+					Job job = { src.client, deadlineOf(src, duePts), duePts };
+					pushJob(job);
+					src.queued = true;
+					src.stats.dropped += duePts - src.nextPts;
+					queuedJobs++;
+				}
+				src.nextPts = duePts + 1;
+			}
+			const LONGLONG deadline = deadlineOf(src, src.nextPts);
+			if (earliest < 0 || deadline < earliest)
+				earliest = deadline;
+		}
+		LeaveCriticalSection(&m_lock);
+		if (queuedJobs > 0)
+			ReleaseSemaphore(m_jobSemaphore, queuedJobs, NULL);
+		DWORD timeout = INFINITE;
+		if (earliest >= 0)
+		{
+			//a master clock slower than the wait wakes the timer early, the next loop waits again
+			const LONGLONG waitTicks = earliest - now;
+			timeout = waitTicks <= 0 ? 0 : (DWORD)((waitTicks * 1000 + freq - 1) / freq);
+		}
+		WaitForSingleObject(m_wakeTimer, timeout);
+	}
+}
+
+void FrameIOScheduler::doWork()
+{
+	for (;;)
+	{
+		WaitForSingleObject(m_jobSemaphore, INFINITE);
+		if (!m_running)
+			break;
+		Job job;
+		if (!popJob(job))
+			continue;
+		const int ret = job.client->serviceFrame(job.pts);
+		EnterCriticalSection(&m_lock);
+		const double latenessMs = (double)(m_clock->now() - job.deadline) * 1000.0 / m_clock->frequency();
+		Source* src = findSource(job.client);
+		if (src)
+		{
+			src->stats.serviced++;
+			if (ret < 0)
+				src->stats.repeated++;
+			src->stats.totalLatenessMs += latenessMs;
+			if (latenessMs > src->stats.maxLatenessMs)
+				src->stats.maxLatenessMs = latenessMs;
+			if (latenessMs > LATE_THRESHOLD_MS)
+				src->stats.late++;
+			src->queued = false;
+			src->running = false;
+		}
+		SetEvent(m_serviceDone);
+		LeaveCriticalSection(&m_lock);
+	}
+}
+
+FrameIOScheduler::Source* FrameIOScheduler::findSource(IFrameIOClient* client)
+{
+	for (size_t i = 0; i < m_sources.size(); i++)
+	{
+		if (m_sources[i].client == client)
+			return &m_sources[i];
+	}
+	return NULL;
+}
+
+const FrameIOScheduler::Source* FrameIOScheduler::findSource(IFrameIOClient* client) const
+{
+	for (size_t i = 0; i < m_sources.size(); i++)
+	{
+		if (m_sources[i].client == client)
+			return &m_sources[i];
+	}
+	return NULL;
+}
+
+void FrameIOScheduler::pushJob(const Job& job)
+{
+	m_jobs.push_back(job);
+	std::push_heap(m_jobs.begin(), m_jobs.end(), LaterDeadline());
+}
+
+bool FrameIOScheduler::popJob(Job& job)
+{
+	EnterCriticalSection(&m_lock);
+	if (m_jobs.empty())
+	{
+		LeaveCriticalSection(&m_lock);
+		return false;
+	}
+	std::pop_heap(m_jobs.begin(), m_jobs.end(), LaterDeadline());
+	job = m_jobs.back();
+	m_jobs.pop_back();
+	//the source stays while running is set, removeSource() waits for it
+	Source* src = findSource(job.client);
+	if (src)
+		src->running = true;
+	LeaveCriticalSection(&m_lock);
+	return src != NULL;
+}
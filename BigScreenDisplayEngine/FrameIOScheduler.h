@@ -0,0 +1,180 @@
+/**
+ *	@name		FrameIOScheduler.h
+ *	@brief		one timer thread and a few worker threads reading the frames of every file source, earliest deadline first
+ */
+#pragma once
+#ifndef _Z_RENDER_FRAME_IO_SCHEDULER_H_
+#define _Z_RENDER_FRAME_IO_SCHEDULER_H_
+
+#include <Windows.h>
+#include <vector>
+
+namespace zRender
+{
+	/**
+	 *	@brief	frames a second as num/den, 30000/1001 for 29.97
+	 **/
+	struct FrameRate
+	{
+		int num;
+		int den;
+
+		FrameRate(int fps = 0, int denominator = 1) : num(fps), den(denominator) {}
+		bool valid() const { return num > 0 && den > 0; }
+	};
+
+	/**
+	 *	@name		IMasterClock
+	 *	@brief		the time all the sources are shown against. Monotonic while playing, may stall or restart, e.g. the clock of the audio
+	 **/
+	class IMasterClock
+	{
+	public:
+		virtual ~IMasterClock() {}
+
+		virtual LONGLONG now() const = 0;
+		/**
+		 *	@brief	ticks of now() a second
+		 **/
+		virtual LONGLONG frequency() const = 0;
+	};
+
+	/**
+	 *	@name		IFrameIOClient
+	 *	@brief		a source whose frames are read by the FrameIOScheduler
+	 **/
+	class IFrameIOClient
+	{
+	public:
+		virtual ~IFrameIOClient() {}
+
+		/**
+		 *	@name		serviceFrame
+		 *	@brief		read the frame with the presentation timestamp pts and hand it to the display.
+		 *				Called on a worker thread, never twice at the same time for one client.
+		 *				The pts go up by one a frame, a jump means the frames between were dropped
+		 *	@param[in]	LONGLONG pts frames of the rate since the epoch the client was added with
+		 *	@return		int 0:success <0:failed, the frame shown before is repeated
+		 **/
+		virtual int serviceFrame(LONGLONG pts) = 0;
+	};
+
+	/**
+	 *	@brief	timing of the frames of one client, lateness is the time from the deadline to the end of serviceFrame()
+	 **/
+	struct FrameIOStats
+	{
+		long long serviced;			//frames read
+		long long late;				//frames finished after their deadline by more than the late threshold
+		long long dropped;			//frames whose time passed while the frame before was still queued or being read
+		long long repeated;			//frames serviceFrame() failed, the frame before stayed on the screen
+		double maxLatenessMs;
+		double totalLatenessMs;		//sum over the serviced frames, divide by serviced for the mean
+
+		FrameIOStats() : serviced(0), late(0), dropped(0), repeated(0), maxLatenessMs(0), totalLatenessMs(0) {}
+	};
+
+	/**
+	 *	@name		FrameIOScheduler
+	 *	@brief		replaces one sleeping reader thread per source. The timer thread queues a read when the pts of a client is due
+	 *				on the master clock, the workers take the queued reads with the earliest deadline first.
+	 *				The deadline of a pts is computed from the epoch of the client, the rounding of one frame is never added up.
+	 *				io_uring and overlapped I/O are not used, a read of a frame is one blocking read on a worker.
+	 **/
+	class FrameIOScheduler
+	{
+	public:
+		enum { DEFAULT_WORKER_COUNT = 4, LATE_THRESHOLD_MS = 2 };
+
+		static FrameIOScheduler& instance();
+
+		/**
+		 *	@name		addSource
+		 *	@brief		serviceFrame() of client is called at rate from now on, the threads start with the first client
+		 *	@param[in]	LONGLONG epoch time of pts 0 on the master clock, <0 for now.
+		 *				Clients added with the same epoch and rate show the same pts at the same time
+		 *	@return		int 0:success <0:the params are invalid or the client is added already
+		 **/
+		int addSource(IFrameIOClient* client, const FrameRate& rate, LONGLONG epoch = -1);
+
+		/**
+		 *	@name		removeSource
+		 *	@brief		stop calling client, returns after a serviceFrame() running on a worker has finished
+		 **/
+		void removeSource(IFrameIOClient* client);
+
+		/**
+		 *	@name		setMasterClock
+		 *	@brief		set before the first addSource(), the epochs are times of this clock. NULL for the performance counter
+		 **/
+		void setMasterClock(IMasterClock* clock);
+		IMasterClock* getMasterClock() const;
+
+		/**
+		 *	@brief	set before the first addSource(), the count of workers reading the frames
+		 **/
+		void setWorkerCount(int count);
+
+		/**
+		 *	@brief	reads queued and not yet taken by a worker
+		 **/
+		int getQueueDepth() const;
+
+		bool getSourceStats(IFrameIOClient* client, FrameIOStats& stats) const;
+
+		/**
+		 *	@brief	stop the threads, the clients are forgotten
+		 **/
+		void shutdown();
+
+	private:
+		FrameIOScheduler();
+		~FrameIOScheduler();
+		FrameIOScheduler(const FrameIOScheduler&);
+		FrameIOScheduler& operator=(const FrameIOScheduler&);
+
+		struct Source
+		{
+			IFrameIOClient* client;
+			LONGLONG epoch;
+			LONGLONG ticksPerUnit;		//ticks of rate.num frames, the frequency of the clock * rate.den
+			FrameRate rate;
+			LONGLONG nextPts;			//the frame whose deadline comes next
+			bool queued;				//a read is in the queue or on a worker
+			bool running;				//serviceFrame() is being called
+			FrameIOStats stats;
+		};
+		struct Job
+		{
+			IFrameIOClient* client;
+			LONGLONG deadline;
+			LONGLONG pts;
+		};
+
+		int startThreads();
+		static DWORD WINAPI timerThread(LPVOID param);
+		static DWORD WINAPI workerThread(LPVOID param);
+		void doTimer();
+		void doWork();
+		static LONGLONG deadlineOf(const Source& src, LONGLONG pts);
+		static LONGLONG ptsAt(const Source& src, LONGLONG time);
+		Source* findSource(IFrameIOClient* client);
+		const Source* findSource(IFrameIOClient* client) const;
+		void pushJob(const Job& job);
+		bool popJob(Job& job);
+
+		mutable CRITICAL_SECTION m_lock;
+		std::vector<Source> m_sources;
+		std::vector<Job> m_jobs;		//heap, earliest deadline on top
+		IMasterClock* m_clock;
+		int m_workerCount;
+		volatile bool m_running;
+		HANDLE m_timer;
+		std::vector<HANDLE> m_workers;
+		HANDLE m_wakeTimer;				//a source was added
+		HANDLE m_jobSemaphore;			//one count per queued job
+		HANDLE m_serviceDone;			//manual reset, set under m_lock when a worker returns from serviceFrame()
+	};
+}
+
+#endif //_Z_RENDER_FRAME_IO_SCHEDULER_H_
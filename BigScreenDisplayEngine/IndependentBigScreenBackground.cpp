@@ -27,7 +27,7 @@ void IndependentBigScreenBackground::splitBackgroundImageForBigscreenCell()
 {
 	if(m_isSplited)
 		return;
-	if(m_decodedData==NULL || m_decodedDataLen==0 || m_regions.size()<=0)
+	if(!m_decodedFrame.valid() || m_regions.size()<=0)
 		return;
 	for(int i=0; i<m_regions.size(); ++i)
 	{
@@ -55,8 +55,8 @@ void IndependentBigScreenBackground::splitBackgroundImageForBigscreenCell()
 			currCellRegion.paintRegion.bottom = currCellRegion.paintRegion.top + m_imageHeight;
 		}
 
-		currCellRegion.pData = m_decodedData;
-		currCellRegion.dataLength = m_decodedDataLen;
+		//ĴͼƬÿԼźһ֡
+		currCellRegion.frame = m_decodedFrame;
 
 		float cellPosLeft = (float)(i % m_bigScreenWidth);
 		float cellPosTop = (float)(i / m_bigScreenWidth); 
@@ -65,9 +65,7 @@ void IndependentBigScreenBackground::splitBackgroundImageForBigscreenCell()
 		currCellRegion.displayReg.top = cellPosTop + currCellRegion.paintRegion.top / (float)currCellRegion.cellHeight;
 		currCellRegion.displayReg.bottom = cellPosTop + currCellRegion.paintRegion.bottom / (float)currCellRegion.cellHeight;
 
-		PictureTextureDataSource* ptds = new RawFrameRefData(m_decodedData,m_decodedDataLen, 
-															m_imageWidth, m_imageHeight, FRAMEPITCH(m_imageWidth, m_pixformat), 
-															m_pixformat);
+		PictureTextureDataSource* ptds = new RawFrameRefData(m_decodedFrame);
 		assert(ptds);
 		currCellRegion.m_dcproviders = new VideoContentProvider(ptds, RECT_f(0, 1.0, 0.0, 1.0));
 	}
@@ -28,7 +28,7 @@ void MergedBigScreenBackground::splitBackgroundImageForBigscreenCell()
 {
 	if(m_isSplited)
 		return;
-	if(m_decodedData==NULL || m_decodedDataLen==0 || m_regions.size()<=0)
+	if(!m_decodedFrame.valid() || m_regions.size()<=0)
 		return;
 	int bigscreenPixelWidth = m_bigScreenWidth * m_regions[0].cellWidth;
 	int bigscreenPixelHeight = m_bigScreenHeight * m_regions[0].cellHeight;
@@ -153,9 +153,7 @@ void MergedBigScreenBackground::splitBackgroundImageForBigscreenCell()
 		currCellRegion.displayReg.top = cellPosTop + currCellRegion.paintRegion.top / (float)currCellRegion.cellHeight;
 		currCellRegion.displayReg.bottom = cellPosTop + currCellRegion.paintRegion.bottom / (float)currCellRegion.cellHeight;
 
-		PictureTextureDataSource* ptds = new RawFrameRefData(m_decodedData,m_decodedDataLen, 
-															m_imageWidth, m_imageHeight, FRAMEPITCH(m_imageWidth, m_pixformat), 
-															m_pixformat);
+		PictureTextureDataSource* ptds = new RawFrameRefData(m_decodedFrame);
 		assert(ptds);
 		RECT_f picEffectiveReg(leftInImageMemory/(float)m_imageWidth, rightInImage/(float)m_imageWidth,
 								topInImageMemory/(float)m_imageHeight, bottomInImage/(float)m_imageHeight);
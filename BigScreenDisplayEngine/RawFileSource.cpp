@@ -1,15 +1,41 @@
 #include "RawFileSource.h"
 #include "BigView.h"
+#include "inc/FrameView.h"
+#include <limits.h>
 
 using namespace zRender;
 using namespace SOA::Mirror::Render;
 
+namespace
+{
+	//frames of the mapping asked in advance, the file cache reads them while the frames before are shown
+	const int PREFETCH_FRAMES = 8;
+
+	typedef struct _PREFETCH_RANGE_ENTRY
+	{
+		PVOID VirtualAddress;
+		SIZE_T NumberOfBytes;
+	} PREFETCH_RANGE_ENTRY;
+	typedef BOOL (WINAPI *pPrefetchVirtualMemory)(HANDLE hProcess, ULONG_PTR NumberOfEntries, PREFETCH_RANGE_ENTRY* VirtualAddresses, ULONG Flags);
+
+	//PrefetchVirtualMemory exists since Windows 8, NULL before
+	pPrefetchVirtualMemory getPrefetchVirtualMemory()
+	{
+		static pPrefetchVirtualMemory prefetch = (pPrefetchVirtualMemory)GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")), "PrefetchVirtualMemory");
+		return prefetch;
+	}
+}
+
 zRender::RawFileSource::RawFileSource(DxRender * dxrender)
 	: m_textureSource(new SharedTextureSource(dxrender))
 	, m_width(0), m_height(0), m_pixfmt(zRender::PIXFMT_UNKNOW)
-	, m_fileStream(NULL), m_thUpdate(NULL), m_thUpdateRunning(false)
-	, m_fps(0)
+	, m_fileStream(NULL), m_started(false)
+	, m_file(INVALID_HANDLE_VALUE), m_fileMapping(NULL), m_mappedData(NULL), m_mappedSize(0)
+	, m_frameLen(0), m_frameCount(0), m_nextFrame(0), m_shownFrame(-1), m_backBuffer(0)
 {
+	//hashed by cacheFrame on the worker that read the frame, one pass over memory it has just touched.
+	//Repeated frames, e.g. slides recorded at a video rate or a short file looped, are not uploaded again
+	m_textureSource->setFingerprintMode(FINGERPRINT_FULL);
 }
 
 zRender::RawFileSource::~RawFileSource()
@@ -23,11 +49,48 @@ zRender::RawFileSource::~RawFileSource()
 	}
 }
 
-bool zRender::RawFileSource::open(const TCHAR * filePathName, zRender::PIXFormat pixfmt, int width, int height)
+bool zRender::RawFileSource::open(const TCHAR * filePathName, zRender::PIXFormat pixfmt, int width, int height, bool mapFile)
+{
+	if (NULL == filePathName)	return false;
+	if (NULL != m_fileStream || NULL != m_mappedData)	return false;
+
+	if (!openFile(filePathName, mapFile))
+		return false;
+	m_width = width;
+	m_height = height;
+	m_pixfmt = pixfmt;
+	m_layout = FrameLayout::create(m_pixfmt, m_width, m_height);
+	m_textureSource->createTexture(m_pixfmt, width, height);
+	return true;
+}
+
+bool zRender::RawFileSource::openContainer(const TCHAR * filePathName, bool mapFile)
 {
 	if (NULL == filePathName)	return false;
-	if (NULL != m_fileStream)	return false;
+	if (NULL != m_fileStream || NULL != m_mappedData)	return false;
+	if (0 != m_index.load(filePathName) || m_index.frameCount() <= 0)
+	{
+		m_index.clear();
+		return false;
+	}
+	if (!openFile(filePathName, mapFile))
+	{
+		m_index.clear();
+		return false;
+	}
+	const RawVideoIndexEntry& first = m_index.frame(0);
+	m_width = first.width;
+	m_height = first.height;
+	m_pixfmt = (PIXFormat)first.pixfmt;
+	m_layout = FrameLayout::create(m_pixfmt, m_width, m_height);
+	m_textureSource->createTexture(m_pixfmt, m_width, m_height);
+	return true;
+}
 
+bool zRender::RawFileSource::openFile(const TCHAR * filePathName, bool mapFile)
+{
+	if (mapFile && openMapped(filePathName))
+		return true;
 	std::ifstream* filestream = new std::ifstream(filePathName, std::ios::binary | std::ios::in);
 	if (NULL == filestream || !(*filestream))
 	{
@@ -35,15 +98,68 @@ bool zRender::RawFileSource::open(const TCHAR * filePathName, zRender::PIXFormat
 		return false;
 	}
 	m_fileStream = filestream;
-	m_width = width;
-	m_height = height;
-	m_pixfmt = pixfmt;
-	m_textureSource->createTexture(m_pixfmt, width, height);
 	return true;
 }
 
+bool zRender::RawFileSource::openMapped(const TCHAR * filePathName)
+{
+	HANDLE file = CreateFile(filePathName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+		return false;
+	LARGE_INTEGER fileSize = { 0 };
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || (unsigned long long)fileSize.QuadPart > (SIZE_T)-1)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	const unsigned char* data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (NULL == data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_file = file;
+	m_fileMapping = mapping;
+	m_mappedData = data;
+	m_mappedSize = fileSize.QuadPart;
+	return true;
+}
+
+void zRender::RawFileSource::closeMapped()
+{
+	if (m_mappedData)
+		UnmapViewOfFile(m_mappedData);
+	if (m_fileMapping)
+		CloseHandle(m_fileMapping);
+	if (INVALID_HANDLE_VALUE != m_file)
+		CloseHandle(m_file);
+	m_mappedData = NULL;
+	m_fileMapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+	m_mappedSize = 0;
+}
+
 void zRender::RawFileSource::close()
 {
+	//a worker may be reading the file
+	stop();
+	if (m_mappedData)
+	{
+		//the texture source holds a view into the mapping and a render thread may be uploading out of it.
+		//cacheFrame takes the lock of the upload, once it returns no thread reads the mapping any more
+		m_textureSource->cacheFrame(FrameView());
+		closeMapped();
+		m_width = 0;
+		m_height = 0;
+		m_pixfmt = PIXFMT_UNKNOW;
+	}
 	if (m_fileStream)
 	{
 		m_fileStream->close();
@@ -53,94 +169,223 @@ void zRender::RawFileSource::close()
 		m_height = 0;
 		m_pixfmt = PIXFMT_UNKNOW;
 	}
+	m_index.clear();
+	m_layout = FrameLayout();
 }
 
-DWORD WINAPI doReadFileAndUpdateTexture(LPVOID param)
+bool zRender::RawFileSource::start(const FrameRate& rate, LONGLONG epoch)
 {
-	RawFileSource* pThis = reinterpret_cast<RawFileSource*>(param);
-	if (pThis) pThis->doReadFileAndUpdateToTexture();
-	return 0;
-}
-bool zRender::RawFileSource::start(int fps)
-{
-	if (NULL != m_thUpdate) return false;
-	if (fps <= 0)	return false;
-	m_thUpdateRunning = true;
-	HANDLE thUpdate = CreateThread(NULL, 0, doReadFileAndUpdateTexture, this, 0, 0);
-	if (NULL == thUpdate)	return false;
-	m_thUpdate = thUpdate;
-	m_fps = fps;
+	if (m_started) return false;
+	const bool isContainer = m_index.frameCount() > 0;
+	const FrameRate playRate = !rate.valid() && isContainer ? m_index.rate() : rate;
+	if (!playRate.valid())	return false;
+	if (NULL == m_fileStream && NULL == m_mappedData)	return false;
+	int frameLen = getFrameSize();
+	if (frameLen <= 0)	return false;
+	long long frameCount = m_index.frameCount();
+	if (isContainer)
+	{
+		//the read buffers hold the biggest frame, the frames too big for the texture are not read anyway
+		frameLen = m_index.maxFrameSize();
+	}
+	else
+	{
+		long long fileSize = m_mappedSize;
+		if (NULL == m_mappedData)
+		{
+			m_fileStream->clear();
+			m_fileStream->seekg(0, std::ios::end);
+			fileSize = m_fileStream->tellg();
+			m_fileStream->seekg(0, std::ios::beg);
+		}
+		//a partial last frame is never shown
+		frameCount = fileSize / frameLen;
+	}
+	if (frameCount <= 0 || frameCount > INT_MAX)	return false;
+	if (NULL == m_mappedData)
+	{
+		//from the FramePool, a frame starts on a page and the source started again reuses the buffers
+		if (!m_readBuffers[0].allocate(frameLen) || !m_readBuffers[1].allocate(frameLen))
+		{
+			m_readBuffers[0].reset();
+			m_readBuffers[1].reset();
+			return false;
+		}
+	}
+	m_frameLen = frameLen;
+	m_frameCount = (int)frameCount;
+	m_nextFrame = 0;
+	m_shownFrame = -1;
+	m_backBuffer = 0;
+	m_rate = playRate;
+	if (m_mappedData)
+		prefetchFrames(0);
+	if (0 != FrameIOScheduler::instance().addSource(this, playRate, epoch))
+	{
+		m_readBuffers[0].reset();
+		m_readBuffers[1].reset();
+		return false;
+	}
+	m_started = true;
 	return true;
 }
 
 void zRender::RawFileSource::stop()
 {
-	if (NULL == m_thUpdate) return;
-	m_thUpdateRunning = false;
-	WaitForSingleObject(m_thUpdate, INFINITE);
-	CloseHandle(m_thUpdate);
-	m_thUpdate = NULL;
+	if (!m_started) return;
+	//returns after a read running on a worker has finished, serviceFrame() is not called again
+	FrameIOScheduler::instance().removeSource(this);
+	m_started = false;
+	if (m_readBuffers[0].valid())
+	{
+		//the texture source holds a pointer to one of the buffers
+		m_textureSource->cacheFrame(FrameView());
+		m_readBuffers[0].reset();
+		m_readBuffers[1].reset();
+	}
 }
 
-void zRender::RawFileSource::doReadFileAndUpdateToTexture()
+//A headerless file holds frames of FrameLayout::create(): 4:2:0 chroma planes of (w+1)/2 x (h+1)/2, as the Y4M export and
+//RawVideoWriter write them. The stride used before counted w/2 x h/2 chroma samples, so a file of odd width or height was read
+//shifted by a part of a frame per frame and the view of its last frame ended past the mapping. Even sizes are unchanged
+int zRender::RawFileSource::getFrameSize() const
 {
-	if (NULL == m_fileStream || m_fps<=0)	return;
-	if (m_fileStream->eof())	return;
-	int duration = 1000 / m_fps;
-	if (duration <= 0)
-		return;
-	size_t frameLen = 0;
-	int pitch = 0;
-	int idt = 0;
 	switch (m_pixfmt)
 	{
-	case zRender::PIXFMT_UNKNOW:
-		return;
 	case zRender::PIXFMT_YUV420P:
-		pitch = m_width;
-		frameLen = pitch * m_height + (pitch / 2) * (m_height >> 1) * 2;
-		break;
 	case zRender::PIXFMT_YUY2:
-		pitch = m_width * 2;
-		frameLen = pitch * m_height;
-		break;
 	case zRender::PIXFMT_R8G8B8:
-		pitch = m_width * 3;
-		frameLen = pitch * m_height;
-		break;
 	case zRender::PIXFMT_NV12:
-		pitch = m_width;
-		frameLen = pitch * m_height + pitch * (m_height >> 1);
-		break;
 	case zRender::PIXFMT_YV12:
-		pitch = m_width;
-		frameLen = pitch * m_height + pitch * (m_height >> 1);
-		break;
 	case zRender::PIXFMT_A8R8G8B8:
 	case zRender::PIXFMT_X8R8G8B8:
 	case zRender::PIXFMT_R8G8B8A8:
 	case zRender::PIXFMT_B8G8R8A8:
 	case zRender::PIXFMT_B8G8R8X8:
-		pitch = m_width * 4;
-		frameLen = pitch * m_height;
-		break;
+		return m_layout.size();
+	case zRender::PIXFMT_UNKNOW:
 	default:
-		return;
+		return 0;
 	}
-	unsigned char* pOneFrame = (unsigned char*)malloc(frameLen);
-	while (m_thUpdateRunning)
+}
+
+int zRender::RawFileSource::serviceFrame(LONGLONG pts)
+{
+	if (pts < 0 || m_frameCount <= 0)
+		return -1;
+	int frame = 0;
+	if (m_index.frameCount() > 0)
 	{
-		if (!(*m_fileStream))
+		//the pts of a container may skip numbers, the frame before a gap stays on the screen
+		frame = m_index.findFrame(pts % m_index.duration());
+		if (frame < 0)
+			return -1;
+		if (frame == m_shownFrame)
+			return 0;
+		const RawVideoIndexEntry& entry = m_index.frame(frame);
+		if (entry.pixfmt != m_pixfmt || (int)entry.width != m_width || (int)entry.height != m_height)
 		{
-			m_fileStream->clear();
-			m_fileStream->seekg(0, std::ios::beg);
+			//the texture follows the frames, the render threads open the new one at their next update.
+			//The read buffers hold the biggest frame of the container already
+			if (0 != m_textureSource->createTexture((PIXFormat)entry.pixfmt, (int)entry.width, (int)entry.height))
+				return -1;
+			m_pixfmt = (PIXFormat)entry.pixfmt;
+			m_width = (int)entry.width;
+			m_height = (int)entry.height;
+			m_layout = FrameLayout::create(m_pixfmt, m_width, m_height);
 		}
-		m_fileStream->read((char*)pOneFrame, frameLen);
-		//m_textureSource->copyDataToTexture(RECT_f(0, 1, 0, 1), pOneFrame, pitch, m_height, ++idt);	
-		m_textureSource->cacheData(RECT_f(0, 1, 0, 1), pOneFrame, pitch, m_width, m_height);
-		Sleep(duration);
 	}
-	free(pOneFrame);
+	else
+	{
+		frame = (int)(pts % m_frameCount);
+	}
+	if (m_mappedData)
+		return serviceMapped(frame);
+	if (m_fileStream && m_readBuffers[0].valid())
+		return serviceStream(frame);
+	return -1;
+}
+
+bool zRender::RawFileSource::frameAt(int frame, long long& offset, int& len) const
+{
+	if (frame < 0 || frame >= m_frameCount)
+		return false;
+	if (m_index.frameCount() > 0)
+	{
+		offset = m_index.frame(frame).offset;
+		len = m_index.frame(frame).size;
+	}
+	else
+	{
+		offset = (long long)frame * m_frameLen;
+		len = m_frameLen;
+	}
+	return true;
+}
+
+void zRender::RawFileSource::prefetchFrames(int firstFrame)
+{
+	pPrefetchVirtualMemory prefetch = getPrefetchVirtualMemory();
+	const int lastFrame = firstFrame + PREFETCH_FRAMES < m_frameCount ? firstFrame + PREFETCH_FRAMES - 1 : m_frameCount - 1;
+	long long firstOffset = 0, lastOffset = 0;
+	int firstLen = 0, lastLen = 0;
+	if (NULL == prefetch || !frameAt(firstFrame, firstOffset, firstLen) || !frameAt(lastFrame, lastOffset, lastLen))
+		return;
+	PREFETCH_RANGE_ENTRY range;
+	range.VirtualAddress = (PVOID)(m_mappedData + firstOffset);
+	range.NumberOfBytes = (SIZE_T)(lastOffset + lastLen - firstOffset);
+	prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+
+int zRender::RawFileSource::serviceMapped(int frame)
+{
+	const int frameCount = m_frameCount;
+	long long offset = 0;
+	int len = 0;
+	if (!frameAt(frame, offset, len))
+		return -1;
+	//one prefetch every PREFETCH_FRAMES frames, for the batch after the one being shown.
+	//Frames dropped may jump over the frame prefetching, the batch of the new frame is asked for then
+	if (frame != m_nextFrame)
+		prefetchFrames(frame);
+	else if (frame % PREFETCH_FRAMES == 0)
+		prefetchFrames(frame + PREFETCH_FRAMES < frameCount ? frame + PREFETCH_FRAMES : 0);
+	unsigned char* pOneFrame = const_cast<unsigned char*>(m_mappedData + offset);
+	m_textureSource->cacheFrame(FrameView::wrap(pOneFrame, m_layout));
+	publishFrame(FrameView::wrap(pOneFrame, m_layout), frame);
+	//loop without reopening, the first frames are still mapped
+	m_nextFrame = frame + 1 < frameCount ? frame + 1 : 0;
+	m_shownFrame = frame;
+	return 0;
+}
+
+int zRender::RawFileSource::serviceStream(int frame)
+{
+	long long offset = 0;
+	int len = 0;
+	if (!frameAt(frame, offset, len))
+		return -1;
+	//read into the buffer not shown, the shown frame is never written while the renderer copies it
+	unsigned char* pOneFrame = m_readBuffers[m_backBuffer].data();
+	if (frame != m_nextFrame || m_index.frameCount() > 0 || !(*m_fileStream))
+	{
+		//frames dropped, the loop back to the first frame or the padding between the frames of a container
+		m_fileStream->clear();
+		m_fileStream->seekg(offset, std::ios::beg);
+	}
+	m_fileStream->read((char*)pOneFrame, len);
+	if (m_fileStream->gcount() != len)
+	{
+		//the frame shown before stays, the next pts seeks again
+		m_nextFrame = -1;
+		return -1;
+	}
+	m_textureSource->cacheFrame(FrameView::wrap(pOneFrame, m_layout));
+	publishFrame(FrameView::wrap(pOneFrame, m_layout), frame);
+	m_backBuffer ^= 1;
+	m_nextFrame = frame + 1 < m_frameCount ? frame + 1 : 0;
+	m_shownFrame = frame;
+	return 0;
 }
 
 SOA::Mirror::Render::BigView * zRender::RawFileSource::createSourceView()
@@ -150,10 +395,48 @@ SOA::Mirror::Render::BigView * zRender::RawFileSource::createSourceView()
 	return srcview;
 }
 
+SOA::Mirror::Render::BigView * zRender::RawFileSource::createMultiplexedView(const zRender::RECT_f & effectiveReg, zRender::PIXFormat pixfmt)
+{
+	//the last frame published is given to the view at once, converted if need be
+	MultiplexedSource* source = m_multiplexer.subscribe(effectiveReg, pixfmt);
+	if (NULL == source)
+		return NULL;
+	SOA::Mirror::Render::BigView* srcview = new SOA::Mirror::Render::BigView(zRender::RECT_f(0, 1, 0, 1));
+	if (!srcview->attachTextureSource(source))
+	{
+		delete srcview;
+		m_multiplexer.unsubscribe(source);
+		return NULL;
+	}
+	MultiplexedView multiplexed = { srcview, source };
+	m_multiplexedViews.push_back(multiplexed);
+	return srcview;
+}
+
 void zRender::RawFileSource::releaseSourceView(SOA::Mirror::Render::BigView ** srcView)
 {
 	if (srcView == NULL)	return;
 	SOA::Mirror::Render::BigView* psrcview = *srcView;
+	MultiplexedSource* source = NULL;
+	for (size_t i = 0; i < m_multiplexedViews.size(); i++)
+	{
+		if (m_multiplexedViews[i].view == psrcview)
+		{
+			source = m_multiplexedViews[i].source;
+			m_multiplexedViews.erase(m_multiplexedViews.begin() + i);
+			break;
+		}
+	}
+	//the BigView lets its source go first, the multiplexer deletes it then
 	delete psrcview;
+	if (source)
+		m_multiplexer.unsubscribe(source);
 	*srcView = NULL;
 }
+
+void zRender::RawFileSource::publishFrame(const FrameView & frame, int frameIndex)
+{
+	//nothing to convert nor copy while no view is multiplexed
+	if (m_multiplexer.getViewCount() > 0)
+		m_multiplexer.publish(frame, frameIndex);
+}
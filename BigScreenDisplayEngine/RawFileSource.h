@@ -3,7 +3,13 @@
 #define _Z_RENDER_RAW_FILE_SOURCE_H_
 
 #include "inc/SharedTextureSource.h"
+#include "FrameIOScheduler.h"
+#include "RawVideoContainer.h"
+#include "inc/FramePool.h"
+#include "inc/FrameLayout.h"
+#include "inc/FrameMultiplexer.h"
 #include <fstream>
+#include <vector>
 
 namespace SOA
 {
@@ -20,33 +26,101 @@ namespace zRender
 {
 	class DxRender;
 
-	class RawFileSource
+	/**
+	 *	@brief	the frames are read on the workers of the FrameIOScheduler, no thread per source
+	 **/
+	class RawFileSource : public IFrameIOClient
 	{
 	public:
 		RawFileSource(DxRender* dxrender);
 		~RawFileSource();
 
-		bool open(const TCHAR* filePathName, zRender::PIXFormat pixfmt, int width, int height);
+		/**
+		 *	@brief	open a file of raw frames. When mapFile the whole file is mapped into memory and the frames are handed
+		 *			to the texture source straight out of the mapping, no read and no copy per frame.
+		 *			Falls back to reading the file when the mapping fails, e.g. a file too big for a 32 bits process
+		 **/
+		bool open(const TCHAR* filePathName, zRender::PIXFormat pixfmt, int width, int height, bool mapFile = false);
+		/**
+		 *	@brief	open a file written by RawVideoWriter, the format and size are read from it. The texture has the size of the first frame
+		 *			and is created again on the worker for a later frame of another format or size
+		 **/
+		bool openContainer(const TCHAR* filePathName, bool mapFile = false);
 		void close();
+		bool isMapped() const { return m_mappedData != NULL; }
+		const RawVideoIndex& getIndex() const { return m_index; }
 
-		bool start(int fps);
+		/**
+		 *	@brief	show the frames at rate, 30000/1001 for 29.97. Frame n of the file is shown at epoch + n / rate of the master clock
+		 *			of the FrameIOScheduler, looping at the end of the file. Frames are dropped to catch up when the reads are behind.
+		 *			Sources started with the same epoch, rate and length stay on the same frame however long they loop.
+		 *			A container is shown at the pts of its index, an invalid rate takes the rate of the container
+		 *	@param[in]	LONGLONG epoch <0 for now
+		 **/
+		bool start(const FrameRate& rate, LONGLONG epoch = -1);
 		void stop();
-		void doReadFileAndUpdateToTexture();
+
+		/**
+		 *	@brief	hand the next frame to the texture source, called by the FrameIOScheduler at the frame rate
+		 **/
+		virtual int serviceFrame(LONGLONG pts);
 
 		SOA::Mirror::Render::BigView* createSourceView();
+		/**
+		 *	@brief	a view of the region effectiveReg of the frames in pixfmt, PIXFMT_UNKNOW for the format of the file.
+		 *			The views are fed by a FrameMultiplexer: every frame is converted once per format on the worker that read it,
+		 *			e.g. a YUV file shown in PIXFMT_B8G8R8X8 thumbnails, and the render threads upload the frames from memory
+		 **/
+		SOA::Mirror::Render::BigView* createMultiplexedView(const zRender::RECT_f& effectiveReg, zRender::PIXFormat pixfmt = zRender::PIXFMT_UNKNOW);
 		void releaseSourceView(SOA::Mirror::Render::BigView** srcView);
+		FrameMultiplexerStats getMultiplexerStats() const { return m_multiplexer.getStats(); }
+
+		/**
+		 *	@brief	for files of mostly still content, e.g. recorded desktops or slides. The tiles of every frame are hashed on the worker
+		 *			that read it, only the tiles changed since the frame before are uploaded and a frame without change is not uploaded
+		 **/
+		void enableDamageDetection(bool enable) { m_textureSource->enableDamageDetection(enable); }
 
 		zRender::SharedTextureSource* getTextureSource() const { return m_textureSource; }
 	private:
+		bool openFile(const TCHAR* filePathName, bool mapFile);
+		bool openMapped(const TCHAR* filePathName);
+		void closeMapped();
+		int getFrameSize() const;
+		bool frameAt(int frame, long long& offset, int& len) const;
+		void prefetchFrames(int firstFrame);
+		int serviceMapped(int frame);
+		int serviceStream(int frame);
+		void publishFrame(const FrameView& frame, int frameIndex);
+
+		struct MultiplexedView
+		{
+			SOA::Mirror::Render::BigView* view;
+			MultiplexedSource* source;
+		};
+
 		zRender::SharedTextureSource* m_textureSource;
 
 		std::ifstream* m_fileStream;
+		HANDLE m_file;
+		HANDLE m_fileMapping;
+		const unsigned char* m_mappedData;
+		long long m_mappedSize;
 		int m_width;
 		int m_height;
 		zRender::PIXFormat m_pixfmt;
-		HANDLE m_thUpdate;
-		bool m_thUpdateRunning;
-		int m_fps;
+		bool m_started;
+		FrameRate m_rate;
+		int m_frameLen;
+		int m_frameCount;
+		FrameLayout m_layout;				//of every frame, the planes follow each other without padding
+		int m_nextFrame;					//frame of the file following the one shown, a pts on another frame seeks
+		int m_shownFrame;
+		RawVideoIndex m_index;				//empty for a headerless file
+		FrameBuffer m_readBuffers[2];		//the frame shown and the one being read
+		int m_backBuffer;
+		FrameMultiplexer m_multiplexer;		//the views of createMultiplexedView(), they hold copies so the buffers above stay free to reuse
+		std::vector<MultiplexedView> m_multiplexedViews;
 	};
 }
 
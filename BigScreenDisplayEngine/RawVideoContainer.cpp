@@ -0,0 +1,319 @@
+#include "RawVideoContainer.h"
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace zRender;
+
+namespace
+{
+	const char RAW_VIDEO_MAGIC[8] = { 'Z', 'R', 'A', 'W', 'V', 'I', 'D', '\0' };
+	const int Y4M_MAX_LINE = 1024;
+
+	unsigned long long alignOffset(unsigned long long offset)
+	{
+		return (offset + RAW_VIDEO_FRAME_ALIGN - 1) / RAW_VIDEO_FRAME_ALIGN * RAW_VIDEO_FRAME_ALIGN;
+	}
+
+	bool pts_less(long long pts, const RawVideoIndexEntry& entry)
+	{
+		return pts < entry.pts;
+	}
+
+	/**
+	 *	@brief	read up to '\n', the '\n' is not kept. false at the end of the file or for a line too long
+	 **/
+	bool readLine(std::ifstream& file, char* line, int maxLen)
+	{
+		int len = 0;
+		for (;;)
+		{
+			const int c = file.get();
+			if (c == EOF)
+				return false;
+			if (c == '\n')
+				break;
+			if (len + 1 >= maxLen)
+				return false;
+			line[len++] = (char)c;
+		}
+		line[len] = '\0';
+		return true;
+	}
+}
+
+RawVideoIndex::RawVideoIndex()
+	: m_maxFrameSize(0), m_ptsAreIndexes(true)
+{
+}
+
+void RawVideoIndex::clear()
+{
+	m_entries.clear();
+	m_rate = FrameRate();
+	m_maxFrameSize = 0;
+	m_ptsAreIndexes = true;
+}
+
+int RawVideoIndex::load(const TCHAR* filePathName)
+{
+	clear();
+	if (NULL == filePathName)
+		return -1;
+	std::ifstream file(filePathName, std::ios::binary | std::ios::in);
+	if (!file)
+		return -1;
+	RawVideoFileHeader header;
+	file.read((char*)&header, sizeof(header));
+	if (file.gcount() != sizeof(header) || 0 != memcmp(header.magic, RAW_VIDEO_MAGIC, sizeof(RAW_VIDEO_MAGIC))
+		|| header.version != RAW_VIDEO_VERSION || header.headerSize < sizeof(header)
+		|| header.rateNum == 0 || header.rateDen == 0 || header.rateNum > INT_MAX || header.rateDen > INT_MAX
+		|| header.indexOffset < header.headerSize)
+		return -2;
+	std::vector<RawVideoIndexEntry> entries(header.frameCount);
+	file.seekg((std::streamoff)header.indexOffset, std::ios::beg);
+	if (!entries.empty())
+		file.read((char*)&entries[0], sizeof(RawVideoIndexEntry) * entries.size());
+	if (!file || file.gcount() != (std::streamsize)(sizeof(RawVideoIndexEntry) * entries.size()))
+		return -3;
+	int maxFrameSize = 0;
+	bool ptsAreIndexes = true;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const RawVideoIndexEntry& entry = entries[i];
+		const PIXFormat pixfmt = (PIXFormat)entry.pixfmt;
+		if (!isKnownPixelFormat(pixfmt) || entry.width == 0 || entry.height == 0 || entry.width > INT_MAX || entry.height > INT_MAX
+			|| entry.size != (unsigned int)FRAMESIZE(entry.width, entry.height, pixfmt)
+			|| entry.offset < header.headerSize || entry.offset + entry.size > header.indexOffset
+			|| (i > 0 && entry.pts <= entries[i - 1].pts))
+			return -3;
+		if ((int)entry.size > maxFrameSize)
+			maxFrameSize = (int)entry.size;
+		if (entry.pts != (long long)i)
+			ptsAreIndexes = false;
+	}
+	m_entries.swap(entries);
+	m_rate = FrameRate((int)header.rateNum, (int)header.rateDen);
+	m_maxFrameSize = maxFrameSize;
+	m_ptsAreIndexes = ptsAreIndexes;
+	return 0;
+}
+
+long long RawVideoIndex::duration() const
+{
+	return m_entries.empty() ? 0 : m_entries.back().pts + 1;
+}
+
+int RawVideoIndex::findFrame(long long pts) const
+{
+	if (m_entries.empty() || pts < m_entries[0].pts)
+		return -1;
+	if (m_ptsAreIndexes)
+		return pts < (long long)m_entries.size() ? (int)pts : (int)m_entries.size() - 1;
+	std::vector<RawVideoIndexEntry>::const_iterator it = std::upper_bound(m_entries.begin(), m_entries.end(), pts, pts_less);
+	return (int)(it - m_entries.begin()) - 1;
+}
+
+RawVideoWriter::RawVideoWriter()
+	: m_writeOffset(0)
+{
+}
+
+RawVideoWriter::~RawVideoWriter()
+{
+	close();
+}
+
+int RawVideoWriter::open(const TCHAR* filePathName, const FrameRate& rate)
+{
+	if (NULL == filePathName || !rate.valid())
+		return -1;
+	if (m_file.is_open())
+		return -2;
+	m_file.open(filePathName, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (!m_file)
+		return -3;
+	//the header without the index, a file not closed is not loaded
+	RawVideoFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RAW_VIDEO_MAGIC, sizeof(RAW_VIDEO_MAGIC));
+	header.version = RAW_VIDEO_VERSION;
+	header.headerSize = sizeof(header);
+	header.rateNum = rate.num;
+	header.rateDen = rate.den;
+	m_file.write((const char*)&header, sizeof(header));
+	if (!m_file)
+	{
+		m_file.close();
+		return -4;
+	}
+	m_rate = rate;
+	m_entries.clear();
+	m_writeOffset = sizeof(header);
+	return 0;
+}
+
+int RawVideoWriter::writeFrame(long long pts, PIXFormat pixfmt, int width, int height, const unsigned char* data, int dataLen)
+{
+	if (!m_file.is_open())
+		return -1;
+	const int size = FRAMESIZE(width, height, pixfmt);
+	if (NULL == data || size <= 0 || dataLen < size || (!m_entries.empty() && pts <= m_entries.back().pts))
+		return -2;
+	static const char padding[RAW_VIDEO_FRAME_ALIGN] = { 0 };
+	const unsigned long long offset = alignOffset(m_writeOffset);
+	m_file.write(padding, (std::streamsize)(offset - m_writeOffset));
+	m_file.write((const char*)data, size);
+	if (!m_file)
+		return -3;
+	RawVideoIndexEntry entry;
+	entry.offset = offset;
+	entry.pts = pts;
+	entry.pixfmt = pixfmt;
+	entry.width = width;
+	entry.height = height;
+	entry.size = size;
+	m_entries.push_back(entry);
+	m_writeOffset = offset + size;
+	return 0;
+}
+
+int RawVideoWriter::close()
+{
+	if (!m_file.is_open())
+		return 0;
+	if (!m_entries.empty())
+		m_file.write((const char*)&m_entries[0], sizeof(RawVideoIndexEntry) * m_entries.size());
+	RawVideoFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RAW_VIDEO_MAGIC, sizeof(RAW_VIDEO_MAGIC));
+	header.version = RAW_VIDEO_VERSION;
+	header.headerSize = sizeof(header);
+	header.rateNum = m_rate.num;
+	header.rateDen = m_rate.den;
+	header.frameCount = (unsigned int)m_entries.size();
+	header.indexOffset = m_writeOffset;
+	m_file.seekp(0, std::ios::beg);
+	m_file.write((const char*)&header, sizeof(header));
+	const bool written = !!m_file;
+	m_file.close();
+	m_entries.clear();
+	m_writeOffset = 0;
+	return written ? 0 : -1;
+}
+
+int zRender::importY4M(const TCHAR* y4mPathName, const TCHAR* containerPathName)
+{
+	if (NULL == y4mPathName || NULL == containerPathName)
+		return -1;
+	std::ifstream y4m(y4mPathName, std::ios::binary | std::ios::in);
+	if (!y4m)
+		return -1;
+	char line[Y4M_MAX_LINE];
+	if (!readLine(y4m, line, sizeof(line)) || 0 != strncmp(line, "YUV4MPEG2 ", 10))
+		return -2;
+	int width = 0, height = 0, rateNum = 0, rateDen = 0;
+	bool is420 = true;
+	char* context = NULL;
+	for (char* token = strtok_s(line + 10, " ", &context); token; token = strtok_s(NULL, " ", &context))
+	{
+		switch (token[0])
+		{
+		case 'W': width = atoi(token + 1); break;
+		case 'H': height = atoi(token + 1); break;
+		case 'F':
+			if (2 != sscanf_s(token + 1, "%d:%d", &rateNum, &rateDen))
+				return -2;
+			break;
+		case 'C':
+			//4:2:0 whatever the siting, the samples are the same
+			is420 = 0 == strcmp(token, "C420") || 0 == strcmp(token, "C420jpeg")
+				|| 0 == strcmp(token, "C420paldv") || 0 == strcmp(token, "C420mpeg2");
+			break;
+		default:
+			//interlacing, aspect and comments do not change the samples
+			break;
+		}
+	}
+	if (width <= 0 || height <= 0 || rateNum <= 0 || rateDen <= 0)
+		return -2;
+	if (!is420)
+		return -3;
+	const int frameLen = FRAMESIZE(width, height, PIXFMT_YUV420P);
+	std::vector<unsigned char> frame(frameLen);
+	RawVideoWriter writer;
+	if (0 != writer.open(containerPathName, FrameRate(rateNum, rateDen)))
+		return -1;
+	for (long long pts = 0; readLine(y4m, line, sizeof(line)); pts++)
+	{
+		//FRAME may have params of its own, none of them change the samples
+		if (0 != strncmp(line, "FRAME", 5))
+			return -2;
+		y4m.read((char*)&frame[0], frameLen);
+		if (y4m.gcount() != frameLen)
+			break;
+		if (0 != writer.writeFrame(pts, PIXFMT_YUV420P, width, height, &frame[0], frameLen))
+			return -4;
+	}
+	return 0 == writer.close() ? 0 : -4;
+}
+
+int zRender::exportY4M(const TCHAR* containerPathName, const TCHAR* y4mPathName)
+{
+	if (NULL == containerPathName || NULL == y4mPathName)
+		return -1;
+	RawVideoIndex index;
+	const int ret = index.load(containerPathName);
+	if (-1 == ret)
+		return -1;
+	if (0 != ret || index.frameCount() <= 0)
+		return -2;
+	const RawVideoIndexEntry& first = index.frame(0);
+	for (int i = 0; i < index.frameCount(); i++)
+	{
+		const RawVideoIndexEntry& entry = index.frame(i);
+		if ((entry.pixfmt != PIXFMT_YUV420P && entry.pixfmt != PIXFMT_YV12) || entry.width != first.width || entry.height != first.height)
+			return -3;
+	}
+	std::ifstream container(containerPathName, std::ios::binary | std::ios::in);
+	std::ofstream y4m(y4mPathName, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (!container || !y4m)
+		return -1;
+	char line[Y4M_MAX_LINE];
+	sprintf_s(line, sizeof(line), "YUV4MPEG2 W%u H%u F%d:%d Ip A1:1 C420jpeg\n", first.width, first.height, index.rate().num, index.rate().den);
+	y4m.write(line, strlen(line));
+	const PixelFormatDesc& desc = PixelFormatDescs[PIXFMT_YUV420P];
+	const int lumaLen = getPlaneRowBytes(desc.planes[0], first.width) * getPlaneRows(desc.planes[0], first.height);
+	const int chromaLen = getPlaneRowBytes(desc.planes[1], first.width) * getPlaneRows(desc.planes[1], first.height);
+	std::vector<unsigned char> frame(first.size);
+	for (int i = 0; i < index.frameCount(); i++)
+	{
+		const RawVideoIndexEntry& entry = index.frame(i);
+		container.seekg((std::streamoff)entry.offset, std::ios::beg);
+		container.read((char*)&frame[0], entry.size);
+		if (container.gcount() != (std::streamsize)entry.size)
+			return -2;
+		//y4m has one frame per period, a gap in the pts repeats the frame
+		const long long repeat = i + 1 < index.frameCount() ? index.frame(i + 1).pts - entry.pts : 1;
+		for (long long r = 0; r < repeat; r++)
+		{
+			y4m.write("FRAME\n", 6);
+			y4m.write((const char*)&frame[0], lumaLen);
+			if (entry.pixfmt == PIXFMT_YV12)
+			{
+				//the planes of YV12 are Y V U
+				y4m.write((const char*)&frame[lumaLen + chromaLen], chromaLen);
+				y4m.write((const char*)&frame[lumaLen], chromaLen);
+			}
+			else
+			{
+				y4m.write((const char*)&frame[lumaLen], chromaLen * 2);
+			}
+		}
+		if (!y4m)
+			return -4;
+	}
+	return 0;
+}
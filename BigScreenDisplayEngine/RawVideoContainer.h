@@ -0,0 +1,146 @@
+/**
+ *	@name		RawVideoContainer.h
+ *	@brief		file of raw frames with a header and an index of the frames, the format and size of every frame are in the index
+ */
+#pragma once
+#ifndef _Z_RENDER_RAW_VIDEO_CONTAINER_H_
+#define _Z_RENDER_RAW_VIDEO_CONTAINER_H_
+
+#include "DxRenderCommon.h"
+#include "FrameIOScheduler.h"
+#include <fstream>
+#include <vector>
+
+namespace zRender
+{
+	/**
+	 *	@brief	layout of the file, little endian:
+	 *			RawVideoFileHeader, the frames each starting on RAW_VIDEO_FRAME_ALIGN bytes, the index of frameCount RawVideoIndexEntry at indexOffset.
+	 *			The rows of a frame are FRAMEPITCH bytes, the planes follow each other, as in the headerless raw files
+	 **/
+	enum
+	{
+		RAW_VIDEO_VERSION = 1,
+		RAW_VIDEO_FRAME_ALIGN = 4096,		//a frame of a mapped file starts on a page
+	};
+
+#pragma pack(push, 1)
+	struct RawVideoFileHeader
+	{
+		char magic[8];						//"ZRAWVID\0"
+		unsigned int version;
+		unsigned int headerSize;			//sizeof(RawVideoFileHeader), the frames are after it
+		unsigned int rateNum;
+		unsigned int rateDen;
+		unsigned int frameCount;
+		unsigned int reserved;
+		unsigned long long indexOffset;		//0 while the file is written
+	};
+
+	struct RawVideoIndexEntry
+	{
+		unsigned long long offset;
+		long long pts;						//frames of the rate, increasing
+		unsigned int pixfmt;
+		unsigned int width;
+		unsigned int height;
+		unsigned int size;
+	};
+#pragma pack(pop)
+
+	/**
+	 *	@name		RawVideoIndex
+	 *	@brief		the header and the index of a file, the frames are read by the caller at the offsets of the index
+	 **/
+	class RawVideoIndex
+	{
+	public:
+		RawVideoIndex();
+
+		/**
+		 *	@return		int 0:success -1:the file can not be read -2:not a file of this format -3:the index is damaged
+		 **/
+		int load(const TCHAR* filePathName);
+		void clear();
+
+		int frameCount() const { return (int)m_entries.size(); }
+		const RawVideoIndexEntry& frame(int index) const { return m_entries[index]; }
+		FrameRate rate() const { return m_rate; }
+
+		/**
+		 *	@brief	pts after the last frame, the length of one loop
+		 **/
+		long long duration() const;
+
+		/**
+		 *	@name		findFrame
+		 *	@brief		the frame shown at pts, the last one whose pts is not after it.
+		 *				Constant time when the pts are the frame numbers, a binary search over the index otherwise
+		 *	@return		int index of the frame, -1 before the first frame
+		 **/
+		int findFrame(long long pts) const;
+
+		/**
+		 *	@brief	bytes of the biggest frame, a read buffer of this size holds every frame
+		 **/
+		int maxFrameSize() const { return m_maxFrameSize; }
+
+	private:
+		std::vector<RawVideoIndexEntry> m_entries;
+		FrameRate m_rate;
+		int m_maxFrameSize;
+		bool m_ptsAreIndexes;
+	};
+
+	/**
+	 *	@name		RawVideoWriter
+	 *	@brief		writes the frames as they come, the index at close()
+	 **/
+	class RawVideoWriter
+	{
+	public:
+		RawVideoWriter();
+		~RawVideoWriter();
+
+		int open(const TCHAR* filePathName, const FrameRate& rate);
+
+		/**
+		 *	@name		writeFrame
+		 *	@brief		append a frame, the format and size may change from one frame to the next
+		 *	@param[in]	const unsigned char* data FRAMESIZE(width, height, pixfmt) bytes, rows of FRAMEPITCH bytes
+		 *	@param[in]	long long pts greater than the pts of the frame before
+		 *	@return		int 0:success <0:failed
+		 **/
+		int writeFrame(long long pts, PIXFormat pixfmt, int width, int height, const unsigned char* data, int dataLen);
+
+		/**
+		 *	@brief	write the index and the header, the file is not readable without it
+		 **/
+		int close();
+
+	private:
+		RawVideoWriter(const RawVideoWriter&);
+		RawVideoWriter& operator=(const RawVideoWriter&);
+
+		std::ofstream m_file;
+		std::vector<RawVideoIndexEntry> m_entries;
+		FrameRate m_rate;
+		unsigned long long m_writeOffset;
+	};
+
+	/**
+	 *	@name		importY4M
+	 *	@brief		convert a YUV4MPEG2 file of 4:2:0 frames into a file of this format, the frames become PIXFMT_YUV420P
+	 *	@return		int 0:success -1:the files can not be opened -2:bad header -3:chroma other than 4:2:0 -4:write failed
+	 **/
+	int importY4M(const TCHAR* y4mPathName, const TCHAR* containerPathName);
+
+	/**
+	 *	@name		exportY4M
+	 *	@brief		write the frames of a file of this format as YUV4MPEG2 4:2:0, only PIXFMT_YUV420P and PIXFMT_YV12 frames of one size
+	 *	@return		int 0:success -1:the files can not be opened -2:bad container -3:a frame of another format or size -4:write failed
+	 **/
+	int exportY4M(const TCHAR* containerPathName, const TCHAR* y4mPathName);
+}
+
+#endif //_Z_RENDER_RAW_VIDEO_CONTAINER_H_
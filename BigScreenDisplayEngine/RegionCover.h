@@ -0,0 +1,73 @@
+/**
+ *	@name		RegionCover.h
+ *	@brief		whether a region is hidden by the union of opaque regions, the regions of RegionGrid cut one by another
+ */
+#pragma once
+#ifndef _SOA_MIRROR_RENDER_REGION_COVER_H_
+#define _SOA_MIRROR_RENDER_REGION_COVER_H_
+
+#include "DxRenderCommon.h"
+#include <stddef.h>
+#include <vector>
+
+namespace SOA
+{
+namespace Mirror
+{
+namespace Render
+{
+	//a piece left narrower than this, a fraction of a pixel of a cell, is rounding between the regions of neighbouring windows
+	const float COVER_EPSILON = 0.0001f;
+
+	/**
+	 *	@name		subtractRegion
+	 *	@brief		the pieces of region not covered by occluder, at most 4, added to out. Regions are half open like
+	 *				the ones of RegionGrid, an occluder only sharing an edge with region leaves it whole
+	 **/
+	inline void subtractRegion(const zRender::RECT_f& region, const zRender::RECT_f& occluder, std::vector<zRender::RECT_f>& out)
+	{
+		if (occluder.left >= region.right || region.left >= occluder.right || occluder.top >= region.bottom || region.top >= occluder.bottom)
+		{
+			out.push_back(region);
+			return;
+		}
+		const float top = occluder.top > region.top ? occluder.top : region.top;
+		const float bottom = occluder.bottom < region.bottom ? occluder.bottom : region.bottom;
+		if (occluder.top > region.top)
+			out.push_back(zRender::RECT_f(region.left, region.right, region.top, occluder.top));
+		if (occluder.bottom < region.bottom)
+			out.push_back(zRender::RECT_f(region.left, region.right, occluder.bottom, region.bottom));
+		if (occluder.left > region.left)
+			out.push_back(zRender::RECT_f(region.left, occluder.left, top, bottom));
+		if (occluder.right < region.right)
+			out.push_back(zRender::RECT_f(occluder.right, region.right, top, bottom));
+	}
+
+	/**
+	 *	@name		isRegionCovered
+	 *	@brief		whether the union of the occluders covers the region, the region is cut by each occluder in turn.
+	 *				The pieces not wider or not higher than COVER_EPSILON are dropped as covered
+	 **/
+	inline bool isRegionCovered(const zRender::RECT_f& region, const std::vector<zRender::RECT_f>& occluders)
+	{
+		std::vector<zRender::RECT_f> left(1, region);
+		std::vector<zRender::RECT_f> next;
+		for (size_t i = 0; i < occluders.size() && !left.empty(); i++)
+		{
+			next.clear();
+			for (size_t k = 0; k < left.size(); k++)
+				subtractRegion(left[k], occluders[i], next);
+			left.clear();
+			for (size_t k = 0; k < next.size(); k++)
+			{
+				if (next[k].width() > COVER_EPSILON && next[k].height() > COVER_EPSILON)
+					left.push_back(next[k]);
+			}
+		}
+		return left.empty();
+	}
+}
+}
+}
+
+#endif //_SOA_MIRROR_RENDER_REGION_COVER_H_
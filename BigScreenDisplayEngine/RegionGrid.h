@@ -0,0 +1,255 @@
+/**
+ *	@name		RegionGrid.h
+ *	@brief		uniform grid over the RECT_f regions of a BigScreen, hit tests and overlap queries visit the cells of the query only
+ */
+#pragma once
+#ifndef _SOA_MIRROR_RENDER_REGION_GRID_H_
+#define _SOA_MIRROR_RENDER_REGION_GRID_H_
+
+#include "DxRenderCommon.h"
+#include <vector>
+#include <map>
+#include <math.h>
+
+namespace SOA
+{
+namespace Mirror
+{
+namespace Render
+{
+	/**
+	 *	@name		RegionGrid
+	 *	@brief		items of type T (a pointer most of the time) with one region each, every cell of the grid lists the items
+	 *				whose region covers it. The regions outside of the bounds are kept in the cells of the border, nothing is lost.
+	 *				A query costs the cells it covers plus the items listed in them, not the number of items.
+	 *				An item covering several cells is reported once: by the cell holding the top left corner of its
+	 *				intersection with the query, so the queries need no state and may run on several threads at once.
+	 *				Regions are half open, [left, right) x [top, bottom), regions sharing an edge do not overlap.
+	 *				Not thread safe against insert(), remove() and update()
+	 **/
+	template<typename T>
+	class RegionGrid
+	{
+	public:
+		RegionGrid() : m_columns(0), m_rows(0), m_cellWidth(0), m_cellHeight(0) {}
+
+		/**
+		 *	@name		reset
+		 *	@brief		drop every item and cut bounds into columns x rows cells
+		 *	@return		int 0:success -1:bounds empty or no cell
+		 **/
+		int reset(const zRender::RECT_f& bounds, int columns, int rows)
+		{
+			if (bounds.width() <= 0 || bounds.height() <= 0 || columns <= 0 || rows <= 0)
+				return -1;
+			m_bounds = bounds;
+			m_columns = columns;
+			m_rows = rows;
+			m_cellWidth = bounds.width() / columns;
+			m_cellHeight = bounds.height() / rows;
+			m_cells.assign(columns * rows, std::vector<Entry>());
+			m_regions.clear();
+			return 0;
+		}
+
+		void clear()
+		{
+			for (size_t i = 0; i < m_cells.size(); i++)
+				m_cells[i].clear();
+			m_regions.clear();
+		}
+
+		/**
+		 *	@return		int 0:success -1:region empty or not reset -2:the item is in the grid already
+		 **/
+		int insert(T item, const zRender::RECT_f& region)
+		{
+			if (m_cells.empty() || region.width() <= 0 || region.height() <= 0)
+				return -1;
+			if (m_regions.find(item) != m_regions.end())
+				return -2;
+			m_regions[item] = region;
+			int c0, r0, c1, r1;
+			cellRange(region, c0, r0, c1, r1);
+			Entry entry = { item, region };
+			for (int r = r0; r <= r1; r++)
+				for (int c = c0; c <= c1; c++)
+					m_cells[r * m_columns + c].push_back(entry);
+			return 0;
+		}
+
+		/**
+		 *	@return		int 0:success -1:not in the grid
+		 **/
+		int remove(T item)
+		{
+			typename std::map<T, zRender::RECT_f>::iterator iter = m_regions.find(item);
+			if (iter == m_regions.end())
+				return -1;
+			int c0, r0, c1, r1;
+			cellRange(iter->second, c0, r0, c1, r1);
+			m_regions.erase(iter);
+			for (int r = r0; r <= r1; r++)
+			{
+				for (int c = c0; c <= c1; c++)
+				{
+					std::vector<Entry>& cell = m_cells[r * m_columns + c];
+					for (size_t i = 0; i < cell.size(); i++)
+					{
+						if (cell[i].item == item)
+						{
+							//the order within a cell does not matter
+							cell[i] = cell.back();
+							cell.pop_back();
+							break;
+						}
+					}
+				}
+			}
+			return 0;
+		}
+
+		/**
+		 *	@brief		give an item a new region, e.g. a partition moved or resized
+		 *	@return		int 0:success -1:region empty or the item is not in the grid
+		 **/
+		int update(T item, const zRender::RECT_f& region)
+		{
+			if (region.width() <= 0 || region.height() <= 0 || m_regions.find(item) == m_regions.end())
+				return -1;
+			remove(item);
+			return insert(item, region);
+		}
+
+		bool contains(T item) const { return m_regions.find(item) != m_regions.end(); }
+		bool getRegion(T item, zRender::RECT_f& region) const
+		{
+			typename std::map<T, zRender::RECT_f>::const_iterator iter = m_regions.find(item);
+			if (iter == m_regions.end())
+				return false;
+			region = iter->second;
+			return true;
+		}
+		int size() const { return (int)m_regions.size(); }
+
+		/**
+		 *	@name		hitTest
+		 *	@brief		the items whose region contains the point (x, y)
+		 *	@return		int count of the items added to out
+		 **/
+		int hitTest(float x, float y, std::vector<T>& out) const
+		{
+			if (m_cells.empty())
+				return 0;
+			const std::vector<Entry>& cell = m_cells[cellRow(y) * m_columns + cellColumn(x)];
+			int found = 0;
+			for (size_t i = 0; i < cell.size(); i++)
+			{
+				const zRender::RECT_f& reg = cell[i].region;
+				if (x >= reg.left && x < reg.right && y >= reg.top && y < reg.bottom)
+				{
+					out.push_back(cell[i].item);
+					found++;
+				}
+			}
+			return found;
+		}
+
+		/**
+		 *	@name		queryOverlaps
+		 *	@brief		the items whose region overlaps region, each one once
+		 *	@return		int count of the items added to out
+		 **/
+		int queryOverlaps(const zRender::RECT_f& region, std::vector<T>& out) const
+		{
+			Collector collector(out);
+			return forEachOverlap(region, collector);
+		}
+
+		/**
+		 *	@name		forEachOverlap
+		 *	@brief		call visit(item, regionOfItem) for each item overlapping region, without building a list.
+		 *				visit returns false to stop
+		 *	@return		int count of the items visited
+		 **/
+		template<typename Visitor>
+		int forEachOverlap(const zRender::RECT_f& region, Visitor& visit) const
+		{
+			if (m_cells.empty() || region.width() <= 0 || region.height() <= 0)
+				return 0;
+			int c0, r0, c1, r1;
+			cellRange(region, c0, r0, c1, r1);
+			int visited = 0;
+			for (int r = r0; r <= r1; r++)
+			{
+				for (int c = c0; c <= c1; c++)
+				{
+					const std::vector<Entry>& cell = m_cells[r * m_columns + c];
+					for (size_t i = 0; i < cell.size(); i++)
+					{
+						const zRender::RECT_f& reg = cell[i].region;
+						if (reg.left >= region.right || region.left >= reg.right || reg.top >= region.bottom || region.top >= reg.bottom)
+							continue;
+						//reported by one cell only, the one of the top left corner of the intersection
+						const float left = reg.left > region.left ? reg.left : region.left;
+						const float top = reg.top > region.top ? reg.top : region.top;
+						if (cellColumn(left) != c || cellRow(top) != r)
+							continue;
+						visited++;
+						if (!visit(cell[i].item, reg))
+							return visited;
+					}
+				}
+			}
+			return visited;
+		}
+
+	private:
+		struct Entry
+		{
+			T item;
+			zRender::RECT_f region;
+		};
+
+		struct Collector
+		{
+			explicit Collector(std::vector<T>& out) : items(out) {}
+			bool operator()(T item, const zRender::RECT_f&) { items.push_back(item); return true; }
+			std::vector<T>& items;
+		};
+
+		int cellColumn(float x) const
+		{
+			int c = (int)floor((x - m_bounds.left) / m_cellWidth);
+			return c < 0 ? 0 : (c >= m_columns ? m_columns - 1 : c);
+		}
+
+		int cellRow(float y) const
+		{
+			int r = (int)floor((y - m_bounds.top) / m_cellHeight);
+			return r < 0 ? 0 : (r >= m_rows ? m_rows - 1 : r);
+		}
+
+		//a region ending on a line of the grid is listed by the next cell too, the cells of a point inside it
+		//and of the corner of an intersection are then always among its cells, whatever the rounding
+		void cellRange(const zRender::RECT_f& region, int& c0, int& r0, int& c1, int& r1) const
+		{
+			c0 = cellColumn(region.left);
+			r0 = cellRow(region.top);
+			c1 = cellColumn(region.right);
+			r1 = cellRow(region.bottom);
+		}
+
+		zRender::RECT_f m_bounds;
+		int m_columns;
+		int m_rows;
+		float m_cellWidth;
+		float m_cellHeight;
+		std::vector<std::vector<Entry> > m_cells;
+		std::map<T, zRender::RECT_f> m_regions;
+	};
+}
+}
+}
+
+#endif //_SOA_MIRROR_RENDER_REGION_GRID_H_
@@ -0,0 +1,82 @@
+#include "RenderCommandMailbox.h"
+
+using namespace SOA::Mirror::Render;
+
+RenderCommandMailbox::RenderCommandMailbox()
+	: m_newest(&m_stub), m_oldest(&m_stub), m_posted(0), m_taken(0)
+{
+	m_stub.next = NULL;
+}
+
+RenderCommandMailbox::~RenderCommandMailbox()
+{
+	RenderCommand command;
+	while (take(command))
+		;
+}
+
+int RenderCommandMailbox::post(const RenderCommand& command)
+{
+	if (NULL == command.partition)
+		return -1;
+	Node* node = new Node;
+	node->command = command;
+	link(node);
+	InterlockedIncrement(&m_posted);
+	return 0;
+}
+
+void RenderCommandMailbox::link(Node* node)
+{
+	//the stub comes back with the next of its last time in the queue
+	node->next = NULL;
+	//the producers are ordered by the exchange, each one links the node it replaced to its own
+	Node* previous = (Node*)InterlockedExchangePointer((PVOID volatile*)&m_newest, node);
+	InterlockedExchangePointer((PVOID volatile*)&previous->next, node);
+}
+
+bool RenderCommandMailbox::take(RenderCommand& command)
+{
+	Node* oldest = m_oldest;
+	Node* next = oldest->next;
+	if (oldest == &m_stub)
+	{
+		//the stub is skipped, it holds no command
+		if (NULL == next)
+			return false;
+		m_oldest = next;
+		oldest = next;
+		next = next->next;
+	}
+	if (next)
+	{
+		m_oldest = next;
+		command = oldest->command;
+		delete oldest;
+		InterlockedIncrement(&m_taken);
+		return true;
+	}
+	//oldest is the last node linked: either the newest one, or a producer has exchanged but not linked yet
+	if (oldest != m_newest)
+		return false;
+	//the stub goes behind the last node so it can be taken without leaving the queue without a node
+	link(&m_stub);
+	next = oldest->next;
+	if (next)
+	{
+		m_oldest = next;
+		command = oldest->command;
+		delete oldest;
+		InterlockedIncrement(&m_taken);
+		return true;
+	}
+	return false;
+}
+
+RenderCommandMailboxStats RenderCommandMailbox::getStats() const
+{
+	RenderCommandMailboxStats stats;
+	stats.posted = m_posted;
+	stats.taken = m_taken;
+	return stats;
+}
@@ -0,0 +1,102 @@
+/**
+ *	@name		RenderCommandMailbox.h
+ *	@brief		lock-free queue of commands from any thread to the render thread of one RenderDrawing
+ */
+#pragma once
+#ifndef _SOA_MIRROR_RENDER_RENDER_COMMAND_MAILBOX_H_
+#define _SOA_MIRROR_RENDER_RENDER_COMMAND_MAILBOX_H_
+
+#include <Windows.h>
+
+namespace SOA
+{
+namespace Mirror
+{
+namespace Render
+{
+	class BigViewportPartition;
+	class BigView;
+
+	/**
+	 *	@brief	what the render thread does with the partition of a RenderCommand
+	 **/
+	typedef enum RENDER_COMMAND_TYPE
+	{
+		RENDER_COMMAND_ADD_PARTITION = 0,	//start drawing it, its DisplayElement is created already
+		RENDER_COMMAND_REMOVE_PARTITION,	//release it, it is deleted with its DisplayElement by the draw loop
+		RENDER_COMMAND_SET_ZINDEX,			//give it the z of the command
+		RENDER_COMMAND_ATTACH_VIEW,			//show the view of the command, NULL detaches the view shown
+	}RENDER_COMMAND_TYPE;
+
+	struct RenderCommand
+	{
+		RENDER_COMMAND_TYPE type;
+		BigViewportPartition* partition;
+		int zIndex;							//RENDER_COMMAND_SET_ZINDEX only
+		BigView* view;						//RENDER_COMMAND_ATTACH_VIEW only
+	};
+
+	struct RenderCommandMailboxStats
+	{
+		long posted;		//commands given to post()
+		long taken;			//commands returned by take()
+	};
+
+	/**
+	 *	@name		RenderCommandMailbox
+	 *	@brief		unbounded FIFO of RenderCommand, many producers and one consumer, the render thread.
+	 *				post() is wait-free: one InterlockedExchangePointer on the newest node then a link from the node before it.
+	 *				take() never waits either: a producer stopped between its exchange and its link hides the commands after its own
+	 *				until it links, take() reports the mailbox empty meanwhile and the render thread gets them the next frame.
+	 *				The commands of one producer come out in the order it posted them
+	 **/
+	class RenderCommandMailbox
+	{
+	public:
+		RenderCommandMailbox();
+
+		/**
+		 *	@brief	the commands never taken are dropped, their partitions are not touched.
+		 *			RenderDrawing::stop() takes them all first, only the commands posted to a stopped RenderDrawing are left
+		 **/
+		~RenderCommandMailbox();
+
+		/**
+		 *	@name		post
+		 *	@brief		queue a command, from any thread
+		 *	@return		int 0:success -1:no partition
+		 **/
+		int post(const RenderCommand& command);
+
+		/**
+		 *	@name		take
+		 *	@brief		the oldest command, the render thread only
+		 *	@return		bool false when no command is ready
+		 **/
+		bool take(RenderCommand& command);
+
+		RenderCommandMailboxStats getStats() const;
+
+	private:
+		RenderCommandMailbox(const RenderCommandMailbox&);
+		RenderCommandMailbox& operator=(const RenderCommandMailbox&);
+
+		struct Node
+		{
+			Node* volatile next;
+			RenderCommand command;
+		};
+
+		void link(Node* node);
+
+		Node m_stub;					//stands in the queue while it is empty, so the producers never see a NULL tail
+		Node* volatile m_newest;		//written by every producer
+		Node* m_oldest;					//the consumer only
+		volatile LONG m_posted;
+		volatile LONG m_taken;
+	};
+}
+}
+}
+
+#endif //_SOA_MIRROR_RENDER_RENDER_COMMAND_MAILBOX_H_
@@ -5,26 +5,35 @@
 #include "BigViewportPartition.h"
 #include <tchar.h>
 #include "inc/TextureResource.h"
+#include "inc/FramePool.h"
 #include "ElemDsplModel.h"
+#include "RegionCover.h"
 
 using namespace SOA::Mirror::Render;
 using namespace zRender;
 
 DWORD WINAPI renderThreadWork(LPVOID param);
 
-RenderDrawing::RenderDrawing(HWND attatchWnd, float ltPointX, float ltPointY, float rbPointX, float rbPointY, BigScreenBackground* background)
+RenderDrawing::RenderDrawing(HWND attatchWnd, float ltPointX, float ltPointY, float rbPointX, float rbPointY, BigScreenBackground* background, SceneState* scene)
 	: m_hwnd(attatchWnd), m_render(NULL)
 	, m_isRunning(false)
 	, m_thread(NULL)
 	, m_ltPointX(ltPointX), m_ltPointY(ltPointY), m_rbPointX(rbPointX), m_rbPointY(rbPointY)
 	, m_background(background)
 	, m_dsplModel(NULL)
+	, m_culledCount(0)
+	, m_scene(scene), m_sceneReader(-1), m_sceneEpoch(0)
 {
+	InitializeCriticalSection(&m_partitionLock);
+	if (m_scene && (m_sceneReader = m_scene->registerReader()) < 0)
+		printf("Error in RenderDrawing::RenderDrawing : no slot left to read the scene, the layout is not drawn.\n");
+	m_partitionIndex.reset(zRender::RECT_f(ltPointX, rbPointX, ltPointY, rbPointY), PARTITION_GRID_DIVISIONS, PARTITION_GRID_DIVISIONS);
 }
 
 RenderDrawing::~RenderDrawing()
 {
 	stop();
+	DeleteCriticalSection(&m_partitionLock);
 }
 
 int RenderDrawing::start(HANDLE timerHandle)
@@ -49,9 +58,39 @@ void RenderDrawing::stop()
 	WaitForSingleObject(m_thread, INFINITE);
 	CloseHandle(m_thread);
 	m_thread = NULL;
+	//the render thread is gone, the commands it never took run here: a partition added meanwhile holds a DisplayElement
+	//and belongs to this RenderDrawing, it joins m_vpPartitions instead of being lost with the mailbox
+	drainCommands();
+	releaseRetiredPartitions();
 	return;
 }
 
+void RenderDrawing::deletePartition(BigViewportPartition* vpPartition)
+{
+	EnterCriticalSection(&m_partitionLock);
+	m_partitionIndex.remove(vpPartition);
+	LeaveCriticalSection(&m_partitionLock);
+	DisplayElement* de = vpPartition->getAttachedDisplayElement();
+	if (m_render)
+		m_render->releaseDisplayElement(&de);
+	delete vpPartition;
+}
+
+void RenderDrawing::releaseRetiredPartitions()
+{
+	std::list<BigViewportPartition*>::iterator iter = m_vpPartitions.begin();
+	while (iter != m_vpPartitions.end())
+	{
+		std::list<BigViewportPartition*>::iterator cur = iter++;
+		BigViewportPartition* vpp = *cur;
+		if (vpp && !vpp->isValid() && vpp->isNeedRelease())
+		{
+			m_vpPartitions.erase(cur);
+			deletePartition(vpp);
+		}
+	}
+}
+
 int RenderDrawing::getWidthInPixel() const
 {
 	if(NULL==m_hwnd)
@@ -97,8 +136,69 @@ int RenderDrawing::addBigViewportPartition(BigViewportPartition* viewportPartiti
 		m_render->releaseDisplayElement(&de);
 		return -4;
 	}
-	addViewportPartition(viewportPartition);
-	return 0;
+	//m_vpPartitionsȾ߳
+	RenderCommand command = { RENDER_COMMAND_ADD_PARTITION, viewportPartition, 0, NULL };
+	return m_mailbox.post(command);
+}
+
+int RenderDrawing::removeBigViewportPartition(BigViewportPartition* viewportPartition)
+{
+	RenderCommand command = { RENDER_COMMAND_REMOVE_PARTITION, viewportPartition, 0, NULL };
+	return m_mailbox.post(command);
+}
+
+int RenderDrawing::setPartitionZIndex(BigViewportPartition* viewportPartition, int zIndex)
+{
+	RenderCommand command = { RENDER_COMMAND_SET_ZINDEX, viewportPartition, zIndex, NULL };
+	return m_mailbox.post(command);
+}
+
+int RenderDrawing::attachPartitionView(BigViewportPartition* viewportPartition, BigView* view)
+{
+	RenderCommand command = { RENDER_COMMAND_ATTACH_VIEW, viewportPartition, 0, view };
+	return m_mailbox.post(command);
+}
+
+int RenderDrawing::drainCommands()
+{
+	int count = 0;
+	RenderCommand command;
+	while (m_mailbox.take(command))
+	{
+		executeCommand(command);
+		count++;
+	}
+	return count;
+}
+
+void RenderDrawing::executeCommand(const RenderCommand& command)
+{
+	BigViewportPartition* vpp = command.partition;
+	switch (command.type)
+	{
+	case RENDER_COMMAND_ADD_PARTITION:
+		addViewportPartition(vpp);
+		break;
+	case RENDER_COMMAND_REMOVE_PARTITION:
+		//ѭɾԼDisplayElement
+		if (!vpp->isNeedRelease())
+			vpp->notifyToRelease();
+		break;
+	case RENDER_COMMAND_SET_ZINDEX:
+		vpp->setZIndex(command.zIndex);
+		break;
+	case RENDER_COMMAND_ATTACH_VIEW:
+		if (command.view == vpp->getAttachedView())
+			break;
+		if (vpp->getAttachedView())
+			vpp->disattachView();
+		if (command.view)
+			vpp->attachBigView(command.view);
+		break;
+	default:
+		assert(false);
+		break;
+	}
 }
 
 zRender::DisplayElement* RenderDrawing::createDisplayElement(BigViewportPartition* vpPartition)
@@ -116,7 +216,123 @@ zRender::DisplayElement* RenderDrawing::createDisplayElement(BigViewportPartitio
 
 void RenderDrawing::addViewportPartition(BigViewportPartition* vpPartition)
 {
+	EnterCriticalSection(&m_partitionLock);
 	m_vpPartitions.push_back(vpPartition);
+	m_partitionIndex.insert(vpPartition, vpPartition->getRegOfBigScreen());
+	LeaveCriticalSection(&m_partitionLock);
+}
+
+BigViewportPartition* RenderDrawing::hitTest(float x, float y)
+{
+	std::vector<BigViewportPartition*> hits;
+	EnterCriticalSection(&m_partitionLock);
+	m_partitionIndex.hitTest(x, y, hits);
+	BigViewportPartition* top = NULL;
+	for (size_t i = 0; i < hits.size(); i++)
+	{
+		if (hits[i]->isValid() && isShown(hits[i]) && (top == NULL || hits[i]->getZIndex() > top->getZIndex()))
+			top = hits[i];
+	}
+	LeaveCriticalSection(&m_partitionLock);
+	return top;
+}
+
+int RenderDrawing::queryPartitions(const zRender::RECT_f& regOfBigScreen, std::vector<BigViewportPartition*>& out)
+{
+	EnterCriticalSection(&m_partitionLock);
+	int count = m_partitionIndex.queryOverlaps(regOfBigScreen, out);
+	LeaveCriticalSection(&m_partitionLock);
+	return count;
+}
+
+int RenderDrawing::updatePartitionRegion(BigViewportPartition* vpPartition)
+{
+	if (NULL == vpPartition)
+		return -1;
+	EnterCriticalSection(&m_partitionLock);
+	int ret = m_partitionIndex.update(vpPartition, vpPartition->getRegOfBigScreen());
+	LeaveCriticalSection(&m_partitionLock);
+	return ret;
+}
+
+int RenderDrawing::cullOccludedPartitions(bool& cellCovered)
+{
+	std::vector<BigViewportPartition*> candidates;
+	std::vector<RECT_f> occluders;
+	std::vector<RECT_f> opaqueRegions;
+	int culled = 0;
+	//ֻȾ߳޸m_vpPartitionsm_partitionIndexȡҪ
+	std::list<BigViewportPartition*>::iterator iter = m_vpPartitions.begin();
+	for (; iter != m_vpPartitions.end(); iter++)
+	{
+		BigViewportPartition* vpp = *iter;
+		if (NULL == vpp || !vpp->isValid() || !isShown(vpp))
+			continue;
+		const RECT_f reg = vpp->getRegOfBigScreen();
+		if (vpp->isOpaque())
+			opaqueRegions.push_back(reg);
+		//only the partitions overlapping this one are looked at, the ones with the same z may be drawn above or below it
+		candidates.clear();
+		occluders.clear();
+		m_partitionIndex.queryOverlaps(reg, candidates);
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			BigViewportPartition* other = candidates[i];
+			if (other != vpp && other->isValid() && isShown(other) && other->isOpaque() && other->getZIndex() > vpp->getZIndex())
+				occluders.push_back(other->getRegOfBigScreen());
+		}
+		//a partition hidden itself is under others covering all it covers, it still counts as an occluder
+		const bool occluded = !occluders.empty() && isRegionCovered(reg, occluders);
+		vpp->setOccluded(occluded);
+		if (occluded)
+			culled++;
+	}
+	cellCovered = !opaqueRegions.empty() && isRegionCovered(RECT_f(m_ltPointX, m_rbPointX, m_ltPointY, m_rbPointY), opaqueRegions);
+	InterlockedExchange(&m_culledCount, culled);
+	return culled;
+}
+
+bool RenderDrawing::isShown(const BigViewportPartition* vpPartition) const
+{
+	return vpPartition->isShownAt(m_sceneEpoch);
+}
+
+void RenderDrawing::applyScene(const SceneSnapshot* scene)
+{
+	const LONG epoch = scene->getEpoch();
+	const int xIndex = static_cast<int>(m_ltPointX);
+	const int yIndex = static_cast<int>(m_ltPointY);
+	std::list<BigViewportPartition*>::iterator iter = m_vpPartitions.begin();
+	for (; iter != m_vpPartitions.end(); iter++)
+	{
+		BigViewportPartition* vpp = *iter;
+		if (NULL == vpp || vpp->isNeedRelease())
+			continue;
+		//its viewport left the cell or was destroyed, the draw loop deletes it
+		if (vpp->isRetiredAt(epoch))
+		{
+			vpp->notifyToRelease();
+			continue;
+		}
+		if (!vpp->isShownAt(epoch))
+			continue;
+		const SceneViewport* layout = scene->find(vpp->getViewport());
+		RECT_f regOfPartition, regOfTexture;
+		if (NULL == layout || !layout->partitionOf(xIndex, yIndex, regOfPartition, regOfTexture))
+			continue;
+		if (!(regOfPartition == vpp->getRegOfBigScreen()) || !(regOfTexture == vpp->getRegOfBigViewport()))
+			vpp->move(regOfPartition, regOfTexture);
+		if (layout->zIndex != vpp->getZIndex())
+			vpp->setZIndex(layout->zIndex);
+		if (layout->view != vpp->getAttachedView())
+		{
+			if (vpp->getAttachedView())
+				vpp->disattachView();
+			if (layout->view)
+				vpp->attachBigView(layout->view);
+		}
+	}
+	InterlockedExchange(&m_sceneEpoch, epoch);
 }
 
 #include <fstream>
@@ -183,8 +399,9 @@ int RenderDrawing::doRenderWork()
 	LONGLONG nowTime = 0;
 	QueryPerformanceFrequency(&freq);
 	/////////////////ڴrendertargetнݿ////////////////////////
-	UINT dstDataLen = width * height * 4;
-	unsigned char* pdstData = (unsigned char*)malloc(dstDataLen);
+	UINT dstDataLen = FRAMESIZE(width, height, PIXFMT_A8R8G8B8);
+	zRender::FrameBuffer dstData(PIXFMT_A8R8G8B8, width, height);
+	unsigned char* pdstData = dstData.data();
 	int dstWidth = 0, dstHeight = 0;
 	int dstPixfmt = 0;
 	int dstPitch = 0;
@@ -209,25 +426,46 @@ int RenderDrawing::doRenderWork()
 		lastTime = nowTime;
 		if(WaitForSingleObject(m_timerHandle, INFINITE)==WAIT_FAILED)
 			return -2;
-		render->clear(0);
+		//the layout of this frame, the snapshot adopted by the tick that woke every cell
+		const SceneSnapshot* scene = m_scene ? m_scene->acquire(m_sceneReader) : NULL;
+		//drained after acquire(): the control thread posts the ADD of a partition before the endUpdate() publishing it,
+		//so every partition of the snapshot acquired is in the mailbox by now. Drained before, a tick in between would
+		//hand out a snapshot showing a partition not added yet
+		drainCommands();
+		if(scene)
+		{
+			if(scene->getEpoch()!=m_sceneEpoch)
+				applyScene(scene);
+			m_scene->release(m_sceneReader);
+		}
+		bool cellCovered = false;
+		cullOccludedPartitions(cellCovered);
+		//every pixel of the cell is drawn by an opaque partition, only the depth of the last frame has to go
+		if(cellCovered)
+			render->clearDepth();
+		else
+			render->clear(0);
 		//render->drawBackground();
 		std::list<BigViewportPartition*>::iterator iter = m_vpPartitions.begin();
-		for(; iter!=m_vpPartitions.end(); iter++)
+		while(iter!=m_vpPartitions.end())
 		{
-			vpp = *iter;
+			std::list<BigViewportPartition*>::iterator cur = iter++;
+			vpp = *cur;
 			if(NULL==vpp)
 				continue;
 			if(!vpp->isValid())	//ٿãBigViewportѱͷŻBigViewportBigWindowѾMoveRenderDrawing
 			{
 				if(vpp->isNeedRelease())
 				{
-					*iter = NULL;
-					de = vpp->getAttachedDisplayElement();
-					m_render->releaseDisplayElement(&de);
-					delete vpp;
+					//iterָһֱɾvppڵĽڵ
+					m_vpPartitions.erase(cur);
+					deletePartition(vpp);
 				}
 				continue;
 			}
+			//created for a snapshot not adopted yet, or hidden under opaque partitions with a higher z, neither uploaded nor drawn
+			if(!isShown(vpp) || vpp->isOccluded())
+				continue;
 			de = vpp->getAttachedDisplayElement();
 			if (de->getDsplModel() == NULL && NULL != m_dsplModel)
 			{
@@ -252,7 +490,6 @@ int RenderDrawing::doRenderWork()
 		//}
 		Sleep(10);
 	}
-	free(pdstData);
 /*
 	float left, right;
 	if(m_ltPointX==0.0)
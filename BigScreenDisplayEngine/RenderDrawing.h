@@ -7,6 +7,7 @@
 
 #include <Windows.h>
 #include <list>
+#include <vector>
 
 #pragma once
 #ifndef _SOA_RENDER_RENDERDRAWING_H_
@@ -14,6 +15,9 @@
 
 #include "BigScreenBackground.h"
 #include "ElemDsplModel.h"
+#include "RegionGrid.h"
+#include "SceneState.h"
+#include "RenderCommandMailbox.h"
 
 namespace zRender
 {
@@ -37,6 +41,8 @@ namespace Render
 	class RenderDrawing
 	{
 	public:
+		enum { PARTITION_GRID_DIVISIONS = 8 };	//ÿзֵBigViewportPartitionĿռ
+
 		/**
 		 *	@name		RenderDrawing
 		 *	@brief		췽BigScreenһӦʾģ飬ģʾλڸôڵBigViewport
@@ -45,8 +51,9 @@ namespace Render
 		 *	@param[in]	float ltPointY BigScreenе꣬϶Yֵ
 		 *	@param[in]	float rbPointX BigScreenе꣬¶Xֵ
 		 *	@param[in]	float rbPointY BigScreenе꣬¶Yֵ
+		 *	@param[in]	SceneState* scene BigScreenĲ֣ÿһ֡ʼʱµSceneSnapshotNULLʱʹòֿ
 		 **/
-		RenderDrawing(HWND attatchWnd, float ltPointX, float ltPointY, float rbPointX, float rbPointY, BigScreenBackground* background);
+		RenderDrawing(HWND attatchWnd, float ltPointX, float ltPointY, float rbPointX, float rbPointY, BigScreenBackground* background, SceneState* scene = NULL);
 
 		/**
 		 *	@name		~RenderDrawing
@@ -64,6 +71,8 @@ namespace Render
 		/**
 		 *	@name		stop
 		 *	@brief		ֹͣȾ̣߳Ⱦ߳дԴͷ
+		 *				Ⱦ߳˳ɵִ߳ʣBigViewportPartitionб
+		 *				֪ͨͷŵBigViewportPartitionDisplayElementһͷţٴstart
 		 *	@return		
 		 **/
 		void stop();
@@ -79,11 +88,38 @@ namespace Render
 		 *	@brief		зֺBigViewportĲʾݣöȾӵBigViewportʾ
 		 *				BigViewportPartitionDisplayElement󣬴ӶⲿͨBigViewportPartitionĽӿ޸ʾ
 		 *				Ⱦ̸߳ͷӵBigViewportPartitionڸöҪʾʱ
+		 *				̵߳ãDisplayElementڵ߳дбȾ߳һ֡ʼʱ
 		 *	@param[in]	BigViewportPartition* viewportPartition зֺBigViewportĲʾ
 		 *	@return		int	0--ӳɹ  <0--ʧ
 		 **/
 		int addBigViewportPartition(BigViewportPartition* viewportPartition);
 
+		/**
+		 *	@name		removeBigViewportPartition
+		 *	@brief		Ⱦ߳һ֡ʼʱͷŸBigViewportPartition֮Ⱦ߳ɾ֮ʹøö
+		 *	@return		int	0--ɹ  <0--ΪNULL
+		 **/
+		int removeBigViewportPartition(BigViewportPartition* viewportPartition);
+
+		/**
+		 *	@name		setPartitionZIndex
+		 *	@brief		Ⱦ߳һ֡ʼʱ޸ĸBigViewportPartitionZ꣬μBigViewportPartition::setZIndex
+		 *	@return		int	0--ɹ  <0--ΪNULL
+		 **/
+		int setPartitionZIndex(BigViewportPartition* viewportPartition, int zIndex);
+
+		/**
+		 *	@name		attachPartitionView
+		 *	@brief		Ⱦ߳һ֡ʼʱʹBigViewportPartitionʾviewݣviewΪNULLʱȡʾ
+		 *	@return		int	0--ɹ  <0--ΪNULL
+		 **/
+		int attachPartitionView(BigViewportPartition* viewportPartition, BigView* view);
+
+		/**
+		 *	@brief	͸Ⱦ̵ִ߳е
+		 **/
+		RenderCommandMailboxStats getCommandStats() const { return m_mailbox.getStats(); }
+
 		/**
 		 *	@name		getRegOfBigScreen
 		 *	@brief		ȡöʾȾBigScreenеλ
@@ -118,12 +154,78 @@ namespace Render
 		//int get
 
 		zRender::DxRender* getDxRender() const { return m_render; }
+
+		/**
+		 *	@name		hitTest
+		 *	@brief		ȡBigScreenеĵ(x, y)ʾϲBigViewportPartitionֻҸõеBigViewportPartition
+		 *				صĶȾ̣߳ڵnotifyToRelease֮ǰЧ
+		 *	@return		BigViewportPartition* NULL--õûʾκBigViewportPartition
+		 **/
+		BigViewportPartition* hitTest(float x, float y);
+
+		/**
+		 *	@name		queryPartitions
+		 *	@brief		ȡBigScreenеregOfBigScreenصBigViewportPartitionÿֻһ
+		 *				ֻҸ򸲸ǵ񣬲BigViewportPartition
+		 *	@return		int ӵoutеBigViewportPartitionĸ
+		 **/
+		int queryPartitions(const zRender::RECT_f& regOfBigScreen, std::vector<BigViewportPartition*>& out);
+
+		/**
+		 *	@name		updatePartitionRegion
+		 *	@brief		BigViewportPartitionBigScreenеıãڿռеλ
+		 *	@return		int 0--ɹ <0--BigViewportPartitionڸö
+		 **/
+		int updatePartitionRegion(BigViewportPartition* vpPartition);
+
+		/**
+		 *	@name		getCulledPartitionCount
+		 *	@brief		һ֡бZߵĲ͸ȫڵûлҲûϴBigViewportPartitionĸ
+		 **/
+		int getCulledPartitionCount() const { return m_culledCount; }
 	private:
+		//Ⱦִ߳RENDER_COMMAND_ADD_PARTITION
 		void addViewportPartition(BigViewportPartition* vpPartition);
 		//void removeViewportPartition(BigViewportPartition* vpPartition);
 		zRender::DisplayElement* createDisplayElement(BigViewportPartition* vpPartition);
 		void drawBigViewportPartition(zRender::DxRender* render, BigViewportPartition* vpPartition);
 
+		/**
+		 *	@name		drainCommands
+		 *	@brief		̷ִ߳͵Ⱦ߳ÿһ֡ʼʱSceneSnapshot֮ǰ
+		 *	@return		int ִе
+		 **/
+		int drainCommands();
+		void executeCommand(const RenderCommand& command);
+
+		/**
+		 *	@brief	BigViewportPartitionƳб֮ãӿռƳDisplayElementһͷ
+		 **/
+		void deletePartition(BigViewportPartition* vpPartition);
+		//Ⱦֹ߳ͣͷ֪ͨͷŵBigViewportPartition
+		void releaseRetiredPartitions();
+
+		/**
+		 *	@name		cullOccludedPartitions
+		 *	@brief		ÿһ֡ǰĿɼԼ㣬ǱZߵĲ͸BigViewportPartitionȫǵBigViewportPartition
+		 *	@param[out]	bool& cellCovered Ƿ񱻲͸ȫǣҪɫ
+		 *	@return		int ڵBigViewportPartitionĸ
+		 **/
+		int cullOccludedPartitions(bool& cellCovered);
+
+		/**
+		 *	@name		applyScene
+		 *	@brief		µSceneSnapshotͷڸepochбɾBigViewportPartition
+		 *				տBigViewportZꡢBigViewԼü޸ĸôеBigViewportPartition
+		 *				ֻȾ߳еã޸ڸ߳ɣƽ
+		 **/
+		void applyScene(const SceneSnapshot* scene);
+
+		/**
+		 *	@brief	ڵǰõSceneSnapshotǷʾ
+		 **/
+		bool isShown(const BigViewportPartition* vpPartition) const;
+
 		HWND m_hwnd;
 		zRender::DxRender* m_render;
 		HANDLE m_timerHandle;
@@ -137,7 +239,14 @@ namespace Render
 
 		BigScreenBackground* m_background;
 
-		std::list<BigViewportPartition*> m_vpPartitions;
+		std::list<BigViewportPartition*> m_vpPartitions;	//Ƶ˳ֻȾ߳з
+		RegionGrid<BigViewportPartition*> m_partitionIndex;	//m_vpPartitionsBigScreenеڲѯ
+		CRITICAL_SECTION m_partitionLock;					//Ⱦ̶߳m_partitionIndex޸ģ߳hitTestqueryPartitionsĶȡ
+		RenderCommandMailbox m_mailbox;						//̶߳m_vpPartitionsӡɾԼ޸
+		volatile LONG m_culledCount;
+		SceneState* m_scene;
+		int m_sceneReader;					//m_sceneиȾ̵߳Ķȡλ
+		volatile LONG m_sceneEpoch;			//ǰõSceneSnapshotepochûm_sceneʱΪ0
 		zRender::ElemDsplModel<zRender::BasicEffect>* m_dsplModel;
 	};
 }
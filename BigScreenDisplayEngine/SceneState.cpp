@@ -0,0 +1,184 @@
+#include "SceneState.h"
+
+using namespace SOA::Mirror::Render;
+using namespace zRender;
+
+bool SceneViewport::partitionOf(int xIndex, int yIndex, RECT_f& regOfPartition, RECT_f& regOfTexture) const
+{
+	if (regOfScreen.width() <= 0 || regOfScreen.height() <= 0)
+		return false;
+	int xPosStart = static_cast<int>(regOfScreen.left);
+	int xPosEnd = regOfScreen.right - static_cast<int>(regOfScreen.right) > 0.001 ? static_cast<int>(regOfScreen.right) : static_cast<int>(regOfScreen.right) - 1;
+	int yPosStart = static_cast<int>(regOfScreen.top);
+	int yPosEnd = regOfScreen.bottom - static_cast<int>(regOfScreen.bottom) > 0.001 ? static_cast<int>(regOfScreen.bottom) : static_cast<int>(regOfScreen.bottom) - 1;
+	if (xIndex < xPosStart || xIndex > xPosEnd || yIndex < yPosStart || yIndex > yPosEnd)
+		return false;
+	float left = xIndex == xPosStart ? regOfScreen.left : xIndex;
+	float right = xIndex == xPosEnd ? regOfScreen.right : xIndex + 1;
+	float top = yIndex == yPosStart ? regOfScreen.top : yIndex;
+	float bottom = yIndex == yPosEnd ? regOfScreen.bottom : yIndex + 1;
+	regOfPartition = RECT_f(left, right, top, bottom);
+	//the piece relative to the viewport, then to the crop of the view
+	float leftOfvp = (left - regOfScreen.left) / regOfScreen.width();
+	float rightOfvp = (right - regOfScreen.left) / regOfScreen.width();
+	float topOfvp = (top - regOfScreen.top) / regOfScreen.height();
+	float bottomOfvp = (bottom - regOfScreen.top) / regOfScreen.height();
+	regOfTexture = RECT_f(crop.left + leftOfvp * crop.width(), crop.left + rightOfvp * crop.width(),
+		crop.top + topOfvp * crop.height(), crop.top + bottomOfvp * crop.height());
+	return true;
+}
+
+const SceneViewport* SceneSnapshot::find(const BigViewport* viewport) const
+{
+	for (size_t i = 0; i < m_viewports.size(); i++)
+	{
+		if (m_viewports[i].viewport == viewport)
+			return &m_viewports[i];
+	}
+	return NULL;
+}
+
+int SceneSnapshot::setViewport(const SceneViewport& layout)
+{
+	if (NULL == layout.viewport || layout.regOfScreen.width() <= 0 || layout.regOfScreen.height() <= 0)
+		return -1;
+	removeViewport(layout.viewport);
+	//after the viewports with a lower or the same z, a viewport changed is drawn above the others of its z
+	size_t pos = 0;
+	while (pos < m_viewports.size() && m_viewports[pos].zIndex <= layout.zIndex)
+		pos++;
+	m_viewports.insert(m_viewports.begin() + pos, layout);
+	return 0;
+}
+
+int SceneSnapshot::removeViewport(const BigViewport* viewport)
+{
+	for (size_t i = 0; i < m_viewports.size(); i++)
+	{
+		if (m_viewports[i].viewport == viewport)
+		{
+			m_viewports.erase(m_viewports.begin() + i);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+SceneState::SceneState(int readerCount)
+	: m_front(&m_snapshots[0]), m_pending(NULL), m_back(NULL), m_updateDepth(0)
+	, m_readerEpochs(readerCount > 0 ? readerCount : 0, 0), m_readerCount(0)
+{
+	//0 marks a slot between two frames, the epochs of the snapshots start at 1
+	m_snapshots[0].m_epoch = 1;
+	InitializeCriticalSection(&m_updateLock);
+	InitializeCriticalSection(&m_swapLock);
+}
+
+SceneState::~SceneState()
+{
+	DeleteCriticalSection(&m_swapLock);
+	DeleteCriticalSection(&m_updateLock);
+}
+
+int SceneState::registerReader()
+{
+	LONG reader = InterlockedIncrement(&m_readerCount) - 1;
+	if (reader >= (LONG)m_readerEpochs.size())
+	{
+		InterlockedDecrement(&m_readerCount);
+		return -1;
+	}
+	return (int)reader;
+}
+
+SceneSnapshot* SceneState::beginUpdate()
+{
+	EnterCriticalSection(&m_updateLock);
+	if (m_updateDepth++ > 0)
+		return m_back;
+	EnterCriticalSection(&m_swapLock);
+	SceneSnapshot* pending = m_pending;
+	m_pending = NULL;
+	LeaveCriticalSection(&m_swapLock);
+	if (pending)
+	{
+		//not adopted yet, edited again with the same epoch
+		m_back = pending;
+		return m_back;
+	}
+	//only tick() moves the front, from a pending snapshot, and there is none
+	SceneSnapshot* front = m_front;
+	SceneSnapshot* back = front == &m_snapshots[0] ? &m_snapshots[1] : &m_snapshots[0];
+	waitForReaders(back->m_epoch);
+	back->m_viewports = front->m_viewports;
+	back->m_epoch = front->m_epoch + 1;
+	m_back = back;
+	return m_back;
+}
+
+int SceneState::endUpdate()
+{
+	if (m_updateDepth <= 0)
+		return -1;
+	if (--m_updateDepth > 0)
+	{
+		LeaveCriticalSection(&m_updateLock);
+		return 1;
+	}
+	EnterCriticalSection(&m_swapLock);
+	m_pending = m_back;
+	LeaveCriticalSection(&m_swapLock);
+	m_back = NULL;
+	LeaveCriticalSection(&m_updateLock);
+	return 0;
+}
+
+LONG SceneState::tick()
+{
+	EnterCriticalSection(&m_swapLock);
+	if (m_pending)
+	{
+		//the one swap the readers see, the writes to the snapshot are done before it
+		InterlockedExchangePointer((PVOID volatile*)&m_front, m_pending);
+		m_pending = NULL;
+	}
+	LONG epoch = m_front->m_epoch;
+	LeaveCriticalSection(&m_swapLock);
+	return epoch;
+}
+
+const SceneSnapshot* SceneState::acquire(int reader)
+{
+	if (reader < 0 || reader >= (int)m_readerEpochs.size())
+		return NULL;
+	while (true)
+	{
+		SceneSnapshot* front = m_front;
+		const LONG epoch = front->m_epoch;
+		InterlockedExchange(&m_readerEpochs[reader], epoch);
+		//swapped meanwhile: the writer may not have seen the slot and may be writing the old front already.
+		//The epoch is checked too, the old front may have been written and swapped back in between
+		if (front == m_front && epoch == front->m_epoch)
+			return front;
+	}
+}
+
+void SceneState::release(int reader)
+{
+	if (reader < 0 || reader >= (int)m_readerEpochs.size())
+		return;
+	InterlockedExchange(&m_readerEpochs[reader], 0);
+}
+
+void SceneState::waitForReaders(LONG epoch) const
+{
+	//never published, nobody reads it
+	if (0 == epoch)
+		return;
+	for (size_t i = 0; i < m_readerEpochs.size(); i++)
+	{
+		//a render thread holds a snapshot for the few copies at the start of a frame
+		while (*(volatile const LONG*)&m_readerEpochs[i] == epoch)
+			Sleep(0);
+	}
+}
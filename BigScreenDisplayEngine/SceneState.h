@@ -0,0 +1,157 @@
+/**
+ *	@name		SceneState.h
+ *	@brief		layout of the BigScreen shared by all the cells: immutable snapshots, double buffered and published by epoch
+ */
+#pragma once
+#ifndef _SOA_MIRROR_RENDER_SCENE_STATE_H_
+#define _SOA_MIRROR_RENDER_SCENE_STATE_H_
+
+#include <Windows.h>
+#include "DxRenderCommon.h"
+#include <vector>
+
+namespace SOA
+{
+namespace Mirror
+{
+namespace Render
+{
+	class BigViewport;
+	class BigView;
+
+	/**
+	 *	@name		SceneViewport
+	 *	@brief		layout of one BigViewport in a snapshot
+	 **/
+	struct SceneViewport
+	{
+		const BigViewport* viewport;	//the key of the partitions of the viewport, never dereferenced by the render threads
+		zRender::RECT_f regOfScreen;	//region in the BigScreen
+		int zIndex;
+		BigView* view;					//the view shown, NULL before attachView()
+		zRender::RECT_f crop;			//region of the view shown by the viewport, relative coordinates in [0,1]
+
+		/**
+		 *	@name		partitionOf
+		 *	@brief		the piece of the viewport shown by the cell (xIndex, yIndex) of the BigScreen.
+		 *				The cells are cut the way BigViewport always did: a viewport ending less than 0.001 into a cell does not enter it
+		 *	@param[out]	zRender::RECT_f& regOfPartition region of the piece in the BigScreen
+		 *	@param[out]	zRender::RECT_f& regOfTexture region of the view drawn in the piece, crop included
+		 *	@return		bool false:the viewport is not shown by the cell
+		 **/
+		bool partitionOf(int xIndex, int yIndex, zRender::RECT_f& regOfPartition, zRender::RECT_f& regOfTexture) const;
+	};
+
+	/**
+	 *	@name		SceneSnapshot
+	 *	@brief		the viewports of the BigScreen with their region, z, view and crop, sorted by z.
+	 *				A snapshot published is never written again until every render thread has left it
+	 **/
+	class SceneSnapshot
+	{
+	public:
+		SceneSnapshot() : m_epoch(0) {}
+
+		/**
+		 *	@brief	grows by one with every snapshot published, the partitions created or released by an update are shown or hidden from it
+		 **/
+		LONG getEpoch() const { return m_epoch; }
+
+		int getViewportCount() const { return (int)m_viewports.size(); }
+		const SceneViewport& getViewport(int index) const { return m_viewports[index]; }
+		const SceneViewport* find(const BigViewport* viewport) const;
+
+		/**
+		 *	@brief	add the viewport or replace its layout, only on a snapshot returned by SceneState::beginUpdate()
+		 *	@return	int 0:success -1:no viewport or an empty region
+		 **/
+		int setViewport(const SceneViewport& layout);
+
+		/**
+		 *	@return	int 0:success -1:not in the snapshot
+		 **/
+		int removeViewport(const BigViewport* viewport);
+
+	private:
+		friend class SceneState;
+
+		LONG m_epoch;
+		std::vector<SceneViewport> m_viewports;
+	};
+
+	/**
+	 *	@name		SceneState
+	 *	@brief		two snapshots: the front one drawn by the render threads, the back one written by the control thread.
+	 *				publish: the control thread edits the back snapshot between beginUpdate() and endUpdate(), which makes it pending.
+	 *				adopt: the frame clock calls tick() before it wakes the cells, the pending snapshot becomes the front one
+	 *				with one pointer swap, every cell woken by that tick draws the same layout.
+	 *				read: a render thread acquire()s the front snapshot at the start of its frame and release()s it once copied,
+	 *				without a lock: it writes the epoch it reads in its own slot and the writer waits for the slots to leave
+	 *				the old front before writing it again.
+	 **/
+	class SceneState
+	{
+	public:
+		/**
+		 *	@param[in]	int readerCount most render threads reading the snapshots, one slot each
+		 **/
+		explicit SceneState(int readerCount);
+		~SceneState();
+
+		/**
+		 *	@name		registerReader
+		 *	@brief		the slot of a render thread, given once when the thread is created
+		 *	@return		int the slot >=0, -1:every slot is taken
+		 **/
+		int registerReader();
+
+		/**
+		 *	@name		beginUpdate
+		 *	@brief		the snapshot to edit, a copy of the last one published, its epoch is the one it will be adopted at.
+		 *				Nested calls return the same snapshot, the outermost endUpdate() publishes it, so many changes show at once.
+		 *				A snapshot published but not adopted yet is edited again, no reader has seen it.
+		 *				Only one thread at a time: the others wait in beginUpdate() until endUpdate()
+		 **/
+		SceneSnapshot* beginUpdate();
+
+		/**
+		 *	@return		int 0:published >0:still in a nested update -1:no update begun
+		 **/
+		int endUpdate();
+
+		/**
+		 *	@name		tick
+		 *	@brief		the frame boundary, called by the frame clock before it wakes the render threads
+		 *	@return		LONG epoch of the front snapshot
+		 **/
+		LONG tick();
+
+		/**
+		 *	@name		acquire
+		 *	@brief		the front snapshot, valid until release(reader)
+		 *	@return		const SceneSnapshot* NULL when reader is not a registered slot
+		 **/
+		const SceneSnapshot* acquire(int reader);
+		void release(int reader);
+
+	private:
+		SceneState(const SceneState&);
+		SceneState& operator=(const SceneState&);
+
+		void waitForReaders(LONG epoch) const;
+
+		SceneSnapshot m_snapshots[2];
+		SceneSnapshot* volatile m_front;
+		SceneSnapshot* m_pending;			//published, adopted by the next tick()
+		SceneSnapshot* m_back;				//being edited, between beginUpdate() and endUpdate()
+		int m_updateDepth;
+		std::vector<LONG> m_readerEpochs;	//epoch of the snapshot each render thread reads, 0 between its frames
+		volatile LONG m_readerCount;
+		CRITICAL_SECTION m_updateLock;		//held from the outermost beginUpdate() to its endUpdate()
+		CRITICAL_SECTION m_swapLock;		//m_pending, between endUpdate(), beginUpdate() and tick()
+	};
+}
+}
+}
+
+#endif //_SOA_MIRROR_RENDER_SCENE_STATE_H_
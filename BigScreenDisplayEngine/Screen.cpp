@@ -5,16 +5,19 @@
 using namespace SOA::Mirror::Render;
 
 Screen::Screen(const ScreenConfig& screenCfg, BigScreenBackground* background)
+	: m_scene(NULL)
 {
 	if (screenCfg.width <= 0 || screenCfg.height <= 0 || screenCfg.screenCellCfg.size() > screenCfg.width*screenCfg.height)
 		throw std::exception("Argument invalid.");
+	//one reader per cell, the render thread of each ScreenRender
+	m_scene = new SceneState((int)screenCfg.screenCellCfg.size());
 	for (size_t cellIndex = 0; cellIndex < screenCfg.screenCellCfg.size(); cellIndex++)
 	{
 		ScreenRender* scRender = NULL;
 		try{
 			scRender = new ScreenRender(screenCfg.screenCellCfg[cellIndex].output, 
 				screenCfg.screenCellCfg[cellIndex].posX, screenCfg.screenCellCfg[cellIndex].posY,
-				background);
+				background, m_scene);
 			m_screenRender.push_back(scRender);
 		}
 		catch (const std::exception& ex)
@@ -24,7 +27,19 @@ Screen::Screen(const ScreenConfig& screenCfg, BigScreenBackground* background)
 		}
 	}
 	if (m_screenRender.size() <= 0)
+	{
+		delete m_scene;
 		throw std::exception("Create Screen Render Obj failed.(Can not create any obj)\n");
+	}
+	m_cellIndex.reset(zRender::RECT_f(0, (float)screenCfg.width, 0, (float)screenCfg.height), screenCfg.width, screenCfg.height);
+	for (size_t scRenderIndex = 0; scRenderIndex < m_screenRender.size(); scRenderIndex++)
+	{
+		//the cell of the wall the ScreenRender is looked up by, see getScreenRender
+		ScreenRender* sr = m_screenRender[scRenderIndex];
+		const float cellX = (float)static_cast<int>(sr->getPosX());
+		const float cellY = (float)static_cast<int>(sr->getPosY());
+		m_cellIndex.insert(sr, zRender::RECT_f(cellX, cellX + 1, cellY, cellY + 1));
+	}
 }
 
 Screen::~Screen()
@@ -34,14 +49,17 @@ Screen::~Screen()
 		delete m_screenRender[scRenderIndex];
 	}
 	m_screenRender.clear();
+	delete m_scene;
+	m_scene = NULL;
 }
 
 ScreenRender* Screen::getScreenRender(int posX, int posY) const
 {
-	for (size_t scRenderIndex = 0; scRenderIndex < m_screenRender.size(); scRenderIndex++)
+	std::vector<ScreenRender*> hits;
+	m_cellIndex.hitTest(posX + 0.5f, posY + 0.5f, hits);
+	for (size_t i = 0; i < hits.size(); i++)
 	{
-		ScreenRender* sr = m_screenRender[scRenderIndex];
-		if (!sr)	continue;
+		ScreenRender* sr = hits[i];
 		if (static_cast<int>(sr->getPosX()) == posX
 			&& static_cast<int>(sr->getPosY()) == posY)
 			return sr;
@@ -49,6 +67,26 @@ ScreenRender* Screen::getScreenRender(int posX, int posY) const
 	return NULL;
 }
 
+int Screen::getScreenRenders(const zRender::RECT_f& regOfScreen, std::vector<ScreenRender*>& out) const
+{
+	return m_cellIndex.queryOverlaps(regOfScreen, out);
+}
+
+void Screen::beginLayout()
+{
+	m_scene->beginUpdate();
+}
+
+int Screen::endLayout()
+{
+	return m_scene->endUpdate();
+}
+
+LONG Screen::tick()
+{
+	return m_scene->tick();
+}
+
 BigViewport* Screen::createViewport(const zRender::RECT_f& viewportReg, int zIndex)
 {
 	try{
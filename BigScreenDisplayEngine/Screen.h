@@ -5,6 +5,8 @@
 #include <DXGI.h>
 #include <vector>
 #include "DxRenderCommon.h"
+#include "RegionGrid.h"
+#include "SceneState.h"
 #include <exception>
 
 namespace SOA
@@ -42,9 +44,45 @@ namespace Render
 		void destroyViewport(BigViewport** bigviewport);
 
 		inline std::vector<ScreenRender*> getScreenRender() const;
+
+		/**
+		 *	@brief	the ScreenRender of the cell (posX, posY) of the wall, looked up in the cell index
+		 **/
 		ScreenRender* getScreenRender(int posX, int posY) const;
+
+		/**
+		 *	@brief	the ScreenRenders of the cells overlapping regOfScreen, each one once
+		 *	@return	int count of the ScreenRenders added to out
+		 **/
+		int getScreenRenders(const zRender::RECT_f& regOfScreen, std::vector<ScreenRender*>& out) const;
+
+		/**
+		 *	@brief	the layout drawn by the cells, written by the BigViewports of this screen
+		 **/
+		SceneState* getSceneState() const { return m_scene; }
+
+		/**
+		 *	@name		beginLayout
+		 *	@brief		the changes of the BigViewports until endLayout() are published together and every cell shows them from the same frame
+		 **/
+		void beginLayout();
+
+		/**
+		 *	@return		int 0:published >0:in a nested beginLayout() -1:no beginLayout()
+		 **/
+		int endLayout();
+
+		/**
+		 *	@name		tick
+		 *	@brief		the frame boundary: the layout published becomes the one drawn by every cell.
+		 *				Called by the frame clock before it signals the timer events of the cells
+		 *	@return		LONG epoch of the layout drawn from this frame
+		 **/
+		LONG tick();
 	private:
+		SceneState* m_scene;						//created before the ScreenRenders, deleted after them
 		std::vector<ScreenRender*> m_screenRender;
+		RegionGrid<ScreenRender*> m_cellIndex;		//one grid cell per cell of the wall, built once by the constructor
 
 	private:
 		Screen(const Screen& sc);
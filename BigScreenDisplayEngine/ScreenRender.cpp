@@ -4,7 +4,7 @@
 
 using namespace SOA::Mirror::Render;
 
-ScreenRender::ScreenRender(IDXGIOutput* dxgiOutput, float posX, float posY, BigScreenBackground* background)
+ScreenRender::ScreenRender(IDXGIOutput* dxgiOutput, float posX, float posY, BigScreenBackground* background, SceneState* scene)
 	: m_rd(NULL)
 	, m_window(NULL)
 	, m_timerHandle(NULL)
@@ -29,7 +29,7 @@ ScreenRender::ScreenRender(IDXGIOutput* dxgiOutput, float posX, float posY, BigS
 
 	HANDLE eventHandle = CreateEvent(NULL, false, false, NULL);
 	assert(eventHandle != INVALID_HANDLE_VALUE);
-	SOA::Mirror::Render::RenderDrawing* rd = new SOA::Mirror::Render::RenderDrawing(hWnd, posX, posY, posX + 1.0f, posY + 1.0f, background);
+	SOA::Mirror::Render::RenderDrawing* rd = new SOA::Mirror::Render::RenderDrawing(hWnd, posX, posY, posX + 1.0f, posY + 1.0f, background, scene);
 	if (0 != rd->start(eventHandle))
 	{
 		//printf("Error in  ScreenRender::ScreenRender : start render drawing failed.\n");
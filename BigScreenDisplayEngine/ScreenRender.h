@@ -15,6 +15,7 @@ namespace Render
 {
 	class RenderDrawing;
 	class BigScreenBackground;
+	class SceneState;
 
 	class ScreenRender
 	{
@@ -25,7 +26,7 @@ namespace Render
 		zRender::RECT_f m_DisplayReg;
 
 	public:
-		ScreenRender(IDXGIOutput* dxgiOutput, float posX, float posY, BigScreenBackground* background) throw (std::exception);
+		ScreenRender(IDXGIOutput* dxgiOutput, float posX, float posY, BigScreenBackground* background, SceneState* scene = NULL) throw (std::exception);
 		~ScreenRender();
 
 		RenderDrawing* getRenderDrawing() const;
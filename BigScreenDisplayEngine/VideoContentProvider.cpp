@@ -12,10 +12,13 @@ unsigned char* RawFrameRefData::getData(int& dataLen, int& yPitch, int& uPitch,
 		return NULL;
 	if(m_isUpdatedIdentify<=identify)
 		return NULL;
-	dataLen = m_DataLen;
+	dataLen = m_frame.size();
 	if(dataLen<=0)
 		return NULL;
-	yPitch = m_Pitch;
+	const zRender::FrameLayout& layout = m_frame.layout();
+	yPitch = layout.pitch(0);
+	uPitch = layout.planeCount()>1 ? layout.pitch(1) : 0;
+	vPitch = layout.planeCount()>2 ? layout.pitch(2) : 0;
 	width = m_frameWidth;
 	height = m_frameHeight;
 	pixelFmt = m_framePixFmt;
@@ -26,5 +29,6 @@ unsigned char* RawFrameRefData::getData(int& dataLen, int& yPitch, int& uPitch,
 	effectReg.top = m_frameHeight * effectiveReg.top + 0.5;
 	effectReg.bottom = m_frameHeight * effectiveReg.bottom + 0.5;
 	identify = m_isUpdatedIdentify;
-	return m_pFrameData;
+	//the texture only reads the frame, it stays immutable while it is shared
+	return const_cast<unsigned char*>(m_frame.data());
 }
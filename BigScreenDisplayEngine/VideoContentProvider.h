@@ -11,6 +11,9 @@
 #define _SOA_MIRROR_RENDER_VIDEO_CP_H_
 
 #include "IDisplayContentProvider.h"
+#include "inc/FrameLayout.h"
+#include "inc/FrameView.h"
+#include "inc/FrameRef.h"
 
 namespace zRender
 {
@@ -38,6 +41,7 @@ namespace Render
 			: m_isUpdatedIdentify(0)
 			, m_frameHeight(0), m_frameWidth(0), m_framePixFmt(zRender::PIXFMT_UNKNOW)
 		{			
+			SetRectEmpty(&m_effectiveRect);
 		}
 
 		/**
@@ -51,7 +55,7 @@ namespace Render
 			, m_frameHeight(height), m_frameWidth(width), m_framePixFmt(zRender::PIXFMT_UNKNOW)
 			, m_Pitch(0)
 		{
-			
+			SetRectEmpty(&m_effectiveRect);
 		}
 
 		/**
@@ -102,16 +106,11 @@ namespace Render
 		#endif
 				return -1;
 			}
-			if(m_framePixFmt==zRender::PIXFMT_UNKNOW || m_frameWidth==0 || m_frameHeight==0)
+			RECT cropRect;
+			if(m_framePixFmt==zRender::PIXFMT_UNKNOW || m_frameWidth==0 || m_frameHeight==0 || !getCropRect(textureReg, cropRect))
 				return -2;
-			float texReg_width = textureReg.width();
-			float texReg_height = textureReg.height();
-			float effReg_width = m_effectiveReg.width();
-			float effReg_height = m_effectiveReg.height();
-			float actual_width = texReg_width * effReg_width * m_frameWidth;
-			float actual_height = texReg_height * effReg_height * m_frameHeight;
-			width = actual_width;
-			height = actual_height;
+			width = cropRect.right - cropRect.left;
+			height = cropRect.bottom - cropRect.top;
 			yPitch = m_Pitch;//FRAMEPITCH(width, m_framePixFmt);
 			dataLen = yPitch * height;
 			pixelFmt = m_framePixFmt;
@@ -158,6 +157,9 @@ namespace Render
 				return -1;
 			}
 			m_effectiveReg = textureEffectiveReg;
+			RECT frameRect = {0, 0, m_frameWidth, m_frameHeight};
+			if(!zRender::FrameView::toPixelRect(textureEffectiveReg, frameRect, m_effectiveRect))
+				SetRectEmpty(&m_effectiveRect);
 			m_isUpdatedIdentify++;
 			return 0;
 		}
@@ -171,6 +173,21 @@ namespace Render
 		{
 			return m_effectiveReg;
 		}
+	protected:
+		/**
+		 *	@name		getCropRect
+		 *	@brief		ȡЧtextureRegָ꣬ϽǶ뵽ɫȲFrameView::cropĽһ
+		 *				ЧsetEffectiveRegʱ㣬ÿεֻtextureRegĸȡ
+		 *	@return		bool true--ɹ  false--Ϊջ߲Ϸ
+		 **/
+		bool getCropRect(const zRender::RECT_f& textureReg, RECT& rect) const
+		{
+			if(!zRender::FrameView::toPixelRect(textureReg, m_effectiveRect, rect))
+				return false;
+			zRender::FrameView::alignCropRect(m_framePixFmt, rect);
+			return true;
+		}
+
 	protected:
 		int m_isUpdatedIdentify;
 		int m_frameWidth;
@@ -180,6 +197,7 @@ namespace Render
 
 	private:
 		zRender::RECT_f m_effectiveReg;
+		RECT m_effectiveRect;		//ЧͼƬе
 	};
 	
 	/**
@@ -293,16 +311,20 @@ namespace Render
 		int m_vvCount;
 	};
 
+	/**
+	 *	@name		RawFrameRefData
+	 *	@brief		һ֡ݣԹͬһ֡
+	 *				и֡FrameRefʹ֡ıͼѾŻͷţ֡ڸöɾ֮ǰһֱЧ
+	 **/
 	class RawFrameRefData : public PictureTextureDataSource
 	{
 	public:
-		RawFrameRefData(unsigned char* frameData, unsigned long dataLen,
-						int width, int height, int pitch, zRender::PIXFormat pixfmt)
-						: PictureTextureDataSource(width, height)
-						, m_pFrameData(frameData), m_DataLen(dataLen)
+		RawFrameRefData(const zRender::FrameRef& frame)
+						: PictureTextureDataSource(frame.layout().width(), frame.layout().height())
+						, m_frame(frame)
 		{
-			m_framePixFmt = pixfmt;
-			m_Pitch = pitch;
+			m_framePixFmt = frame.layout().valid() ? frame.layout().pixfmt() : zRender::PIXFMT_UNKNOW;
+			m_Pitch = frame.layout().valid() ? frame.layout().pitch(0) : 0;
 		}
 
 		~RawFrameRefData() {}
@@ -318,16 +340,34 @@ namespace Render
 			return -1;
 		}
 
+		int getFrameView(const zRender::RECT_f& textureReg, zRender::FrameView& view, int& identify)
+		{
+			RECT cropRect;
+			if(!isFrameParamValid() || !getCropRect(textureReg, cropRect))
+				return -1;
+			view = m_frame.view().crop(cropRect);
+			if(!view.valid())
+				return -2;
+			identify = m_isUpdatedIdentify;
+			return 0;
+		}
+
+		int getFrameRef(zRender::FrameRef& frame, int& identify)
+		{
+			if(!isFrameParamValid())
+				return -1;
+			frame = m_frame;
+			identify = m_isUpdatedIdentify;
+			return 0;
+		}
+
 	private:
-		unsigned char* m_pFrameData;
-		unsigned long m_DataLen;
+		zRender::FrameRef m_frame;
 
 		bool isFrameParamValid() const
 		{
-			return m_pFrameData!=NULL && m_frameWidth>0 && m_frameHeight>0
-				&& m_framePixFmt!=zRender::PIXFMT_UNKNOW 
-				&& m_Pitch>=FRAMEPITCH(m_frameWidth, m_framePixFmt)
-				&& m_DataLen >= m_Pitch*m_frameHeight;
+			return m_frame.valid() && m_frameWidth>0 && m_frameHeight>0
+				&& m_framePixFmt!=zRender::PIXFMT_UNKNOW;
 		}
 	};
 }
@@ -4,7 +4,11 @@
 
 #include "IDisplayContentProvider.h"
 #include "DxRenderCommon.h"
-#include <fstream>
+#include "inc/FrameLayout.h"
+#include "inc/FrameView.h"
+#include "inc/FrameRef.h"
+#include "inc/FrameQueue.h"
+#include "FrameFileRing.h"
 #include <assert.h>
 
 namespace zRender
@@ -18,62 +22,66 @@ namespace Mirror
 {
 namespace Render
 {
+	/**
+	 *	@name		VideoTextureDataSource
+	 *	@brief		frames of a raw file shown by every partition of a BigView.
+	 *				draw() is the producer, on the thread of the VideoTextureSourceUpdater: it reads the next frame of the ring into m_queue.
+	 *				The partitions are the consumers, on the render threads: once each authorized partition has drawn the frame shown,
+	 *				the next call takes the oldest frame queued. The pops are serialized by m_shownLock, so m_queue sees one consumer at a time
+	 **/
 	class VideoTextureDataSource : public zRender::TextureDataSource
 	{
 	public:
-		VideoTextureDataSource(const char* fileName, zRender::PIXFormat pixFmt, int width, int height, int pitch)
-			: m_isUpdatedIdentify(0)
+		enum { FRAME_QUEUE_DEPTH = 2 };
+
+		/**
+		 *	@brief	the frames are read by a FrameFileRing, ringDepth frames are held in memory whatever the length of the file
+		 *			and the first frame is there when the constructor returns
+		 **/
+		VideoTextureDataSource(const char* fileName, zRender::PIXFormat pixFmt, int width, int height, int pitch,
+							int ringDepth = FrameFileRing::DEFAULT_RING_DEPTH, int prefetch = FrameFileRing::DEFAULT_PREFETCH_DISTANCE)
+			: m_isUpdatedIdentify(0), m_idtCount(0), m_DrawedCount(0)
 			, m_frameHeight(0), m_frameWidth(0), m_framePixFmt(zRender::PIXFMT_UNKNOW), m_framePitch(0)
-			, m_curFrameIndex(-1)
+			, m_queue(FRAME_QUEUE_DEPTH, zRender::FRAME_QUEUE_DROP_OLDEST)
 		{
+			InitializeCriticalSection(&m_shownLock);
+			SetRectEmpty(&m_effectiveRect);
 			if(pixFmt<=0 || width<=0 || height<=0 || pitch<=0 || NULL==fileName)
 				return;
-			std::ifstream srcFileStream(fileName, std::ios::binary | std::ios::in);
-			if(!srcFileStream)
-			{
-				assert(false);
+			zRender::FrameLayout layout = createLayout(pixFmt, width, height, pitch);
+			if(!layout.valid())
 				return;
-			}
-			int frameDataLen = pitch * height;
-			unsigned char* frameData = NULL;
-			while(srcFileStream)
+			//frames follow each other in the file, the last row of a frame is padded to the pitch too
+			int lastPlane = layout.planeCount() - 1;
+			int frameDataLen = layout.offset(lastPlane) + layout.pitch(lastPlane) * layout.planeRows(lastPlane);
+			if(0!=m_frames.open(fileName, frameDataLen, ringDepth, prefetch))
 			{
-				frameData = (unsigned char*)malloc(frameDataLen);
-				assert(frameData);
-				srcFileStream.read((char*)frameData, frameDataLen);
-				m_frameVector.push_back(frameData);
-			}
-			srcFileStream.close();
-			if(m_frameVector.size()<=0)
-			{
-				free(frameData);
+				assert(false);
 				return;
 			}
 			m_frameHeight = height;
 			m_frameWidth = width;
 			m_framePitch = pitch;
 			m_framePixFmt = pixFmt;
+			m_frameLayout = layout;
+			m_shown = m_frames.currentFrameRef(layout);
 
 			m_isUpdatedIdentify++;
-			m_idtCount = 0;
-			m_DrawedCount = 0;
-			m_backupIdt = 0;
-			m_reqCount = 0;
 		}
 
 		~VideoTextureDataSource()
 		{
-			m_curFrameIndex = -1;
+			//the frames held pin their slots of the ring, close() waits for them
+			m_queue.clear();
+			m_shown.reset();
+			m_retired.reset();
+			m_frames.close();
+			DeleteCriticalSection(&m_shownLock);
 			m_isUpdatedIdentify = 0;
 			m_frameHeight = 0;
 			m_frameWidth = 0;
 			m_framePitch = 0;
 			m_framePixFmt = zRender::PIXFMT_UNKNOW;
-			for (int i = 0; i < m_frameVector.size(); i++)
-			{
-				free(m_frameVector[i]);
-			}
-			m_frameVector.clear();
 		}
 
 		bool isUpdated(int identify) const {return m_isUpdatedIdentify>identify;}
@@ -89,31 +97,39 @@ namespace Render
 		#endif
 				return -1;
 			}
-			if(m_frameVector.size()<=0 || m_frameWidth==0 || m_frameHeight==0)
+			int shownIdentify = 0;
+			zRender::FrameRef frame = shownFrame(shownIdentify);
+			zRender::FrameView view;
+			if(0!=cropFrame(frame, textureReg, view))
 				return -2;
-			float texReg_width = textureReg.width();
-			float texReg_height = textureReg.height();
-			float effReg_width = m_effectiveReg.width();
-			float effReg_height = m_effectiveReg.height();
-			float actual_width = texReg_width * effReg_width * m_frameWidth;
-			float actual_height = texReg_height * effReg_height * m_frameHeight;
-			width = actual_width;
-			height = actual_height;
-			yPitch = m_framePitch;
-			dataLen = yPitch * height;
+			width = view.width();
+			height = view.height();
+			getPitches(yPitch, uPitch, vPitch);
+			zRender::FrameLayout layout = zRender::FrameLayout::create(m_framePixFmt, width, height, yPitch, uPitch, vPitch);
+			if(!layout.valid())
+				return -3;
+			dataLen = layout.size();
 			pixelFmt = m_framePixFmt;
 			return 0;
 		}
 
+		/**
+		 *	@brief	the data stays in place until every authorized partition has drawn this frame and the next one:
+		 *			the frame replaced is kept in m_retired, a partition still reading it when the next frame is presented
+		 *			has to finish before it can take that frame, and the frame after it cannot be presented before
+		 **/
 		unsigned char* getData(int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, zRender::PIXFormat& pixelFmt, RECT& effectReg, int& identify)
 		{
-			if(m_frameVector.size()<=0 || m_frameWidth==0 || m_frameHeight==0)
+			if(!m_frames.valid() || m_frameWidth==0 || m_frameHeight==0)
 				return NULL;
 
-			if(m_isUpdatedIdentify<=identify)
+			presentNextFrame();
+			int shownIdentify = 0;
+			zRender::FrameRef frame = shownFrame(shownIdentify);
+			if(shownIdentify<=identify || !frame.valid())
 				return NULL;
-			dataLen = m_framePitch * m_frameHeight;
-			yPitch = m_framePitch;
+			dataLen = m_frameLayout.size();
+			getPitches(yPitch, uPitch, vPitch);
 			width = m_frameWidth;
 			height = m_frameHeight;
 			pixelFmt = m_framePixFmt;
@@ -121,17 +137,9 @@ namespace Render
 			effectReg.right = m_frameWidth * m_effectiveReg.right + 0.5;
 			effectReg.top = m_frameHeight * m_effectiveReg.top + 0.5;
 			effectReg.bottom = m_frameHeight * m_effectiveReg.bottom + 0.5;
-			int frameIndex = m_curFrameIndex % m_frameVector.size();
-			identify = m_isUpdatedIdentify;
-			int t = m_DrawedCount + 1;
-			if(m_backupIdt!=0 && t==m_idtCount)
-			{
-				InterlockedExchange((long*)&m_isUpdatedIdentify, m_backupIdt);
-				InterlockedExchange((long*)&m_DrawedCount, 0);
-				InterlockedExchange((long*)&m_backupIdt, 0);
-			}
-			InterlockedIncrement((long*)&m_DrawedCount);
-			return m_frameVector[frameIndex];
+			identify = shownIdentify;
+			InterlockedIncrement(&m_DrawedCount);
+			return const_cast<unsigned char*>(frame.data());
 		}
 	
 		zRender::SharedTexture* getSharedTexture(RECT& effectReg, int& identify)
@@ -143,24 +151,21 @@ namespace Render
 
 		int copyDataToTexture(const zRender::RECT_f& textureReg, unsigned char* dstTextureData, int pitch, int height, int& identify)
 		{
-			if(m_frameVector.size()<=0 || m_frameWidth==0 || m_frameHeight==0)
+			if(!m_frames.valid() || m_frameWidth==0 || m_frameHeight==0)
 				return -1;
 
-			if(m_isUpdatedIdentify<=identify)
+			presentNextFrame();
+			int shownIdentify = 0;
+			zRender::FrameRef frame = shownFrame(shownIdentify);
+			if(shownIdentify<=identify)
 				return 1;
-			
-			//if(m_isUpdatedIdentify==identify+1 || m_isUpdatedIdentify==identify+2)
-			//	InterlockedIncrement((long*)&m_reqCount);
-			//if(m_reqCount<m_idtCount)
-			//	return 2;
-
-			float texReg_width = textureReg.width();
-			float texReg_height = textureReg.height();
-			float effReg_width = m_effectiveReg.width();
-			float effReg_height = m_effectiveReg.height();
-			float actual_width = texReg_width * effReg_width * m_frameWidth;
-			float actual_height = texReg_height * effReg_height * m_frameHeight;
-			if(pitch<actual_width*2 || height<actual_height || NULL==dstTextureData)
+
+			zRender::FrameView view;
+			if(0!=cropFrame(frame, textureReg, view))
+				return -2;
+			//the crop is read in place, the rows go straight into the mapped texture
+			zRender::FrameLayout dstLayout = createLayout(m_framePixFmt, view.width(), view.height(), pitch);
+			if(!dstLayout.valid() || height<view.height() || NULL==dstTextureData)
 			{
 #ifdef _DEBUG
 				printf("Error copyDataToTexture : param invalid.(pData=%d, pitch=%d, H=%d)\n",
@@ -168,36 +173,10 @@ namespace Render
 #endif
 				return -2;
 			}
-
-			//float fStartPosHrz = m_frameWidth * m_effectiveReg.left + actual_width * textureReg.left + 0.5;
-			//float fStartPosVtc = m_frameHeight * m_effectiveReg.top + actual_height * textureReg.top + 0.5;
-			float fStartPosHrz = m_frameWidth * (m_effectiveReg.left + m_effectiveReg.width()*textureReg.left) + 0.5;
-			float fStartPosVtc = m_frameHeight * (m_effectiveReg.top + m_effectiveReg.height() * textureReg.top) + 0.5;
-			int iStartPosHrz = fStartPosHrz;
-			int iStartPosVtc = fStartPosVtc;
-			int iEndPosVtc = iStartPosVtc+actual_height;
-			int dataLenCopyed = actual_width*2;
-			int frameIndex = m_curFrameIndex % m_frameVector.size();
-			unsigned char* frameData = m_frameVector[frameIndex];
-			for(int iVtc=iStartPosVtc; iVtc<iEndPosVtc; iVtc++)
-			{				
-				int dataPos = iVtc * m_framePitch + iStartPosHrz * 2;
-				unsigned char* pVtcData = frameData + dataPos;
-				memcpy(dstTextureData, pVtcData, dataLenCopyed);
-				dstTextureData += pitch;
-			}
-			identify = m_isUpdatedIdentify;
-			int t = m_DrawedCount + 1;
-			//if(t==m_idtCount)
-			//	m_reqCount = 0;
-
-			if(m_backupIdt!=0 && t==m_idtCount)
-			{
-				InterlockedExchange((long*)&m_isUpdatedIdentify, m_backupIdt);
-				InterlockedExchange((long*)&m_DrawedCount, 0);
-				InterlockedExchange((long*)&m_backupIdt, 0);
-			}
-			InterlockedIncrement((long*)&m_DrawedCount);
+			if(0!=view.copyTo(dstTextureData, dstLayout))
+				return -3;
+			identify = shownIdentify;
+			InterlockedIncrement(&m_DrawedCount);
 			return 0;
 		}
 
@@ -213,58 +192,147 @@ namespace Render
 				return -1;
 			}
 			m_effectiveReg = textureEffectiveReg;
-			m_isUpdatedIdentify++;
+			RECT frameRect = {0, 0, m_frameWidth, m_frameHeight};
+			if(!zRender::FrameView::toPixelRect(textureEffectiveReg, frameRect, m_effectiveRect))
+				SetRectEmpty(&m_effectiveRect);
+			InterlockedIncrement(&m_isUpdatedIdentify);
 			return 0;
 		}
 
-		int draw()
+		int getFrameView(const zRender::RECT_f& textureReg, zRender::FrameView& view, int& identify)
 		{
-			//m_curFrameIndex = 0;
-			//return 0;
-			if(m_frameVector.size()<=0 || m_frameWidth==0 || m_frameHeight==0)
+			int shownIdentify = 0;
+			zRender::FrameRef frame = shownFrame(shownIdentify);
+			if(0!=cropFrame(frame, textureReg, view))
 				return -1;
-			if(m_DrawedCount>=m_idtCount)
-			{
-				m_DrawedCount = 0;
-				m_backupIdt = 0;
-				m_isUpdatedIdentify++;
-			}
-			else
-			{
-				int t = m_isUpdatedIdentify+1;
-				InterlockedCompareExchange((long*)&t, t, m_isUpdatedIdentify+1);
-				m_backupIdt = t;
-			}
-			m_curFrameIndex++;
-			//int index = m_curFrameIndex + 1;
-			//index %= m_frameVector.size();
+			identify = shownIdentify;
+			return 0;
+		}
 
+		int getFrameRef(zRender::FrameRef& frame, int& identify)
+		{
+			int shownIdentify = 0;
+			frame = shownFrame(shownIdentify);
+			if(!frame.valid())
+				return -1;
+			identify = shownIdentify;
+			return 0;
+		}
+
+		/**
+		 *	@brief	queue the next frame of the file, the producer side
+		 *	@return	int 0:a frame was queued 1:the reader is behind, the frame shown stays <0:not opened
+		 **/
+		int draw()
+		{
+			if(!m_frames.valid() || !m_frameLayout.valid())
+				return -1;
+			if(!m_frames.advance())
+				return 1;
+			zRender::FrameRef frame = m_frames.currentFrameRef(m_frameLayout);
+			if(!frame.valid())
+				return -2;
+			//the partitions are slower than the rate, the oldest frame waiting is dropped and the newest is shown next
+			m_queue.push(frame);
 			return 0;
 		}
 
 		void increaseAuthorization()
 		{
-			InterlockedIncrement((long*)&m_idtCount);
+			InterlockedIncrement(&m_idtCount);
 		}
 		void decreaseAuthorization()
 		{
-			InterlockedDecrement((long*)&m_idtCount);
+			InterlockedDecrement(&m_idtCount);
+		}
+
+		zRender::FrameQueueStats getQueueStats() const { return m_queue.getStats(); }
+
+	private:
+		/**
+		 *	@brief	planes of the frames read from the file, the chroma rows of the planar formats are half as wide as the luma rows
+		 **/
+		static zRender::FrameLayout createLayout(zRender::PIXFormat pixFmt, int width, int height, int pitch)
+		{
+			int uvPitch = pixFmt==zRender::PIXFMT_NV12 ? pitch : pitch / 2;
+			return zRender::FrameLayout::create(pixFmt, width, height, pitch, uvPitch, uvPitch);
+		}
+
+		/**
+		 *	@brief	the pitches of the planes as IRawFrameTexture::update() takes them, NV12 has no V plane of its own
+		 **/
+		void getPitches(int& yPitch, int& uPitch, int& vPitch) const
+		{
+			const int planeOfU = m_frameLayout.planeOfU();
+			const int planeOfV = m_frameLayout.planeOfV();
+			yPitch = m_frameLayout.pitch(0);
+			uPitch = planeOfU > 0 ? m_frameLayout.pitch(planeOfU) : 0;
+			vPitch = planeOfV > 0 && planeOfV != planeOfU ? m_frameLayout.pitch(planeOfV) : 0;
+		}
+
+		/**
+		 *	@brief	the consumer side, every authorized partition has drawn the frame shown and the oldest frame queued takes its place
+		 **/
+		void presentNextFrame()
+		{
+			if(m_DrawedCount<m_idtCount || m_queue.size()==0)
+				return;
+			//the frame retired before is released after the lock
+			zRender::FrameRef next;
+			EnterCriticalSection(&m_shownLock);
+			if(m_DrawedCount>=m_idtCount && m_queue.pop(next))
+			{
+				m_shown.swap(next);
+				m_retired.swap(next);
+				InterlockedExchange(&m_DrawedCount, 0);
+				InterlockedIncrement(&m_isUpdatedIdentify);
+			}
+			LeaveCriticalSection(&m_shownLock);
+		}
+
+		/**
+		 *	@brief	the frame shown and its identify read together, the frame stays valid while the FrameRef is held
+		 **/
+		zRender::FrameRef shownFrame(int& identify)
+		{
+			EnterCriticalSection(&m_shownLock);
+			zRender::FrameRef frame = m_shown;
+			identify = m_isUpdatedIdentify;
+			LeaveCriticalSection(&m_shownLock);
+			return frame;
+		}
+
+		/**
+		 *	@brief	view of the region textureReg of the effective region of frame, m_effectiveRect is computed once in setEffectiveReg
+		 **/
+		int cropFrame(const zRender::FrameRef& frame, const zRender::RECT_f& textureReg, zRender::FrameView& view) const
+		{
+			if(!frame.valid())
+				return -1;
+			RECT rect;
+			if(!zRender::FrameView::toPixelRect(textureReg, m_effectiveRect, rect))
+				return -2;
+			view = frame.view().crop(rect);
+			return view.valid() ? 0 : -3;
 		}
 
 	private:
-		int m_isUpdatedIdentify;
-		int m_idtCount;
-		int m_DrawedCount;
-		int m_reqCount;
-		int m_backupIdt;
+		volatile LONG m_isUpdatedIdentify;	//grows with every frame shown and every change of the effective region
+		volatile LONG m_idtCount;			//partitions authorized to show the frames
+		volatile LONG m_DrawedCount;		//partitions which have drawn the frame shown
 
 		zRender::RECT_f m_effectiveReg;
+		RECT m_effectiveRect;		//m_effectiveReg in pixel of the frame
+		zRender::FrameLayout m_frameLayout;
 		int m_frameWidth;
 		int m_frameHeight;
 		zRender::PIXFormat m_framePixFmt;
 		int m_framePitch;
-		std::vector<unsigned char*> m_frameVector;
-		int m_curFrameIndex;
+		FrameFileRing m_frames;
+		zRender::FrameQueue m_queue;		//frames read by draw() and not shown yet
+		zRender::FrameRef m_shown;			//frame drawn by the partitions now
+		zRender::FrameRef m_retired;		//frame shown before m_shown, the pointer getData() handed out may still be read
+		CRITICAL_SECTION m_shownLock;		//m_shown, m_retired and the consumer side of m_queue
 	};
 
 	class VideoTextureSourceUpdater
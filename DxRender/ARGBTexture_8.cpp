@@ -4,6 +4,9 @@
 #include <stdio.h>
 #include "DXLogger.h"
 #include "inc/TextureResource.h"
+#include "inc/PixelFormatConverter.h"
+#include "inc/FrameLayout.h"
+#include "inc/PlaneCopy.h"
 
 using namespace zRender;
 #define LOG_TAG L"D3D11_ARGBTexture_8"
@@ -210,8 +213,9 @@ int zRender::ARGBTexture_8::FrameTexture::update_A8R8G8B8( const unsigned char*
 	int updatedHeight = regHeight >= m_height ? m_height : regHeight;
 	int startPosHrz = regionUpdated.left;
 	int startPosVtc = regionUpdated.top;
-	int dataLenCopyed = (int)(updatedWidth * PixelByteCount[m_pixfmt]);
-	unsigned char* pDataStartPos = (unsigned char*)pData + (startPosVtc * dataPitch + (int)(startPosHrz * PixelByteCount[m_pixfmt]));
+	FrameLayout layout = FrameLayout::create(m_pixfmt, width, height, dataPitch, 0, 0);
+	int dataLenCopyed = FRAMEPITCH(updatedWidth, m_pixfmt);
+	unsigned char* pDataStartPos = (unsigned char*)pData + layout.pixelOffset(0, startPosHrz, startPosVtc);
 
 	D3D11_MAPPED_SUBRESOURCE mappedRes;
 	ZeroMemory(&mappedRes, sizeof(mappedRes));
@@ -231,12 +235,7 @@ int zRender::ARGBTexture_8::FrameTexture::update_A8R8G8B8( const unsigned char*
 		return -4;
 	}
 	unsigned char* pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight; iVtc++)
-	{				
-		memcpy(pDes, pDataStartPos, dataLenCopyed);
-		pDes += mappedRes.RowPitch;
-		pDataStartPos += dataPitch;
-	}
+	copyPlane(pDataStartPos, dataPitch, pDes, mappedRes.RowPitch, dataLenCopyed, updatedHeight);
 	d3dDevContex->Unmap(m_rgbTexStage, 0);
 	D3D11_BOX box;
 	box.front = 0;
@@ -268,8 +267,9 @@ int zRender::ARGBTexture_8::FrameTexture::update_R8G8B8( const unsigned char* pD
 	int updatedHeight = regHeight >= m_height ? m_height : regHeight;
 	int startPosHrz = regionUpdated.left;
 	int startPosVtc = regionUpdated.top;
-	int dataLenCopyed = (int)(updatedWidth * PixelByteCount[m_pixfmt]);
-	unsigned char* pDataStartPos = (unsigned char*)pData + (startPosVtc * dataPitch + (int)(startPosHrz * PixelByteCount[m_pixfmt]));
+	FrameLayout layout = FrameLayout::create(m_pixfmt, width, height, dataPitch, 0, 0);
+	int dataLenCopyed = FRAMEPITCH(updatedWidth, m_pixfmt);
+	unsigned char* pDataStartPos = (unsigned char*)pData + layout.pixelOffset(0, startPosHrz, startPosVtc);
 
 	D3D11_MAPPED_SUBRESOURCE mappedRes;
 	ZeroMemory(&mappedRes, sizeof(mappedRes));
@@ -289,23 +289,8 @@ int zRender::ARGBTexture_8::FrameTexture::update_R8G8B8( const unsigned char* pD
 		return -4;
 	}
 	unsigned char* pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight; iVtc++)
-	{		
-		unsigned char* pLine = pDes;
-		unsigned char* pSrcLine = pDataStartPos;
-		for (int iHrz=0; iHrz<updatedWidth; iHrz++)
-		{
-			pLine[0] = pSrcLine[0];
-			pLine[1] = pSrcLine[1];
-			pLine[2] = pSrcLine[2];
-			pLine[3] = 0xff;
-			pSrcLine += 3;
-			pLine += 4;
-		}
-
-		pDes += mappedRes.RowPitch;
-		pDataStartPos += dataPitch;
-	}
+	//RGB24 is expanded to the B8G8R8A8 texture with an opaque alpha
+	convertPixelFormat(PIXFMT_R8G8B8, pDataStartPos, dataPitch, PIXFMT_B8G8R8A8, pDes, mappedRes.RowPitch, updatedWidth, updatedHeight);
 	d3dDevContex->Unmap(m_rgbTexStage, 0);
 	D3D11_BOX box;
 	box.front = 0;
@@ -318,6 +303,63 @@ int zRender::ARGBTexture_8::FrameTexture::update_R8G8B8( const unsigned char* pD
 	return 0;
 }
 
+int ARGBTexture_8::update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+						const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex)
+{
+	if(PIXFMT_UNKNOW==m_pixfmt || (!m_VideoFrame.valid() && m_textureArray[0] == NULL))
+		return -1;
+	if(width<=0 || height<=0 || pData==NULL || yPitch<FRAMEPITCH(width, m_pixfmt)
+		|| dataLen < yPitch*height || (m_VideoFrame.valid() && d3dDevContex==NULL))
+		return -2;
+	std::vector<RECT> rects;
+	if(0 != prepareRegions(regions, regionCount, width, height, coalesce, rects))
+		return -3;
+	if(rects.empty())
+		return 0;
+	if(!m_VideoFrame.valid())
+	{
+		//staging texture of a SharedTextureSource
+		return updateResourceRegions(pData, dataLen, yPitch, width, height, rects);
+	}
+	if(width != m_VideoFrame.m_width || height != m_VideoFrame.m_height)
+		return -3;
+	if(m_pixfmt == PIXFMT_R8G8B8)
+		return m_VideoFrame.updateRegions_R8G8B8(pData, yPitch, rects, d3dDevContex);
+	return uploadPlaneRegions(d3dDevContex, m_VideoFrame.m_rgbTexStage, m_VideoFrame.m_rgbTex,
+							pData, yPitch, PixelFormatDescs[m_pixfmt].planes[0], 4, rects);
+}
+
+int zRender::ARGBTexture_8::FrameTexture::updateRegions_R8G8B8(const unsigned char* pData, int dataPitch, const std::vector<RECT>& regions,
+															ID3D11DeviceContext* d3dDevContex)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedRes;
+	ZeroMemory(&mappedRes, sizeof(mappedRes));
+	if(S_OK!=d3dDevContex->Map(m_rgbTexStage, 0, D3D11_MAP_WRITE, 0, &mappedRes))
+		return -4;
+	unsigned char* pDes = (unsigned char*)mappedRes.pData;
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		const RECT& rect = regions[i];
+		convertPixelFormat(PIXFMT_R8G8B8, pData + rect.top * dataPitch + rect.left * 3, dataPitch,
+						PIXFMT_B8G8R8A8, pDes + rect.top * mappedRes.RowPitch + rect.left * 4, mappedRes.RowPitch,
+						rect.right - rect.left, rect.bottom - rect.top);
+	}
+	d3dDevContex->Unmap(m_rgbTexStage, 0);
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		const RECT& rect = regions[i];
+		D3D11_BOX box;
+		box.front = 0;
+		box.back = 1;
+		box.left = rect.left;
+		box.right = rect.right;
+		box.top = rect.top;
+		box.bottom = rect.bottom;
+		d3dDevContex->CopySubresourceRegion(m_rgbTex, 0, rect.left, rect.top, 0, m_rgbTexStage, 0, &box);
+	}
+	return 0;
+}
+
 zRender::ARGBTexture_8::FrameTexture zRender::ARGBTexture_8::create_txframe( ID3D11Device* device, int width, int height, const char* initData, int dataLen )
 {
 	/*D3D11_TEXTURE2D_DESC texDesc;
@@ -80,6 +80,13 @@ namespace zRender
 							const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
 
 		virtual int update(SharedTexture* pSharedTexture, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
+
+		/**
+		 *	@name		update
+		 *	@brief		μӿ @ref IRawFrameTexture Ķ˵
+		 **/
+		virtual int update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+							const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex);
 	private:
 		ARGBTexture_8(const ARGBTexture_8&);
 		ARGBTexture_8& operator=(const ARGBTexture_8&);
@@ -107,6 +114,8 @@ namespace zRender
 				const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
 			int update_R8G8B8(const unsigned char* pData, int dataLen, int dataPitch, int width, int height,
 				const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
+			int updateRegions_R8G8B8(const unsigned char* pData, int dataPitch, const std::vector<RECT>& regions,
+				ID3D11DeviceContext* d3dDevContex);
 			int getTexture(ID3D11Texture2D** outYUVTexs, int& texsCount) const;
 			int getShaderResourceView(ID3D11ShaderResourceView** outYUVSRVs, int& srvsCount) const;
 			bool valid() const;
@@ -12,6 +12,7 @@ DisplayElement::DisplayElement(DxRender_D3D11* dxRender, ID3D11Device* d3dDevice
 	: m_dxRender(dxRender), m_device(d3dDevice), m_context(context)
 	, m_IndexBuf(NULL), m_IndexFmt(DXGI_FORMAT_UNKNOWN), m_VertexBuf(NULL)
 	, m_texture(NULL), m_isTextureUpdated(false)
+	, m_sharedTexSrc(NULL), m_sharedTexture(NULL), m_sharedTexGeneration(0)
 	, m_curVerVec(NULL), m_isVertexInfoUpdated(false)
 	, m_TexFmt(PIXFMT_UNKNOW), m_TexWidth(0), m_TexHeight(0), m_TexDataSrc(NULL)
 	, m_dsplModel(NULL)
@@ -140,6 +141,9 @@ int DisplayElement::setTexture(PIXFormat pixfmt, int width, int height)
 
 int DisplayElement::setTextureDataSource(TextureDataSource* dataSrc, const RECT_f& textureReg)
 {
+	//the shared texture is given back before its source goes away
+	if(m_sharedTexture && dataSrc!=m_sharedTexSrc)
+		releaseTexTureResource();
 	if(dataSrc==NULL)//dataSrcΪNULLԶtextureRegļ
 	{
 		m_TexDataSrc = dataSrc;
@@ -225,6 +229,12 @@ int DisplayElement::releaseTexTureResource()
 		delete m_texture;
 		m_texture = NULL;
 	}
+	if(m_sharedTexture)
+	{
+		m_sharedTexSrc->releaseAcquiredTexture(m_sharedTexture);
+		m_sharedTexture = NULL;
+		m_sharedTexSrc = NULL;
+	}
 	return 0;
 }
 
@@ -300,12 +310,25 @@ int DisplayElement::updateTexture(int& identify)
 	m_texture->getTexture(tex2d, tex2dCount);
 	if(tex2dCount<=0)
 		return -1004;
+	if(NULL != m_TexDataSrc->getTexture())
+	{
+		//the source uploads the FrameView it holds into its own shared texture, e.g. SharedTextureSource, no data is read here
+		int frameIdentify = identify;
+		int ret = m_TexDataSrc->copyDataToTexture(RECT_f(0, 1, 0, 1), NULL, 0, 0, frameIdentify);
+		//a shared texture created again meanwhile got the frame, not the one opened here: identify stays so the next update reopens
+		if(ret>=0 && m_sharedTexGeneration!=m_TexDataSrc->getTextureGeneration())
+			return -1006;
+		identify = frameIdentify;
+		return ret;
+	}
 
  	RECT effectReg;
  	//zRender::SharedTexture* shTex = m_TexDataSrc->getSharedTexture(effectReg, identify);
-	int dataLen, width, height, yPitch, uPitch, vPitch;
-	PIXFormat pixfmt;
-	unsigned char* pData = m_TexDataSrc->getData(dataLen, yPitch, uPitch, vPitch, width, height, pixfmt, effectReg, identify);
+	int dataLen = 0, width = 0, height = 0, yPitch = 0, uPitch = 0, vPitch = 0;
+	PIXFormat pixfmt = PIXFMT_UNKNOW;
+	//identify moves on once the frame is in the texture, a failed upload is tried again with the next update
+	int frameIdentify = identify;
+	unsigned char* pData = m_TexDataSrc->getData(dataLen, yPitch, uPitch, vPitch, width, height, pixfmt, effectReg, frameIdentify);
 	int effectRegWidth = effectReg.right-effectReg.left;
 	int effectRegHeight = effectReg.bottom-effectReg.top;
 	if(pData==NULL || dataLen<=0 || width<=0 || height<=0 
@@ -318,9 +341,13 @@ int DisplayElement::updateTexture(int& identify)
 	copyedReg.right = (LONG)(effectReg.left + (effectRegWidth * m_TexEffectiveReg.right + 0.5));
 	copyedReg.top = (LONG)(effectReg.top + (effectRegHeight * m_TexEffectiveReg.top + 0.5));
 	copyedReg.bottom = (LONG)(effectReg.top + (effectRegHeight * m_TexEffectiveReg.bottom + 0.5));
-	return m_TexDataSrc->copyDataToTexture(RECT_f(0, 1, 0, 1), pData, yPitch, height, identify);
-	return m_texture->update(pData, dataLen, yPitch, uPitch, vPitch, width, height, copyedReg, m_context);
-	return -1005;
+	//the region of the frame goes to the top left of the texture, sized by the partition to the region.
+	//The source keeps the frame of pData pinned until its next getData, see MultiplexedSource and VideoTextureDataSource
+	int ret = m_texture->update(pData, dataLen, yPitch, uPitch, vPitch, width, height, copyedReg, m_context);
+	if(0!=ret)
+		return ret;
+	identify = frameIdentify;
+	return 0;
 	//return -1005;
  	//else
  	//{
@@ -361,18 +388,28 @@ void zRender::DisplayElement::enableTransparent( bool enable )
 	m_isEnableTransparent = enable;
 }
 
-int zRender::DisplayElement::openSharedTexture(IRawFrameTexture * sharedTexture)
+int zRender::DisplayElement::openSharedTexture(TextureDataSource* dataSrc)
 {
+	if (dataSrc == NULL)
+		return -1;
+	if (m_texture && m_sharedTexture && m_sharedTexSrc == dataSrc && m_sharedTexGeneration == dataSrc->getTextureGeneration())
+		return 0;
+	int generation = 0;
+	IRawFrameTexture* sharedTexture = dataSrc->acquireTexture(generation);
 	if (sharedTexture == NULL)
 		return -1;
-	if (m_texture)
+	IRawFrameTexture* texture = m_dxRender->openSharedTexture(sharedTexture);
+	if (NULL == texture)
 	{
-		//releaseTexTureResource();
-		return 0;
-	}
-	m_texture = m_dxRender->openSharedTexture(sharedTexture);
-	if (NULL == m_texture)
+		dataSrc->releaseAcquiredTexture(sharedTexture);
 		return -2;
+	}
+	//the texture opened before, of an older generation or of another source, is released with the shared texture it holds
+	releaseTexTureResource();
+	m_texture = texture;
+	m_sharedTexSrc = dataSrc;
+	m_sharedTexture = sharedTexture;
+	m_sharedTexGeneration = generation;
 	return 0;
 }
 
@@ -198,7 +198,13 @@ namespace zRender
 		ElemDsplModel<BasicEffect>* getDsplModel() const { return m_dsplModel; }
 		int draw();
 		//////////////////////////ִ֧򿪹Դʾ///////////////////////////////
-		int openSharedTexture(IRawFrameTexture* sharedTexture);
+		/**
+		 *	@name		openSharedTexture
+		 *	@brief		dataSrcShared TextureʾѾ򿪵ͬһShared Textureʱʲô
+		 *				Դ´Shared Textureʱͷ֮ǰ򿪵Textureµ
+		 *	@return		int 0--ɹ  <0--ʧܣdataSrcûShared Textureߴʧ
+		 **/
+		int openSharedTexture(TextureDataSource* dataSrc);
 	private:
 		DisplayElement(const DisplayElement& rObj);
 		DisplayElement& operator=(const DisplayElement& robj);
@@ -227,6 +233,9 @@ namespace zRender
 		bool m_isTextureUpdated;
 
 		IRawFrameTexture*	m_texture;//std::shared_ptr<YUVTexture_Packed*>
+		TextureDataSource*	m_sharedTexSrc;			//the source of the shared texture m_texture is opened on
+		IRawFrameTexture*	m_sharedTexture;		//held by acquireTexture until m_texture is released
+		int					m_sharedTexGeneration;
 		ID3D11Buffer*		m_VertexBuf;//std::shared_ptr<ID3D11Buffer*>
 		ID3D11Buffer*		m_IndexBuf;//std::shared_ptr<ID3D11Buffer*>
 		DXGI_FORMAT			m_IndexFmt;//
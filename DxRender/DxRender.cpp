@@ -92,6 +92,11 @@ int DxRender::clear(DWORD color)
 	return m_renderImp->clear(color);
 }
 
+int DxRender::clearDepth()
+{
+	return m_renderImp->clearDepth();
+}
+
 int DxRender::setupBackground(IDisplayContentProvider* contentProvider, const RECT_f& displayReg)
 {
 	if(m_background)
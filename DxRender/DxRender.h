@@ -223,6 +223,13 @@ namespace zRender
 		 */
 		int clear(DWORD color);
 
+		/**
+		 *	@name		clearDepth
+		 *	@brief		ֻȻ壬ʾݡʾ򱻲͸ȫǡҪɫʱ
+		 *	@return		int 0--ɹ   <0--ʧ
+		 */
+		int clearDepth();
+
 		/**
 		 *	@name			lockBackbufferHDC
 		 *	@brief			ȡBackBufferHDCʾGDI
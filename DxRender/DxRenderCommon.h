@@ -91,15 +91,89 @@ namespace zRender
 	 **/
 	const float PixelByteCount[] = {0, 1.5, 2, 4, 3, 1.5, 4, 1.5, 4, 4, 4};
 
+	/**
+	 *	@brief	one plane of a pixel format. A row of the plane holds ceil(ceil(width>>shiftX) / blockWidth) blocks of blockBytes,
+	 *			the plane holds ceil(height>>shiftY) rows
+	 **/
+	struct PlaneFormatDesc
+	{
+		int shiftX;			//log2 of the horizontal subsampling
+		int shiftY;			//log2 of the vertical subsampling
+		int blockWidth;		//samples stored in one block, 2 for YUY2 (Y0 U Y1 V)
+		int blockBytes;		//bytes of one block
+	};
+
+	/**
+	 *	@brief	planes of a pixel format in memory order, e.g. Y-V-U for PIXFMT_YV12
+	 **/
+	struct PixelFormatDesc
+	{
+		int planeCount;
+		PlaneFormatDesc planes[3];
+	};
+
+	/**
+	 *	@brief	exact description of every PIXFormat, index by the PIXFormat value
+	 **/
+	constexpr PixelFormatDesc PixelFormatDescs[] = {
+		{0, {{0, 0, 1, 0}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_UNKNOW
+		{3, {{0, 0, 1, 1}, {1, 1, 1, 1}, {1, 1, 1, 1}}},	//PIXFMT_YUV420P
+		{1, {{0, 0, 2, 4}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_YUY2
+		{1, {{0, 0, 1, 4}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_A8R8G8B8
+		{1, {{0, 0, 1, 3}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_R8G8B8
+		{2, {{0, 0, 1, 1}, {1, 1, 1, 2}, {0, 0, 1, 0}}},	//PIXFMT_NV12
+		{1, {{0, 0, 1, 4}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_X8R8G8B8
+		{3, {{0, 0, 1, 1}, {1, 1, 1, 1}, {1, 1, 1, 1}}},	//PIXFMT_YV12
+		{1, {{0, 0, 1, 4}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_R8G8B8A8
+		{1, {{0, 0, 1, 4}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_B8G8R8A8
+		{1, {{0, 0, 1, 4}, {0, 0, 1, 0}, {0, 0, 1, 0}}},	//PIXFMT_B8G8R8X8
+	};
+
+	constexpr bool isKnownPixelFormat(PIXFormat pixfmt)
+	{
+		return pixfmt > PIXFMT_UNKNOW && (int)pixfmt < (int)(sizeof(PixelFormatDescs) / sizeof(PixelFormatDescs[0]));
+	}
+
+	constexpr int getPlaneRowBytes(const PlaneFormatDesc& desc, int width)
+	{
+		return ((((width + (1 << desc.shiftX) - 1) >> desc.shiftX) + desc.blockWidth - 1) / desc.blockWidth) * desc.blockBytes;
+	}
+
+	constexpr int getPlaneRows(const PlaneFormatDesc& desc, int height)
+	{
+		return (height + (1 << desc.shiftY) - 1) >> desc.shiftY;
+	}
+
+	/**
+	 *	@brief	bytes of one row of the first plane, without padding.
+	 *			That is the Y row of the planar formats, the chroma planes have rows of their own, see FrameLayout.
+	 *			YUY2 rows hold whole pixel pairs, an odd width or x is rounded up to the next pair
+	 **/
+	constexpr int getFramePitch(int width, PIXFormat pixfmt)
+	{
+		return isKnownPixelFormat(pixfmt) && width > 0 ? getPlaneRowBytes(PixelFormatDescs[pixfmt].planes[0], width) : 0;
+	}
+
+	/**
+	 *	@brief	bytes of a frame whose planes follow each other without padding
+	 **/
+	constexpr int getFrameSize(int width, int height, PIXFormat pixfmt)
+	{
+		return !isKnownPixelFormat(pixfmt) || width <= 0 || height <= 0 ? 0 :
+			getPlaneRowBytes(PixelFormatDescs[pixfmt].planes[0], width) * getPlaneRows(PixelFormatDescs[pixfmt].planes[0], height)
+			+ (PixelFormatDescs[pixfmt].planeCount > 1 ? getPlaneRowBytes(PixelFormatDescs[pixfmt].planes[1], width) * getPlaneRows(PixelFormatDescs[pixfmt].planes[1], height) : 0)
+			+ (PixelFormatDescs[pixfmt].planeCount > 2 ? getPlaneRowBytes(PixelFormatDescs[pixfmt].planes[2], width) * getPlaneRows(PixelFormatDescs[pixfmt].planes[2], height) : 0);
+	}
+
 /**
 *	@brief һ֡ͼƬĴСbyte
 **/
-#define FRAMESIZE(width, height, pixfmt) ((width)*(height)*(zRender::PixelByteCount[pixfmt]))
+#define FRAMESIZE(width, height, pixfmt) (zRender::getFrameSize((int)(width), (int)(height), (zRender::PIXFormat)(pixfmt)))
 
 /**
 *	@brief 㱣ͼƬһֽbyte
 **/
-#define FRAMEPITCH(width, pixfmt) ((width)*(zRender::PixelByteCount[pixfmt]))
+#define FRAMEPITCH(width, pixfmt) (zRender::getFramePitch((int)(width), (zRender::PIXFormat)(pixfmt)))
 
 	typedef enum TEXTURE_USAGE
 	{
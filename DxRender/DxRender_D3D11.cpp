@@ -11,7 +11,9 @@
 #include "libtext.h"
 #include "SharedFrameTexture.h"
 #include "inc/TextureResource.h"
+#include "inc/ConstantTextureCache.h"
 #include "D3D11TextureRender.h"
+#include <d3d10.h>
 
 using namespace zRender;
 
@@ -95,6 +97,8 @@ int DxRender_D3D11::init(HWND hWnd, const wchar_t* effectFileName, bool isEnable
 		return -2;
 	}
 
+	enableMultithreadProtection();
+
 	if( curFeatureLv < D3D_FEATURE_LEVEL_11_0 )
 	{
 #ifdef _DEBUG
@@ -370,6 +374,8 @@ int zRender::DxRender_D3D11::init(HMONITOR hmonitor)
 	}
 	dstAdapter->Release();
 
+	enableMultithreadProtection();
+
 	if( curFeatureLv < D3D_FEATURE_LEVEL_11_0 )
 	{
 #ifdef _DEBUG
@@ -448,6 +454,8 @@ int zRender::DxRender_D3D11::init( int width, int height, int adapter, const wch
 	}
 	DXGI_releaseAdaptersObjs(adapterVec);
 
+	enableMultithreadProtection();
+
 	if( curFeatureLv < D3D_FEATURE_LEVEL_11_0 )
 	{
 #ifdef _DEBUG
@@ -801,6 +809,8 @@ void DxRender_D3D11::deinit()
 	if( m_context )
 		m_context->ClearState();
 	ReleaseCOM(m_context);
+	if( m_device )
+		ConstantTextureCache::instance().purge(m_device);
 	ReleaseCOM(m_device);
 }
 
@@ -1078,6 +1088,20 @@ int DxRender_D3D11::releaseTexture(IRawFrameTexture** texture)
 	return 0;
 }
 
+void DxRender_D3D11::enableMultithreadProtection()
+{
+	//the render thread draws on m_context while the SharedTextureSources created on this render upload through it
+	//from the render threads of other views, every call on the immediate context takes the lock of the device
+	ID3D10Multithread* multithread = NULL;
+	if(S_OK!=m_context->QueryInterface(__uuidof(ID3D10Multithread), (void**)&multithread))
+	{
+		log_e(LOG_TAG, L"Error in DxRender_D3D11::init : ID3D10Multithread unsupported, the immediate context is not protected.");
+		return;
+	}
+	multithread->SetMultithreadProtected(TRUE);
+	multithread->Release();
+}
+
 ID3D11Buffer* DxRender_D3D11::createBuffer(int byteCount, const unsigned char* initData, int initDataLen,
 									D3D11_USAGE usage, UINT bindFlag)
 {
@@ -1200,6 +1224,15 @@ int DxRender_D3D11::clear(DWORD color)
 	}
 }
 
+int DxRender_D3D11::clearDepth()
+{
+	if (m_context == NULL || m_depthView == NULL)
+		return -1;
+	//the same depth view is bound with the offscreen render target and with the backbuffer
+	m_context->ClearDepthStencilView(m_depthView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	return 0;
+}
+
 int zRender::DxRender_D3D11::lockBackbufferHDC( BOOL Discard, HDC* outHDC )
 {
 	if(m_device==NULL || m_depthView==NULL)
@@ -242,6 +242,13 @@ namespace zRender
 		 */
 		int clear(const RECT_f& clearReg, DWORD color);
 
+		/**
+		 *	@name		clearDepth
+		 *	@brief		ֻȻ壬ʾݡʾ򱻲͸ȫǡҪɫʱ
+		 *	@return		int 0--ɹ   <0--ʧ
+		 */
+		int clearDepth();
+
 		/**
 		 *	@name		present
 		 *	@brief		Կеʾ豸г
@@ -314,6 +321,7 @@ namespace zRender
 
 		ID3D11Buffer* createBuffer(int byteCount, const unsigned char* initData, int initDataLen,
 									D3D11_USAGE usage, UINT bindFlag);
+		void enableMultithreadProtection();
 
 		int setRenderTargetTexture();
 		int setRenderTargetBackbuffer();
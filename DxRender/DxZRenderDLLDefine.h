@@ -10,6 +10,10 @@
 #define DX_ZRENDER_EXPORT_IMPORT _declspec(dllimport)
 #endif
 
+#else
+
+#define DX_ZRENDER_EXPORT_IMPORT
+
 #endif //_WINDOWS
 
 #endif //_ZRENDER_DXRENDER_DLL_DEFINE_H_
\ No newline at end of file
@@ -17,6 +17,8 @@ namespace zRender
 {
 	class SharedTexture;
 	class IRawFrameTexture;
+	class FrameView;
+	class FrameRef;
 
 	/**
 	 *	@name		TextureDataSource
@@ -55,10 +57,12 @@ namespace zRender
 		 *	@param[out]	int& dataLen ݵĳ
 		 *	@param[out]	int& yPitch ݵпYݻRGBݡYUY2ݵп
 		 *	@param[out]	int& uPitch ݵпUݻUVVUݵп
-		 *	@param[out]	int& vPitch ݵпVݵп
+		 *	@param[out]	int& vPitch ݵпVݵпNV12Ϊ0
 		 *	@param[out]	int& width ؿ
 		 *	@param[out]	int& height ĸ
 		 *	@param[out]	int& pixelFmt ظʽ
+		 *				пdataLenFrameLayout㣺ƽ䣬ߵɫпȡYUY2ضȡ
+		 *				YUV420P/YV12uPitchvPitchΪɫƽп(width+1)/2width
 		 *	@return		int 0--ȡɹ  <0--ʧܣǳԱδʼ߳ԱֵϷ
 		 **/
 		virtual int getTextureProfile(const RECT_f& textureReg, int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt) = 0;
@@ -87,6 +91,21 @@ namespace zRender
 
 		virtual IRawFrameTexture* getTexture() = 0;
 
+		/**
+		 *	@name		acquireTexture
+		 *	@brief		ȡShared TexturereleaseAcquiredTexture֮ǰʹԴ´Shared TextureҲᱻͷ
+		 *	@param[out]	int& generation TextureĴԴÿ´Shared Textureʱ
+		 *	@return		IRawFrameTexture* NULL--Shared Texture  NULL--ûShared Texture
+		 **/
+		virtual IRawFrameTexture* acquireTexture(int& generation) { generation = 0; return getTexture(); }
+		virtual void releaseAcquiredTexture(IRawFrameTexture* texture) {}
+
+		/**
+		 *	@name		getTextureGeneration
+		 *	@brief		ǰShared TextureĴacquireTextureĴͬʱеTextureѾٱ£Ӧ»ȡ
+		 **/
+		virtual int getTextureGeneration() const { return 0; }
+
 		/**
 		 *	@name		copyDataToTexture
 		 *	@brief		ݿD3D11еTextureС
@@ -101,6 +120,29 @@ namespace zRender
 		 **/
 		virtual int copyDataToTexture(const RECT_f& textureReg, unsigned char* dstTextureData, int pitch, int height, int& identify) = 0;
 
+		/**
+		 *	@name		getFrameView
+		 *	@brief		ȡtextureRegָݵãݡ
+		 *				㣬ڵ߽磬ϽǶ뵽ɫȲ
+		 *				FrameViewõڴTextureDataSourceһ֡ݸ֮ǰЧ
+		 *	@param[in]	const RECT_f& textureReg Ҫȡ꣬ȡֵΧΪ[0,1]
+		 *	@param[out]	FrameView& view ݵ
+		 *	@param[out]	int& identify ݵıʶ
+		 *	@return		int 0--ɹ  <0--ʧֻܻ߲֧֣ͨcopyDataToTextureȡ
+		 **/
+		virtual int getFrameView(const RECT_f& textureReg, FrameView& view, int& identify) { return -1; }
+
+		/**
+		 *	@name		getFrameRef
+		 *	@brief		ȡǰ֡ݵüݡ
+		 *				getFrameViewֻͬҪFrameRef֡ݾһֱЧᱻ֡ǡ
+		 *				FrameRefӦڴ֡󾡿ͷţļȡ֡ԴڹرʱȴFrameRefͷ
+		 *	@param[out]	FrameRef& frame ǰ֡ݡڴ沼ֺpts
+		 *	@param[out]	int& identify ݵıʶ
+		 *	@return		int 0--ɹ  <0--ʧܻ߲֧
+		 **/
+		virtual int getFrameRef(FrameRef& frame, int& identify) { return -1; }
+
 		virtual void increaseAuthorization() {};
 		virtual void decreaseAuthorization() {};
 	};
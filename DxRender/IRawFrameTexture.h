@@ -105,7 +105,30 @@ namespace zRender
 
 		virtual int update(SharedTexture* pSharedTexture, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex) = 0;
 
-		virtual int copyTexture(const IRawFrameTexture* srcTexture) = 0;
+		/**
+		 *	@name		update
+		 *	@brief		һθͼƬеĶ뵥updateͬÿݿTextureͬλãಿֵݱֲ
+		 *				ÿStage TextureֻMapһΣÿһCopySubresourceRegion
+		 *				ᱻɫȲλãYUV420Pż
+		 *				¶ΨһӿڡSharedTextureSourceStage TextureûԼʾTextureֻдЩ
+		 *				֮Shared TexturecopyTexture(srcTexture, regions, regionCount)ͬ
+		 *	@param[in]	const unsigned char* pData ֡ͼƬݵڴַTextureһ£ͬupdate
+		 *	@param[in]	const RECT* regions Ҫµ飬꣬ͼƬ
+		 *	@param[in]	int regionCount ĸ
+		 *	@param[in]	bool coalesce ΪtrueʱȺϲһߵԼ򣬼ٿĴ
+		 *	@return		int 0--ɹ	<0--ʧ
+		 **/
+		virtual int update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+							const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex) = 0;
+
+		/**
+		 *	@name		copyTexture
+		 *	@brief		srcTextureݿǰTexture
+		 *	@param[in]	const RECT* regions ΪNULLʱTextureֻЩͬλãÿһCopySubresourceRegion
+		 *				Ŀֻֻ֧һƽĸʽ
+		 *	@return		int 0--ɹ	<0--ʧܻ߲֧֣ʧʱ߿ԿTexture
+		 **/
+		virtual int copyTexture(const IRawFrameTexture* srcTexture, const RECT* regions = NULL, int regionCount = 0) = 0;
 
 		/**
 		 *	@name		getWidth
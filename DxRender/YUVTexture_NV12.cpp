@@ -1,6 +1,7 @@
 #include "YUVTexture_NV12.h"
 #include "DxRenderCommon.h"
 #include "DXLogger.h"
+#include "inc/PlaneCopy.h"
 
 using namespace std;
 using namespace zRender;
@@ -199,12 +200,7 @@ int YUVTexture_NV12::update(const unsigned char* pData, int dataLen, int yPitch,
 	}
 	startDataPos = (unsigned char*)pData + (startPosVtc * width + startPosHrz);
 	unsigned char* pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight; iVtc++)
-	{				
-		memcpy(pDes, startDataPos, updatedWidth);
-		pDes += mappedRes.RowPitch;
-		startDataPos += width;
-	}
+	copyPlane(startDataPos, width, pDes, mappedRes.RowPitch, updatedWidth, updatedHeight);
 	d3dDevContex->Unmap(m_yTex, 0);
 
 	if(S_OK!=(rslt=d3dDevContex->Map(m_uvTex, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes)))
@@ -224,12 +220,7 @@ int YUVTexture_NV12::update(const unsigned char* pData, int dataLen, int yPitch,
 
 	pDes = (unsigned char*)mappedRes.pData;
 	int byteCopyed = (updatedWidth + 1) / 2 * 2;
-	for(int iVtc=0; iVtc<updatedHeight/2; iVtc++)
-	{				
-		memcpy(pDes, startDataPos, byteCopyed );//updatedWidth & 0xFFFFFFFE
-		pDes += mappedRes.RowPitch;
-		startDataPos += width;
-	}
+	copyPlane(startDataPos, width, pDes, mappedRes.RowPitch, byteCopyed, updatedHeight/2);
 	d3dDevContex->Unmap(m_uvTex, 0);
 	return 0;
 }
@@ -238,3 +229,16 @@ int zRender::YUVTexture_NV12::update(SharedTexture* pSharedTexture, const RECT&
 {
 	return -1;
 }
+
+int zRender::YUVTexture_NV12::update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+									const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex)
+{
+	std::vector<RECT> rects;
+	if(0 != prepareRegions(regions, regionCount, width, height, coalesce, rects))
+		return -3;
+	if(rects.empty())
+		return 0;
+	//the textures are dynamic and mapping them discards every texel, so the whole frame is written once
+	RECT wholeFrame = {0, 0, width, height};
+	return update(pData, dataLen, yPitch, uPitch, vPitch, width, height, wholeFrame, d3dDevContex);
+}
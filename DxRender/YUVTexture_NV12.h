@@ -77,6 +77,13 @@ namespace zRender
 							const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
 
 		virtual int update(SharedTexture* pSharedTexture, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
+
+		/**
+		 *	@name		update
+		 *	@brief		μӿ @ref IRawFrameTexture Ķ˵
+		 **/
+		virtual int update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+							const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex);
 	private:
 		YUVTexture_NV12(const YUVTexture_NV12&);
 		YUVTexture_NV12& operator=(const YUVTexture_NV12&);
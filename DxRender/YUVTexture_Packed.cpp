@@ -2,6 +2,10 @@
 #include "DxRenderCommon.h"
 #include "DXLogger.h"
 #include "inc/TextureResource.h"
+#include "inc/FrameLayout.h"
+#include "inc/PlaneCopy.h"
+#include "inc/ConstantTextureCache.h"
+#include "inc/FramePool.h"
 
 using namespace zRender;
 
@@ -65,22 +69,38 @@ int zRender::YUVTexture_Packed::create(ID3D11Device * device, int width, int hei
 		return -3;
 	}
 	m_yuvTexRes = yuvTex;
-	TextureResource* parityTexRes = new TextureResource();
-	unsigned char* parityBuf = (unsigned char*)malloc(width*height);
-	for (int indexHeight = 0; indexHeight < height; indexHeight++)
+	TextureResource* parityTexRes = NULL;
+	if (TEXTURE_USAGE_DEFAULT == usage && !bShared)
 	{
-		for (int indexWidth = 0; indexWidth < width; indexWidth++)
-		{
-			parityBuf[width*indexHeight + indexWidth] = (indexWidth % 2) * 255;
-		}
+		//the parity pattern only depends on the size, every YUY2 texture of this size uses the same one
+		parityTexRes = ConstantTextureCache::instance().acquire(device, CONSTANT_TEXTURE_PARITY, width, height);
+		if (NULL == parityTexRes)
+			return -4;
 	}
-	if (0 != parityTexRes->create(device, width, height, DXGI_FORMAT_R8_UNORM, usage, bShared, (char*)parityBuf, width*height, width))
+	else
 	{
-		free(parityBuf);
-		delete parityTexRes;
-		return -4;
+		//a shared texture is opened by other devices and synced with its own keyed mutex, it needs a parity texture of its own
+		parityTexRes = new TextureResource();
+		FrameBuffer parity(width*height);
+		unsigned char* parityBuf = parity.data();
+		if (NULL == parityBuf)
+		{
+			delete parityTexRes;
+			return -4;
+		}
+		for (int indexHeight = 0; indexHeight < height; indexHeight++)
+		{
+			for (int indexWidth = 0; indexWidth < width; indexWidth++)
+			{
+				parityBuf[width*indexHeight + indexWidth] = (indexWidth % 2) * 255;
+			}
+		}
+		if (0 != parityTexRes->create(device, width, height, DXGI_FORMAT_R8_UNORM, usage, bShared, (char*)parityBuf, width*height, width))
+		{
+			delete parityTexRes;
+			return -4;
+		}
 	}
-	free(parityBuf);
 	m_parityTexRes = parityTexRes;
 	if (m_textureCount >= 2)
 	{
@@ -102,9 +122,15 @@ int YUVTexture_Packed::destroy()
 	}
 	if (m_parityTexRes)
 	{
-		m_parityTexRes->release();
+		if (0 != ConstantTextureCache::instance().release(m_parityTexRes))
+			m_parityTexRes->release();
 		m_parityTexRes = NULL;
 	}
+	if (m_textureCount >= 2)
+	{
+		m_textureArray[0] = NULL;
+		m_textureArray[1] = NULL;
+	}
 	m_VideoFrame.destroy();
 	m_device = NULL;
 	m_width = 0;
@@ -186,6 +212,31 @@ int zRender::YUVTexture_Packed::update(SharedTexture* pSharedTexture, const RECT
 	return -1;
 }
 
+int zRender::YUVTexture_Packed::update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+									const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex)
+{
+	if(PIXFMT_UNKNOW==m_pixfmt || (!m_VideoFrame.valid() && m_textureArray[0] == NULL))
+		return -1;
+	if(width<=0 || height<=0 || pData==NULL || yPitch<FRAMEPITCH(width, m_pixfmt)
+		|| dataLen < yPitch*height || (m_VideoFrame.valid() && d3dDevContex==NULL))
+		return -2;
+	std::vector<RECT> rects;
+	if(0 != prepareRegions(regions, regionCount, width, height, coalesce, rects))
+		return -3;
+	if(rects.empty())
+		return 0;
+	if(!m_VideoFrame.valid())
+	{
+		//staging texture of a SharedTextureSource
+		return updateResourceRegions(pData, dataLen, yPitch, width, height, rects);
+	}
+	if(width != m_VideoFrame.m_width || height != m_VideoFrame.m_height)
+		return -3;
+	//the R8G8 texture holds the YUY2 bytes as they are, the parity texture never changes
+	return uploadPlaneRegions(d3dDevContex, m_VideoFrame.m_yuvTexStage, m_VideoFrame.m_yuvTex,
+							pData, yPitch, PixelFormatDescs[m_pixfmt].planes[0], 2, rects);
+}
+
 int zRender::YUVTexture_Packed::FrameTexture::update( const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex )
 {
 	if(PIXFMT_UNKNOW==m_pixfmt || m_yuvTex==NULL || m_yuvSRV==NULL)
@@ -221,8 +272,10 @@ int zRender::YUVTexture_Packed::FrameTexture::update( const unsigned char* pData
 	int updatedHeight = regHeight >= m_height ? m_height : regHeight;
 	int startPosHrz = regionUpdated.left;
 	int startPosVtc = regionUpdated.top;
-	int dataLenCopyed = (int)(updatedWidth * PixelByteCount[m_pixfmt]);
-	unsigned char* pDataStartPos = (unsigned char*)pData + (startPosVtc * yPitch + (int)(startPosHrz * PixelByteCount[m_pixfmt]));
+	//the R8G8 texture holds 2 bytes per pixel, the start is rounded down to a Y0-U-Y1-V pair
+	FrameLayout layout = FrameLayout::create(m_pixfmt, width, height, yPitch, 0, 0);
+	int dataLenCopyed = updatedWidth * 2;
+	unsigned char* pDataStartPos = (unsigned char*)pData + layout.pixelOffset(0, startPosHrz, startPosVtc);
 
 	D3D11_MAPPED_SUBRESOURCE mappedRes;
 	ZeroMemory(&mappedRes, sizeof(mappedRes));
@@ -242,14 +295,7 @@ int zRender::YUVTexture_Packed::FrameTexture::update( const unsigned char* pData
 		return -4;
 	}
 	unsigned char* pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight; iVtc++)
-	{				
-		//int dataPos = iVtc * dataPitch + startPosHrz * PixelByteCount[m_pixfmt];
-		//unsigned char* pVtcData = (unsigned char*)pData + dataPos;
-		memcpy(pDes, pDataStartPos, dataLenCopyed);
-		pDes += mappedRes.RowPitch;
-		pDataStartPos += yPitch;
-	}
+	copyPlane(pDataStartPos, yPitch, pDes, mappedRes.RowPitch, dataLenCopyed, updatedHeight);
 	d3dDevContex->Unmap(m_yuvTexStage, 0);
 	D3D11_BOX box;
 	box.front = 0;
@@ -287,10 +333,13 @@ int zRender::YUVTexture_Packed::FrameTexture::getShaderResourceView( ID3D11Shade
 void zRender::YUVTexture_Packed::FrameTexture::destroy()
 {
 	ReleaseCOM(m_yuvSRV);
-	ReleaseCOM(m_paritySRV);
 	ReleaseCOM(m_yuvTex);
-	ReleaseCOM(m_parityTex);
 	ReleaseCOM(m_yuvTexStage);
+	if(m_parityRes)
+		ConstantTextureCache::instance().release(m_parityRes);
+	m_parityRes = NULL;
+	m_paritySRV = NULL;
+	m_parityTex = NULL;
 	m_width = 0;
 	m_height = 0;
 	m_pixfmt = zRender::PIXFMT_UNKNOW;
@@ -366,32 +415,12 @@ zRender::YUVTexture_Packed::FrameTexture YUVTexture_Packed::create_txframe(ID3D1
 	if(FAILED(device->CreateShaderResourceView(ft.m_yuvTex, &srvDesc, &ft.m_yuvSRV)))
 		goto ErrorEnd;
 
-	texDesc.Format = DXGI_FORMAT_R8_UNORM;
-	texDesc.Usage = D3D11_USAGE_DEFAULT;
-	texDesc.CPUAccessFlags = 0;
-	unsigned char* parityBuf = (unsigned char*)malloc(width*height);
-	for (int indexHeight = 0; indexHeight < height; indexHeight++)
-	{
-		for (int indexWidth = 0; indexWidth < width; indexWidth++)
-		{
-			parityBuf[width*indexHeight + indexWidth] = (indexWidth % 2) * 255;
-		}
-	}
-	initSubData.pSysMem = parityBuf;
-	initSubData.SysMemPitch = width;
-	pSubResData = &initSubData;
-	if(FAILED(device->CreateTexture2D(&texDesc, pSubResData, &ft.m_parityTex)))
-	{
-		free(parityBuf);
-		goto ErrorEnd;
-	}
-	free(parityBuf);
-
-	srvDesc.Format = texDesc.Format;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = 1;
-	if(FAILED(device->CreateShaderResourceView(ft.m_parityTex, &srvDesc, &ft.m_paritySRV)))
+	//the parity pattern only depends on the size, every YUY2 texture of this size uses the same one
+	ft.m_parityRes = ConstantTextureCache::instance().acquire(device, CONSTANT_TEXTURE_PARITY, width, height);
+	if(ft.m_parityRes == NULL)
 		goto ErrorEnd;
+	ft.m_parityTex = ft.m_parityRes->getTexture();
+	ft.m_paritySRV = ft.m_parityRes->getResourceView();
 
 	m_device = device;
 	m_width = width;
@@ -402,6 +431,7 @@ zRender::YUVTexture_Packed::FrameTexture YUVTexture_Packed::create_txframe(ID3D1
 	ft.m_pixfmt = m_pixfmt;
 	return ft;
 ErrorEnd:
+	ft.destroy();
 	destroy();
 	return YUVTexture_Packed::FrameTexture();
 }
@@ -87,6 +87,13 @@ namespace zRender
 							const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
 
 		virtual int update(SharedTexture* pSharedTexture, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
+
+		/**
+		 *	@name		update
+		 *	@brief		μӿ @ref IRawFrameTexture Ķ˵
+		 **/
+		virtual int update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+							const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex);
 	private:
 		YUVTexture_Packed(const YUVTexture_Packed&);
 		YUVTexture_Packed& operator=(const YUVTexture_Packed&);
@@ -99,6 +106,7 @@ namespace zRender
 			ID3D11Texture2D* m_parityTex;
 			ID3D11ShaderResourceView*	m_yuvSRV;
 			ID3D11ShaderResourceView*	m_paritySRV;
+			TextureResource* m_parityRes;		//from ConstantTextureCache, owns m_parityTex and m_paritySRV
 			int m_width;
 			int m_height;
 			PIXFormat m_pixfmt;
@@ -108,6 +116,7 @@ namespace zRender
 				, m_yuvTexStage(NULL)
 				, m_yuvTex(NULL), m_parityTex(NULL)
 				, m_yuvSRV(NULL), m_paritySRV(NULL)
+				, m_parityRes(NULL)
 			{
 
 			}
@@ -6,6 +6,8 @@
 #include <Windows.h>
 #include "DXLogger.h"
 #include "SharedFrameTexture.h"
+#include "inc/FrameLayout.h"
+#include "inc/PlaneCopy.h"
 
 using namespace std;
 using namespace zRender;
@@ -124,6 +126,33 @@ int zRender::YUVTexture_Planar::update(SharedTexture* pSharedTexture, const RECT
 	return ret;
 }
 
+int zRender::YUVTexture_Planar::update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+									const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex)
+{
+	FrameTexture& ft = m_VideoFrame;
+	if(PIXFMT_UNKNOW==m_pixfmt || !ft.valid() || NULL==ft.m_yTexStage || NULL==ft.m_uTexStage || NULL==ft.m_vTexStage)
+		return -1;
+	FrameLayout layout = FrameLayout::create(m_pixfmt, width, height, yPitch, uPitch, vPitch);
+	if(pData==NULL || !layout.valid() || dataLen < layout.size() || d3dDevContex==NULL)
+		return -2;
+	std::vector<RECT> rects;
+	if(width != ft.m_width || height != ft.m_height
+		|| 0 != prepareRegions(regions, regionCount, width, height, coalesce, rects))
+		return -3;
+	const unsigned char* planes[FrameLayout::MAX_PLANE_COUNT] = {NULL, NULL, NULL};
+	layout.getPlanes(pData, planes);
+	const PixelFormatDesc& desc = PixelFormatDescs[m_pixfmt];
+	const int planeOfU = layout.planeOfU();
+	const int planeOfV = layout.planeOfV();
+	if(0 != uploadPlaneRegions(d3dDevContex, ft.m_yTexStage, ft.m_yTex, planes[0], layout.pitch(0), desc.planes[0], 1, rects))
+		return -4;
+	if(0 != uploadPlaneRegions(d3dDevContex, ft.m_uTexStage, ft.m_uTex, planes[planeOfU], layout.pitch(planeOfU), desc.planes[planeOfU], 1, rects))
+		return -5;
+	if(0 != uploadPlaneRegions(d3dDevContex, ft.m_vTexStage, ft.m_vTex, planes[planeOfV], layout.pitch(planeOfV), desc.planes[planeOfV], 1, rects))
+		return -6;
+	return 0;
+}
+
 int zRender::YUVTexture_Planar::FrameTexture::update( const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex )
 {
 	if(m_yTex==NULL || NULL==m_uTex || NULL==m_vTex || NULL==m_ySRV || NULL==m_uSRV || NULL==m_vSRV)
@@ -134,7 +163,8 @@ int zRender::YUVTexture_Planar::FrameTexture::update( const unsigned char* pData
 #endif
 		return -1;
 	}
-	if(width<=0 || height<=0 || pData==NULL	|| dataLen < FRAMESIZE(width, height, m_pixfmt) || d3dDevContex==NULL)
+	FrameLayout layout = FrameLayout::create(m_pixfmt, width, height, yPitch, uPitch, vPitch);
+	if(width<=0 || height<=0 || pData==NULL	|| !layout.valid() || dataLen < layout.size() || d3dDevContex==NULL)
 	{
 #ifdef _DEBUG
 		printf("Error in YUVTexture_Packed::update : param invalid.(Data=%d dataLen=%d width=%d height=%d Ctx=%d)\n",
@@ -177,14 +207,9 @@ int zRender::YUVTexture_Planar::FrameTexture::update( const unsigned char* pData
 		log_e(LOG_TAG, errmsg, 20);
 		return -4;
 	}
-	startDataPos = (unsigned char*)pData + (startPosVtc * yPitch + startPosHrz);
+	startDataPos = (unsigned char*)pData + layout.pixelOffset(0, startPosHrz, startPosVtc);
 	unsigned char* pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight; iVtc++)
-	{				
-		memcpy(pDes, startDataPos, updatedWidth);
-		pDes += mappedRes.RowPitch;
-		startDataPos += yPitch;
-	}
+	copyPlane(startDataPos, yPitch, pDes, mappedRes.RowPitch, updatedWidth, updatedHeight);
 	d3dDevContex->Unmap(m_yTexStage, 0);
 	D3D11_BOX box;
 	box.front = 0;
@@ -207,26 +232,11 @@ int zRender::YUVTexture_Planar::FrameTexture::update( const unsigned char* pData
 		log_e(LOG_TAG, errmsg, 20);
 		return -5;
 	}
-	int startPosVtc_uv = (startPosVtc+1)/2;
-	int startPosHrz_uv = (startPosHrz+1) / 2;
-	int height_uv = (height+1)/2;
 	int updatedHeight_uv = (updatedHeight+1)/2;
 	int updatedWidth_uv = (updatedWidth+1) / 2;
-	if(m_pixfmt==PIXFMT_YUV420P)
-	{
-		startDataPos = (unsigned char*)pData + ((yPitch * height) + ( (startPosVtc_uv) * uPitch + startPosHrz_uv) );
-	}
-	else
-	{
-		startDataPos = (unsigned char*)pData + ((yPitch * height) + vPitch * (height_uv) + ((startPosVtc_uv) * uPitch + startPosHrz_uv));
-	}
+	startDataPos = (unsigned char*)pData + layout.pixelOffset(layout.planeOfU(), startPosHrz, startPosVtc);
 	pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight_uv; iVtc++)
-	{				
-		memcpy(pDes, startDataPos, updatedWidth_uv);
-		pDes += mappedRes.RowPitch;
-		startDataPos += uPitch;
-	}
+	copyPlane(startDataPos, uPitch, pDes, mappedRes.RowPitch, updatedWidth_uv, updatedHeight_uv);
 	d3dDevContex->Unmap(m_uTexStage, 0);
 	box.front = 0;
 	box.back = 1;
@@ -248,22 +258,9 @@ int zRender::YUVTexture_Planar::FrameTexture::update( const unsigned char* pData
 		log_e(LOG_TAG, errmsg, 20);
 		return -6;
 	}
-	if(m_pixfmt==PIXFMT_YUV420P)
-	{
-		startDataPos = (unsigned char*)pData + ((yPitch * height) + uPitch * (height_uv) + ((startPosVtc_uv) * vPitch + startPosHrz_uv));
-	}
-	else
-	{
-		startDataPos = (unsigned char*)pData + ((yPitch * height) + ((startPosVtc_uv) * vPitch + startPosHrz_uv));
-	}
+	startDataPos = (unsigned char*)pData + layout.pixelOffset(layout.planeOfV(), startPosHrz, startPosVtc);
 	pDes = (unsigned char*)mappedRes.pData;
-	for(int iVtc=0; iVtc<updatedHeight_uv; iVtc++)
-	{				
-		memcpy(pDes, startDataPos, updatedWidth_uv);
-		pDes += mappedRes.RowPitch;
-		startDataPos += vPitch;
-		//assert((int)(startDataPos+updatedWidth/2) - (int)pData <= width*height*1.5);
-	}
+	copyPlane(startDataPos, vPitch, pDes, mappedRes.RowPitch, updatedWidth_uv, updatedHeight_uv);
 	d3dDevContex->Unmap(m_vTexStage, 0);
 	box.front = 0;
 	box.back = 1;
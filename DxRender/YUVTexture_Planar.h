@@ -72,6 +72,13 @@ namespace zRender
 
 		virtual int update(SharedTexture* pSharedTexture, const RECT& regionUpdated, ID3D11DeviceContext* d3dDevContex);
 
+		/**
+		 *	@name		update
+		 *	@brief		μӿ @ref IRawFrameTexture Ķ˵
+		 **/
+		virtual int update(const unsigned char* pData, int dataLen, int yPitch, int uPitch, int vPitch, int width, int height,
+							const RECT* regions, int regionCount, bool coalesce, ID3D11DeviceContext* d3dDevContex);
+
 		/**
 		 *	@name		getTexture
 		 *	@brief		μӿ @ref IRawFrameTexture Ķ˵
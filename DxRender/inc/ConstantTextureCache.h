@@ -0,0 +1,86 @@
+/**
+ *	@name		ConstantTextureCache.h
+ *	@brief		process wide cache of the immutable helper textures (e.g. the YUY2 parity pattern) shared by the textures of one device
+ */
+
+#pragma once
+#ifndef _ZRENDER_CONSTANT_TEXTURE_CACHE_H_
+#define _ZRENDER_CONSTANT_TEXTURE_CACHE_H_
+
+#include "DxZRenderDLLDefine.h"
+#include <D3D11.h>
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
+
+namespace zRender
+{
+	class TextureResource;
+
+	/**
+	 *	@brief	content of a constant texture
+	 **/
+	typedef enum CONSTANT_TEXTURE_PATTERN
+	{
+		CONSTANT_TEXTURE_PARITY = 0,	//R8, 0 on even columns and 255 on odd columns, tells the YUY2 shader which Y of the pair to use
+	}CONSTANT_TEXTURE_PATTERN;
+
+	/**
+	 *	@name	ConstantTextureCache
+	 *	@brief	textures with the same (device, pattern, width, height) are created once and reference counted.
+	 *			A few textures nobody uses any more are kept, so the layout of the wall can change without uploading them again.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT ConstantTextureCache
+	{
+	public:
+		static ConstantTextureCache& instance();
+
+		/**
+		 *	@name		acquire
+		 *	@brief		get the texture of the pattern, created with its shader resource view on the first call
+		 *	@return		TextureResource* NULL when failed, must be given back with release()
+		 **/
+		TextureResource* acquire(ID3D11Device* device, CONSTANT_TEXTURE_PATTERN pattern, int width, int height);
+
+		/**
+		 *	@name		release
+		 *	@brief		give back a texture returned by acquire()
+		 *	@return		int 0:success <0:the texture does not belong to the cache
+		 **/
+		int release(TextureResource* texture);
+
+		/**
+		 *	@name		purge
+		 *	@brief		destroy the unused textures of the device, call before the device is released
+		 **/
+		void purge(ID3D11Device* device);
+
+	private:
+		ConstantTextureCache();
+		~ConstantTextureCache();
+		ConstantTextureCache(const ConstantTextureCache&);
+		ConstantTextureCache& operator=(const ConstantTextureCache&);
+
+		TextureResource* createTexture(ID3D11Device* device, CONSTANT_TEXTURE_PATTERN pattern, int width, int height);
+		void trimIdle();
+
+		struct Entry
+		{
+			ID3D11Device* device;
+			CONSTANT_TEXTURE_PATTERN pattern;
+			int width;
+			int height;
+			TextureResource* texture;
+			int refCount;
+			unsigned int lastUsed;		//value of m_useClock when the last reference was released
+		};
+		std::vector<Entry> m_entries;
+		unsigned int m_useClock;
+		CRITICAL_SECTION m_lock;
+	};
+}
+
+#pragma warning(pop)
+
+#endif //_ZRENDER_CONSTANT_TEXTURE_CACHE_H_
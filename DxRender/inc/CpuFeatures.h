@@ -0,0 +1,63 @@
+/**
+ *	@name		CpuFeatures.h
+ *	@brief		runtime detection of the SIMD instruction sets used by the CPU side pixel kernels
+ */
+
+#pragma once
+#ifndef _ZRENDER_CPU_FEATURES_H_
+#define _ZRENDER_CPU_FEATURES_H_
+
+#include "DxZRenderDLLDefine.h"
+
+//MSVC emits any instruction set in any function, GCC and clang want the set named on the kernels using it
+#if defined(_MSC_VER)
+#define ZRENDER_TARGET_SSSE3
+#define ZRENDER_TARGET_SSE42
+#define ZRENDER_TARGET_AVX2
+#else
+#define ZRENDER_TARGET_SSSE3	__attribute__((target("ssse3")))
+#define ZRENDER_TARGET_SSE42	__attribute__((target("sse4.2")))
+#define ZRENDER_TARGET_AVX2		__attribute__((target("avx2")))
+#endif
+
+namespace zRender
+{
+	/**
+	 *	@brief	SIMD instruction sets, returned as a bit mask by getCpuFeatures()
+	 **/
+	enum CPU_FEATURE
+	{
+		CPU_FEATURE_NONE	= 0x00,
+		CPU_FEATURE_SSE2	= 0x01,
+		CPU_FEATURE_SSSE3	= 0x02,
+		CPU_FEATURE_SSE41	= 0x04,
+		CPU_FEATURE_AVX2	= 0x08,
+		CPU_FEATURE_SSE42	= 0x10,		//crc32 instruction
+	};
+
+	/**
+	 *	@name		getCpuFeatures
+	 *	@brief		detect (once) the SIMD instruction sets supported by the CPU and the OS.
+	 *				AVX2 is only reported when the OS saves the YMM registers.
+	 *	@return		unsigned int bit mask of CPU_FEATURE
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT unsigned int getCpuFeatures();
+
+	/**
+	 *	@name		setCpuFeaturesMask
+	 *	@brief		restrict the instruction sets used by the kernels, e.g. to compare the SSE2 path with the AVX2 path.
+	 *				getCpuFeatures() returns (detected & mask) after this call.
+	 *	@param[in]	unsigned int mask bit mask of CPU_FEATURE, 0xffffffff enables everything detected
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT void setCpuFeaturesMask(unsigned int mask);
+
+	/**
+	 *	@name		getLastLevelCacheSize
+	 *	@brief		detect (once) the size of the largest data cache of the CPU, L3 on most desktop parts.
+	 *				Used to decide when a copy is large enough to bypass the caches.
+	 *	@return		int size in bytes, 8MB when the CPU does not report its caches
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int getLastLevelCacheSize();
+}
+
+#endif //_ZRENDER_CPU_FEATURES_H_
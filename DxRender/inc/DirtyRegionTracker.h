@@ -0,0 +1,95 @@
+/**
+ *	@name		DirtyRegionTracker.h
+ *	@brief		damage of a frame kept on a grid of tiles, reported by the producer or detected by hashing the tiles
+ */
+
+#pragma once
+#ifndef _ZRENDER_DIRTY_REGION_TRACKER_H_
+#define _ZRENDER_DIRTY_REGION_TRACKER_H_
+
+#include <Windows.h>
+#include "DxZRenderDLLDefine.h"
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
+
+namespace zRender
+{
+	class FrameView;
+
+	/**
+	 *	@name		DirtyRegionTracker
+	 *	@brief		a frame is cut into square tiles, every tile is either clean or dirty.
+	 *				Dirty tiles are turned into a few rectangles for the upload, runs of tiles on a row are merged
+	 *				and the runs of neighbouring rows covering the same columns too.
+	 *				Not thread safe, used by the thread that produces the frames.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT DirtyRegionTracker
+	{
+	public:
+		enum { DEFAULT_TILE_SIZE = 64 };
+
+		DirtyRegionTracker();
+
+		/**
+		 *	@name		reset
+		 *	@brief		set the size of the frames, every tile is dirty and the hashes are forgotten
+		 *	@param[in]	int tileSize edge of a tile in pixel, a multiple of 2 so the tiles stay on the chroma grid
+		 *	@return		int 0:success <0:the params are invalid
+		 **/
+		int reset(int width, int height, int tileSize = DEFAULT_TILE_SIZE);
+
+		int width() const { return m_width; }
+		int height() const { return m_height; }
+		int tileSize() const { return m_tileSize; }
+
+		/**
+		 *	@brief	mark the tiles touched by rect dirty, rect is clipped to the frame
+		 **/
+		void markDirty(const RECT& rect);
+		void markAllDirty();
+
+		/**
+		 *	@brief	every tile is clean, call after the dirty rectangles have been uploaded
+		 **/
+		void clear();
+
+		/**
+		 *	@name		detectChanges
+		 *	@brief		hash every tile of frame and mark the tiles whose hash changed since the last call dirty.
+		 *				The first call after reset() only records the hashes, the tiles are dirty already
+		 *	@param[in]	const FrameView& frame the new frame, the size must be the one given to reset()
+		 *	@return		int count of tiles found changed, <0 when the frame does not match
+		 **/
+		int detectChanges(const FrameView& frame);
+
+		bool isDirty() const { return m_dirtyCount > 0; }
+		bool isAllDirty() const { return m_dirtyCount == (int)m_dirty.size() && m_dirtyCount > 0; }
+		int dirtyTileCount() const { return m_dirtyCount; }
+
+		/**
+		 *	@name		getDirtyRects
+		 *	@brief		rectangles covering the dirty tiles, clipped to the frame
+		 *	@param[out]	RECT* rects receives the rectangles
+		 *	@param[in]	int maxCount size of rects. When more rectangles are needed the bounding box of the damage is returned
+		 *	@return		int count of rectangles written, 0 when nothing is dirty
+		 **/
+		int getDirtyRects(RECT* rects, int maxCount) const;
+
+	private:
+		int m_width;
+		int m_height;
+		int m_tileSize;
+		int m_tilesX;
+		int m_tilesY;
+		int m_dirtyCount;
+		bool m_hashesValid;
+		std::vector<unsigned char> m_dirty;
+		std::vector<unsigned long long> m_hashes;
+	};
+}
+
+#pragma warning(pop)
+
+#endif //_ZRENDER_DIRTY_REGION_TRACKER_H_
@@ -0,0 +1,37 @@
+/**
+ *	@name		FrameFingerprint.h
+ *	@brief		64 bit fingerprint of the pixels of a frame, used to find frames republished without change
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_FINGERPRINT_H_
+#define _ZRENDER_FRAME_FINGERPRINT_H_
+
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	class FrameView;
+
+	/**
+	 *	@brief	how much of the frame goes into the fingerprint
+	 **/
+	typedef enum FINGERPRINT_MODE
+	{
+		FINGERPRINT_NONE = 0,	//no fingerprint, every frame is taken as new
+		FINGERPRINT_FULL,		//every byte of every plane
+		FINGERPRINT_SAMPLED,	//the first row and every 8th row after it of every plane and the last row, 8 times cheaper.
+								//A change that touches none of these rows, e.g. a small cursor, is missed
+	}FINGERPRINT_MODE;
+
+	/**
+	 *	@name		computeFrameFingerprint
+	 *	@brief		hash the pixels of frame, the padding of the rows is ignored.
+	 *				Uses four interleaved crc32 streams when the CPU has SSE4.2, a multiply-rotate hash otherwise.
+	 *				Fingerprints are only comparable when computed with the same mode in the same process
+	 *	@return		unsigned long long the fingerprint, never 0. 0 when the frame is invalid or mode is FINGERPRINT_NONE
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT unsigned long long computeFrameFingerprint(const FrameView& frame, FINGERPRINT_MODE mode);
+}
+
+#endif //_ZRENDER_FRAME_FINGERPRINT_H_
@@ -0,0 +1,145 @@
+/**
+ *	@name		FrameLayout.h
+ *	@brief		exact geometry of a decoded frame in memory: plane offsets, pitches and subsampling in integer bytes.
+ *				Replaces the float FRAMESIZE/FRAMEPITCH arithmetic and the plane offsets computed by hand in the textures.
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_LAYOUT_H_
+#define _ZRENDER_FRAME_LAYOUT_H_
+
+#include "DxRenderCommon.h"
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	/**
+	 *	@name		FrameLayout
+	 *	@brief		value type describing where every plane of a frame lives relative to the start of the frame buffer.
+	 *				Planes are indexed in memory order (Y-U-V for PIXFMT_YUV420P, Y-V-U for PIXFMT_YV12, Y-UV for PIXFMT_NV12).
+	 *				Pitches may be larger than the row bytes, e.g. 64 byte aligned rows handed over by a producer.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FrameLayout
+	{
+	public:
+		enum { MAX_PLANE_COUNT = 3 };
+
+		/**
+		 *	@name		FrameLayout
+		 *	@brief		an invalid layout
+		 **/
+		FrameLayout();
+
+		/**
+		 *	@name		create
+		 *	@brief		planes follow each other, the pitch of every plane is its row bytes rounded up to alignment
+		 *	@param[in]	PIXFormat pixfmt pixel format
+		 *	@param[in]	int width width of the frame in pixel
+		 *	@param[in]	int height height of the frame in pixel
+		 *	@param[in]	int alignment power of 2, 1 means no padding, 64 gives cache line aligned rows
+		 *	@return		FrameLayout invalid when the params are invalid
+		 **/
+		static FrameLayout create(PIXFormat pixfmt, int width, int height, int alignment = 1);
+
+		/**
+		 *	@name		create
+		 *	@brief		planes follow each other with the pitches used by IRawFrameTexture::update()
+		 *	@param[in]	int yPitch pitch of the Y plane or of the only plane of packed formats
+		 *	@param[in]	int uPitch pitch of the U plane, of the UV plane for PIXFMT_NV12
+		 *	@param[in]	int vPitch pitch of the V plane
+		 *	@return		FrameLayout invalid when the params are invalid or a pitch is smaller than the row bytes
+		 **/
+		static FrameLayout create(PIXFormat pixfmt, int width, int height, int yPitch, int uPitch, int vPitch);
+
+		/**
+		 *	@name		create
+		 *	@brief		planes at arbitrary offsets from the start of the buffer
+		 *	@param[in]	const int offsets[3] offset of every plane in memory order
+		 *	@param[in]	const int pitches[3] pitch of every plane in memory order
+		 *	@return		FrameLayout invalid when the params are invalid or a pitch is smaller than the row bytes
+		 **/
+		static FrameLayout create(PIXFormat pixfmt, int width, int height, const int offsets[3], const int pitches[3]);
+
+		bool valid() const { return m_planeCount > 0; }
+		PIXFormat pixfmt() const { return m_pixfmt; }
+		int width() const { return m_width; }
+		int height() const { return m_height; }
+		int planeCount() const { return m_planeCount; }
+
+		int offset(int plane) const { return m_offsets[plane]; }
+		int pitch(int plane) const { return m_pitches[plane]; }
+		const int* offsets() const { return m_offsets; }
+		const int* pitches() const { return m_pitches; }
+
+		/**
+		 *	@brief	bytes of the samples of one row of the plane, without padding
+		 **/
+		int rowBytes(int plane) const;
+
+		/**
+		 *	@brief	rows of the plane, (height+1)/2 for 4:2:0 chroma
+		 **/
+		int planeRows(int plane) const;
+
+		/**
+		 *	@brief	log2 of the subsampling of the plane
+		 **/
+		int shiftX(int plane) const { return PixelFormatDescs[m_pixfmt].planes[plane].shiftX; }
+		int shiftY(int plane) const { return PixelFormatDescs[m_pixfmt].planes[plane].shiftY; }
+
+		/**
+		 *	@brief	index of the U/V plane, -1 when the component has no plane of its own
+		 **/
+		int planeOfU() const;
+		int planeOfV() const;
+
+		/**
+		 *	@brief	bytes from the start of the buffer to the end of the last row of the last plane
+		 **/
+		int size() const { return m_size; }
+
+		/**
+		 *	@brief	largest power of 2 (up to 4096) dividing every offset and pitch
+		 **/
+		int alignment() const;
+		bool isAligned(int alignment) const { return alignment > 0 && (this->alignment() % alignment) == 0; }
+
+		/**
+		 *	@brief	whether the rows of the plane are stored without padding, the plane can be copied at once
+		 **/
+		bool isPlaneContiguous(int plane) const { return m_pitches[plane] == rowBytes(plane); }
+
+		/**
+		 *	@name		pixelOffset
+		 *	@brief		byte offset from the start of the buffer of the sample of plane covering the luma pixel (x, y).
+		 *				x is rounded down to the start of the block (a YUY2 pixel pair) and to the subsampled grid.
+		 **/
+		int pixelOffset(int plane, int x, int y) const;
+
+		const unsigned char* plane(const unsigned char* base, int plane) const { return base + m_offsets[plane]; }
+		unsigned char* plane(unsigned char* base, int plane) const { return base + m_offsets[plane]; }
+
+		/**
+		 *	@brief	plane pointers of a frame stored at base, the unused entries are NULL
+		 **/
+		void getPlanes(const unsigned char* base, const unsigned char* planes[3]) const;
+		void getPlanes(unsigned char* base, unsigned char* planes[3]) const;
+
+		bool operator==(const FrameLayout& robj) const;
+		bool operator!=(const FrameLayout& robj) const { return !(*this == robj); }
+
+	private:
+		bool init(PIXFormat pixfmt, int width, int height, const int offsets[3], const int pitches[3]);
+
+	private:
+		PIXFormat m_pixfmt;
+		int m_width;
+		int m_height;
+		int m_planeCount;
+		int m_offsets[MAX_PLANE_COUNT];
+		int m_pitches[MAX_PLANE_COUNT];
+		int m_size;
+	};
+}
+
+#endif //_ZRENDER_FRAME_LAYOUT_H_
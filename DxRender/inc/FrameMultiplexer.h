@@ -0,0 +1,172 @@
+/**
+ *	@name		FrameMultiplexer.h
+ *	@brief		one source shown by many views, every frame is converted once per pixel format and shared by the views
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_MULTIPLEXER_H_
+#define _ZRENDER_FRAME_MULTIPLEXER_H_
+
+#include <Windows.h>
+#include "IDisplayContentProvider.h"
+#include "DxZRenderDLLDefine.h"
+#include "inc/FrameRef.h"
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
+
+namespace zRender
+{
+	class FrameMultiplexer;
+
+	/**
+	 *	@name		MultiplexedSource
+	 *	@brief		a view subscribed to a FrameMultiplexer, the TextureDataSource attached to one BigView.
+	 *				It holds a FrameRef of the frame published in its format and the region of the frame it shows,
+	 *				the crop is computed once per change of the region and read in place.
+	 *				getData() returns a raw pointer, the frame it points to is pinned until the next call of getData();
+	 *				the uploaders able to hold the frame themselves use getFrameRef() instead.
+	 *				The frame and the region are read and written under a lock of the view, any thread may call any method
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT MultiplexedSource : public TextureDataSource
+	{
+	public:
+		virtual bool isUpdated(int identify) const;
+		virtual int getTextureProfile(const RECT_f& textureReg, int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt);
+		virtual unsigned char* getData(int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt, RECT& effectReg, int& identify);
+		virtual SharedTexture* getSharedTexture(RECT& effectReg, int& identify) { return NULL; }
+		virtual IRawFrameTexture* getTexture() { return NULL; }
+		virtual int copyDataToTexture(const RECT_f& textureReg, unsigned char* dstTextureData, int pitch, int height, int& identify);
+		virtual int getFrameView(const RECT_f& textureReg, FrameView& view, int& identify);
+		virtual int getFrameRef(FrameRef& frame, int& identify);
+
+		/**
+		 *	@name		setEffectiveReg
+		 *	@brief		region of the frames shown by this view, relative coordinates in [0,1]
+		 *	@return		int 0:success -1:the region is empty or not inside [0,1]
+		 **/
+		int setEffectiveReg(const RECT_f& effectiveReg);
+		RECT_f getEffectiveReg() const;
+
+		/**
+		 *	@brief	pixel format of the frames given to this view, PIXFMT_UNKNOW for the format they are published in
+		 **/
+		PIXFormat getPixelFormat() const { return m_pixfmt; }
+
+	private:
+		friend class FrameMultiplexer;
+
+		MultiplexedSource(const RECT_f& effectiveReg, PIXFormat pixfmt);
+		~MultiplexedSource();
+		MultiplexedSource(const MultiplexedSource&);
+		MultiplexedSource& operator=(const MultiplexedSource&);
+
+		/**
+		 *	@brief	the frame published in m_pixfmt takes the place of the one shown, called by FrameMultiplexer::publish()
+		 **/
+		void present(const FrameRef& frame);
+
+		/**
+		 *	@brief	the frame shown, its identify and the crop read together
+		 **/
+		FrameRef shownFrame(int& identify, RECT& effectiveRect) const;
+
+		static bool isValidRegion(const RECT_f& region);
+
+		const PIXFormat m_pixfmt;
+		FrameRef m_frame;
+		FrameRef m_dataFrame;		//frame of the pointer returned by the last getData(), whatever was presented since
+		RECT_f m_effectiveReg;
+		RECT m_effectiveRect;		//m_effectiveReg in pixel of m_frame, empty until the first frame
+		int m_identify;				//grows with every frame and every change of the region
+		mutable CRITICAL_SECTION m_lock;
+	};
+
+	struct FrameMultiplexerStats
+	{
+		long published;		//frames given to publish()
+		long conversions;	//frames converted to the format of a group of views
+		long failures;		//conversions failed or not supported, the views of the format keep the frame they show
+	};
+
+	/**
+	 *	@name		FrameMultiplexer
+	 *	@brief		the producer publishes each frame once, whatever the number of views showing the source.
+	 *				The views are grouped by pixel format: the views of the format of the frame share the frame itself,
+	 *				the frame is converted once for each other format and the result is shared by the views of that format.
+	 *				A camera shown in a big window and in several thumbnails costs one conversion per format and no copy per view.
+	 *				publish() runs on the thread of the producer, the views are read by the render threads.
+	 *				The conversions run outside the lock of the multiplexer into buffers of the FramePool, the lock is only held
+	 *				to swap the frames of the views, so a render thread reading a view never waits for a conversion.
+	 *				The frames are published by one producer thread at a time
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FrameMultiplexer
+	{
+	public:
+		FrameMultiplexer();
+		~FrameMultiplexer();
+
+		/**
+		 *	@name		subscribe
+		 *	@brief		add a view showing the region effectiveReg of the frames, the last frame published is shown until the next one
+		 *	@param[in]	PIXFormat pixfmt format the view wants the frames in, PIXFMT_UNKNOW for the format they are published in
+		 *	@return		MultiplexedSource* owned by the multiplexer until unsubscribe(), NULL when effectiveReg is invalid
+		 **/
+		MultiplexedSource* subscribe(const RECT_f& effectiveReg, PIXFormat pixfmt = PIXFMT_UNKNOW);
+
+		/**
+		 *	@brief	remove and delete a view, the BigView showing it must have released it
+		 *	@return	int 0:success -1:not a view of this multiplexer
+		 **/
+		int unsubscribe(MultiplexedSource* view);
+
+		/**
+		 *	@name		publish
+		 *	@brief		give a frame to every view, converted at most once per pixel format wanted
+		 *	@return		int 0:every view got the frame <0:empty frame >0:views of that many formats keep the previous frame
+		 **/
+		int publish(const FrameRef& frame);
+
+		/**
+		 *	@name		publish
+		 *	@brief		give a frame the caller only keeps during the call, e.g. a frame of a file mapping or of a read buffer used again.
+		 *				It is converted once per pixel format wanted and copied once for the views of its own format,
+		 *				the views hold frames of the FramePool only
+		 *	@return		int 0:every view got the frame <0:invalid frame >0:views of that many formats keep the previous frame
+		 **/
+		int publish(const FrameView& frame, long long pts);
+
+		int getViewCount() const;
+		FrameMultiplexerStats getStats() const;
+
+	private:
+		FrameMultiplexer(const FrameMultiplexer&);
+		FrameMultiplexer& operator=(const FrameMultiplexer&);
+
+		/**
+		 *	@brief	shared is the FrameRef of view or empty when the frame is borrowed, the views of its format get a copy then
+		 **/
+		int publishFrame(const FrameRef& shared, const FrameView& view, long long pts);
+
+		/**
+		 *	@brief	the formats wanted by the views, one entry per format, read under the lock
+		 **/
+		std::vector<PIXFormat> wantedFormats(PIXFormat published) const;
+
+		/**
+		 *	@brief	a frame of the FramePool holding frame in pixfmt, a copy when pixfmt is the format of frame
+		 **/
+		static FrameRef convert(const FrameView& frame, PIXFormat pixfmt, long long pts);
+
+		std::vector<MultiplexedSource*> m_views;
+		FrameRef m_last;
+		long m_publishSequence;				//grows with every publish(), tells subscribe() a frame came during its conversion
+		FrameMultiplexerStats m_stats;
+		mutable CRITICAL_SECTION m_lock;	//m_views, m_last, m_publishSequence and m_stats, held by publish() so a view never misses a frame
+	};
+}
+
+#pragma warning(pop)
+
+#endif //_ZRENDER_FRAME_MULTIPLEXER_H_
@@ -0,0 +1,148 @@
+/**
+ *	@name		FramePool.h
+ *	@brief		process wide pool of aligned frame buffers, a buffer given back is handed out again for the next frame of the same size
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_POOL_H_
+#define _ZRENDER_FRAME_POOL_H_
+
+#include "DxZRenderDLLDefine.h"
+#include "DxRenderCommon.h"
+#include <Windows.h>
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
+
+namespace zRender
+{
+	/**
+	 *	@brief	counters of FramePool. A playback without allocation only adds to hits
+	 **/
+	struct FramePoolStats
+	{
+		long long hits;					//acquires served with a buffer given back before
+		long long misses;				//acquires that allocated
+		long long bytesOutstanding;		//bytes of the buffers handed out and not given back
+		long long bytesPooled;			//bytes of the buffers waiting in the pool
+		long long largePageBuffers;		//buffers allocated on large pages, still alive
+	};
+
+	/**
+	 *	@name	FramePool
+	 *	@brief	buffers are keyed by (pixel format, width, height), or by the byte count for PIXFMT_UNKNOW.
+	 *			Every buffer starts on BUFFER_ALIGN bytes, a buffer of a page or more starts on a page.
+	 *			A few idle buffers are kept per key, the ones over MAX_IDLE_PER_KEY are freed when given back.
+	 *			The pool is reference counted by instance() and by every buffer handed out: static objects destroyed
+	 *			after the instance at the end of the process still give their buffers back, the last one frees the pool.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FramePool
+	{
+	public:
+		enum { BUFFER_ALIGN = 64, PAGE_ALIGN = 4096, MAX_IDLE_PER_KEY = 4 };
+
+		static FramePool& instance();
+
+		/**
+		 *	@name		acquire
+		 *	@brief		a buffer of FRAMESIZE(width, height, pixfmt) bytes, the content is what the last user left
+		 *	@return		unsigned char* NULL when failed, must be given back with release()
+		 **/
+		unsigned char* acquire(PIXFormat pixfmt, int width, int height);
+
+		/**
+		 *	@brief	a buffer of byteCount bytes, for the data not in a pixel format
+		 **/
+		unsigned char* acquire(int byteCount);
+
+		/**
+		 *	@name		release
+		 *	@brief		give back a buffer returned by acquire()
+		 *	@return		int 0:success <0:the buffer does not belong to the pool
+		 **/
+		int release(unsigned char* buffer);
+
+		/**
+		 *	@name		setLargePages
+		 *	@brief		allocate the buffers of at least GetLargePageMinimum() bytes on large pages, fewer TLB misses when the frames are copied.
+		 *				Needs the "Lock pages in memory" right of the user, the buffers are allocated as usual without it
+		 *	@return		bool true when large pages can be used
+		 **/
+		bool setLargePages(bool enable);
+
+		/**
+		 *	@brief	free the buffers waiting in the pool
+		 **/
+		void trim();
+
+		FramePoolStats getStats() const;
+
+	private:
+		FramePool();
+		~FramePool();
+		FramePool(const FramePool&);
+		FramePool& operator=(const FramePool&);
+
+		//the reference of instance(), dropped when the static objects of the process are destroyed
+		struct InstanceRef;
+		friend struct InstanceRef;
+		void releaseRef();
+
+		struct Buffer
+		{
+			unsigned char* data;
+			PIXFormat pixfmt;
+			int width;
+			int height;
+			size_t size;
+			bool largePage;
+			bool inUse;
+		};
+
+		unsigned char* acquireKey(PIXFormat pixfmt, int width, int height, size_t size);
+		bool allocate(Buffer& buffer);
+		static void freeBuffer(Buffer& buffer);
+
+		std::vector<Buffer> m_buffers;
+		FramePoolStats m_stats;
+		bool m_largePages;
+		size_t m_largePageMin;
+		mutable CRITICAL_SECTION m_lock;
+		volatile LONG m_refs;			//instance() and the buffers handed out
+	};
+
+	/**
+	 *	@name	FrameBuffer
+	 *	@brief	a buffer of the FramePool given back when the FrameBuffer is destroyed or reset
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FrameBuffer
+	{
+	public:
+		FrameBuffer() : m_data(NULL), m_size(0), m_pool(NULL) {}
+		FrameBuffer(PIXFormat pixfmt, int width, int height);
+		explicit FrameBuffer(int byteCount);
+		~FrameBuffer() { reset(); }
+
+		bool allocate(PIXFormat pixfmt, int width, int height);
+		bool allocate(int byteCount);
+		void reset();
+		void swap(FrameBuffer& other);
+
+		unsigned char* data() const { return m_data; }
+		int size() const { return m_size; }
+		bool valid() const { return m_data != NULL; }
+
+	private:
+		FrameBuffer(const FrameBuffer&);
+		FrameBuffer& operator=(const FrameBuffer&);
+
+		unsigned char* m_data;
+		int m_size;
+		FramePool* m_pool;				//the buffer goes back to it even once instance() is gone
+	};
+}
+
+#pragma warning(pop)
+
+#endif //_ZRENDER_FRAME_POOL_H_
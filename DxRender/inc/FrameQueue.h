@@ -0,0 +1,121 @@
+/**
+ *	@name		FrameQueue.h
+ *	@brief		bounded lock-free queue of frames from one producer thread to one consumer thread
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_QUEUE_H_
+#define _ZRENDER_FRAME_QUEUE_H_
+
+#include <Windows.h>
+#include "DxZRenderDLLDefine.h"
+#include "inc/FrameRef.h"
+
+namespace zRender
+{
+	/**
+	 *	@brief	what push() does when the queue is full
+	 **/
+	typedef enum FRAME_QUEUE_OVERFLOW
+	{
+		FRAME_QUEUE_DROP_OLDEST = 0,	//the oldest frame queued is released, the producer never waits. For the live sources
+		FRAME_QUEUE_BLOCK,				//the producer waits for the consumer, no frame is lost. For the files played at any speed
+	}FRAME_QUEUE_OVERFLOW;
+
+	/**
+	 *	@brief	counters of a FrameQueue, pushed == popped + dropped + size() at any quiet moment
+	 **/
+	struct FrameQueueStats
+	{
+		long pushed;		//frames queued by push()
+		long popped;		//frames taken by pop()
+		long dropped;		//frames released by push() to make room, FRAME_QUEUE_DROP_OLDEST only
+		long timeouts;		//push() given up after waiting for room, FRAME_QUEUE_BLOCK only
+	};
+
+	/**
+	 *	@name		FrameQueue
+	 *	@brief		ring of FrameRef, the frames come out in the order they went in.
+	 *				One thread calls push() and another one pop(), the consumer may change if the pops never overlap.
+	 *				The producer and the consumer indexes live on their own cache lines.
+	 *				With FRAME_QUEUE_BLOCK the head is only moved by the consumer and push() finding room and pop() are wait-free.
+	 *				With FRAME_QUEUE_DROP_OLDEST a push() on a full queue races pop() for the oldest frame by one InterlockedCompareExchange,
+	 *				the loser retries after the winner has moved the head, the queue stays lock-free and a frame is never taken twice.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FrameQueue
+	{
+	public:
+		enum { CACHE_LINE = 64, SPIN_COUNT = 1000 };
+
+		/**
+		 *	@param[in]	int capacity frames held at most, at least 1
+		 **/
+		explicit FrameQueue(int capacity, FRAME_QUEUE_OVERFLOW overflow = FRAME_QUEUE_DROP_OLDEST);
+		~FrameQueue();
+
+		/**
+		 *	@name		push
+		 *	@brief		queue a frame, the producer side
+		 *	@param[in]	DWORD timeoutMs how long FRAME_QUEUE_BLOCK waits for room, ignored by FRAME_QUEUE_DROP_OLDEST
+		 *	@return		int 0:queued 1:queued and the oldest frame dropped -1:empty frame -2:no room before the timeout
+		 **/
+		int push(const FrameRef& frame, DWORD timeoutMs = INFINITE);
+
+		/**
+		 *	@name		pop
+		 *	@brief		take the oldest frame, the consumer side
+		 *	@return		bool false when the queue is empty, frame is left as it was
+		 **/
+		bool pop(FrameRef& frame);
+
+		/**
+		 *	@brief	release the frames queued, the consumer side
+		 **/
+		void clear();
+
+		/**
+		 *	@brief	frames queued now, only a hint while the other side runs
+		 **/
+		int size() const;
+		int capacity() const { return m_capacity; }
+		FRAME_QUEUE_OVERFLOW overflow() const { return m_overflow; }
+
+		FrameQueueStats getStats() const;
+
+	private:
+		FrameQueue(const FrameQueue&);
+		FrameQueue& operator=(const FrameQueue&);
+
+		typedef FrameRef::Block Block;
+
+		/**
+		 *	@brief	move the head over the oldest frame, the frame belongs to the caller when it returns true
+		 **/
+		bool takeHead(LONG head, Block*& block);
+
+		//read-only after the constructor, shared by both sides
+		Block* volatile* m_slots;
+		LONG m_mask;
+		int m_capacity;
+		FRAME_QUEUE_OVERFLOW m_overflow;
+		HANDLE m_roomFreed;
+		char m_sharedPad[CACHE_LINE];
+
+		//written by the producer
+		volatile LONG m_tail;
+		LONG m_headCache;				//head seen by the producer last, it only grows
+		volatile LONG m_pushed;
+		volatile LONG m_dropped;
+		volatile LONG m_timeouts;
+		volatile LONG m_producerWaiting;
+		char m_producerPad[CACHE_LINE - 6 * sizeof(LONG)];
+
+		//written by the consumer, and by the producer dropping the oldest frame
+		volatile LONG m_head;
+		LONG m_tailCache;				//tail seen by the consumer last, it only grows
+		volatile LONG m_popped;
+		char m_consumerPad[CACHE_LINE - 3 * sizeof(LONG)];
+	};
+}
+
+#endif //_ZRENDER_FRAME_QUEUE_H_
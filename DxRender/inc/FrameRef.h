@@ -0,0 +1,120 @@
+/**
+ *	@name		FrameRef.h
+ *	@brief		reference counted handle of a decoded frame, one frame is shared by all the cells and partitions showing it
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_REF_H_
+#define _ZRENDER_FRAME_REF_H_
+
+#include <Windows.h>
+#include "DxRenderCommon.h"
+#include "DxZRenderDLLDefine.h"
+#include "inc/FrameLayout.h"
+#include "inc/FrameView.h"
+
+namespace zRender
+{
+	/**
+	 *	@brief	called once when the last FrameRef of a frame goes, gives the buffer back to its producer
+	 **/
+	typedef void (*FrameReleaseHook)(unsigned char* data, void* context);
+
+	/**
+	 *	@name		FrameRef
+	 *	@brief		value type, copies share the frame and the count is changed with Interlocked*, so copies may live on any thread.
+	 *				The frame is immutable once shared: only the single owner may write it, through mutableData().
+	 *				The buffer, its layout and the pts stay valid as long as one FrameRef of the frame is alive,
+	 *				whatever the producer or the layout of the consumers does meanwhile.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FrameRef
+	{
+	public:
+		/**
+		 *	@brief	the blocks counting the references come from a free list keeping up to MAX_FREE_BLOCKS of them,
+		 *			wrapping the frames at the rate of the video allocates nothing
+		 **/
+		enum { MAX_FREE_BLOCKS = 256 };
+
+		/**
+		 *	@brief	an empty handle
+		 **/
+		FrameRef() : m_block(NULL) {}
+		FrameRef(const FrameRef& other);
+		FrameRef& operator=(const FrameRef& other);
+		~FrameRef() { reset(); }
+
+		/**
+		 *	@name		wrap
+		 *	@brief		share a buffer of the caller, hook(data, context) is called when the last FrameRef goes
+		 *	@param[in]	int dataLen bytes of the buffer, at least layout.size()
+		 *	@param[in]	FrameReleaseHook hook NULL when the caller keeps the buffer alive longer than the FrameRefs by other means
+		 *	@return		FrameRef empty when the params are invalid, the hook is not called then
+		 **/
+		static FrameRef wrap(unsigned char* data, int dataLen, const FrameLayout& layout, long long pts,
+							 FrameReleaseHook hook, void* context);
+
+		/**
+		 *	@name		allocate
+		 *	@brief		a frame of FRAMESIZE(width, height, pixfmt) bytes from the FramePool, given back to the pool by the last FrameRef.
+		 *				The planes follow each other without padding, the content is what the last user of the buffer left
+		 *	@return		FrameRef empty when failed
+		 **/
+		static FrameRef allocate(PIXFormat pixfmt, int width, int height, long long pts = 0);
+
+		bool valid() const { return m_block != NULL; }
+		const unsigned char* data() const { return m_block ? m_block->data : NULL; }
+		int size() const { return m_block ? m_block->size : 0; }
+		const FrameLayout& layout() const;
+		long long pts() const { return m_block ? m_block->pts : 0; }
+
+		/**
+		 *	@brief	the frame can be written while this is the only FrameRef of it, NULL once it is shared
+		 **/
+		unsigned char* mutableData();
+
+		/**
+		 *	@brief	FrameRefs of the frame alive now, 0 for an empty handle
+		 **/
+		long useCount() const;
+
+		/**
+		 *	@brief	view of the whole frame, valid while this FrameRef is
+		 **/
+		FrameView view() const;
+
+		/**
+		 *	@brief	let the frame go, the handle becomes empty
+		 **/
+		void reset();
+		void swap(FrameRef& other);
+
+	private:
+		//moves the Block of a FrameRef in and out of its slots without touching the count
+		friend class FrameQueue;
+
+		struct Block
+		{
+			Block* next;			//link of the free list while the block is not used
+			volatile LONG refs;
+			unsigned char* data;
+			int size;
+			FrameLayout layout;
+			long long pts;
+			FrameReleaseHook hook;
+			void* context;
+		};
+
+		explicit FrameRef(Block* block) : m_block(block) {}
+		static void releaseToPool(unsigned char* data, void* context);
+
+		struct BlockCache;
+		friend struct BlockCache;
+		static Block* newBlock();
+		static void deleteBlock(Block* block);
+
+		Block* m_block;
+	};
+}
+
+#endif //_ZRENDER_FRAME_REF_H_
@@ -0,0 +1,117 @@
+/**
+ *	@name		FrameView.h
+ *	@brief		non-owning reference to a frame or to a rectangle of a frame, by plane pointers and pitches.
+ *				Cropping a view only moves the plane pointers, no pixel is copied.
+ */
+
+#pragma once
+#ifndef _ZRENDER_FRAME_VIEW_H_
+#define _ZRENDER_FRAME_VIEW_H_
+
+#include <Windows.h>
+#include "DxRenderCommon.h"
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	class FrameLayout;
+
+	/**
+	 *	@name		FrameView
+	 *	@brief		value type, the memory it refers to belongs to the producer of the frame and must outlive the view.
+	 *				Planes are indexed in memory order, like FrameLayout.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT FrameView
+	{
+	public:
+		enum { MAX_PLANE_COUNT = 3 };
+
+		/**
+		 *	@name		FrameView
+		 *	@brief		an invalid view
+		 **/
+		FrameView();
+
+		/**
+		 *	@name		wrap
+		 *	@brief		view of a whole frame stored at base with the given layout
+		 *	@return		FrameView invalid when base is NULL or the layout is invalid
+		 **/
+		static FrameView wrap(const unsigned char* base, const FrameLayout& layout);
+
+		/**
+		 *	@name		wrap
+		 *	@brief		view of a whole frame whose planes live anywhere
+		 *	@param[in]	const unsigned char* const planes[3] first byte of every plane in memory order
+		 *	@param[in]	const int pitches[3] pitch of every plane in memory order
+		 *	@return		FrameView invalid when a plane is NULL or a pitch is smaller than the row bytes
+		 **/
+		static FrameView wrap(PIXFormat pixfmt, const unsigned char* const planes[3], const int pitches[3], int width, int height);
+
+		/**
+		 *	@name		toPixelRect
+		 *	@brief		pixel rectangle of a region given in relative coordinates [0,1] of the rectangle outer.
+		 *				Every edge is rounded on its own, so regions sharing an edge share the pixel column or row too.
+		 *	@return		bool false when the region is invalid or the rectangle would be empty
+		 **/
+		static bool toPixelRect(const RECT_f& region, const RECT& outer, RECT& rect);
+
+		bool valid() const { return m_planeCount > 0; }
+		PIXFormat pixfmt() const { return m_pixfmt; }
+		int width() const { return m_width; }
+		int height() const { return m_height; }
+		int planeCount() const { return m_planeCount; }
+
+		const unsigned char* plane(int plane) const { return m_planes[plane]; }
+		int pitch(int plane) const { return m_pitches[plane]; }
+		const int* pitches() const { return m_pitches; }
+
+		int rowBytes(int plane) const;
+		int planeRows(int plane) const;
+
+		/**
+		 *	@name		alignCropRect
+		 *	@brief		move the top left corner of rect down to the pixel grid a crop of pixfmt snaps to,
+		 *				2 for the formats with subsampled chroma or YUY2 pixel pairs. The right and bottom edges stay.
+		 *				This is the rectangle crop() returns, producers use it to report the size of a crop without data at hand
+		 **/
+		static void alignCropRect(PIXFormat pixfmt, RECT& rect);
+
+		/**
+		 *	@brief	the pixel grid of alignCropRect(), alignX and alignY are powers of 2, 1 for unknown formats
+		 **/
+		static void getCropAlignment(PIXFormat pixfmt, int& alignX, int& alignY);
+
+		/**
+		 *	@name		crop
+		 *	@brief		view of the rectangle (x, y, width, height) of this view, aligned by alignCropRect(),
+		 *				so the rectangle is only ever enlarged by one pixel on the left or top.
+		 *	@return		FrameView invalid when the rectangle is empty or not inside this view
+		 **/
+		FrameView crop(int x, int y, int width, int height) const;
+		FrameView crop(const RECT& rect) const { return crop(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top); }
+
+		/**
+		 *	@name		copyTo
+		 *	@brief		copy the pixels of the view into planes of the same format and size, see copyPlane()
+		 *	@return		int 0:success <0:the view or the params are invalid
+		 **/
+		int copyTo(unsigned char* const dstPlanes[3], const int dstPitches[3]) const;
+
+		/**
+		 *	@name		copyTo
+		 *	@brief		copy the pixels of the view into a frame stored at dst with dstLayout, whose format and size must match the view
+		 **/
+		int copyTo(unsigned char* dst, const FrameLayout& dstLayout) const;
+
+	private:
+		PIXFormat m_pixfmt;
+		int m_width;
+		int m_height;
+		int m_planeCount;
+		const unsigned char* m_planes[MAX_PLANE_COUNT];
+		int m_pitches[MAX_PLANE_COUNT];
+	};
+}
+
+#endif //_ZRENDER_FRAME_VIEW_H_
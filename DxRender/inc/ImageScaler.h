@@ -0,0 +1,61 @@
+/**
+ *	@name		ImageScaler.h
+ *	@brief		CPU side resize of an image of any PIXFormat, separable filters with SSSE3/SSE2/AVX2 kernels selected at runtime
+ */
+
+#pragma once
+#ifndef _ZRENDER_IMAGE_SCALER_H_
+#define _ZRENDER_IMAGE_SCALER_H_
+
+#include "DxRenderCommon.h"
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	/**
+	 *	@brief	filter used to resample the image. Every filter is widened by the scale factor when shrinking,
+	 *			so every source pixel contributes to the result
+	 **/
+	typedef enum SCALE_FILTER
+	{
+		SCALE_FILTER_BILINEAR = 0,	//triangle filter, 2 taps when enlarging
+		SCALE_FILTER_AREA,			//average of the source pixels covered by the destination pixel, the cheapest when shrinking a lot
+		SCALE_FILTER_LANCZOS,		//Lanczos3, sharpest, 6 taps when enlarging
+	}SCALE_FILTER;
+
+	/**
+	 *	@name		scaleImage
+	 *	@brief		resize an image, source and destination have the same pixel format.
+	 *				The planes are given in the memory order of the format, see convertPixelFormat().
+	 *				Chroma planes are resized on their own with the same filter, the pixel centers of the planes stay aligned.
+	 *	@param[in]	PIXFormat pixfmt pixel format of both images
+	 *	@param[in]	const unsigned char* const srcPlanes[3] start of each plane of the source image
+	 *	@param[in]	const int srcPitches[3] bytes of one row of each plane of the source image
+	 *	@param[in]	int srcWidth width of the source image in pixel
+	 *	@param[in]	int srcHeight height of the source image in pixel
+	 *	@param[in]	unsigned char* const dstPlanes[3] start of each plane of the destination image
+	 *	@param[in]	const int dstPitches[3] bytes of one row of each plane of the destination image
+	 *	@param[in]	int dstWidth width of the destination image in pixel
+	 *	@param[in]	int dstHeight height of the destination image in pixel
+	 *	@param[in]	SCALE_FILTER filter the resampling filter
+	 *	@param[in]	int threadCount count of threads sharing the rows of the destination, the calling thread included.
+	 *				The extra threads come from the process thread pool
+	 *	@return		int 0--success <0--failed
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int scaleImage(PIXFormat pixfmt,
+											const unsigned char* const srcPlanes[3], const int srcPitches[3], int srcWidth, int srcHeight,
+											unsigned char* const dstPlanes[3], const int dstPitches[3], int dstWidth, int dstHeight,
+											SCALE_FILTER filter, int threadCount = 1);
+
+	/**
+	 *	@name		scaleImage
+	 *	@brief		resize an image stored in one buffer without padding, the layout of FrameLayout::create(pixfmt, width, height).
+	 *				dst must hold FRAMESIZE(dstWidth, dstHeight, pixfmt) bytes
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int scaleImage(PIXFormat pixfmt,
+											const unsigned char* src, int srcWidth, int srcHeight,
+											unsigned char* dst, int dstWidth, int dstHeight,
+											SCALE_FILTER filter, int threadCount = 1);
+}
+
+#endif //_ZRENDER_IMAGE_SCALER_H_
@@ -0,0 +1,67 @@
+/**
+ *	@name		PixelFormatConverter.h
+ *	@brief		CPU side conversion between every PIXFormat, the SSE2/SSSE3/AVX2 kernels are selected at runtime.
+ *				Byte order of the packed formats in memory is the order the textures upload them:
+ *				PIXFMT_R8G8B8 -- B G R			PIXFMT_A8R8G8B8/PIXFMT_R8G8B8A8 -- R G B A
+ *				PIXFMT_B8G8R8A8 -- B G R A		PIXFMT_B8G8R8X8/PIXFMT_X8R8G8B8 -- B G R X
+ */
+
+#pragma once
+#ifndef _ZRENDER_PIXEL_FORMAT_CONVERTER_H_
+#define _ZRENDER_PIXEL_FORMAT_CONVERTER_H_
+
+#include "DxRenderCommon.h"
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	/**
+	 *	@name		isPixelFormatConvertSupported
+	 *	@brief		whether convertPixelFormat() can convert srcFmt images to dstFmt images
+	 *	@param[in]	PIXFormat srcFmt pixel format of the source image
+	 *	@param[in]	PIXFormat dstFmt pixel format of the destination image
+	 *	@return		bool true--supported false--not supported
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT bool isPixelFormatConvertSupported(PIXFormat srcFmt, PIXFormat dstFmt);
+
+	/**
+	 *	@name		convertPixelFormat
+	 *	@brief		convert an image from srcFmt to dstFmt. The planes are given in the memory order of the format,
+	 *				e.g. Y-U-V for PIXFMT_YUV420P, Y-V-U for PIXFMT_YV12, Y-UV for PIXFMT_NV12, one plane for packed formats.
+	 *				4:2:0 chroma is averaged vertically when down sampled and replicated when up sampled.
+	 *				YUV --> RGB uses matYUV2RGB of DefaultVideo.fx (YUV_MATRIX_BT601_LIMITED, see YUVToRGBConverter.h),
+	 *				RGB --> YUV uses the BT.601 limited range matrix.
+	 *	@param[in]	PIXFormat srcFmt pixel format of the source image
+	 *	@param[in]	const unsigned char* const srcPlanes[3] start of each plane of the source image
+	 *	@param[in]	const int srcPitches[3] bytes of one row of each plane of the source image
+	 *	@param[in]	PIXFormat dstFmt pixel format of the destination image
+	 *	@param[in]	unsigned char* const dstPlanes[3] start of each plane of the destination image
+	 *	@param[in]	const int dstPitches[3] bytes of one row of each plane of the destination image
+	 *	@param[in]	int width width of the image in pixel
+	 *	@param[in]	int height height of the image in pixel
+	 *	@return		int 0--success <0--failed
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int convertPixelFormat(PIXFormat srcFmt, const unsigned char* const srcPlanes[3], const int srcPitches[3],
+													PIXFormat dstFmt, unsigned char* const dstPlanes[3], const int dstPitches[3],
+													int width, int height);
+
+	/**
+	 *	@name		convertPixelFormat
+	 *	@brief		convert an image stored in one buffer. The planes of planar formats follow each other,
+	 *				the chroma planes use half of the pitch of the Y plane.
+	 *	@param[in]	PIXFormat srcFmt pixel format of the source image
+	 *	@param[in]	const unsigned char* src the source image
+	 *	@param[in]	int srcPitch bytes of one row of the first plane of the source image
+	 *	@param[in]	PIXFormat dstFmt pixel format of the destination image
+	 *	@param[in]	unsigned char* dst the destination image
+	 *	@param[in]	int dstPitch bytes of one row of the first plane of the destination image
+	 *	@param[in]	int width width of the image in pixel
+	 *	@param[in]	int height height of the image in pixel
+	 *	@return		int 0--success <0--failed
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int convertPixelFormat(PIXFormat srcFmt, const unsigned char* src, int srcPitch,
+													PIXFormat dstFmt, unsigned char* dst, int dstPitch,
+													int width, int height);
+}
+
+#endif //_ZRENDER_PIXEL_FORMAT_CONVERTER_H_
@@ -0,0 +1,43 @@
+/**
+ *	@name		PlaneCopy.h
+ *	@brief		strided copy of one plane of a frame, used to upload frames into the mapped staging textures
+ */
+
+#pragma once
+#ifndef _ZRENDER_PLANE_COPY_H_
+#define _ZRENDER_PLANE_COPY_H_
+
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	/**
+	 *	@name		copyPlane
+	 *	@brief		copy rows of rowBytes bytes from src to dst.
+	 *				Rows stored without padding on both sides are copied at once.
+	 *				Planes larger than the last level cache are written with non-temporal stores,
+	 *				so a frame upload does not evict the data the render thread works on.
+	 *				Planes larger than the split threshold are shared by the plane copy workers, see setPlaneCopyWorkerCount().
+	 *	@param[in]	const unsigned char* src first byte of the first row to copy
+	 *	@param[in]	int srcPitch bytes between two rows of src
+	 *	@param[out]	unsigned char* dst first byte of the first row to write
+	 *	@param[in]	int dstPitch bytes between two rows of dst
+	 *	@param[in]	int rowBytes bytes to copy of every row
+	 *	@param[in]	int rows count of rows
+	 *	@return		int 0:success <0:the params are invalid
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int copyPlane(const unsigned char* src, int srcPitch, unsigned char* dst, int dstPitch, int rowBytes, int rows);
+
+	/**
+	 *	@name		setPlaneCopyWorkerCount
+	 *	@brief		set how many threads share the copy of a large plane, the calling thread included.
+	 *				The extra threads come from the process thread pool. The default is 1, every copy runs on the calling thread.
+	 *	@param[in]	int count 1 to 16
+	 *	@param[in]	int splitThreshold planes smaller than this count of bytes are never split, 0 keeps the current threshold
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT void setPlaneCopyWorkerCount(int count, int splitThreshold = 0);
+
+	DX_ZRENDER_EXPORT_IMPORT int getPlaneCopyWorkerCount();
+}
+
+#endif //_ZRENDER_PLANE_COPY_H_
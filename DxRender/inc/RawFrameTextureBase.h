@@ -3,6 +3,7 @@
 #define _Z_RENDER_RAW_FRAME_TEXTURE_BASE_H_
 
 #include "IRawFrameTexture.h"
+#include <vector>
 
 namespace zRender
 {
@@ -16,13 +17,35 @@ namespace zRender
 		virtual int openSharedTexture(ID3D11Device* device, IRawFrameTexture* sharedTexture);
 		virtual int getTextureResources(TextureResource** outTexs, int& texsCount) const;
 
-		virtual int copyTexture(const IRawFrameTexture* srcTexture);
+		virtual int copyTexture(const IRawFrameTexture* srcTexture, const RECT* regions = NULL, int regionCount = 0);
 
 		bool isValid() const;
 
 		virtual int acquireSync(int key, unsigned int timeout);
 		virtual int releaseSync(int key);
 	protected:
+		/**
+		 *	@brief	check the regions against the frame, snap them outwards to the crop grid of m_pixfmt
+		 *			(see FrameView::alignCropRect) and merge the neighbours sharing a whole edge when coalesce
+		 *	@return	int 0:success <0:a region is empty or not inside the frame
+		 **/
+		int prepareRegions(const RECT* regions, int regionCount, int width, int height, bool coalesce, std::vector<RECT>& out) const;
+
+		/**
+		 *	@brief	batched update of a texture made of TextureResources only, e.g. a staging texture of a SharedTextureSource.
+		 *			The regions are written into the first resource, only formats of one plane whose pixels are its texels
+		 **/
+		int updateResourceRegions(const unsigned char* pData, int dataLen, int pitch, int width, int height, const std::vector<RECT>& regions);
+
+		/**
+		 *	@brief	copy the regions of one plane into stage, mapped once, then one CopySubresourceRegion per region from stage to tex.
+		 *			The texels of both textures hold the bytes of the plane as they are, texelBytes of them per texel
+		 *	@param[in]	const unsigned char* plane first byte of the plane in the frame
+		 **/
+		static int uploadPlaneRegions(ID3D11DeviceContext* context, ID3D11Texture2D* stage, ID3D11Texture2D* tex,
+									const unsigned char* plane, int pitch, const PlaneFormatDesc& desc, int texelBytes,
+									const std::vector<RECT>& regions);
+
 		TextureResource** m_textureArray;
 		int m_textureCount;
 
@@ -4,6 +4,14 @@
 
 #include "IDisplayContentProvider.h"
 #include "DxZRenderDLLDefine.h"
+#include "inc/DirtyRegionTracker.h"
+#include "inc/FrameFingerprint.h"
+#include "inc/FrameView.h"
+#include "inc/StagingRing.h"
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
 
 namespace zRender
 {
@@ -12,10 +20,15 @@ namespace zRender
 	/**
 	 *	@name		SharedTextureSource
 	 *	@brief		ʵݻȡµĽӿ
-	 *				͵TextureԴ2IRawFrameTexture󣬷ֱΪStageͺShared
-	 *				copyDataToTextureڴݿStage͵TextureУcopyShared͵Texture
+	 *				͵TextureԴ1Shared͵IRawFrameTextureNStage͵IRawFrameTexture
+	 *				ߵcacheFrameṩһ֡ݵFrameView
+	 *				copyDataToTexture֡ݿStage͵TextureУcopyShared͵Texture
+	 *				Stage͵TextureʹãGPUӵkʱCPUдk+1صȴGPUͬһStage Texture
 	 *				getTextureȡShared͵TextureStage͵Textureⲿɼ
 	 *				getData
+	 *				̰߳ȫȾ̵߳DisplayElementcopyDataToTextureзm_lockС
+	 *				m_lockֻ״̬m_dxrenderimmediate contextϵԴȾ̹߳ã豸Ķ̱߳
+	 *				ͨcacheFrameṩһֻ֡ϴһΣ֮Ⱦ̵߳copyDataToTexture1µidentify
 	 **/
 	class DX_ZRENDER_EXPORT_IMPORT SharedTextureSource : public TextureDataSource
 	{
@@ -25,28 +38,129 @@ namespace zRender
 		virtual bool isUpdated(int identify) const;
 		virtual int getTextureProfile(const RECT_f& textureReg, int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt);
 		virtual IRawFrameTexture* getTexture();
+		/**
+		 *	@brief		Shared TextureacquireTextureʱٴcreateTexturereleaseTextureͷ
+		 *				ֱг߶releaseAcquiredTexture
+		 **/
+		virtual IRawFrameTexture* acquireTexture(int& generation);
+		virtual void releaseAcquiredTexture(IRawFrameTexture* texture);
+		virtual int getTextureGeneration() const;
+		/**
+		 *	@brief		ϴcacheFrame֡Shared͵Textureеݱԣ
+		 *				ûмʱȡõݣ߿Ѿһ֡ͷ
+		 *	@return		int 0:ϴ 1:֡Ѿ߳ϴûб仯 <0:ʧ
+		 **/
 		virtual int copyDataToTexture(const RECT_f& textureReg, unsigned char* dstTextureData, int pitch, int height, int& identify);
+		/**
+		 *	@brief		֡textureRegãһcacheFrame֮ǰЧ
+		 **/
+		virtual int getFrameView(const RECT_f& textureReg, FrameView& view, int& identify);
+
+		enum { DEFAULT_STAGING_DEPTH = 3 };
 
+		/**
+		 *	@brief		߳ٴεԸıʽСShared TextureĴӣ
+		 *				Ⱦ߳һθʱִ仯ͷžɵĲµShared Texture
+		 **/
 		int createTexture(PIXFormat pixfmt, int w, int h);
 		void releaseTexture();
 
-		void cacheData(const RECT_f& textureReg, unsigned char* dstTextureData, int pitch, int width, int height);
+		/**
+		 *	@name		cacheFrame
+		 *	@brief		ߵһ֡ݣȾ߳ϴֻframe
+		 *				frameĿTextureһ£ƽ水FrameLayout::create()˳ţpitchж
+		 *				frameõڴһcacheFrame֮ǰЧʱڽеϴѾ
+		 *	@param[in]	const FrameView& frame Чframeʾ߲ṩݣرļ֮ǰ
+		 **/
+		void cacheFrame(const FrameView& frame);
+
+		/**
+		 *	@name		addDirtyRect
+		 *	@brief		һcacheFrame֡б仯ꡣԵöΣcacheFrame֮ǰ
+		 *				ϴʱֻϴЩǵtileûбκʱϴ֡
+		 **/
+		void addDirtyRect(const RECT& rect);
+
+		/**
+		 *	@name		enableDamageDetection
+		 *	@brief		cacheFrame̼߳ÿtilehashֻϴݱ仯tileûб仯ʱ֪ͨȾ߳
+		 *				ڴ󲿷ݲԴǱ̡õƬ
+		 **/
+		void enableDamageDetection(bool enable);
+
+		/**
+		 *	@name		setFingerprintMode
+		 *	@brief		ָ֡Ƶļ㷽ʽĬFINGERPRINT_NONE
+		 *				cacheFrameָ̼߳֡ƣһcacheFrame֡ͬʱϴidentify䣬Ⱦ̲߳ᱻ֪ͨ
+		 *				FINGERPRINT_SAMPLEDֻ㲿УС©Сı仯
+		 **/
+		void setFingerprintMode(FINGERPRINT_MODE mode);
+
+		/**
+		 *	@brief		ûб仯ϴ֡ʵϴ֡
+		 **/
+		long getSkippedFrameCount() const { return m_skippedFrames; }
+		long getUploadedFrameCount() const { return m_uploadedFrames; }
+
+		/**
+		 *	@name		setStagingDepth
+		 *	@brief		StageTextureĸĬDEFAULT_STAGING_DEPTHһcreateTextureʱЧ
+		 *				Ϊ1ʱGPUУÿϴܵȴGPUһ֡
+		 *	@return		int 0:ɹ -1:depth1..StagingRing::MAX_DEPTH
+		 **/
+		int setStagingDepth(int depth);
+		int getStagingDepth() const { return m_stagingDepth; }
+
+		/**
+		 *	@brief		Stage TextureʹͳƣstallsΪȴGPUStage TextureĴ
+		 **/
+		StagingRingStats getStagingStats() const;
 	private:
+		//m_lock held by the caller
+		int upload(const FrameView& frame, int& identify);
+		bool detectChanges(const FrameView& frame);
+		bool detectDamage(const FrameView& frame);
+		int createTextures(PIXFormat pixfmt, int w, int h);
+		void releaseTextures();
+		void retireSharedTexture();
+
 		virtual SharedTexture* getSharedTexture(RECT& effectReg, int& identify);
 		virtual unsigned char* getData(int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt, RECT& effectReg, int& identify);
 	private:
-		IRawFrameTexture* m_texStaging;
+		std::vector<IRawFrameTexture*> m_texStagings;
 		IRawFrameTexture* m_texShared;
+		int m_texSharedRefs;				//acquireTexture calls on m_texShared not released yet
+		int m_texGeneration;				//increased by every createTexture
+		struct RetiredTexture
+		{
+			IRawFrameTexture* texture;
+			int refs;
+		};
+		std::vector<RetiredTexture> m_texRetired;	//shared textures created before, still held by acquireTexture
+		StagingRing m_stagingRing;
+		IStagingFence* m_stagingFence;
+		int m_stagingDepth;
 		DxRender* m_dxrender;
 
 		int m_isUpdatedIdentify;
+		int m_uploadedIdentify;				//m_isUpdatedIdentify when the data in the shared texture was uploaded
+		mutable CRITICAL_SECTION m_lock;	//the render threads upload concurrently, see copyDataToTexture. Guards the state of this
+											//source only, the immediate context of m_dxrender is shared by all its sources and its
+											//render thread and is protected by the device, see DxRender_D3D11::enableMultithreadProtection
 
-		unsigned char* m_cacheData;
-		int m_cache_pitch;
-		int m_cache_width;
-		int m_cache_height;
-		RECT_f m_cache_textureReg;
+		FrameView m_cacheFrame;				//memory of the producer, valid until the next cacheFrame
+
+		DirtyRegionTracker m_dirtyTracker;
+		bool m_damageReported;
+		bool m_detectDamage;
+
+		FINGERPRINT_MODE m_fingerprintMode;
+		unsigned long long m_lastFingerprint;
+		volatile LONG m_skippedFrames;
+		volatile LONG m_uploadedFrames;
 	};
 }
 
+#pragma warning(pop)
+
 #endif // !_Z_RENDER_SHARED_TEXTURE_SOURCE_H_
@@ -0,0 +1,119 @@
+/**
+ *	@name		StagingRing.h
+ *	@brief		ownership of N staging buffers between the CPU writing them and the GPU copying out of them
+ */
+
+#pragma once
+#ifndef _ZRENDER_STAGING_RING_H_
+#define _ZRENDER_STAGING_RING_H_
+
+#include <Windows.h>
+#include "DxZRenderDLLDefine.h"
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
+
+namespace zRender
+{
+	/**
+	 *	@brief	who owns a slot of a StagingRing
+	 **/
+	typedef enum STAGING_SLOT_STATE
+	{
+		STAGING_SLOT_FREE = 0,		//nobody, the next acquire() may hand it out
+		STAGING_SLOT_WRITING,		//the CPU, between acquire() and submit() or abandon()
+		STAGING_SLOT_IN_FLIGHT,		//the GPU, from submit() until the fence of the slot is signaled
+	}STAGING_SLOT_STATE;
+
+	/**
+	 *	@name		IStagingFence
+	 *	@brief		tells when the GPU is done with the commands queued before a slot was submitted.
+	 *				Implemented over a D3D11 event query for the device, by a mock for the tests
+	 **/
+	class IStagingFence
+	{
+	public:
+		virtual ~IStagingFence() {}
+
+		/**
+		 *	@brief	mark the end of the commands reading the slot, called by StagingRing::submit()
+		 **/
+		virtual void signal(int slot) = 0;
+
+		/**
+		 *	@brief	true once the commands before the last signal(slot) are done
+		 **/
+		virtual bool isSignaled(int slot) = 0;
+	};
+
+	struct StagingRingStats
+	{
+		long acquired;		//slots handed out by acquire()
+		long submitted;		//slots given to the GPU
+		long abandoned;		//slots given back without a copy
+		long stalls;		//acquire() found the oldest slot still read by the GPU and waited
+		long timeouts;		//acquire() given up waiting
+	};
+
+	/**
+	 *	@name		StagingRing
+	 *	@brief		the slots are handed out round robin, the one handed out is always the oldest submitted,
+	 *				so the CPU fills slot k+1 while the GPU copies slot k and only waits when it is depth slots ahead.
+	 *				The GPU runs the commands in order: when the oldest slot is still in flight, the others are too.
+	 *				Without a fence a submitted slot is free at once, the Map of the slot waits for the GPU then.
+	 *				Not thread safe, SharedTextureSource uses its ring under its own lock.
+	 **/
+	class DX_ZRENDER_EXPORT_IMPORT StagingRing
+	{
+	public:
+		enum { MAX_DEPTH = 8 };
+
+		StagingRing();
+
+		/**
+		 *	@name		init
+		 *	@brief		start over with depth free slots
+		 *	@param[in]	IStagingFence* fence kept by the caller, alive until reset() or the next init()
+		 *	@return		int 0:success -1:depth out of 1..MAX_DEPTH
+		 **/
+		int init(int depth, IStagingFence* fence);
+		void reset();
+
+		/**
+		 *	@name		acquire
+		 *	@brief		take the oldest slot for the CPU to write
+		 *	@param[in]	DWORD timeoutMs how long to wait for the GPU to be done with the slot, 0 never waits
+		 *	@return		int the slot >=0, -1:not initialized or the slot is being written -2:the GPU still reads the slot after the timeout
+		 **/
+		int acquire(DWORD timeoutMs = INFINITE);
+
+		/**
+		 *	@brief	the copy out of the slot is queued, the slot belongs to the GPU until its fence is signaled
+		 *	@return	int 0:success -1:the slot is not being written
+		 **/
+		int submit(int slot);
+
+		/**
+		 *	@brief	nothing was queued reading the slot, it is free again
+		 *	@return	int 0:success -1:the slot is not being written
+		 **/
+		int abandon(int slot);
+
+		int depth() const { return (int)m_states.size(); }
+		STAGING_SLOT_STATE state(int slot) const;
+		StagingRingStats getStats() const { return m_stats; }
+
+	private:
+		bool gpuDone(int slot);
+
+		std::vector<STAGING_SLOT_STATE> m_states;
+		IStagingFence* m_fence;
+		int m_next;
+		StagingRingStats m_stats;
+	};
+}
+
+#pragma warning(pop)
+
+#endif //_ZRENDER_STAGING_RING_H_
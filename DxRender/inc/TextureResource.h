@@ -33,6 +33,19 @@ namespace zRender
 		int copyTexture(ID3D11Texture2D* d3dTex2D);
 		int update(const unsigned char* pData, int dataLen, int dataPitch, int width, int height,
 			const RECT& regionUpdated);
+		/**
+		 *	@brief	copy the rectangles of pData into the same place of the texture, mapped once. Staging textures only.
+		 *			The texels of the texture are the pixels of pData
+		 **/
+		int updateRegions(const unsigned char* pData, int dataPitch, int width, int height, const RECT* rects, int rectCount);
+		/**
+		 *	@brief	copy the rectangles of res into the same place of this texture, one CopySubresourceRegion per rectangle
+		 **/
+		int copyRegions(const TextureResource* res, const RECT* rects, int rectCount);
+		/**
+		 *	@brief	bytes of one texel, 0 when the format is not used by DxRender
+		 **/
+		int texelBytes() const;
 
 		bool isShared() const { return m_bShared; }
 		HANDLE getSharedHandle() const { return m_sharedHandle; }
@@ -0,0 +1,69 @@
+/**
+ *	@name		YUVToRGBConverter.h
+ *	@brief		CPU side YUV --> BGRA conversion for snapshots, previews and headless rendering.
+ *				YUV_MATRIX_BT601_LIMITED reproduces matYUV2RGB of FX/DefaultVideo.fx: the kernels evaluate the
+ *				shader's float expression in the same order, so the SSE2/AVX2 results equal the scalar reference.
+ */
+
+#pragma once
+#ifndef _ZRENDER_YUV_TO_RGB_CONVERTER_H_
+#define _ZRENDER_YUV_TO_RGB_CONVERTER_H_
+
+#include "DxRenderCommon.h"
+#include "DxZRenderDLLDefine.h"
+
+namespace zRender
+{
+	/**
+	 *	@brief	color matrix used to convert YUV to RGB
+	 **/
+	enum YUV_COLOR_MATRIX
+	{
+		YUV_MATRIX_BT601_LIMITED = 0,	//same as matYUV2RGB in DefaultVideo.fx
+		YUV_MATRIX_BT709_LIMITED,
+		YUV_MATRIX_BT601_FULL,
+		YUV_MATRIX_BT709_FULL,
+	};
+
+	/**
+	 *	@name		convertYUVPixelToBGRA
+	 *	@brief		scalar reference of one pixel: rgb = saturate(mul(matrix, float4(y/255, u/255, v/255, 1))) stored as UNORM
+	 *	@param[in]	unsigned char y,u,v the pixel
+	 *	@param[in]	YUV_COLOR_MATRIX matrix color matrix
+	 *	@param[out]	unsigned char* outBGRA 4 bytes B G R A, alpha is always 0xff
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT void convertYUVPixelToBGRA(unsigned char y, unsigned char u, unsigned char v,
+														YUV_COLOR_MATRIX matrix, unsigned char* outBGRA);
+
+	/**
+	 *	@name		convertYUVRowToBGRA
+	 *	@brief		convert one row of planar YUV, the chroma rows have (width+1)/2 samples
+	 *	@param[in]	const unsigned char* y luma row
+	 *	@param[in]	const unsigned char* u Cb row
+	 *	@param[in]	const unsigned char* v Cr row
+	 *	@param[out]	unsigned char* dst width*4 bytes of B G R A
+	 *	@param[in]	int width pixels of the row
+	 *	@param[in]	YUV_COLOR_MATRIX matrix color matrix
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT void convertYUVRowToBGRA(const unsigned char* y, const unsigned char* u, const unsigned char* v,
+													  unsigned char* dst, int width, YUV_COLOR_MATRIX matrix);
+
+	/**
+	 *	@name		convertYUVToBGRA
+	 *	@brief		convert a PIXFMT_YUV420P/PIXFMT_YV12/PIXFMT_NV12/PIXFMT_YUY2 image to B8G8R8A8
+	 *	@param[in]	PIXFormat srcFmt pixel format of the source image
+	 *	@param[in]	const unsigned char* const srcPlanes[3] planes in the memory order of the format, see convertPixelFormat()
+	 *	@param[in]	const int srcPitches[3] bytes of one row of each plane
+	 *	@param[out]	unsigned char* dst the B8G8R8A8 image
+	 *	@param[in]	int dstPitch bytes of one row of dst, at least width*4
+	 *	@param[in]	int width width of the image in pixel
+	 *	@param[in]	int height height of the image in pixel
+	 *	@param[in]	YUV_COLOR_MATRIX matrix color matrix
+	 *	@return		int 0--success <0--failed
+	 **/
+	DX_ZRENDER_EXPORT_IMPORT int convertYUVToBGRA(PIXFormat srcFmt, const unsigned char* const srcPlanes[3], const int srcPitches[3],
+												  unsigned char* dst, int dstPitch, int width, int height,
+												  YUV_COLOR_MATRIX matrix = YUV_MATRIX_BT601_LIMITED);
+}
+
+#endif //_ZRENDER_YUV_TO_RGB_CONVERTER_H_
@@ -0,0 +1,167 @@
+#include "inc/ConstantTextureCache.h"
+#include "inc/TextureResource.h"
+#include <stdlib.h>
+#include <string.h>
+
+using namespace zRender;
+
+namespace
+{
+	//unused textures kept for the next layout of the wall
+	const int MAX_IDLE_TEXTURES = 4;
+
+	unsigned char* createPatternData(CONSTANT_TEXTURE_PATTERN pattern, int width, int height, DXGI_FORMAT& dxgifmt, int& pitch)
+	{
+		switch(pattern)
+		{
+		case CONSTANT_TEXTURE_PARITY:
+		{
+			dxgifmt = DXGI_FORMAT_R8_UNORM;
+			pitch = width;
+			unsigned char* data = (unsigned char*)malloc(width * height);
+			if(data == NULL)
+				return NULL;
+			for(int x = 0; x < width; x++)
+				data[x] = (x % 2) * 255;
+			for(int y = 1; y < height; y++)
+				memcpy(data + y * width, data, width);
+			return data;
+		}
+		default:
+			return NULL;
+		}
+	}
+}
+
+ConstantTextureCache& ConstantTextureCache::instance()
+{
+	static ConstantTextureCache s_cache;
+	return s_cache;
+}
+
+ConstantTextureCache::ConstantTextureCache()
+	: m_useClock(0)
+{
+	InitializeCriticalSection(&m_lock);
+}
+
+ConstantTextureCache::~ConstantTextureCache()
+{
+	for(size_t i = 0; i < m_entries.size(); i++)
+		delete m_entries[i].texture;
+	m_entries.clear();
+	DeleteCriticalSection(&m_lock);
+}
+
+TextureResource* ConstantTextureCache::acquire(ID3D11Device* device, CONSTANT_TEXTURE_PATTERN pattern, int width, int height)
+{
+	if(device == NULL || width <= 0 || height <= 0)
+		return NULL;
+	EnterCriticalSection(&m_lock);
+	for(size_t i = 0; i < m_entries.size(); i++)
+	{
+		Entry& entry = m_entries[i];
+		if(entry.device == device && entry.pattern == pattern && entry.width == width && entry.height == height)
+		{
+			entry.refCount++;
+			LeaveCriticalSection(&m_lock);
+			return entry.texture;
+		}
+	}
+	//created under the lock, two windows of the same size must not upload the pattern twice
+	TextureResource* texture = createTexture(device, pattern, width, height);
+	if(texture != NULL)
+	{
+		Entry entry;
+		entry.device = device;
+		entry.pattern = pattern;
+		entry.width = width;
+		entry.height = height;
+		entry.texture = texture;
+		entry.refCount = 1;
+		entry.lastUsed = 0;
+		m_entries.push_back(entry);
+	}
+	LeaveCriticalSection(&m_lock);
+	return texture;
+}
+
+int ConstantTextureCache::release(TextureResource* texture)
+{
+	if(texture == NULL)
+		return -1;
+	EnterCriticalSection(&m_lock);
+	for(size_t i = 0; i < m_entries.size(); i++)
+	{
+		Entry& entry = m_entries[i];
+		if(entry.texture != texture)
+			continue;
+		if(entry.refCount > 0 && --entry.refCount == 0)
+		{
+			entry.lastUsed = ++m_useClock;
+			trimIdle();
+		}
+		LeaveCriticalSection(&m_lock);
+		return 0;
+	}
+	LeaveCriticalSection(&m_lock);
+	return -2;
+}
+
+void ConstantTextureCache::purge(ID3D11Device* device)
+{
+	EnterCriticalSection(&m_lock);
+	for(size_t i = 0; i < m_entries.size();)
+	{
+		if(m_entries[i].device == device && m_entries[i].refCount == 0)
+		{
+			delete m_entries[i].texture;
+			m_entries.erase(m_entries.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+	LeaveCriticalSection(&m_lock);
+}
+
+TextureResource* ConstantTextureCache::createTexture(ID3D11Device* device, CONSTANT_TEXTURE_PATTERN pattern, int width, int height)
+{
+	DXGI_FORMAT dxgifmt = DXGI_FORMAT_UNKNOWN;
+	int pitch = 0;
+	unsigned char* data = createPatternData(pattern, width, height, dxgifmt, pitch);
+	if(data == NULL)
+		return NULL;
+	TextureResource* texture = new TextureResource();
+	if(0 != texture->create(device, width, height, dxgifmt, TEXTURE_USAGE_DEFAULT, false, (const char*)data, pitch * height, pitch)
+		|| 0 != texture->createResourceView())
+	{
+		delete texture;
+		texture = NULL;
+	}
+	free(data);
+	return texture;
+}
+
+void ConstantTextureCache::trimIdle()
+{
+	int idleCount = 0;
+	for(size_t i = 0; i < m_entries.size(); i++)
+	{
+		if(m_entries[i].refCount == 0)
+			idleCount++;
+	}
+	while(idleCount > MAX_IDLE_TEXTURES)
+	{
+		size_t oldest = m_entries.size();
+		for(size_t i = 0; i < m_entries.size(); i++)
+		{
+			if(m_entries[i].refCount == 0 && (oldest == m_entries.size() || m_entries[i].lastUsed < m_entries[oldest].lastUsed))
+				oldest = i;
+		}
+		delete m_entries[oldest].texture;
+		m_entries.erase(m_entries.begin() + oldest);
+		idleCount--;
+	}
+}
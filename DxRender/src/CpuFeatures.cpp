@@ -0,0 +1,133 @@
+#include "inc/CpuFeatures.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+using namespace zRender;
+
+namespace
+{
+	const unsigned int FEATURES_NOT_DETECTED = 0x80000000;
+
+	volatile unsigned int s_detectedFeatures = FEATURES_NOT_DETECTED;
+	volatile unsigned int s_featuresMask = 0xffffffff;
+	const int DEFAULT_LAST_LEVEL_CACHE_SIZE = 8 * 1024 * 1024;
+	volatile int s_lastLevelCacheSize = 0;
+
+	void cpuid(int leaf, int subLeaf, int regs[4])
+	{
+#ifdef _MSC_VER
+		__cpuidex(regs, leaf, subLeaf);
+#else
+		unsigned int a = 0, b = 0, c = 0, d = 0;
+		__cpuid_count(leaf, subLeaf, a, b, c, d);
+		regs[0] = (int)a; regs[1] = (int)b; regs[2] = (int)c; regs[3] = (int)d;
+#endif
+	}
+
+	unsigned long long xgetbv0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int eax = 0, edx = 0;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+
+	unsigned int detectFeatures()
+	{
+		unsigned int features = CPU_FEATURE_NONE;
+		int regs[4] = {0};
+		cpuid(0, 0, regs);
+		int maxLeaf = regs[0];
+		if(maxLeaf < 1)
+			return features;
+
+		cpuid(1, 0, regs);
+		const int ecx1 = regs[2];
+		const int edx1 = regs[3];
+		if(edx1 & (1 << 26))
+			features |= CPU_FEATURE_SSE2;
+		if(ecx1 & (1 << 9))
+			features |= CPU_FEATURE_SSSE3;
+		if(ecx1 & (1 << 19))
+			features |= CPU_FEATURE_SSE41;
+		if(ecx1 & (1 << 20))
+			features |= CPU_FEATURE_SSE42;
+
+		//AVX2 needs the OS to save the YMM state (OSXSAVE and XCR0 bits 1,2)
+		const bool osxsave = (ecx1 & (1 << 27)) != 0;
+		const bool avx = (ecx1 & (1 << 28)) != 0;
+		if(maxLeaf >= 7 && osxsave && avx && (xgetbv0() & 0x6) == 0x6)
+		{
+			cpuid(7, 0, regs);
+			if(regs[1] & (1 << 5))
+				features |= CPU_FEATURE_AVX2;
+		}
+		return features;
+	}
+
+	int detectLastLevelCacheSize()
+	{
+		int regs[4] = {0};
+		cpuid(0, 0, regs);
+		const int maxLeaf = regs[0];
+		int largest = 0;
+		//deterministic cache parameters (Intel), AMD returns zero for this leaf
+		if(maxLeaf >= 4)
+		{
+			for(int i = 0; i < 16; i++)
+			{
+				cpuid(4, i, regs);
+				const int type = regs[0] & 0x1f;
+				if(type == 0)
+					break;
+				if(type == 2)	//instruction cache
+					continue;
+				const int ways = ((regs[1] >> 22) & 0x3ff) + 1;
+				const int partitions = ((regs[1] >> 12) & 0x3ff) + 1;
+				const int lineSize = (regs[1] & 0xfff) + 1;
+				const int sets = regs[2] + 1;
+				const int size = ways * partitions * lineSize * sets;
+				if(size > largest)
+					largest = size;
+			}
+		}
+		if(largest > 0)
+			return largest;
+		//AMD: L2 size in KB in ECX[31:16], L3 size in 512KB units in EDX[31:18]
+		cpuid(0x80000000, 0, regs);
+		if((unsigned int)regs[0] >= 0x80000006)
+		{
+			cpuid(0x80000006, 0, regs);
+			const int l2 = (int)(((unsigned int)regs[2] >> 16) * 1024);
+			const int l3 = (int)(((unsigned int)regs[3] >> 18) * 512 * 1024);
+			largest = l3 > l2 ? l3 : l2;
+		}
+		return largest > 0 ? largest : DEFAULT_LAST_LEVEL_CACHE_SIZE;
+	}
+}
+
+unsigned int zRender::getCpuFeatures()
+{
+	//the detection is idempotent, racing threads only do the same work twice
+	if(s_detectedFeatures == FEATURES_NOT_DETECTED)
+		s_detectedFeatures = detectFeatures();
+	return s_detectedFeatures & s_featuresMask;
+}
+
+void zRender::setCpuFeaturesMask(unsigned int mask)
+{
+	s_featuresMask = mask & ~FEATURES_NOT_DETECTED;
+}
+
+int zRender::getLastLevelCacheSize()
+{
+	if(s_lastLevelCacheSize == 0)
+		s_lastLevelCacheSize = detectLastLevelCacheSize();
+	return s_lastLevelCacheSize;
+}
@@ -0,0 +1,196 @@
+#include "inc/DirtyRegionTracker.h"
+#include "inc/FrameView.h"
+#include <string.h>
+
+using namespace zRender;
+
+namespace
+{
+	const unsigned long long HASH_PRIME1 = 0x9E3779B185EBCA87ULL;
+	const unsigned long long HASH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+	inline unsigned long long hashRound(unsigned long long h, unsigned long long word)
+	{
+		h ^= word * HASH_PRIME2;
+		h = (h << 31) | (h >> 33);
+		return h * HASH_PRIME1;
+	}
+
+	unsigned long long hashRow(unsigned long long h, const unsigned char* row, int bytes)
+	{
+		int i = 0;
+		for(; i + 8 <= bytes; i += 8)
+		{
+			unsigned long long word;
+			memcpy(&word, row + i, 8);
+			h = hashRound(h, word);
+		}
+		if(i < bytes)
+		{
+			unsigned long long word = 0;
+			memcpy(&word, row + i, bytes - i);
+			h = hashRound(h, word);
+		}
+		return hashRound(h, (unsigned long long)bytes);
+	}
+
+	unsigned long long hashTile(const FrameView& tile)
+	{
+		unsigned long long h = HASH_PRIME1;
+		for(int p = 0; p < tile.planeCount(); p++)
+		{
+			const unsigned char* row = tile.plane(p);
+			const int rowBytes = tile.rowBytes(p);
+			const int rows = tile.planeRows(p);
+			for(int y = 0; y < rows; y++, row += tile.pitch(p))
+				h = hashRow(h, row, rowBytes);
+		}
+		return h;
+	}
+}
+
+DirtyRegionTracker::DirtyRegionTracker()
+	: m_width(0), m_height(0), m_tileSize(DEFAULT_TILE_SIZE)
+	, m_tilesX(0), m_tilesY(0), m_dirtyCount(0), m_hashesValid(false)
+{
+}
+
+int DirtyRegionTracker::reset(int width, int height, int tileSize)
+{
+	if(width <= 0 || height <= 0 || tileSize <= 0 || (tileSize & 1) != 0)
+		return -1;
+	m_width = width;
+	m_height = height;
+	m_tileSize = tileSize;
+	m_tilesX = (width + tileSize - 1) / tileSize;
+	m_tilesY = (height + tileSize - 1) / tileSize;
+	m_dirty.assign(m_tilesX * m_tilesY, 1);
+	m_hashes.assign(m_tilesX * m_tilesY, 0);
+	m_dirtyCount = m_tilesX * m_tilesY;
+	m_hashesValid = false;
+	return 0;
+}
+
+void DirtyRegionTracker::markDirty(const RECT& rect)
+{
+	const int left = rect.left < 0 ? 0 : (int)rect.left;
+	const int top = rect.top < 0 ? 0 : (int)rect.top;
+	const int right = rect.right > m_width ? m_width : (int)rect.right;
+	const int bottom = rect.bottom > m_height ? m_height : (int)rect.bottom;
+	if(right <= left || bottom <= top)
+		return;
+	for(int ty = top / m_tileSize; ty <= (bottom - 1) / m_tileSize; ty++)
+	{
+		for(int tx = left / m_tileSize; tx <= (right - 1) / m_tileSize; tx++)
+		{
+			unsigned char& dirty = m_dirty[ty * m_tilesX + tx];
+			if(!dirty)
+			{
+				dirty = 1;
+				m_dirtyCount++;
+			}
+		}
+	}
+}
+
+void DirtyRegionTracker::markAllDirty()
+{
+	m_dirty.assign(m_dirty.size(), 1);
+	m_dirtyCount = (int)m_dirty.size();
+}
+
+void DirtyRegionTracker::clear()
+{
+	m_dirty.assign(m_dirty.size(), 0);
+	m_dirtyCount = 0;
+}
+
+int DirtyRegionTracker::detectChanges(const FrameView& frame)
+{
+	if(!frame.valid() || frame.width() != m_width || frame.height() != m_height)
+		return -1;
+	int changed = 0;
+	for(int ty = 0; ty < m_tilesY; ty++)
+	{
+		const int top = ty * m_tileSize;
+		const int rows = m_height - top < m_tileSize ? m_height - top : m_tileSize;
+		for(int tx = 0; tx < m_tilesX; tx++)
+		{
+			const int left = tx * m_tileSize;
+			const int cols = m_width - left < m_tileSize ? m_width - left : m_tileSize;
+			const int index = ty * m_tilesX + tx;
+			const unsigned long long h = hashTile(frame.crop(left, top, cols, rows));
+			if(m_hashesValid && h == m_hashes[index])
+				continue;
+			m_hashes[index] = h;
+			if(!m_hashesValid)
+				continue;
+			changed++;
+			if(!m_dirty[index])
+			{
+				m_dirty[index] = 1;
+				m_dirtyCount++;
+			}
+		}
+	}
+	m_hashesValid = true;
+	return changed;
+}
+
+int DirtyRegionTracker::getDirtyRects(RECT* rects, int maxCount) const
+{
+	if(rects == NULL || maxCount <= 0 || m_dirtyCount == 0)
+		return 0;
+	std::vector<RECT> merged;
+	//rectangles ending at the top of the current tile row, sorted by left like the runs of the row
+	std::vector<int> prevOpen;
+	std::vector<int> curOpen;
+	for(int ty = 0; ty < m_tilesY; ty++)
+	{
+		const unsigned char* row = &m_dirty[ty * m_tilesX];
+		const LONG top = ty * m_tileSize;
+		const LONG bottom = top + m_tileSize > m_height ? m_height : top + m_tileSize;
+		size_t prev = 0;
+		curOpen.clear();
+		for(int tx = 0; tx < m_tilesX; tx++)
+		{
+			if(!row[tx])
+				continue;
+			const int runBegin = tx;
+			while(tx + 1 < m_tilesX && row[tx + 1])
+				tx++;
+			const LONG left = runBegin * m_tileSize;
+			const LONG right = (tx + 1) * m_tileSize > m_width ? m_width : (tx + 1) * m_tileSize;
+			while(prev < prevOpen.size() && merged[prevOpen[prev]].left < left)
+				prev++;
+			if(prev < prevOpen.size() && merged[prevOpen[prev]].left == left && merged[prevOpen[prev]].right == right)
+			{
+				//the same columns were dirty on the row above, grow that rectangle down
+				merged[prevOpen[prev]].bottom = bottom;
+				curOpen.push_back(prevOpen[prev]);
+				continue;
+			}
+			RECT rect = {left, top, right, bottom};
+			merged.push_back(rect);
+			curOpen.push_back((int)merged.size() - 1);
+		}
+		prevOpen.swap(curOpen);
+	}
+	if((int)merged.size() > maxCount)
+	{
+		//too many pieces, one box around the damage
+		RECT bounds = merged[0];
+		for(size_t i = 1; i < merged.size(); i++)
+		{
+			if(merged[i].left < bounds.left) bounds.left = merged[i].left;
+			if(merged[i].top < bounds.top) bounds.top = merged[i].top;
+			if(merged[i].right > bounds.right) bounds.right = merged[i].right;
+			if(merged[i].bottom > bounds.bottom) bounds.bottom = merged[i].bottom;
+		}
+		rects[0] = bounds;
+		return 1;
+	}
+	for(size_t i = 0; i < merged.size(); i++)
+		rects[i] = merged[i];
+	return (int)merged.size();
+}
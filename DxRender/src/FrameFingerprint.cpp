@@ -0,0 +1,119 @@
+#include "inc/FrameFingerprint.h"
+#include "inc/FrameView.h"
+#include "inc/CpuFeatures.h"
+#include <string.h>
+#include <nmmintrin.h>
+
+using namespace zRender;
+
+namespace
+{
+	const int SAMPLE_ROW_STEP = 8;
+	const unsigned long long HASH_PRIME1 = 0x9E3779B185EBCA87ULL;
+	const unsigned long long HASH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+	inline unsigned long long rotl64(unsigned long long v, int bits)
+	{
+		return (v << bits) | (v >> (64 - bits));
+	}
+
+	inline unsigned long long mixRound(unsigned long long h, unsigned long long word)
+	{
+		h ^= word * HASH_PRIME2;
+		return rotl64(h, 31) * HASH_PRIME1;
+	}
+
+	inline unsigned long long loadWord(const unsigned char* p)
+	{
+		unsigned long long word;
+		memcpy(&word, p, 8);
+		return word;
+	}
+
+	/**
+	 *	@brief	four independent lanes, the multiplications of one lane hide behind the other three
+	 **/
+	unsigned long long hashRow_C(const unsigned char* row, int bytes)
+	{
+		unsigned long long h0 = HASH_PRIME1, h1 = HASH_PRIME2, h2 = ~HASH_PRIME1, h3 = ~HASH_PRIME2;
+		int i = 0;
+		for(; i + 32 <= bytes; i += 32)
+		{
+			h0 = mixRound(h0, loadWord(row + i));
+			h1 = mixRound(h1, loadWord(row + i + 8));
+			h2 = mixRound(h2, loadWord(row + i + 16));
+			h3 = mixRound(h3, loadWord(row + i + 24));
+		}
+		for(; i + 8 <= bytes; i += 8)
+			h0 = mixRound(h0, loadWord(row + i));
+		if(i < bytes)
+		{
+			unsigned long long word = 0;
+			memcpy(&word, row + i, bytes - i);
+			h1 = mixRound(h1, word);
+		}
+		return h0 ^ rotl64(h1, 16) ^ rotl64(h2, 32) ^ rotl64(h3, 48);
+	}
+
+	/**
+	 *	@brief	crc32 has a latency of 3 cycles and a throughput of 1, four streams keep the unit busy
+	 **/
+	unsigned long long hashRow_SSE42(const unsigned char* row, int bytes)
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		unsigned long long c0 = 0xffffffff, c1 = 0x12345678, c2 = 0x9abcdef0, c3 = 0x0fedcba9;
+		int i = 0;
+		for(; i + 32 <= bytes; i += 32)
+		{
+			c0 = _mm_crc32_u64(c0, loadWord(row + i));
+			c1 = _mm_crc32_u64(c1, loadWord(row + i + 8));
+			c2 = _mm_crc32_u64(c2, loadWord(row + i + 16));
+			c3 = _mm_crc32_u64(c3, loadWord(row + i + 24));
+		}
+		for(; i + 8 <= bytes; i += 8)
+			c0 = _mm_crc32_u64(c0, loadWord(row + i));
+		for(; i < bytes; i++)
+			c1 = _mm_crc32_u8((unsigned int)c1, row[i]);
+		return (c0 | (c1 << 32)) ^ rotl64(c2 | (c3 << 32), 17);
+#else
+		unsigned int c0 = 0xffffffff, c1 = 0x12345678, c2 = 0x9abcdef0, c3 = 0x0fedcba9;
+		int i = 0;
+		for(; i + 16 <= bytes; i += 16)
+		{
+			unsigned int words[4];
+			memcpy(words, row + i, 16);
+			c0 = _mm_crc32_u32(c0, words[0]);
+			c1 = _mm_crc32_u32(c1, words[1]);
+			c2 = _mm_crc32_u32(c2, words[2]);
+			c3 = _mm_crc32_u32(c3, words[3]);
+		}
+		for(; i < bytes; i++)
+			c0 = _mm_crc32_u8(c0, row[i]);
+		return (c0 | ((unsigned long long)c1 << 32)) ^ rotl64(c2 | ((unsigned long long)c3 << 32), 17);
+#endif
+	}
+}
+
+unsigned long long zRender::computeFrameFingerprint(const FrameView& frame, FINGERPRINT_MODE mode)
+{
+	if(!frame.valid() || (mode != FINGERPRINT_FULL && mode != FINGERPRINT_SAMPLED))
+		return 0;
+	unsigned long long (*hashRow)(const unsigned char*, int) =
+		(getCpuFeatures() & CPU_FEATURE_SSE42) ? hashRow_SSE42 : hashRow_C;
+	const int step = mode == FINGERPRINT_SAMPLED ? SAMPLE_ROW_STEP : 1;
+	//the size and format are part of the fingerprint, a resized source never matches
+	unsigned long long h = mixRound(HASH_PRIME1, ((unsigned long long)frame.width() << 32) | (unsigned int)frame.height());
+	h = mixRound(h, (unsigned long long)frame.pixfmt());
+	for(int p = 0; p < frame.planeCount(); p++)
+	{
+		const unsigned char* plane = frame.plane(p);
+		const int pitch = frame.pitch(p);
+		const int rowBytes = frame.rowBytes(p);
+		const int rows = frame.planeRows(p);
+		for(int y = 0; y < rows; y += step)
+			h = mixRound(h, hashRow(plane + (long long)y * pitch, rowBytes));
+		if(step > 1 && (rows - 1) % step != 0)
+			h = mixRound(h, hashRow(plane + (long long)(rows - 1) * pitch, rowBytes));
+	}
+	return h != 0 ? h : 1;
+}
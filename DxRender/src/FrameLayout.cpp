@@ -0,0 +1,193 @@
+#include "inc/FrameLayout.h"
+#include <stddef.h>
+
+using namespace zRender;
+
+FrameLayout::FrameLayout()
+	: m_pixfmt(PIXFMT_UNKNOW), m_width(0), m_height(0), m_planeCount(0), m_size(0)
+{
+	for(int i = 0; i < MAX_PLANE_COUNT; i++)
+	{
+		m_offsets[i] = 0;
+		m_pitches[i] = 0;
+	}
+}
+
+FrameLayout FrameLayout::create(PIXFormat pixfmt, int width, int height, int alignment)
+{
+	FrameLayout layout;
+	if(!isKnownPixelFormat(pixfmt) || width <= 0 || height <= 0 || alignment <= 0 || (alignment & (alignment - 1)) != 0)
+		return layout;
+	const PixelFormatDesc& desc = PixelFormatDescs[pixfmt];
+	int offsets[MAX_PLANE_COUNT] = {0};
+	int pitches[MAX_PLANE_COUNT] = {0};
+	int offset = 0;
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		pitches[i] = (getPlaneRowBytes(desc.planes[i], width) + alignment - 1) & ~(alignment - 1);
+		offsets[i] = offset;
+		offset += pitches[i] * getPlaneRows(desc.planes[i], height);
+	}
+	layout.init(pixfmt, width, height, offsets, pitches);
+	return layout;
+}
+
+FrameLayout FrameLayout::create(PIXFormat pixfmt, int width, int height, int yPitch, int uPitch, int vPitch)
+{
+	FrameLayout layout;
+	if(!isKnownPixelFormat(pixfmt) || width <= 0 || height <= 0)
+		return layout;
+	const PixelFormatDesc& desc = PixelFormatDescs[pixfmt];
+	int pitches[MAX_PLANE_COUNT] = {yPitch, 0, 0};
+	switch(pixfmt)
+	{
+	case PIXFMT_YUV420P:
+		pitches[1] = uPitch;
+		pitches[2] = vPitch;
+		break;
+	case PIXFMT_YV12:
+		pitches[1] = vPitch;
+		pitches[2] = uPitch;
+		break;
+	case PIXFMT_NV12:
+		pitches[1] = uPitch;
+		break;
+	default:
+		break;
+	}
+	int offsets[MAX_PLANE_COUNT] = {0};
+	int offset = 0;
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		offsets[i] = offset;
+		offset += pitches[i] * getPlaneRows(desc.planes[i], height);
+	}
+	layout.init(pixfmt, width, height, offsets, pitches);
+	return layout;
+}
+
+FrameLayout FrameLayout::create(PIXFormat pixfmt, int width, int height, const int offsets[3], const int pitches[3])
+{
+	FrameLayout layout;
+	if(offsets == NULL || pitches == NULL)
+		return layout;
+	layout.init(pixfmt, width, height, offsets, pitches);
+	return layout;
+}
+
+bool FrameLayout::init(PIXFormat pixfmt, int width, int height, const int offsets[3], const int pitches[3])
+{
+	if(!isKnownPixelFormat(pixfmt) || width <= 0 || height <= 0)
+		return false;
+	const PixelFormatDesc& desc = PixelFormatDescs[pixfmt];
+	int size = 0;
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		const int rowBytes = getPlaneRowBytes(desc.planes[i], width);
+		if(offsets[i] < 0 || pitches[i] < rowBytes)
+			return false;
+		const int end = offsets[i] + pitches[i] * (getPlaneRows(desc.planes[i], height) - 1) + rowBytes;
+		if(end > size)
+			size = end;
+	}
+	m_pixfmt = pixfmt;
+	m_width = width;
+	m_height = height;
+	m_planeCount = desc.planeCount;
+	for(int i = 0; i < MAX_PLANE_COUNT; i++)
+	{
+		m_offsets[i] = i < desc.planeCount ? offsets[i] : 0;
+		m_pitches[i] = i < desc.planeCount ? pitches[i] : 0;
+	}
+	m_size = size;
+	return true;
+}
+
+int FrameLayout::rowBytes(int plane) const
+{
+	if(plane < 0 || plane >= m_planeCount)
+		return 0;
+	return getPlaneRowBytes(PixelFormatDescs[m_pixfmt].planes[plane], m_width);
+}
+
+int FrameLayout::planeRows(int plane) const
+{
+	if(plane < 0 || plane >= m_planeCount)
+		return 0;
+	return getPlaneRows(PixelFormatDescs[m_pixfmt].planes[plane], m_height);
+}
+
+int FrameLayout::planeOfU() const
+{
+	switch(m_pixfmt)
+	{
+	case PIXFMT_YUV420P:
+	case PIXFMT_NV12:
+		return 1;
+	case PIXFMT_YV12:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+int FrameLayout::planeOfV() const
+{
+	switch(m_pixfmt)
+	{
+	case PIXFMT_YUV420P:
+		return 2;
+	case PIXFMT_YV12:
+	case PIXFMT_NV12:
+		return 1;
+	default:
+		return -1;
+	}
+}
+
+int FrameLayout::alignment() const
+{
+	if(!valid())
+		return 0;
+	int bits = 0;
+	for(int i = 0; i < m_planeCount; i++)
+		bits |= m_offsets[i] | m_pitches[i];
+	int align = 1;
+	while(align < 4096 && (bits & align) == 0)
+		align <<= 1;
+	return align;
+}
+
+int FrameLayout::pixelOffset(int plane, int x, int y) const
+{
+	if(plane < 0 || plane >= m_planeCount)
+		return 0;
+	const PlaneFormatDesc& desc = PixelFormatDescs[m_pixfmt].planes[plane];
+	const int sampleX = x >> desc.shiftX;
+	const int sampleY = y >> desc.shiftY;
+	return m_offsets[plane] + sampleY * m_pitches[plane] + (sampleX / desc.blockWidth) * desc.blockBytes;
+}
+
+void FrameLayout::getPlanes(const unsigned char* base, const unsigned char* planes[3]) const
+{
+	for(int i = 0; i < MAX_PLANE_COUNT; i++)
+		planes[i] = (base != NULL && i < m_planeCount) ? base + m_offsets[i] : NULL;
+}
+
+void FrameLayout::getPlanes(unsigned char* base, unsigned char* planes[3]) const
+{
+	for(int i = 0; i < MAX_PLANE_COUNT; i++)
+		planes[i] = (base != NULL && i < m_planeCount) ? base + m_offsets[i] : NULL;
+}
+
+bool FrameLayout::operator==(const FrameLayout& robj) const
+{
+	if(m_pixfmt != robj.m_pixfmt || m_width != robj.m_width || m_height != robj.m_height || m_planeCount != robj.m_planeCount)
+		return false;
+	for(int i = 0; i < m_planeCount; i++)
+	{
+		if(m_offsets[i] != robj.m_offsets[i] || m_pitches[i] != robj.m_pitches[i])
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,398 @@
+#include "inc/FrameMultiplexer.h"
+#include "inc/FrameLayout.h"
+#include "inc/FrameView.h"
+#include "inc/PixelFormatConverter.h"
+#include <string.h>
+
+using namespace zRender;
+
+namespace
+{
+	/**
+	 *	@brief	planes of a texture mapped with one pitch, the chroma rows of the planar formats are half as wide as the luma rows
+	 **/
+	FrameLayout textureLayout(PIXFormat pixfmt, int width, int height, int pitch)
+	{
+		int uvPitch = pixfmt == PIXFMT_NV12 ? pitch : pitch / 2;
+		return FrameLayout::create(pixfmt, width, height, pitch, uvPitch, uvPitch);
+	}
+
+	PIXFormat formatFor(const MultiplexedSource* view, PIXFormat published)
+	{
+		return view->getPixelFormat() == PIXFMT_UNKNOW ? published : view->getPixelFormat();
+	}
+}
+
+MultiplexedSource::MultiplexedSource(const RECT_f& effectiveReg, PIXFormat pixfmt)
+	: m_pixfmt(pixfmt), m_effectiveReg(effectiveReg), m_identify(0)
+{
+	SetRectEmpty(&m_effectiveRect);
+	InitializeCriticalSection(&m_lock);
+}
+
+MultiplexedSource::~MultiplexedSource()
+{
+	m_frame.reset();
+	m_dataFrame.reset();
+	DeleteCriticalSection(&m_lock);
+}
+
+bool MultiplexedSource::isValidRegion(const RECT_f& region)
+{
+	return region.left >= 0 && region.left < 1 && region.top >= 0 && region.top < 1
+		&& region.width() > 0 && region.height() > 0 && region.right <= 1 && region.bottom <= 1;
+}
+
+bool MultiplexedSource::isUpdated(int identify) const
+{
+	EnterCriticalSection(&m_lock);
+	bool updated = m_identify > identify;
+	LeaveCriticalSection(&m_lock);
+	return updated;
+}
+
+int MultiplexedSource::setEffectiveReg(const RECT_f& effectiveReg)
+{
+	if (!isValidRegion(effectiveReg))
+		return -1;
+	EnterCriticalSection(&m_lock);
+	m_effectiveReg = effectiveReg;
+	RECT frameRect = { 0, 0, m_frame.layout().width(), m_frame.layout().height() };
+	if (!m_frame.valid() || !FrameView::toPixelRect(m_effectiveReg, frameRect, m_effectiveRect))
+		SetRectEmpty(&m_effectiveRect);
+	m_identify++;
+	LeaveCriticalSection(&m_lock);
+	return 0;
+}
+
+RECT_f MultiplexedSource::getEffectiveReg() const
+{
+	EnterCriticalSection(&m_lock);
+	RECT_f effectiveReg = m_effectiveReg;
+	LeaveCriticalSection(&m_lock);
+	return effectiveReg;
+}
+
+void MultiplexedSource::present(const FrameRef& frame)
+{
+	//the frame replaced may be the last reference of it, it is released after the lock
+	FrameRef previous = frame;
+	EnterCriticalSection(&m_lock);
+	//the crop only changes with the size of the frames
+	const bool resized = !m_frame.valid() || m_frame.layout().width() != frame.layout().width()
+		|| m_frame.layout().height() != frame.layout().height();
+	m_frame.swap(previous);
+	if (resized)
+	{
+		RECT frameRect = { 0, 0, m_frame.layout().width(), m_frame.layout().height() };
+		if (!FrameView::toPixelRect(m_effectiveReg, frameRect, m_effectiveRect))
+			SetRectEmpty(&m_effectiveRect);
+	}
+	m_identify++;
+	LeaveCriticalSection(&m_lock);
+}
+
+FrameRef MultiplexedSource::shownFrame(int& identify, RECT& effectiveRect) const
+{
+	EnterCriticalSection(&m_lock);
+	FrameRef frame = m_frame;
+	identify = m_identify;
+	effectiveRect = m_effectiveRect;
+	LeaveCriticalSection(&m_lock);
+	return frame;
+}
+
+int MultiplexedSource::getFrameView(const RECT_f& textureReg, FrameView& view, int& identify)
+{
+	int shownIdentify = 0;
+	RECT effectiveRect;
+	FrameRef frame = shownFrame(shownIdentify, effectiveRect);
+	RECT rect;
+	if (!frame.valid() || !FrameView::toPixelRect(textureReg, effectiveRect, rect))
+		return -1;
+	//m_frame keeps the frame alive until the next one is presented, as long as the view is valid by the contract of getFrameView
+	view = frame.view().crop(rect);
+	if (!view.valid())
+		return -2;
+	identify = shownIdentify;
+	return 0;
+}
+
+int MultiplexedSource::getFrameRef(FrameRef& frame, int& identify)
+{
+	RECT effectiveRect;
+	int shownIdentify = 0;
+	FrameRef shown = shownFrame(shownIdentify, effectiveRect);
+	if (!shown.valid())
+		return -1;
+	frame = shown;
+	identify = shownIdentify;
+	return 0;
+}
+
+int MultiplexedSource::getTextureProfile(const RECT_f& textureReg, int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt)
+{
+	if (!isValidRegion(textureReg))
+		return -1;
+	int shownIdentify = 0;
+	RECT effectiveRect;
+	FrameRef frame = shownFrame(shownIdentify, effectiveRect);
+	RECT rect;
+	if (!frame.valid() || !FrameView::toPixelRect(textureReg, effectiveRect, rect))
+		return -2;
+	const FrameLayout& layout = frame.layout();
+	width = rect.right - rect.left;
+	height = rect.bottom - rect.top;
+	yPitch = layout.pitch(0);
+	uPitch = layout.planeOfU() > 0 ? layout.pitch(layout.planeOfU()) : 0;
+	vPitch = layout.planeOfV() > 0 ? layout.pitch(layout.planeOfV()) : 0;
+	//the planes of the crop with the pitches of the frame, as they are uploaded
+	const FrameLayout cropLayout = FrameLayout::create(layout.pixfmt(), width, height, yPitch, uPitch, vPitch);
+	if (!cropLayout.valid())
+		return -3;
+	dataLen = cropLayout.size();
+	pixelFmt = layout.pixfmt();
+	return 0;
+}
+
+unsigned char* MultiplexedSource::getData(int& dataLen, int& yPitch, int& uPitch, int& vPitch, int& width, int& height, PIXFormat& pixelFmt, RECT& effectReg, int& identify)
+{
+	int shownIdentify = 0;
+	RECT effectiveRect;
+	FrameRef frame = shownFrame(shownIdentify, effectiveRect);
+	if (!frame.valid() || shownIdentify <= identify)
+		return NULL;
+	//the caller reads the data after the return, the frame stays pinned here whatever publish() presents meanwhile.
+	//The frame handed out before is released after the lock
+	FrameRef previous = frame;
+	EnterCriticalSection(&m_lock);
+	m_dataFrame.swap(previous);
+	LeaveCriticalSection(&m_lock);
+	const FrameLayout& layout = frame.layout();
+	dataLen = frame.size();
+	yPitch = layout.pitch(0);
+	uPitch = layout.planeOfU() > 0 ? layout.pitch(layout.planeOfU()) : 0;
+	vPitch = layout.planeOfV() > 0 ? layout.pitch(layout.planeOfV()) : 0;
+	width = layout.width();
+	height = layout.height();
+	pixelFmt = layout.pixfmt();
+	effectReg = effectiveRect;
+	identify = shownIdentify;
+	return const_cast<unsigned char*>(frame.data());
+}
+
+int MultiplexedSource::copyDataToTexture(const RECT_f& textureReg, unsigned char* dstTextureData, int pitch, int height, int& identify)
+{
+	int shownIdentify = 0;
+	RECT effectiveRect;
+	FrameRef frame = shownFrame(shownIdentify, effectiveRect);
+	if (!frame.valid())
+		return -1;
+	if (shownIdentify <= identify)
+		return 1;
+	RECT rect;
+	if (!FrameView::toPixelRect(textureReg, effectiveRect, rect))
+		return -2;
+	//the crop is read in place, the rows go straight into the mapped texture
+	FrameView view = frame.view().crop(rect);
+	FrameLayout dstLayout = textureLayout(frame.layout().pixfmt(), view.width(), view.height(), pitch);
+	if (!view.valid() || !dstLayout.valid() || height < view.height() || NULL == dstTextureData)
+		return -2;
+	if (0 != view.copyTo(dstTextureData, dstLayout))
+		return -3;
+	identify = shownIdentify;
+	return 0;
+}
+
+FrameMultiplexer::FrameMultiplexer()
+	: m_publishSequence(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	InitializeCriticalSection(&m_lock);
+}
+
+FrameMultiplexer::~FrameMultiplexer()
+{
+	for (size_t i = 0; i < m_views.size(); i++)
+		delete m_views[i];
+	m_views.clear();
+	m_last.reset();
+	DeleteCriticalSection(&m_lock);
+}
+
+MultiplexedSource* FrameMultiplexer::subscribe(const RECT_f& effectiveReg, PIXFormat pixfmt)
+{
+	if (!MultiplexedSource::isValidRegion(effectiveReg))
+		return NULL;
+	MultiplexedSource* view = new MultiplexedSource(effectiveReg, pixfmt);
+	EnterCriticalSection(&m_lock);
+	FrameRef last = m_last;
+	const long sequence = m_publishSequence;
+	FrameRef frame;
+	if (last.valid())
+	{
+		//a view of the same format already holds the last frame converted
+		const PIXFormat target = formatFor(view, last.layout().pixfmt());
+		for (size_t i = 0; i < m_views.size() && !frame.valid(); i++)
+		{
+			int identify = 0;
+			if (formatFor(m_views[i], last.layout().pixfmt()) == target)
+				m_views[i]->getFrameRef(frame, identify);
+		}
+		if (!frame.valid() && target == last.layout().pixfmt())
+			frame = last;
+	}
+	LeaveCriticalSection(&m_lock);
+	//a new format, converted outside the lock like the frames of publish()
+	if (last.valid() && !frame.valid())
+		frame = convert(last.view(), formatFor(view, last.layout().pixfmt()), last.pts());
+	EnterCriticalSection(&m_lock);
+	//a frame published meanwhile is newer than the one converted, the view waits for the next one.
+	//Compared by sequence, the buffer of m_last may be the one of last again once the pool handed it out
+	if (frame.valid() && m_publishSequence == sequence)
+		view->present(frame);
+	m_views.push_back(view);
+	LeaveCriticalSection(&m_lock);
+	return view;
+}
+
+int FrameMultiplexer::unsubscribe(MultiplexedSource* view)
+{
+	EnterCriticalSection(&m_lock);
+	for (size_t i = 0; i < m_views.size(); i++)
+	{
+		if (m_views[i] == view)
+		{
+			m_views.erase(m_views.begin() + i);
+			LeaveCriticalSection(&m_lock);
+			delete view;
+			return 0;
+		}
+	}
+	LeaveCriticalSection(&m_lock);
+	return -1;
+}
+
+int FrameMultiplexer::publish(const FrameRef& frame)
+{
+	if (!frame.valid())
+		return -1;
+	return publishFrame(frame, frame.view(), frame.pts());
+}
+
+int FrameMultiplexer::publish(const FrameView& frame, long long pts)
+{
+	if (!frame.valid())
+		return -1;
+	return publishFrame(FrameRef(), frame, pts);
+}
+
+std::vector<PIXFormat> FrameMultiplexer::wantedFormats(PIXFormat published) const
+{
+	std::vector<PIXFormat> formats;
+	EnterCriticalSection(&m_lock);
+	for (size_t i = 0; i < m_views.size(); i++)
+	{
+		const PIXFormat target = formatFor(m_views[i], published);
+		bool seen = false;
+		for (size_t k = 0; k < formats.size() && !seen; k++)
+			seen = formats[k] == target;
+		if (!seen)
+			formats.push_back(target);
+	}
+	LeaveCriticalSection(&m_lock);
+	return formats;
+}
+
+int FrameMultiplexer::publishFrame(const FrameRef& shared, const FrameView& view, long long pts)
+{
+	const PIXFormat published = view.pixfmt();
+	const std::vector<PIXFormat> formats = wantedFormats(published);
+	//one frame per format, converted without the lock, the render threads go on reading the views meanwhile
+	std::vector<FrameRef> frames(formats.size());
+	int failedFormats = 0;
+	long conversions = 0;
+	for (size_t k = 0; k < formats.size(); k++)
+	{
+		if (formats[k] == published && shared.valid())
+			frames[k] = shared;
+		else
+			frames[k] = convert(view, formats[k], pts);
+		if (!frames[k].valid())
+			failedFormats++;
+		else if (formats[k] != published)
+			conversions++;
+	}
+	//the last frame of a borrowed frame is its copy, if a view of its format made one
+	FrameRef last = shared;
+	for (size_t k = 0; k < formats.size() && !last.valid(); k++)
+	{
+		if (formats[k] == published)
+			last = frames[k];
+	}
+
+	EnterCriticalSection(&m_lock);
+	m_stats.published++;
+	m_publishSequence++;
+	m_stats.conversions += conversions;
+	m_stats.failures += failedFormats;
+	//the frame replaced may be the last reference of it, it is released after the lock
+	m_last.swap(last);
+	for (size_t i = 0; i < m_views.size(); i++)
+	{
+		//a view subscribed during the conversions in a format not converted keeps the frame subscribe() gave it
+		const PIXFormat target = formatFor(m_views[i], published);
+		for (size_t k = 0; k < formats.size(); k++)
+		{
+			if (formats[k] == target && frames[k].valid())
+				m_views[i]->present(frames[k]);
+		}
+	}
+	LeaveCriticalSection(&m_lock);
+	return failedFormats;
+}
+
+int FrameMultiplexer::getViewCount() const
+{
+	EnterCriticalSection(&m_lock);
+	int count = (int)m_views.size();
+	LeaveCriticalSection(&m_lock);
+	return count;
+}
+
+FrameMultiplexerStats FrameMultiplexer::getStats() const
+{
+	EnterCriticalSection(&m_lock);
+	FrameMultiplexerStats stats = m_stats;
+	LeaveCriticalSection(&m_lock);
+	return stats;
+}
+
+FrameRef FrameMultiplexer::convert(const FrameView& frame, PIXFormat pixfmt, long long pts)
+{
+	const PIXFormat srcFmt = frame.pixfmt();
+	if (pixfmt != srcFmt && !isPixelFormatConvertSupported(srcFmt, pixfmt))
+		return FrameRef();
+	//from the FramePool, the buffers of the frames released by the views are handed out again
+	FrameRef converted = FrameRef::allocate(pixfmt, frame.width(), frame.height(), pts);
+	unsigned char* dst = converted.mutableData();
+	if (NULL == dst)
+		return FrameRef();
+	const FrameLayout& dstLayout = converted.layout();
+	if (pixfmt == srcFmt)
+		return 0 == frame.copyTo(dst, dstLayout) ? converted : FrameRef();
+	const unsigned char* srcPlanes[3] = { NULL, NULL, NULL };
+	int srcPitches[3] = { 0, 0, 0 };
+	for (int i = 0; i < frame.planeCount(); i++)
+	{
+		srcPlanes[i] = frame.plane(i);
+		srcPitches[i] = frame.pitch(i);
+	}
+	unsigned char* dstPlanes[3] = { NULL, NULL, NULL };
+	dstLayout.getPlanes(dst, dstPlanes);
+	//YUV to the 32 bits BGR formats goes through convertYUVToBGRA, the kernels matching the shader of the YUV textures
+	if (0 != convertPixelFormat(srcFmt, srcPlanes, srcPitches, pixfmt, dstPlanes, dstLayout.pitches(),
+								frame.width(), frame.height()))
+		return FrameRef();
+	return converted;
+}
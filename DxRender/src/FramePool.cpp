@@ -0,0 +1,279 @@
+#include "inc/FramePool.h"
+#include <malloc.h>
+#include <string.h>
+
+using namespace zRender;
+
+namespace
+{
+	//SeLockMemoryPrivilege is held by the users with the right but disabled in the token until asked for
+	bool enableLockMemoryPrivilege()
+	{
+		HANDLE token = NULL;
+		if(!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+			return false;
+		TOKEN_PRIVILEGES privileges;
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool enabled = false;
+		if(LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+			&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL))
+		{
+			//succeeds without the right too, ERROR_NOT_ALL_ASSIGNED tells it
+			enabled = GetLastError() == ERROR_SUCCESS;
+		}
+		CloseHandle(token);
+		return enabled;
+	}
+}
+
+struct FramePool::InstanceRef
+{
+	FramePool* pool;
+	InstanceRef() : pool(new FramePool()) {}
+	~InstanceRef() { pool->releaseRef(); }
+};
+
+FramePool& FramePool::instance()
+{
+	static InstanceRef s_instance;
+	return *s_instance.pool;
+}
+
+FramePool::FramePool()
+	: m_largePages(false), m_largePageMin(0), m_refs(1)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	InitializeCriticalSection(&m_lock);
+}
+
+FramePool::~FramePool()
+{
+	//every buffer has been given back, they are all idle
+	trim();
+	DeleteCriticalSection(&m_lock);
+}
+
+void FramePool::releaseRef()
+{
+	if(0 == InterlockedDecrement(&m_refs))
+		delete this;
+}
+
+unsigned char* FramePool::acquire(PIXFormat pixfmt, int width, int height)
+{
+	const int size = FRAMESIZE(width, height, pixfmt);
+	if(size <= 0)
+		return NULL;
+	return acquireKey(pixfmt, width, height, size);
+}
+
+unsigned char* FramePool::acquire(int byteCount)
+{
+	if(byteCount <= 0)
+		return NULL;
+	return acquireKey(PIXFMT_UNKNOW, byteCount, 1, byteCount);
+}
+
+unsigned char* FramePool::acquireKey(PIXFormat pixfmt, int width, int height, size_t size)
+{
+	EnterCriticalSection(&m_lock);
+	for(size_t i = 0; i < m_buffers.size(); i++)
+	{
+		Buffer& buffer = m_buffers[i];
+		if(!buffer.inUse && buffer.pixfmt == pixfmt && buffer.width == width && buffer.height == height)
+		{
+			InterlockedIncrement(&m_refs);
+			buffer.inUse = true;
+			m_stats.hits++;
+			m_stats.bytesPooled -= buffer.size;
+			m_stats.bytesOutstanding += buffer.size;
+			LeaveCriticalSection(&m_lock);
+			return buffer.data;
+		}
+	}
+	const bool largePages = m_largePages;
+	const size_t largePageMin = m_largePageMin;
+	LeaveCriticalSection(&m_lock);
+
+	//a frame of a few MB is not allocated holding the lock
+	Buffer buffer;
+	buffer.data = NULL;
+	buffer.pixfmt = pixfmt;
+	buffer.width = width;
+	buffer.height = height;
+	buffer.size = size;
+	buffer.largePage = false;
+	buffer.inUse = true;
+	if(largePages && largePageMin > 0 && size >= largePageMin)
+	{
+		const size_t largeSize = (size + largePageMin - 1) / largePageMin * largePageMin;
+		buffer.data = (unsigned char*)VirtualAlloc(NULL, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		buffer.largePage = buffer.data != NULL;
+	}
+	if(buffer.data == NULL)
+		buffer.data = (unsigned char*)_aligned_malloc(size, size >= PAGE_ALIGN ? PAGE_ALIGN : BUFFER_ALIGN);
+	if(buffer.data == NULL)
+		return NULL;
+
+	EnterCriticalSection(&m_lock);
+	InterlockedIncrement(&m_refs);
+	m_buffers.push_back(buffer);
+	m_stats.misses++;
+	m_stats.bytesOutstanding += size;
+	if(buffer.largePage)
+		m_stats.largePageBuffers++;
+	LeaveCriticalSection(&m_lock);
+	return buffer.data;
+}
+
+int FramePool::release(unsigned char* data)
+{
+	if(data == NULL)
+		return -1;
+	EnterCriticalSection(&m_lock);
+	size_t index = 0;
+	for(; index < m_buffers.size(); index++)
+	{
+		if(m_buffers[index].data == data)
+			break;
+	}
+	if(index == m_buffers.size() || !m_buffers[index].inUse)
+	{
+		LeaveCriticalSection(&m_lock);
+		return -2;
+	}
+	Buffer& buffer = m_buffers[index];
+	buffer.inUse = false;
+	m_stats.bytesOutstanding -= buffer.size;
+	int idle = 0;
+	for(size_t i = 0; i < m_buffers.size(); i++)
+	{
+		const Buffer& other = m_buffers[i];
+		if(!other.inUse && other.pixfmt == buffer.pixfmt && other.width == buffer.width && other.height == buffer.height)
+			idle++;
+	}
+	if(idle <= MAX_IDLE_PER_KEY)
+	{
+		m_stats.bytesPooled += buffer.size;
+		LeaveCriticalSection(&m_lock);
+		releaseRef();
+		return 0;
+	}
+	Buffer freed = buffer;
+	if(freed.largePage)
+		m_stats.largePageBuffers--;
+	m_buffers.erase(m_buffers.begin() + index);
+	LeaveCriticalSection(&m_lock);
+	freeBuffer(freed);
+	//may free the pool, the last buffer of a process whose instance() is gone
+	releaseRef();
+	return 0;
+}
+
+bool FramePool::setLargePages(bool enable)
+{
+	size_t largePageMin = 0;
+	if(enable)
+	{
+		largePageMin = GetLargePageMinimum();
+		if(largePageMin == 0 || !enableLockMemoryPrivilege())
+			enable = false;
+	}
+	EnterCriticalSection(&m_lock);
+	m_largePages = enable;
+	m_largePageMin = largePageMin;
+	LeaveCriticalSection(&m_lock);
+	return enable;
+}
+
+void FramePool::trim()
+{
+	std::vector<Buffer> freed;
+	EnterCriticalSection(&m_lock);
+	size_t kept = 0;
+	for(size_t i = 0; i < m_buffers.size(); i++)
+	{
+		if(m_buffers[i].inUse)
+		{
+			m_buffers[kept++] = m_buffers[i];
+			continue;
+		}
+		freed.push_back(m_buffers[i]);
+		m_stats.bytesPooled -= m_buffers[i].size;
+		if(m_buffers[i].largePage)
+			m_stats.largePageBuffers--;
+	}
+	m_buffers.resize(kept);
+	LeaveCriticalSection(&m_lock);
+	for(size_t i = 0; i < freed.size(); i++)
+		freeBuffer(freed[i]);
+}
+
+FramePoolStats FramePool::getStats() const
+{
+	EnterCriticalSection(&m_lock);
+	FramePoolStats stats = m_stats;
+	LeaveCriticalSection(&m_lock);
+	return stats;
+}
+
+void FramePool::freeBuffer(Buffer& buffer)
+{
+	if(buffer.largePage)
+		VirtualFree(buffer.data, 0, MEM_RELEASE);
+	else
+		_aligned_free(buffer.data);
+	buffer.data = NULL;
+}
+
+FrameBuffer::FrameBuffer(PIXFormat pixfmt, int width, int height)
+	: m_data(NULL), m_size(0), m_pool(NULL)
+{
+	allocate(pixfmt, width, height);
+}
+
+FrameBuffer::FrameBuffer(int byteCount)
+	: m_data(NULL), m_size(0), m_pool(NULL)
+{
+	allocate(byteCount);
+}
+
+bool FrameBuffer::allocate(PIXFormat pixfmt, int width, int height)
+{
+	reset();
+	m_pool = &FramePool::instance();
+	m_data = m_pool->acquire(pixfmt, width, height);
+	m_size = m_data ? FRAMESIZE(width, height, pixfmt) : 0;
+	return m_data != NULL;
+}
+
+bool FrameBuffer::allocate(int byteCount)
+{
+	reset();
+	m_pool = &FramePool::instance();
+	m_data = m_pool->acquire(byteCount);
+	m_size = m_data ? byteCount : 0;
+	return m_data != NULL;
+}
+
+void FrameBuffer::reset()
+{
+	if(m_data)
+		m_pool->release(m_data);
+	m_data = NULL;
+	m_size = 0;
+}
+
+void FrameBuffer::swap(FrameBuffer& other)
+{
+	unsigned char* data = m_data;
+	int size = m_size;
+	FramePool* pool = m_pool;
+	m_data = other.m_data;
+	m_size = other.m_size;
+	m_pool = other.m_pool;
+	other.m_data = data;
+	other.m_size = size;
+	other.m_pool = pool;
+}
@@ -0,0 +1,141 @@
+#include "inc/FrameQueue.h"
+
+using namespace zRender;
+
+FrameQueue::FrameQueue(int capacity, FRAME_QUEUE_OVERFLOW overflow)
+	: m_slots(NULL), m_mask(0), m_capacity(capacity < 1 ? 1 : capacity), m_overflow(overflow), m_roomFreed(NULL)
+	, m_tail(0), m_headCache(0), m_pushed(0), m_dropped(0), m_timeouts(0), m_producerWaiting(0)
+	, m_head(0), m_tailCache(0), m_popped(0)
+{
+	//a power of 2 of slots, the indexes only grow and are masked
+	LONG slotCount = 1;
+	while(slotCount < m_capacity)
+		slotCount <<= 1;
+	m_mask = slotCount - 1;
+	m_slots = new Block* volatile[slotCount];
+	for(LONG i = 0; i < slotCount; i++)
+		m_slots[i] = NULL;
+	if(m_overflow == FRAME_QUEUE_BLOCK)
+		m_roomFreed = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+FrameQueue::~FrameQueue()
+{
+	clear();
+	delete[] m_slots;
+	if(m_roomFreed)
+		CloseHandle(m_roomFreed);
+}
+
+int FrameQueue::push(const FrameRef& frame, DWORD timeoutMs)
+{
+	if(!frame.valid())
+		return -1;
+	const LONG tail = m_tail;
+	int ret = 0;
+	int spins = 0;
+	bool waited = false;
+	DWORD waitStart = 0;
+	while((LONG)(tail - m_headCache) >= m_capacity)
+	{
+		m_headCache = m_head;
+		if((LONG)(tail - m_headCache) < m_capacity)
+			break;
+		if(m_overflow == FRAME_QUEUE_DROP_OLDEST)
+		{
+			//the consumer may take the oldest frame first, the head has moved then and there is room anyway
+			Block* oldest = NULL;
+			if(takeHead(m_headCache, oldest))
+			{
+				FrameRef dropped(oldest);
+				m_dropped++;
+				ret = 1;
+			}
+			continue;
+		}
+		//the consumer frees a slot within a few instructions most of the time, the event costs a trip to the kernel
+		if(spins < SPIN_COUNT)
+		{
+			spins++;
+			YieldProcessor();
+			continue;
+		}
+		if(!waited)
+		{
+			waited = true;
+			waitStart = GetTickCount();
+		}
+		DWORD elapsed = GetTickCount() - waitStart;
+		if(NULL == m_roomFreed || (timeoutMs != INFINITE && elapsed >= timeoutMs))
+		{
+			m_timeouts++;
+			return -2;
+		}
+		//a pop after the flag is raised sets the event, a pop before it is seen by the check below
+		InterlockedExchange(&m_producerWaiting, 1);
+		if((LONG)(tail - m_head) >= m_capacity)
+			WaitForSingleObject(m_roomFreed, timeoutMs == INFINITE ? INFINITE : timeoutMs - elapsed);
+		InterlockedExchange(&m_producerWaiting, 0);
+	}
+	//the slot holds a count of its own, the frame of the caller stays as it is
+	InterlockedIncrement(&frame.m_block->refs);
+	m_slots[tail & m_mask] = frame.m_block;
+	//the slot is written before the consumer sees the new tail
+	InterlockedExchange(&m_tail, tail + 1);
+	m_pushed++;
+	return ret;
+}
+
+bool FrameQueue::pop(FrameRef& frame)
+{
+	for(;;)
+	{
+		const LONG head = m_head;
+		if((LONG)(m_tailCache - head) <= 0)
+		{
+			m_tailCache = m_tail;
+			if((LONG)(m_tailCache - head) <= 0)
+				return false;
+		}
+		Block* block = NULL;
+		if(!takeHead(head, block))
+			continue;
+		FrameRef taken(block);
+		frame.swap(taken);
+		m_popped++;
+		if(m_producerWaiting)
+			SetEvent(m_roomFreed);
+		return true;
+	}
+}
+
+bool FrameQueue::takeHead(LONG head, Block*& block)
+{
+	//the producer never writes the slot of the head while the head stays, what is read here is the frame of the head
+	//as long as the head moves from head to head+1 by this call
+	block = m_slots[head & m_mask];
+	return InterlockedCompareExchange(&m_head, head + 1, head) == head;
+}
+
+void FrameQueue::clear()
+{
+	FrameRef frame;
+	while(pop(frame))
+		frame.reset();
+}
+
+int FrameQueue::size() const
+{
+	LONG count = (LONG)(m_tail - m_head);
+	return count < 0 ? 0 : (count > m_capacity ? m_capacity : (int)count);
+}
+
+FrameQueueStats FrameQueue::getStats() const
+{
+	FrameQueueStats stats;
+	stats.pushed = m_pushed;
+	stats.popped = m_popped;
+	stats.dropped = m_dropped;
+	stats.timeouts = m_timeouts;
+	return stats;
+}
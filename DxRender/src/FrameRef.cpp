@@ -0,0 +1,180 @@
+#include "inc/FrameRef.h"
+#include "inc/FramePool.h"
+
+using namespace zRender;
+
+namespace
+{
+	const FrameLayout s_emptyLayout;
+}
+
+/**
+ *	@brief	free list of the Blocks. The members are zero initialized before any constructor runs, so the FrameRefs of static objects
+ *			may use it whatever the order of construction. The lock is only held to link or unlink one block
+ **/
+struct FrameRef::BlockCache
+{
+	static volatile LONG s_lock;
+	static Block* s_free;
+	static int s_freeCount;
+	static bool s_closed;		//the static objects are being destroyed, the blocks released from now on are deleted
+	static BlockCache s_instance;	//frees the blocks left in the free list at the end of the process
+
+	static void lock()
+	{
+		while(0 != InterlockedExchange(&s_lock, 1))
+			Sleep(0);
+	}
+
+	static void unlock() { InterlockedExchange(&s_lock, 0); }
+
+	~BlockCache()
+	{
+		lock();
+		Block* block = s_free;
+		s_free = NULL;
+		s_freeCount = 0;
+		s_closed = true;
+		unlock();
+		while(block)
+		{
+			Block* next = block->next;
+			delete block;
+			block = next;
+		}
+	}
+};
+
+volatile LONG FrameRef::BlockCache::s_lock = 0;
+FrameRef::Block* FrameRef::BlockCache::s_free = NULL;
+int FrameRef::BlockCache::s_freeCount = 0;
+bool FrameRef::BlockCache::s_closed = false;
+FrameRef::BlockCache FrameRef::BlockCache::s_instance;
+
+FrameRef::Block* FrameRef::newBlock()
+{
+	BlockCache::lock();
+	Block* block = BlockCache::s_free;
+	if(block)
+	{
+		BlockCache::s_free = block->next;
+		BlockCache::s_freeCount--;
+	}
+	BlockCache::unlock();
+	return block ? block : new Block;
+}
+
+void FrameRef::deleteBlock(Block* block)
+{
+	//the layout of the block is overwritten by the next wrap(), the buffer it described is given back already
+	BlockCache::lock();
+	const bool keep = !BlockCache::s_closed && BlockCache::s_freeCount < MAX_FREE_BLOCKS;
+	if(keep)
+	{
+		block->next = BlockCache::s_free;
+		BlockCache::s_free = block;
+		BlockCache::s_freeCount++;
+	}
+	BlockCache::unlock();
+	if(!keep)
+		delete block;
+}
+
+FrameRef::FrameRef(const FrameRef& other)
+	: m_block(other.m_block)
+{
+	if(m_block)
+		InterlockedIncrement(&m_block->refs);
+}
+
+FrameRef& FrameRef::operator=(const FrameRef& other)
+{
+	//the count of other goes up first, assigning a FrameRef of the same frame never frees it
+	Block* block = other.m_block;
+	if(block)
+		InterlockedIncrement(&block->refs);
+	reset();
+	m_block = block;
+	return *this;
+}
+
+FrameRef FrameRef::wrap(unsigned char* data, int dataLen, const FrameLayout& layout, long long pts,
+						FrameReleaseHook hook, void* context)
+{
+	if(NULL == data || !layout.valid() || dataLen < layout.size())
+		return FrameRef();
+	Block* block = newBlock();
+	block->next = NULL;
+	block->refs = 1;
+	block->data = data;
+	block->size = dataLen;
+	block->layout = layout;
+	block->pts = pts;
+	block->hook = hook;
+	block->context = context;
+	return FrameRef(block);
+}
+
+FrameRef FrameRef::allocate(PIXFormat pixfmt, int width, int height, long long pts)
+{
+	FrameLayout layout = FrameLayout::create(pixfmt, width, height);
+	if(!layout.valid())
+		return FrameRef();
+	FramePool* pool = &FramePool::instance();
+	unsigned char* data = pool->acquire(pixfmt, width, height);
+	if(NULL == data)
+		return FrameRef();
+	FrameRef frame = wrap(data, FRAMESIZE(width, height, pixfmt), layout, pts, releaseToPool, pool);
+	if(!frame.valid())
+		pool->release(data);
+	return frame;
+}
+
+const FrameLayout& FrameRef::layout() const
+{
+	return m_block ? m_block->layout : s_emptyLayout;
+}
+
+unsigned char* FrameRef::mutableData()
+{
+	return useCount() == 1 ? m_block->data : NULL;
+}
+
+long FrameRef::useCount() const
+{
+	if(NULL == m_block)
+		return 0;
+	//an interlocked read, the count may be changed by the other owners on other threads
+	return InterlockedCompareExchange(&m_block->refs, 0, 0);
+}
+
+FrameView FrameRef::view() const
+{
+	if(NULL == m_block)
+		return FrameView();
+	return FrameView::wrap(m_block->data, m_block->layout);
+}
+
+void FrameRef::reset()
+{
+	Block* block = m_block;
+	m_block = NULL;
+	if(NULL == block || InterlockedDecrement(&block->refs) > 0)
+		return;
+	if(block->hook)
+		block->hook(block->data, block->context);
+	deleteBlock(block);
+}
+
+void FrameRef::swap(FrameRef& other)
+{
+	Block* block = m_block;
+	m_block = other.m_block;
+	other.m_block = block;
+}
+
+void FrameRef::releaseToPool(unsigned char* data, void* context)
+{
+	//the pool the frame came from, alive as long as the buffer is out
+	reinterpret_cast<FramePool*>(context)->release(data);
+}
@@ -0,0 +1,145 @@
+#include "inc/FrameView.h"
+#include "inc/FrameLayout.h"
+#include "inc/PlaneCopy.h"
+#include <stddef.h>
+
+using namespace zRender;
+
+FrameView::FrameView()
+	: m_pixfmt(PIXFMT_UNKNOW), m_width(0), m_height(0), m_planeCount(0)
+{
+	for(int i = 0; i < MAX_PLANE_COUNT; i++)
+	{
+		m_planes[i] = NULL;
+		m_pitches[i] = 0;
+	}
+}
+
+FrameView FrameView::wrap(const unsigned char* base, const FrameLayout& layout)
+{
+	if(base == NULL || !layout.valid())
+		return FrameView();
+	const unsigned char* planes[MAX_PLANE_COUNT] = {NULL, NULL, NULL};
+	layout.getPlanes(base, planes);
+	return wrap(layout.pixfmt(), planes, layout.pitches(), layout.width(), layout.height());
+}
+
+FrameView FrameView::wrap(PIXFormat pixfmt, const unsigned char* const planes[3], const int pitches[3], int width, int height)
+{
+	FrameView view;
+	if(!isKnownPixelFormat(pixfmt) || planes == NULL || pitches == NULL || width <= 0 || height <= 0)
+		return view;
+	const PixelFormatDesc& desc = PixelFormatDescs[pixfmt];
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		if(planes[i] == NULL || pitches[i] < getPlaneRowBytes(desc.planes[i], width))
+			return view;
+	}
+	view.m_pixfmt = pixfmt;
+	view.m_width = width;
+	view.m_height = height;
+	view.m_planeCount = desc.planeCount;
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		view.m_planes[i] = planes[i];
+		view.m_pitches[i] = pitches[i];
+	}
+	return view;
+}
+
+bool FrameView::toPixelRect(const RECT_f& region, const RECT& outer, RECT& rect)
+{
+	if(region.left < 0 || region.top < 0 || region.right > 1 || region.bottom > 1
+		|| region.width() <= 0 || region.height() <= 0)
+		return false;
+	const int outerWidth = outer.right - outer.left;
+	const int outerHeight = outer.bottom - outer.top;
+	rect.left = outer.left + (LONG)(outerWidth * region.left + 0.5f);
+	rect.right = outer.left + (LONG)(outerWidth * region.right + 0.5f);
+	rect.top = outer.top + (LONG)(outerHeight * region.top + 0.5f);
+	rect.bottom = outer.top + (LONG)(outerHeight * region.bottom + 0.5f);
+	return rect.right > rect.left && rect.bottom > rect.top;
+}
+
+int FrameView::rowBytes(int plane) const
+{
+	if(plane < 0 || plane >= m_planeCount)
+		return 0;
+	return getPlaneRowBytes(PixelFormatDescs[m_pixfmt].planes[plane], m_width);
+}
+
+int FrameView::planeRows(int plane) const
+{
+	if(plane < 0 || plane >= m_planeCount)
+		return 0;
+	return getPlaneRows(PixelFormatDescs[m_pixfmt].planes[plane], m_height);
+}
+
+void FrameView::getCropAlignment(PIXFormat pixfmt, int& alignX, int& alignY)
+{
+	alignX = 1;
+	alignY = 1;
+	if(!isKnownPixelFormat(pixfmt))
+		return;
+	const PixelFormatDesc& desc = PixelFormatDescs[pixfmt];
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		if((desc.planes[i].blockWidth << desc.planes[i].shiftX) > alignX)
+			alignX = desc.planes[i].blockWidth << desc.planes[i].shiftX;
+		if((1 << desc.planes[i].shiftY) > alignY)
+			alignY = 1 << desc.planes[i].shiftY;
+	}
+}
+
+void FrameView::alignCropRect(PIXFormat pixfmt, RECT& rect)
+{
+	int alignX = 1;
+	int alignY = 1;
+	getCropAlignment(pixfmt, alignX, alignY);
+	//both are powers of 2
+	rect.left &= ~(alignX - 1);
+	rect.top &= ~(alignY - 1);
+}
+
+FrameView FrameView::crop(int x, int y, int width, int height) const
+{
+	FrameView view;
+	if(!valid() || x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > m_width || y + height > m_height)
+		return view;
+	RECT rect = {x, y, x + width, y + height};
+	alignCropRect(m_pixfmt, rect);
+	const int alignedX = rect.left;
+	const int alignedY = rect.top;
+	view = *this;
+	view.m_width = rect.right - rect.left;
+	view.m_height = rect.bottom - rect.top;
+	for(int i = 0; i < m_planeCount; i++)
+	{
+		const PlaneFormatDesc& desc = PixelFormatDescs[m_pixfmt].planes[i];
+		view.m_planes[i] = m_planes[i] + (alignedY >> desc.shiftY) * m_pitches[i]
+						+ ((alignedX >> desc.shiftX) / desc.blockWidth) * desc.blockBytes;
+	}
+	return view;
+}
+
+int FrameView::copyTo(unsigned char* const dstPlanes[3], const int dstPitches[3]) const
+{
+	if(!valid() || dstPlanes == NULL || dstPitches == NULL)
+		return -1;
+	for(int i = 0; i < m_planeCount; i++)
+	{
+		if(0 != copyPlane(m_planes[i], m_pitches[i], dstPlanes[i], dstPitches[i], rowBytes(i), planeRows(i)))
+			return -2;
+	}
+	return 0;
+}
+
+int FrameView::copyTo(unsigned char* dst, const FrameLayout& dstLayout) const
+{
+	if(!valid() || dst == NULL || !dstLayout.valid() || dstLayout.pixfmt() != m_pixfmt
+		|| dstLayout.width() != m_width || dstLayout.height() != m_height)
+		return -1;
+	unsigned char* dstPlanes[MAX_PLANE_COUNT] = {NULL, NULL, NULL};
+	dstLayout.getPlanes(dst, dstPlanes);
+	return copyTo(dstPlanes, dstLayout.pitches());
+}
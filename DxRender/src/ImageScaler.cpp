@@ -0,0 +1,571 @@
+#include "inc/ImageScaler.h"
+#include "inc/CpuFeatures.h"
+#include "inc/FrameLayout.h"
+#include <Windows.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+
+using namespace zRender;
+
+namespace
+{
+	const int WEIGHT_BITS = 14;			//fraction bits of the filter weights
+	const int INTER_BITS = 6;			//fraction bits of the horizontally filtered rows
+	const int HORZ_SHIFT = WEIGHT_BITS - INTER_BITS;
+	const int VERT_SHIFT = WEIGHT_BITS + INTER_BITS;
+	const int MAX_THREAD_COUNT = 16;
+	const int ROW_PADDING = 32;			//samples after every temporary row, the SIMD kernels read and write past the end
+	const double PI = 3.14159265358979323846;
+
+	/**
+	 *	@brief	the taps of every destination sample of one direction
+	 **/
+	struct FilterTaps
+	{
+		int filterSize;					//taps of every destination sample, padded with zero weights
+		std::vector<int> starts;		//first source sample of every destination sample
+		std::vector<short> weights;		//filterSize weights of every destination sample, their sum is 1<<WEIGHT_BITS
+	};
+
+	double sinc(double x)
+	{
+		if(fabs(x) < 1e-9)
+			return 1.0;
+		x *= PI;
+		return sin(x) / x;
+	}
+
+	double filterRadius(SCALE_FILTER filter)
+	{
+		return filter == SCALE_FILTER_LANCZOS ? 3.0 : 1.0;
+	}
+
+	double filterWeight(SCALE_FILTER filter, double x)
+	{
+		x = fabs(x);
+		if(filter == SCALE_FILTER_LANCZOS)
+			return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+		return x < 1.0 ? 1.0 - x : 0.0;
+	}
+
+	int clampInt(int v, int lo, int hi)
+	{
+		return v < lo ? lo : (v > hi ? hi : v);
+	}
+
+	/**
+	 *	@brief	weights of every destination sample, the samples outside of the source are folded onto the edge sample.
+	 *			filterSize is a multiple of alignTaps, and the window of every sample stays inside of the source when it can
+	 **/
+	void buildFilter(int srcLen, int dstLen, SCALE_FILTER filter, int alignTaps, FilterTaps& taps)
+	{
+		const double scale = (double)srcLen / dstLen;
+		std::vector< std::vector<double> > raw(dstLen);
+		std::vector<int> rawStarts(dstLen);
+		int maxSize = 1;
+		for(int i = 0; i < dstLen; i++)
+		{
+			std::vector<double>& w = raw[i];
+			int lo = 0;
+			if(filter == SCALE_FILTER_AREA)
+			{
+				//coverage of the source samples by the destination sample
+				const double a = i * scale;
+				const double b = (i + 1) * scale;
+				lo = clampInt((int)floor(a), 0, srcLen - 1);
+				const int hi = clampInt((int)ceil(b) - 1, lo, srcLen - 1);
+				w.assign(hi - lo + 1, 0.0);
+				for(int j = lo; j <= hi; j++)
+				{
+					const double cover = (b < j + 1 ? b : j + 1) - (a > j ? a : j);
+					if(cover > 0)
+						w[j - lo] += cover;
+				}
+			}
+			else
+			{
+				const double filterScale = scale > 1.0 ? scale : 1.0;
+				const double support = filterRadius(filter) * filterScale;
+				const double center = (i + 0.5) * scale - 0.5;
+				const int rawLo = (int)ceil(center - support);
+				const int rawHi = (int)floor(center + support);
+				lo = clampInt(rawLo, 0, srcLen - 1);
+				const int hi = clampInt(rawHi, 0, srcLen - 1);
+				w.assign(hi - lo + 1, 0.0);
+				for(int j = rawLo; j <= rawHi; j++)
+					w[clampInt(j, 0, srcLen - 1) - lo] += filterWeight(filter, (j - center) / filterScale);
+			}
+			//drop the zero weights on both ends, e.g. the zero crossings of Lanczos
+			size_t first = 0;
+			size_t last = w.size();
+			while(first + 1 < last && fabs(w[first]) < 1e-9)
+				first++;
+			while(last - 1 > first && fabs(w[last - 1]) < 1e-9)
+				last--;
+			w = std::vector<double>(w.begin() + first, w.begin() + last);
+			rawStarts[i] = lo + (int)first;
+			if((int)w.size() > maxSize)
+				maxSize = (int)w.size();
+		}
+
+		taps.filterSize = (maxSize + alignTaps - 1) / alignTaps * alignTaps;
+		taps.starts.assign(dstLen, 0);
+		taps.weights.assign((size_t)dstLen * taps.filterSize, 0);
+		for(int i = 0; i < dstLen; i++)
+		{
+			const std::vector<double>& w = raw[i];
+			int start = rawStarts[i];
+			if(start + taps.filterSize > srcLen)
+				start = srcLen - taps.filterSize > 0 ? srcLen - taps.filterSize : 0;
+			const int offset = rawStarts[i] - start;
+			double sum = 0;
+			for(size_t k = 0; k < w.size(); k++)
+				sum += w[k];
+			if(sum == 0)
+				sum = 1;
+			short* iw = &taps.weights[(size_t)i * taps.filterSize];
+			int isum = 0;
+			int maxIndex = offset;
+			for(size_t k = 0; k < w.size(); k++)
+			{
+				const int v = (int)floor(w[k] / sum * (1 << WEIGHT_BITS) + 0.5);
+				iw[offset + k] = (short)v;
+				isum += v;
+				if(iw[offset + k] > iw[maxIndex])
+					maxIndex = offset + (int)k;
+			}
+			//the rounding error goes to the largest weight, flat areas stay flat
+			iw[maxIndex] = (short)(iw[maxIndex] + (1 << WEIGHT_BITS) - isum);
+			taps.starts[i] = start;
+		}
+	}
+
+	short saturateShort(int v)
+	{
+		return (short)(v < -32768 ? -32768 : (v > 32767 ? 32767 : v));
+	}
+
+	unsigned char clampByte(int v)
+	{
+		return (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+	}
+
+	/**
+	 *	@brief	filter one row horizontally. The kernels may read 8 bytes past the window of a sample,
+	 *			src is the source row when the next row follows it, or a copy followed by zero samples
+	 **/
+	typedef void (*HorzFilterFunc)(const unsigned char* src, short* dst, int dstLen, int channels, const FilterTaps& taps);
+
+	/**
+	 *	@brief	filter taps rows vertically, taps is even. dst receives len bytes
+	 **/
+	typedef void (*VertFilterFunc)(const short* const* rows, const short* weights, int taps, unsigned char* dst, int len);
+
+	void horzFilter_C(const unsigned char* src, short* dst, int dstLen, int channels, const FilterTaps& taps)
+	{
+		const int fs = taps.filterSize;
+		for(int i = 0; i < dstLen; i++)
+		{
+			const unsigned char* p = src + taps.starts[i] * channels;
+			const short* w = &taps.weights[(size_t)i * fs];
+			for(int ch = 0; ch < channels; ch++)
+			{
+				int sum = 0;
+				for(int t = 0; t < fs; t++)
+					sum += p[t * channels + ch] * w[t];
+				dst[i * channels + ch] = saturateShort((sum + (1 << (HORZ_SHIFT - 1))) >> HORZ_SHIFT);
+			}
+		}
+	}
+
+	ZRENDER_TARGET_SSSE3 __m128i horzSum1_SSSE3(const unsigned char* p, const short* w, int fs)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i acc = _mm_setzero_si128();
+		for(int t = 0; t < fs; t += 8)
+		{
+			__m128i x = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + t)), zero);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(x, _mm_loadu_si128((const __m128i*)(w + t))));
+		}
+		return acc;
+	}
+
+	//one channel, filterSize is a multiple of 8
+	ZRENDER_TARGET_SSSE3 void horzFilter1_SSSE3(const unsigned char* src, short* dst, int dstLen, int channels, const FilterTaps& taps)
+	{
+		const int fs = taps.filterSize;
+		const __m128i round = _mm_set1_epi32(1 << (HORZ_SHIFT - 1));
+		int i = 0;
+		for(; i + 4 <= dstLen; i += 4)
+		{
+			__m128i a0 = horzSum1_SSSE3(src + taps.starts[i + 0], &taps.weights[(size_t)(i + 0) * fs], fs);
+			__m128i a1 = horzSum1_SSSE3(src + taps.starts[i + 1], &taps.weights[(size_t)(i + 1) * fs], fs);
+			__m128i a2 = horzSum1_SSSE3(src + taps.starts[i + 2], &taps.weights[(size_t)(i + 2) * fs], fs);
+			__m128i a3 = horzSum1_SSSE3(src + taps.starts[i + 3], &taps.weights[(size_t)(i + 3) * fs], fs);
+			__m128i sums = _mm_hadd_epi32(_mm_hadd_epi32(a0, a1), _mm_hadd_epi32(a2, a3));
+			sums = _mm_srai_epi32(_mm_add_epi32(sums, round), HORZ_SHIFT);
+			_mm_storel_epi64((__m128i*)(dst + i), _mm_packs_epi32(sums, sums));
+		}
+		for(; i < dstLen; i++)
+		{
+			__m128i a = horzSum1_SSSE3(src + taps.starts[i], &taps.weights[(size_t)i * fs], fs);
+			a = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+			a = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1)));
+			dst[i] = saturateShort((_mm_cvtsi128_si32(a) + (1 << (HORZ_SHIFT - 1))) >> HORZ_SHIFT);
+		}
+	}
+
+	//2 to 4 interleaved channels, filterSize is even. Two taps of every channel are multiplied by one madd
+	ZRENDER_TARGET_SSSE3 void horzFilterN_SSSE3(const unsigned char* src, short* dst, int dstLen, int channels, const FilterTaps& taps)
+	{
+		const int fs = taps.filterSize;
+		//16 bit lanes [c0 of tap0, c0 of tap1, c1 of tap0, c1 of tap1, ...]
+		char mask[16];
+		for(int k = 0; k < 8; k++)
+		{
+			const int ch = k / 2;
+			const int tap = k % 2;
+			mask[k * 2] = (char)(ch < channels ? tap * channels + ch : 0x80);
+			mask[k * 2 + 1] = (char)0x80;
+		}
+		const __m128i shuffle = _mm_loadu_si128((const __m128i*)mask);
+		const __m128i round = _mm_set1_epi32(1 << (HORZ_SHIFT - 1));
+		for(int i = 0; i < dstLen; i++)
+		{
+			const unsigned char* p = src + taps.starts[i] * channels;
+			const short* w = &taps.weights[(size_t)i * fs];
+			__m128i acc = _mm_setzero_si128();
+			for(int t = 0; t < fs; t += 2)
+			{
+				int pair = 0;
+				memcpy(&pair, w + t, sizeof(pair));
+				__m128i x = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i*)(p + t * channels)), shuffle);
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(x, _mm_set1_epi32(pair)));
+			}
+			acc = _mm_srai_epi32(_mm_add_epi32(acc, round), HORZ_SHIFT);
+			//4 samples are written, the ones past this pixel are overwritten by the next one or land in the padding
+			_mm_storel_epi64((__m128i*)(dst + i * channels), _mm_packs_epi32(acc, acc));
+		}
+	}
+
+	void vertFilterRange_C(const short* const* rows, const short* weights, int taps, unsigned char* dst, int begin, int end)
+	{
+		for(int x = begin; x < end; x++)
+		{
+			int sum = 1 << (VERT_SHIFT - 1);
+			for(int k = 0; k < taps; k++)
+				sum += rows[k][x] * weights[k];
+			dst[x] = clampByte(sum >> VERT_SHIFT);
+		}
+	}
+
+	void vertFilter_C(const short* const* rows, const short* weights, int taps, unsigned char* dst, int len)
+	{
+		vertFilterRange_C(rows, weights, taps, dst, 0, len);
+	}
+
+	void vertFilter_SSE2(const short* const* rows, const short* weights, int taps, unsigned char* dst, int len)
+	{
+		const __m128i round = _mm_set1_epi32(1 << (VERT_SHIFT - 1));
+		int x = 0;
+		for(; x + 8 <= len; x += 8)
+		{
+			__m128i accLo = round;
+			__m128i accHi = round;
+			for(int k = 0; k < taps; k += 2)
+			{
+				int pair = 0;
+				memcpy(&pair, weights + k, sizeof(pair));
+				const __m128i w = _mm_set1_epi32(pair);
+				__m128i a = _mm_loadu_si128((const __m128i*)(rows[k] + x));
+				__m128i b = _mm_loadu_si128((const __m128i*)(rows[k + 1] + x));
+				accLo = _mm_add_epi32(accLo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+				accHi = _mm_add_epi32(accHi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+			}
+			__m128i v = _mm_packs_epi32(_mm_srai_epi32(accLo, VERT_SHIFT), _mm_srai_epi32(accHi, VERT_SHIFT));
+			_mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(v, v));
+		}
+		vertFilterRange_C(rows, weights, taps, dst, x, len);
+	}
+
+	ZRENDER_TARGET_AVX2 void vertFilter_AVX2(const short* const* rows, const short* weights, int taps, unsigned char* dst, int len)
+	{
+		const __m256i round = _mm256_set1_epi32(1 << (VERT_SHIFT - 1));
+		int x = 0;
+		for(; x + 16 <= len; x += 16)
+		{
+			__m256i accLo = round;
+			__m256i accHi = round;
+			for(int k = 0; k < taps; k += 2)
+			{
+				int pair = 0;
+				memcpy(&pair, weights + k, sizeof(pair));
+				const __m256i w = _mm256_set1_epi32(pair);
+				__m256i a = _mm256_loadu_si256((const __m256i*)(rows[k] + x));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(rows[k + 1] + x));
+				accLo = _mm256_add_epi32(accLo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+				accHi = _mm256_add_epi32(accHi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+			}
+			//unpack and pack both work inside of the 128 bit lanes, the order of the 16 samples is kept
+			__m256i v = _mm256_packs_epi32(_mm256_srai_epi32(accLo, VERT_SHIFT), _mm256_srai_epi32(accHi, VERT_SHIFT));
+			v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(v));
+		}
+		vertFilterRange_C(rows, weights, taps, dst, x, len);
+	}
+
+	/**
+	 *	@brief	one plane to resize, samples of channels bytes
+	 **/
+	struct ScalePlaneJob
+	{
+		const unsigned char* src;
+		int srcPitch;
+		int srcWidth;
+		int srcHeight;
+		unsigned char* dst;
+		int dstPitch;
+		int dstWidth;
+		int dstHeight;
+		int channels;
+		FilterTaps horz;
+		FilterTaps vert;
+		HorzFilterFunc horzFunc;
+		VertFilterFunc vertFunc;
+	};
+
+	/**
+	 *	@brief	destination rows [rowBegin, rowEnd) of the plane. The horizontally filtered source rows are kept in a ring
+	 *			of vert.filterSize rows, source row r lives in slot r % filterSize, so the rows of one window never collide
+	 **/
+	void scaleRows(const ScalePlaneJob& job, int rowBegin, int rowEnd)
+	{
+		const int c = job.channels;
+		const int fsV = job.vert.filterSize;
+		const int interLen = job.dstWidth * c + ROW_PADDING;
+		std::vector<short> ring((size_t)interLen * fsV, 0);
+		std::vector<int> ringRows(fsV, -1);
+		std::vector<unsigned char> srcRow((size_t)(job.srcWidth + job.horz.filterSize + ROW_PADDING) * c, 0);
+		std::vector<const short*> rowPtrs(fsV);
+		//the SIMD kernels read up to 8-2*channels bytes past the window of the last sample, that is the next row,
+		//so only the last row (and a row narrower than the filter) has to be copied into the zero padded buffer
+		const int overRead = c == 1 ? 0 : 8 - 2 * c;
+		const bool inPlace = job.srcWidth >= job.horz.filterSize;
+		for(int y = rowBegin; y < rowEnd; y++)
+		{
+			const int start = job.vert.starts[y];
+			for(int k = 0; k < fsV; k++)
+			{
+				const int row = start + k;
+				const int slot = row % fsV;
+				short* inter = &ring[(size_t)slot * interLen];
+				if(ringRows[slot] != row)
+				{
+					//rows past the end of a source smaller than the filter have zero weights
+					const int r = row < job.srcHeight ? row : job.srcHeight - 1;
+					const unsigned char* src = job.src + (size_t)r * job.srcPitch;
+					if(!inPlace || (overRead > 0 && r == job.srcHeight - 1))
+					{
+						memcpy(&srcRow[0], src, (size_t)job.srcWidth * c);
+						src = &srcRow[0];
+					}
+					job.horzFunc(src, inter, job.dstWidth, c, job.horz);
+					ringRows[slot] = row;
+				}
+				rowPtrs[k] = inter;
+			}
+			job.vertFunc(&rowPtrs[0], &job.vert.weights[(size_t)y * fsV], fsV, job.dst + (size_t)y * job.dstPitch, job.dstWidth * c);
+		}
+	}
+
+	struct ScaleRowsTask
+	{
+		const ScalePlaneJob* job;
+		int rowBegin;
+		int rowEnd;
+		volatile LONG* pending;
+		HANDLE done;
+	};
+
+	void CALLBACK scaleRowsWork(PTP_CALLBACK_INSTANCE instance, PVOID context)
+	{
+		ScaleRowsTask* task = (ScaleRowsTask*)context;
+		scaleRows(*task->job, task->rowBegin, task->rowEnd);
+		if(0 == InterlockedDecrement(task->pending))
+			SetEvent(task->done);
+	}
+
+	void scalePlane(const unsigned char* src, int srcPitch, int srcWidth, int srcHeight,
+					unsigned char* dst, int dstPitch, int dstWidth, int dstHeight,
+					int channels, SCALE_FILTER filter, int threadCount)
+	{
+		ScalePlaneJob job;
+		job.src = src;
+		job.srcPitch = srcPitch;
+		job.srcWidth = srcWidth;
+		job.srcHeight = srcHeight;
+		job.dst = dst;
+		job.dstPitch = dstPitch;
+		job.dstWidth = dstWidth;
+		job.dstHeight = dstHeight;
+		job.channels = channels;
+		buildFilter(srcWidth, dstWidth, filter, channels == 1 ? 8 : 2, job.horz);
+		buildFilter(srcHeight, dstHeight, filter, 2, job.vert);
+
+		const unsigned int features = getCpuFeatures();
+		job.horzFunc = horzFilter_C;
+		if(features & CPU_FEATURE_SSSE3)
+			job.horzFunc = channels == 1 ? horzFilter1_SSSE3 : horzFilterN_SSSE3;
+		job.vertFunc = vertFilter_C;
+		if(features & CPU_FEATURE_SSE2)
+			job.vertFunc = vertFilter_SSE2;
+		if(features & CPU_FEATURE_AVX2)
+			job.vertFunc = vertFilter_AVX2;
+
+		//every band filters the source rows of its first window again, bands shorter than the window are not worth it
+		int bandCount = threadCount < MAX_THREAD_COUNT ? threadCount : MAX_THREAD_COUNT;
+		if(bandCount > dstHeight / 16)
+			bandCount = dstHeight / 16;
+		HANDLE done = bandCount > 1 ? CreateEvent(NULL, TRUE, FALSE, NULL) : NULL;
+		if(done == NULL)
+		{
+			scaleRows(job, 0, dstHeight);
+			return;
+		}
+		volatile LONG pending = bandCount - 1;
+		ScaleRowsTask tasks[MAX_THREAD_COUNT];
+		for(int i = 0; i < bandCount; i++)
+		{
+			tasks[i].job = &job;
+			tasks[i].rowBegin = (int)((long long)dstHeight * i / bandCount);
+			tasks[i].rowEnd = (int)((long long)dstHeight * (i + 1) / bandCount);
+			tasks[i].pending = &pending;
+			tasks[i].done = done;
+		}
+		for(int i = 1; i < bandCount; i++)
+		{
+			if(!TrySubmitThreadpoolCallback(scaleRowsWork, &tasks[i], NULL))
+				scaleRowsWork(NULL, &tasks[i]);
+		}
+		scaleRows(job, tasks[0].rowBegin, tasks[0].rowEnd);
+		WaitForSingleObject(done, INFINITE);
+		CloseHandle(done);
+	}
+
+	/**
+	 *	@brief	split YUY2 into planar 4:2:2, the chroma planes are (width+1)/2 wide
+	 **/
+	void unpackYUY2(const unsigned char* src, int srcPitch, int width, int height, unsigned char* y, unsigned char* u, unsigned char* v)
+	{
+		const int chromaWidth = (width + 1) >> 1;
+		for(int r = 0; r < height; r++)
+		{
+			const unsigned char* s = src + (size_t)r * srcPitch;
+			unsigned char* py = y + (size_t)r * width;
+			unsigned char* pu = u + (size_t)r * chromaWidth;
+			unsigned char* pv = v + (size_t)r * chromaWidth;
+			for(int i = 0; i < chromaWidth; i++)
+			{
+				py[i * 2] = s[i * 4];
+				if(i * 2 + 1 < width)
+					py[i * 2 + 1] = s[i * 4 + 2];
+				pu[i] = s[i * 4 + 1];
+				pv[i] = s[i * 4 + 3];
+			}
+		}
+	}
+
+	void packYUY2(const unsigned char* y, const unsigned char* u, const unsigned char* v, int width, int height, unsigned char* dst, int dstPitch)
+	{
+		const int chromaWidth = (width + 1) >> 1;
+		for(int r = 0; r < height; r++)
+		{
+			unsigned char* d = dst + (size_t)r * dstPitch;
+			const unsigned char* py = y + (size_t)r * width;
+			const unsigned char* pu = u + (size_t)r * chromaWidth;
+			const unsigned char* pv = v + (size_t)r * chromaWidth;
+			for(int i = 0; i < chromaWidth; i++)
+			{
+				d[i * 4] = py[i * 2];
+				d[i * 4 + 1] = pu[i];
+				d[i * 4 + 2] = i * 2 + 1 < width ? py[i * 2 + 1] : py[i * 2];
+				d[i * 4 + 3] = pv[i];
+			}
+		}
+	}
+}
+
+int zRender::scaleImage(PIXFormat pixfmt,
+						const unsigned char* const srcPlanes[3], const int srcPitches[3], int srcWidth, int srcHeight,
+						unsigned char* const dstPlanes[3], const int dstPitches[3], int dstWidth, int dstHeight,
+						SCALE_FILTER filter, int threadCount)
+{
+	if(!isKnownPixelFormat(pixfmt))
+		return -1;
+	if(srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0
+		|| srcPlanes == NULL || srcPitches == NULL || dstPlanes == NULL || dstPitches == NULL)
+		return -2;
+	if(filter != SCALE_FILTER_BILINEAR && filter != SCALE_FILTER_AREA && filter != SCALE_FILTER_LANCZOS)
+		return -2;
+	const PixelFormatDesc& desc = PixelFormatDescs[pixfmt];
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		if(srcPlanes[i] == NULL || srcPitches[i] < getPlaneRowBytes(desc.planes[i], srcWidth)
+			|| dstPlanes[i] == NULL || dstPitches[i] < getPlaneRowBytes(desc.planes[i], dstWidth))
+			return -3;
+	}
+
+	if(pixfmt == PIXFMT_YUY2)
+	{
+		//Y and the chroma pairs are resized separately, the packed samples cannot share one filter
+		const int srcChromaWidth = (srcWidth + 1) >> 1;
+		const int dstChromaWidth = (dstWidth + 1) >> 1;
+		std::vector<unsigned char> srcBuf((size_t)(srcWidth + srcChromaWidth * 2) * srcHeight);
+		std::vector<unsigned char> dstBuf((size_t)(dstWidth + dstChromaWidth * 2) * dstHeight);
+		unsigned char* sy = &srcBuf[0];
+		unsigned char* su = sy + (size_t)srcWidth * srcHeight;
+		unsigned char* sv = su + (size_t)srcChromaWidth * srcHeight;
+		unsigned char* dy = &dstBuf[0];
+		unsigned char* du = dy + (size_t)dstWidth * dstHeight;
+		unsigned char* dv = du + (size_t)dstChromaWidth * dstHeight;
+		unpackYUY2(srcPlanes[0], srcPitches[0], srcWidth, srcHeight, sy, su, sv);
+		scalePlane(sy, srcWidth, srcWidth, srcHeight, dy, dstWidth, dstWidth, dstHeight, 1, filter, threadCount);
+		scalePlane(su, srcChromaWidth, srcChromaWidth, srcHeight, du, dstChromaWidth, dstChromaWidth, dstHeight, 1, filter, threadCount);
+		scalePlane(sv, srcChromaWidth, srcChromaWidth, srcHeight, dv, dstChromaWidth, dstChromaWidth, dstHeight, 1, filter, threadCount);
+		packYUY2(dy, du, dv, dstWidth, dstHeight, dstPlanes[0], dstPitches[0]);
+		return 0;
+	}
+
+	for(int i = 0; i < desc.planeCount; i++)
+	{
+		const PlaneFormatDesc& plane = desc.planes[i];
+		const int channels = plane.blockBytes;
+		scalePlane(srcPlanes[i], srcPitches[i], getPlaneRowBytes(plane, srcWidth) / channels, getPlaneRows(plane, srcHeight),
+				   dstPlanes[i], dstPitches[i], getPlaneRowBytes(plane, dstWidth) / channels, getPlaneRows(plane, dstHeight),
+				   channels, filter, threadCount);
+	}
+	return 0;
+}
+
+int zRender::scaleImage(PIXFormat pixfmt,
+						const unsigned char* src, int srcWidth, int srcHeight,
+						unsigned char* dst, int dstWidth, int dstHeight,
+						SCALE_FILTER filter, int threadCount)
+{
+	if(src == NULL || dst == NULL)
+		return -2;
+	FrameLayout srcLayout = FrameLayout::create(pixfmt, srcWidth, srcHeight);
+	FrameLayout dstLayout = FrameLayout::create(pixfmt, dstWidth, dstHeight);
+	if(!srcLayout.valid() || !dstLayout.valid())
+		return -1;
+	const unsigned char* srcPlanes[3];
+	unsigned char* dstPlanes[3];
+	srcLayout.getPlanes(src, srcPlanes);
+	dstLayout.getPlanes(dst, dstPlanes);
+	return scaleImage(pixfmt, srcPlanes, srcLayout.pitches(), srcWidth, srcHeight,
+					  dstPlanes, dstLayout.pitches(), dstWidth, dstHeight, filter, threadCount);
+}
@@ -0,0 +1,877 @@
+#include "inc/PixelFormatConverter.h"
+#include "inc/CpuFeatures.h"
+#include "inc/YUVToRGBConverter.h"
+#include "inc/FrameLayout.h"
+#include "inc/PlaneCopy.h"
+#include <Windows.h>
+#include <string.h>
+#include <vector>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+
+using namespace zRender;
+
+namespace
+{
+	/**
+	 *	@brief	byte offsets of the channels of a packed RGB format, alpha is -1 when the format has no alpha byte
+	 **/
+	struct PackedRGBDesc
+	{
+		int bpp;
+		int r;
+		int g;
+		int b;
+		int a;
+		bool alphaValid;	//false for the X formats, the 4th byte is padding
+	};
+
+	bool getPackedRGBDesc(PIXFormat fmt, PackedRGBDesc& desc)
+	{
+		switch(fmt)
+		{
+		case PIXFMT_R8G8B8:
+			desc.bpp = 3; desc.r = 2; desc.g = 1; desc.b = 0; desc.a = -1; desc.alphaValid = false;
+			return true;
+		case PIXFMT_A8R8G8B8:
+		case PIXFMT_R8G8B8A8:
+			desc.bpp = 4; desc.r = 0; desc.g = 1; desc.b = 2; desc.a = 3; desc.alphaValid = true;
+			return true;
+		case PIXFMT_B8G8R8A8:
+			desc.bpp = 4; desc.r = 2; desc.g = 1; desc.b = 0; desc.a = 3; desc.alphaValid = true;
+			return true;
+		case PIXFMT_B8G8R8X8:
+		case PIXFMT_X8R8G8B8:
+			desc.bpp = 4; desc.r = 2; desc.g = 1; desc.b = 0; desc.a = 3; desc.alphaValid = false;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool isYUVFormat(PIXFormat fmt)
+	{
+		return fmt == PIXFMT_YUV420P || fmt == PIXFMT_YV12 || fmt == PIXFMT_NV12 || fmt == PIXFMT_YUY2;
+	}
+
+	bool isYUV420Format(PIXFormat fmt)
+	{
+		return fmt == PIXFMT_YUV420P || fmt == PIXFMT_YV12 || fmt == PIXFMT_NV12;
+	}
+
+	/**
+	 *	@brief	shuffle of 4 pixels (16 bytes at most) from one packed RGB format to another.
+	 *			idx[i] is the source byte of destination byte i, 0x80 means the byte is taken from orMask
+	 **/
+	struct ShuffleDesc
+	{
+		unsigned char idx[16];
+		unsigned char orMask[16];
+	};
+
+	void buildShuffleDesc(const PackedRGBDesc& src, const PackedRGBDesc& dst, ShuffleDesc& shuf)
+	{
+		memset(shuf.idx, 0x80, sizeof(shuf.idx));
+		memset(shuf.orMask, 0, sizeof(shuf.orMask));
+		for(int px = 0; px < 4; px++)
+		{
+			const int s = px * src.bpp;
+			const int d = px * dst.bpp;
+			shuf.idx[d + dst.r] = (unsigned char)(s + src.r);
+			shuf.idx[d + dst.g] = (unsigned char)(s + src.g);
+			shuf.idx[d + dst.b] = (unsigned char)(s + src.b);
+			if(dst.a >= 0)
+			{
+				if(src.alphaValid)
+					shuf.idx[d + dst.a] = (unsigned char)(s + src.a);
+				else
+					shuf.orMask[d + dst.a] = 0xff;
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// scalar kernels, also used for the tail of the SIMD kernels
+	//----------------------------------------------------------------------------------------------
+	void shuffleRow_C(const unsigned char* src, int srcBpp, unsigned char* dst, int dstBpp, int width, const ShuffleDesc& shuf)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			for(int i = 0; i < dstBpp; i++)
+			{
+				const unsigned char si = shuf.idx[i];
+				dst[i] = (si & 0x80) ? shuf.orMask[i] : (unsigned char)(src[si] | shuf.orMask[i]);
+			}
+			src += srcBpp;
+			dst += dstBpp;
+		}
+	}
+
+	void shuffle4to4_C(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		shuffleRow_C(src, 4, dst, 4, width, shuf);
+	}
+
+	void shuffle3to4_C(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		shuffleRow_C(src, 3, dst, 4, width, shuf);
+	}
+
+	void shuffle4to3_C(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		shuffleRow_C(src, 4, dst, 3, width, shuf);
+	}
+
+	void interleaveUV_C(const unsigned char* u, const unsigned char* v, unsigned char* uv, int count)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			uv[2 * i] = u[i];
+			uv[2 * i + 1] = v[i];
+		}
+	}
+
+	void deinterleaveUV_C(const unsigned char* uv, unsigned char* u, unsigned char* v, int count)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			u[i] = uv[2 * i];
+			v[i] = uv[2 * i + 1];
+		}
+	}
+
+	void yuy2ToPlanar_C(const unsigned char* src, unsigned char* y, unsigned char* u, unsigned char* v, int width)
+	{
+		const int pairs = width >> 1;
+		for(int i = 0; i < pairs; i++)
+		{
+			y[2 * i] = src[4 * i];
+			u[i] = src[4 * i + 1];
+			y[2 * i + 1] = src[4 * i + 2];
+			v[i] = src[4 * i + 3];
+		}
+		if(width & 1)
+		{
+			y[width - 1] = src[4 * pairs];
+			u[pairs] = src[4 * pairs + 1];
+			v[pairs] = src[4 * pairs + 3];
+		}
+	}
+
+	void planarToYuy2_C(const unsigned char* y, const unsigned char* u, const unsigned char* v, unsigned char* dst, int width)
+	{
+		const int pairs = width >> 1;
+		for(int i = 0; i < pairs; i++)
+		{
+			dst[4 * i] = y[2 * i];
+			dst[4 * i + 1] = u[i];
+			dst[4 * i + 2] = y[2 * i + 1];
+			dst[4 * i + 3] = v[i];
+		}
+		if(width & 1)
+		{
+			dst[4 * pairs] = y[width - 1];
+			dst[4 * pairs + 1] = u[pairs];
+			dst[4 * pairs + 2] = y[width - 1];
+			dst[4 * pairs + 3] = v[pairs];
+		}
+	}
+
+	void averageRow_C(const unsigned char* a, const unsigned char* b, unsigned char* dst, int count)
+	{
+		for(int i = 0; i < count; i++)
+			dst[i] = (unsigned char)((a[i] + b[i] + 1) >> 1);
+	}
+
+	void bgraToYUVRow_C(const unsigned char* bgra, unsigned char* y, unsigned char* u, unsigned char* v, int width)
+	{
+		for(int x = 0; x < width; x += 2)
+		{
+			const unsigned char* p0 = bgra + 4 * x;
+			const unsigned char* p1 = (x + 1 < width) ? p0 + 4 : p0;
+			y[x] = (unsigned char)(((66 * p0[2] + 129 * p0[1] + 25 * p0[0] + 128) >> 8) + 16);
+			if(x + 1 < width)
+				y[x + 1] = (unsigned char)(((66 * p1[2] + 129 * p1[1] + 25 * p1[0] + 128) >> 8) + 16);
+			const int r = p0[2] + p1[2];
+			const int g = p0[1] + p1[1];
+			const int b = p0[0] + p1[0];
+			u[x >> 1] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 256) >> 9) + 128);
+			v[x >> 1] = (unsigned char)(((112 * r - 94 * g - 18 * b + 256) >> 9) + 128);
+		}
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// SSE2 kernels
+	//----------------------------------------------------------------------------------------------
+	void shuffle4to4_SSE2(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		//every destination byte of a pixel is (src >> 8*s) & 0xff << 8*i, SSE2 has no byte shuffle
+		__m128i shiftR[4], shiftL[4], keep[4];
+		const __m128i byteMask = _mm_set1_epi32(0xff);
+		for(int i = 0; i < 4; i++)
+		{
+			const int s = (shuf.idx[i] & 0x80) ? 0 : shuf.idx[i];
+			shiftR[i] = _mm_cvtsi32_si128(8 * s);
+			shiftL[i] = _mm_cvtsi32_si128(8 * i);
+			keep[i] = (shuf.idx[i] & 0x80) ? _mm_setzero_si128() : byteMask;
+		}
+		const __m128i orMask = _mm_loadu_si128((const __m128i*)shuf.orMask);
+		int x = 0;
+		for(; x + 4 <= width; x += 4)
+		{
+			const __m128i p = _mm_loadu_si128((const __m128i*)(src + 4 * x));
+			__m128i out = orMask;
+			for(int i = 0; i < 4; i++)
+			{
+				__m128i t = _mm_and_si128(_mm_srl_epi32(p, shiftR[i]), keep[i]);
+				out = _mm_or_si128(out, _mm_sll_epi32(t, shiftL[i]));
+			}
+			_mm_storeu_si128((__m128i*)(dst + 4 * x), out);
+		}
+		shuffle4to4_C(src + 4 * x, dst + 4 * x, width - x, shuf);
+	}
+
+	void interleaveUV_SSE2(const unsigned char* u, const unsigned char* v, unsigned char* uv, int count)
+	{
+		int i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m128i mu = _mm_loadu_si128((const __m128i*)(u + i));
+			const __m128i mv = _mm_loadu_si128((const __m128i*)(v + i));
+			_mm_storeu_si128((__m128i*)(uv + 2 * i), _mm_unpacklo_epi8(mu, mv));
+			_mm_storeu_si128((__m128i*)(uv + 2 * i + 16), _mm_unpackhi_epi8(mu, mv));
+		}
+		interleaveUV_C(u + i, v + i, uv + 2 * i, count - i);
+	}
+
+	void deinterleaveUV_SSE2(const unsigned char* uv, unsigned char* u, unsigned char* v, int count)
+	{
+		const __m128i lowMask = _mm_set1_epi16(0x00ff);
+		int i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(uv + 2 * i));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(uv + 2 * i + 16));
+			_mm_storeu_si128((__m128i*)(u + i), _mm_packus_epi16(_mm_and_si128(a, lowMask), _mm_and_si128(b, lowMask)));
+			_mm_storeu_si128((__m128i*)(v + i), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+		}
+		deinterleaveUV_C(uv + 2 * i, u + i, v + i, count - i);
+	}
+
+	void yuy2ToPlanar_SSE2(const unsigned char* src, unsigned char* y, unsigned char* u, unsigned char* v, int width)
+	{
+		const __m128i lowMask = _mm_set1_epi16(0x00ff);
+		int x = 0;
+		for(; x + 32 <= width; x += 32)
+		{
+			const unsigned char* p = src + 2 * x;
+			const __m128i a = _mm_loadu_si128((const __m128i*)p);
+			const __m128i b = _mm_loadu_si128((const __m128i*)(p + 16));
+			const __m128i c = _mm_loadu_si128((const __m128i*)(p + 32));
+			const __m128i d = _mm_loadu_si128((const __m128i*)(p + 48));
+			_mm_storeu_si128((__m128i*)(y + x), _mm_packus_epi16(_mm_and_si128(a, lowMask), _mm_and_si128(b, lowMask)));
+			_mm_storeu_si128((__m128i*)(y + x + 16), _mm_packus_epi16(_mm_and_si128(c, lowMask), _mm_and_si128(d, lowMask)));
+			const __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+			const __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_srli_epi16(d, 8));
+			_mm_storeu_si128((__m128i*)(u + (x >> 1)), _mm_packus_epi16(_mm_and_si128(uv0, lowMask), _mm_and_si128(uv1, lowMask)));
+			_mm_storeu_si128((__m128i*)(v + (x >> 1)), _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8)));
+		}
+		yuy2ToPlanar_C(src + 2 * x, y + x, u + (x >> 1), v + (x >> 1), width - x);
+	}
+
+	void planarToYuy2_SSE2(const unsigned char* y, const unsigned char* u, const unsigned char* v, unsigned char* dst, int width)
+	{
+		int x = 0;
+		for(; x + 32 <= width; x += 32)
+		{
+			const __m128i y0 = _mm_loadu_si128((const __m128i*)(y + x));
+			const __m128i y1 = _mm_loadu_si128((const __m128i*)(y + x + 16));
+			const __m128i mu = _mm_loadu_si128((const __m128i*)(u + (x >> 1)));
+			const __m128i mv = _mm_loadu_si128((const __m128i*)(v + (x >> 1)));
+			const __m128i uv0 = _mm_unpacklo_epi8(mu, mv);
+			const __m128i uv1 = _mm_unpackhi_epi8(mu, mv);
+			unsigned char* p = dst + 2 * x;
+			_mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi8(y0, uv0));
+			_mm_storeu_si128((__m128i*)(p + 16), _mm_unpackhi_epi8(y0, uv0));
+			_mm_storeu_si128((__m128i*)(p + 32), _mm_unpacklo_epi8(y1, uv1));
+			_mm_storeu_si128((__m128i*)(p + 48), _mm_unpackhi_epi8(y1, uv1));
+		}
+		planarToYuy2_C(y + x, u + (x >> 1), v + (x >> 1), dst + 2 * x, width - x);
+	}
+
+	void averageRow_SSE2(const unsigned char* a, const unsigned char* b, unsigned char* dst, int count)
+	{
+		int i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m128i ma = _mm_loadu_si128((const __m128i*)(a + i));
+			const __m128i mb = _mm_loadu_si128((const __m128i*)(b + i));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_avg_epu8(ma, mb));
+		}
+		averageRow_C(a + i, b + i, dst + i, count - i);
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// SSSE3 kernels
+	//----------------------------------------------------------------------------------------------
+	ZRENDER_TARGET_SSSE3 void shuffle4to4_SSSE3(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		const __m128i idx = _mm_loadu_si128((const __m128i*)shuf.idx);
+		const __m128i orMask = _mm_loadu_si128((const __m128i*)shuf.orMask);
+		int x = 0;
+		for(; x + 4 <= width; x += 4)
+		{
+			const __m128i p = _mm_loadu_si128((const __m128i*)(src + 4 * x));
+			_mm_storeu_si128((__m128i*)(dst + 4 * x), _mm_or_si128(_mm_shuffle_epi8(p, idx), orMask));
+		}
+		shuffle4to4_C(src + 4 * x, dst + 4 * x, width - x, shuf);
+	}
+
+	ZRENDER_TARGET_SSSE3 void shuffle3to4_SSSE3(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		const __m128i idx = _mm_loadu_si128((const __m128i*)shuf.idx);
+		const __m128i orMask = _mm_loadu_si128((const __m128i*)shuf.orMask);
+		int x = 0;
+		for(; x + 16 <= width; x += 16)
+		{
+			const unsigned char* s = src + 3 * x;
+			const __m128i s0 = _mm_loadu_si128((const __m128i*)s);
+			const __m128i s1 = _mm_loadu_si128((const __m128i*)(s + 16));
+			const __m128i s2 = _mm_loadu_si128((const __m128i*)(s + 32));
+			const __m128i p0 = s0;
+			const __m128i p1 = _mm_alignr_epi8(s1, s0, 12);
+			const __m128i p2 = _mm_alignr_epi8(s2, s1, 8);
+			const __m128i p3 = _mm_srli_si128(s2, 4);
+			unsigned char* d = dst + 4 * x;
+			_mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_shuffle_epi8(p0, idx), orMask));
+			_mm_storeu_si128((__m128i*)(d + 16), _mm_or_si128(_mm_shuffle_epi8(p1, idx), orMask));
+			_mm_storeu_si128((__m128i*)(d + 32), _mm_or_si128(_mm_shuffle_epi8(p2, idx), orMask));
+			_mm_storeu_si128((__m128i*)(d + 48), _mm_or_si128(_mm_shuffle_epi8(p3, idx), orMask));
+		}
+		shuffle3to4_C(src + 3 * x, dst + 4 * x, width - x, shuf);
+	}
+
+	ZRENDER_TARGET_SSSE3 void shuffle4to3_SSSE3(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		const __m128i idx = _mm_loadu_si128((const __m128i*)shuf.idx);
+		int x = 0;
+		for(; x + 16 <= width; x += 16)
+		{
+			const unsigned char* s = src + 4 * x;
+			const __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s), idx);
+			const __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s + 16)), idx);
+			const __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s + 32)), idx);
+			const __m128i e = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s + 48)), idx);
+			unsigned char* d = dst + 3 * x;
+			_mm_storeu_si128((__m128i*)d, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+			_mm_storeu_si128((__m128i*)(d + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+			_mm_storeu_si128((__m128i*)(d + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(e, 4)));
+		}
+		shuffle4to3_C(src + 4 * x, dst + 3 * x, width - x, shuf);
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// AVX2 kernels
+	//----------------------------------------------------------------------------------------------
+	ZRENDER_TARGET_AVX2 void shuffle4to4_AVX2(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		const __m128i idx128 = _mm_loadu_si128((const __m128i*)shuf.idx);
+		const __m128i or128 = _mm_loadu_si128((const __m128i*)shuf.orMask);
+		const __m256i idx = _mm256_broadcastsi128_si256(idx128);
+		const __m256i orMask = _mm256_broadcastsi128_si256(or128);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m256i p = _mm256_loadu_si256((const __m256i*)(src + 4 * x));
+			_mm256_storeu_si256((__m256i*)(dst + 4 * x), _mm256_or_si256(_mm256_shuffle_epi8(p, idx), orMask));
+		}
+		shuffle4to4_SSSE3(src + 4 * x, dst + 4 * x, width - x, shuf);
+	}
+
+	ZRENDER_TARGET_AVX2 void shuffle3to4_AVX2(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		const __m256i idx = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)shuf.idx));
+		const __m256i orMask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)shuf.orMask));
+		int x = 0;
+		//every lane loads 16 bytes for 4 pixels (12 bytes), keep 2 pixels of slack to stay inside the row
+		for(; x + 10 <= width; x += 8)
+		{
+			const unsigned char* s = src + 3 * x;
+			const __m256i p = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)s)),
+													  _mm_loadu_si128((const __m128i*)(s + 12)), 1);
+			_mm256_storeu_si256((__m256i*)(dst + 4 * x), _mm256_or_si256(_mm256_shuffle_epi8(p, idx), orMask));
+		}
+		shuffle3to4_SSSE3(src + 3 * x, dst + 4 * x, width - x, shuf);
+	}
+
+	ZRENDER_TARGET_AVX2 void shuffle4to3_AVX2(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf)
+	{
+		const __m256i idx = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)shuf.idx));
+		int x = 0;
+		//every lane stores 16 bytes for 4 pixels (12 bytes), keep 2 pixels of slack to stay inside the row
+		for(; x + 10 <= width; x += 8)
+		{
+			const __m256i p = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + 4 * x)), idx);
+			unsigned char* d = dst + 3 * x;
+			_mm_storeu_si128((__m128i*)d, _mm256_castsi256_si128(p));
+			_mm_storeu_si128((__m128i*)(d + 12), _mm256_extracti128_si256(p, 1));
+		}
+		shuffle4to3_SSSE3(src + 4 * x, dst + 3 * x, width - x, shuf);
+	}
+
+	ZRENDER_TARGET_AVX2 void interleaveUV_AVX2(const unsigned char* u, const unsigned char* v, unsigned char* uv, int count)
+	{
+		int i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			//unpack works inside the 128 bit lanes, reorder the quad words first
+			const __m256i mu = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i*)(u + i)), 0xD8);
+			const __m256i mv = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i*)(v + i)), 0xD8);
+			_mm256_storeu_si256((__m256i*)(uv + 2 * i), _mm256_unpacklo_epi8(mu, mv));
+			_mm256_storeu_si256((__m256i*)(uv + 2 * i + 32), _mm256_unpackhi_epi8(mu, mv));
+		}
+		interleaveUV_SSE2(u + i, v + i, uv + 2 * i, count - i);
+	}
+
+	ZRENDER_TARGET_AVX2 void deinterleaveUV_AVX2(const unsigned char* uv, unsigned char* u, unsigned char* v, int count)
+	{
+		const __m256i lowMask = _mm256_set1_epi16(0x00ff);
+		int i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			const __m256i a = _mm256_loadu_si256((const __m256i*)(uv + 2 * i));
+			const __m256i b = _mm256_loadu_si256((const __m256i*)(uv + 2 * i + 32));
+			const __m256i mu = _mm256_packus_epi16(_mm256_and_si256(a, lowMask), _mm256_and_si256(b, lowMask));
+			const __m256i mv = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+			_mm256_storeu_si256((__m256i*)(u + i), _mm256_permute4x64_epi64(mu, 0xD8));
+			_mm256_storeu_si256((__m256i*)(v + i), _mm256_permute4x64_epi64(mv, 0xD8));
+		}
+		deinterleaveUV_SSE2(uv + 2 * i, u + i, v + i, count - i);
+	}
+
+	ZRENDER_TARGET_AVX2 void averageRow_AVX2(const unsigned char* a, const unsigned char* b, unsigned char* dst, int count)
+	{
+		int i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			const __m256i ma = _mm256_loadu_si256((const __m256i*)(a + i));
+			const __m256i mb = _mm256_loadu_si256((const __m256i*)(b + i));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_avg_epu8(ma, mb));
+		}
+		averageRow_SSE2(a + i, b + i, dst + i, count - i);
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// runtime dispatch
+	//----------------------------------------------------------------------------------------------
+	typedef void (*ShuffleRowFunc)(const unsigned char* src, unsigned char* dst, int width, const ShuffleDesc& shuf);
+	typedef void (*InterleaveFunc)(const unsigned char* u, const unsigned char* v, unsigned char* uv, int count);
+	typedef void (*DeinterleaveFunc)(const unsigned char* uv, unsigned char* u, unsigned char* v, int count);
+	typedef void (*Yuy2ToPlanarFunc)(const unsigned char* src, unsigned char* y, unsigned char* u, unsigned char* v, int width);
+	typedef void (*PlanarToYuy2Func)(const unsigned char* y, const unsigned char* u, const unsigned char* v, unsigned char* dst, int width);
+	typedef void (*AverageRowFunc)(const unsigned char* a, const unsigned char* b, unsigned char* dst, int count);
+	typedef void (*BGRAToYUVRowFunc)(const unsigned char* bgra, unsigned char* y, unsigned char* u, unsigned char* v, int width);
+
+	struct ConvertKernels
+	{
+		ShuffleRowFunc shuffle4to4;
+		ShuffleRowFunc shuffle3to4;
+		ShuffleRowFunc shuffle4to3;
+		InterleaveFunc interleaveUV;
+		DeinterleaveFunc deinterleaveUV;
+		Yuy2ToPlanarFunc yuy2ToPlanar;
+		PlanarToYuy2Func planarToYuy2;
+		AverageRowFunc averageRow;
+		BGRAToYUVRowFunc bgraToYUVRow;
+	};
+
+	void selectKernels(ConvertKernels& k, unsigned int features)
+	{
+		k.shuffle4to4 = shuffle4to4_C;
+		k.shuffle3to4 = shuffle3to4_C;
+		k.shuffle4to3 = shuffle4to3_C;
+		k.interleaveUV = interleaveUV_C;
+		k.deinterleaveUV = deinterleaveUV_C;
+		k.yuy2ToPlanar = yuy2ToPlanar_C;
+		k.planarToYuy2 = planarToYuy2_C;
+		k.averageRow = averageRow_C;
+		k.bgraToYUVRow = bgraToYUVRow_C;
+		if(features & CPU_FEATURE_SSE2)
+		{
+			k.shuffle4to4 = shuffle4to4_SSE2;
+			k.interleaveUV = interleaveUV_SSE2;
+			k.deinterleaveUV = deinterleaveUV_SSE2;
+			k.yuy2ToPlanar = yuy2ToPlanar_SSE2;
+			k.planarToYuy2 = planarToYuy2_SSE2;
+			k.averageRow = averageRow_SSE2;
+		}
+		if(features & CPU_FEATURE_SSSE3)
+		{
+			k.shuffle4to4 = shuffle4to4_SSSE3;
+			k.shuffle3to4 = shuffle3to4_SSSE3;
+			k.shuffle4to3 = shuffle4to3_SSSE3;
+		}
+		if(features & CPU_FEATURE_AVX2)
+		{
+			k.shuffle4to4 = shuffle4to4_AVX2;
+			k.shuffle3to4 = shuffle3to4_AVX2;
+			k.shuffle4to3 = shuffle4to3_AVX2;
+			k.interleaveUV = interleaveUV_AVX2;
+			k.deinterleaveUV = deinterleaveUV_AVX2;
+			k.averageRow = averageRow_AVX2;
+		}
+	}
+
+	//one table per feature mask, never written once published: setCpuFeaturesMask() switches tables under the readers
+	enum { KERNEL_TABLE_COUNT = 0x20 };
+	ConvertKernels* volatile s_kernelTables[KERNEL_TABLE_COUNT];
+
+	const ConvertKernels& getKernels()
+	{
+		const unsigned int features = getCpuFeatures() & (KERNEL_TABLE_COUNT - 1);
+		ConvertKernels* table = s_kernelTables[features];
+		if(table)
+			return *table;
+		ConvertKernels* selected = new ConvertKernels;
+		selectKernels(*selected, features);
+		table = (ConvertKernels*)InterlockedCompareExchangePointer((PVOID volatile*)&s_kernelTables[features], selected, NULL);
+		if(NULL == table)
+			return *selected;
+		//another thread published the table first
+		delete selected;
+		return *table;
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// packed RGB <--> packed RGB
+	//----------------------------------------------------------------------------------------------
+	void convertPackedRow(const ConvertKernels& k, const PackedRGBDesc& srcDesc, const PackedRGBDesc& dstDesc,
+						  const ShuffleDesc& shuf, const unsigned char* src, unsigned char* dst, int width)
+	{
+		if(srcDesc.bpp == 4 && dstDesc.bpp == 4)
+			k.shuffle4to4(src, dst, width, shuf);
+		else if(srcDesc.bpp == 3 && dstDesc.bpp == 4)
+			k.shuffle3to4(src, dst, width, shuf);
+		else if(srcDesc.bpp == 4 && dstDesc.bpp == 3)
+			k.shuffle4to3(src, dst, width, shuf);
+		else
+			memcpy(dst, src, width * 3);
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// everything that has a YUV side goes through rows of planar 4:2:2 (Y, U, V with half width chroma)
+	//----------------------------------------------------------------------------------------------
+	struct YUVRow
+	{
+		const unsigned char* y;
+		const unsigned char* u;
+		const unsigned char* v;
+	};
+
+	class YUVRowReader
+	{
+	public:
+		YUVRowReader(const ConvertKernels& k, PIXFormat fmt, const unsigned char* const planes[3], const int pitches[3], int width)
+			: m_k(k), m_fmt(fmt), m_width(width), m_chromaWidth((width + 1) >> 1), m_cachedChromaRow(-1)
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				m_planes[i] = planes[i];
+				m_pitches[i] = pitches[i];
+			}
+			PackedRGBDesc bgra;
+			getPackedRGBDesc(PIXFMT_B8G8R8A8, bgra);
+			if(getPackedRGBDesc(fmt, m_rgbDesc))
+				buildShuffleDesc(m_rgbDesc, bgra, m_toBGRA);
+			for(int slot = 0; slot < 2; slot++)
+				m_slotBuffer[slot].resize(m_width * 5 + m_chromaWidth * 2);
+			m_chromaBuffer.resize(m_chromaWidth * 2);
+		}
+
+		/**
+		 *	@brief	read row r of the image, slot (0 or 1) selects the temporary buffer so two rows can be alive at once
+		 **/
+		YUVRow read(int r, int slot)
+		{
+			YUVRow row;
+			unsigned char* tmp = &m_slotBuffer[slot][0];
+			switch(m_fmt)
+			{
+			case PIXFMT_YUV420P:
+			case PIXFMT_YV12:
+				{
+					const int ui = (m_fmt == PIXFMT_YUV420P) ? 1 : 2;
+					const int vi = 3 - ui;
+					row.y = m_planes[0] + r * m_pitches[0];
+					row.u = m_planes[ui] + (r >> 1) * m_pitches[ui];
+					row.v = m_planes[vi] + (r >> 1) * m_pitches[vi];
+				}
+				break;
+			case PIXFMT_NV12:
+				if(m_cachedChromaRow != (r >> 1))
+				{
+					m_cachedChromaRow = r >> 1;
+					m_k.deinterleaveUV(m_planes[1] + m_cachedChromaRow * m_pitches[1],
+									   &m_chromaBuffer[0], &m_chromaBuffer[m_chromaWidth], m_chromaWidth);
+				}
+				row.y = m_planes[0] + r * m_pitches[0];
+				row.u = &m_chromaBuffer[0];
+				row.v = &m_chromaBuffer[m_chromaWidth];
+				break;
+			case PIXFMT_YUY2:
+				m_k.yuy2ToPlanar(m_planes[0] + r * m_pitches[0], tmp, tmp + m_width, tmp + m_width + m_chromaWidth, m_width);
+				row.y = tmp;
+				row.u = tmp + m_width;
+				row.v = tmp + m_width + m_chromaWidth;
+				break;
+			default:
+				{
+					//packed RGB, Y-U-V are stored after the BGRA row in the slot buffer
+					const unsigned char* src = m_planes[0] + r * m_pitches[0];
+					unsigned char* yuv = tmp + m_width * 4;
+					if(m_rgbDesc.bpp == 4 && m_rgbDesc.b == 0 && m_rgbDesc.g == 1 && m_rgbDesc.r == 2)
+					{
+						m_k.bgraToYUVRow(src, yuv, yuv + m_width, yuv + m_width + m_chromaWidth, m_width);
+					}
+					else
+					{
+						if(m_rgbDesc.bpp == 3)
+							m_k.shuffle3to4(src, tmp, m_width, m_toBGRA);
+						else
+							m_k.shuffle4to4(src, tmp, m_width, m_toBGRA);
+						m_k.bgraToYUVRow(tmp, yuv, yuv + m_width, yuv + m_width + m_chromaWidth, m_width);
+					}
+					row.y = yuv;
+					row.u = yuv + m_width;
+					row.v = yuv + m_width + m_chromaWidth;
+				}
+				break;
+			}
+			return row;
+		}
+
+	private:
+		const ConvertKernels& m_k;
+		PIXFormat m_fmt;
+		const unsigned char* m_planes[3];
+		int m_pitches[3];
+		int m_width;
+		int m_chromaWidth;
+		int m_cachedChromaRow;
+		PackedRGBDesc m_rgbDesc;
+		ShuffleDesc m_toBGRA;
+		std::vector<unsigned char> m_slotBuffer[2];
+		std::vector<unsigned char> m_chromaBuffer;
+	};
+
+	class YUVRowWriter
+	{
+	public:
+		YUVRowWriter(const ConvertKernels& k, PIXFormat fmt, unsigned char* const planes[3], const int pitches[3], int width)
+			: m_k(k), m_fmt(fmt), m_width(width), m_chromaWidth((width + 1) >> 1)
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				m_planes[i] = planes[i];
+				m_pitches[i] = pitches[i];
+			}
+			PackedRGBDesc bgra;
+			getPackedRGBDesc(PIXFMT_B8G8R8A8, bgra);
+			if(getPackedRGBDesc(fmt, m_rgbDesc))
+				buildShuffleDesc(bgra, m_rgbDesc, m_fromBGRA);
+			m_buffer.resize(m_width * 4 + m_chromaWidth * 2);
+		}
+
+		/**
+		 *	@brief	4:2:0 destinations consume two rows at once
+		 **/
+		int rowsPerStep() const
+		{
+			return isYUV420Format(m_fmt) ? 2 : 1;
+		}
+
+		void write(int r, const YUVRow* rows, int count)
+		{
+			switch(m_fmt)
+			{
+			case PIXFMT_YUV420P:
+			case PIXFMT_YV12:
+				{
+					const int ui = (m_fmt == PIXFMT_YUV420P) ? 1 : 2;
+					const int vi = 3 - ui;
+					writeLuma(r, rows, count);
+					writeChroma(rows, count, m_planes[ui] + (r >> 1) * m_pitches[ui], true);
+					writeChroma(rows, count, m_planes[vi] + (r >> 1) * m_pitches[vi], false);
+				}
+				break;
+			case PIXFMT_NV12:
+				{
+					writeLuma(r, rows, count);
+					unsigned char* u = &m_buffer[0];
+					unsigned char* v = u + m_chromaWidth;
+					writeChroma(rows, count, u, true);
+					writeChroma(rows, count, v, false);
+					m_k.interleaveUV(u, v, m_planes[1] + (r >> 1) * m_pitches[1], m_chromaWidth);
+				}
+				break;
+			case PIXFMT_YUY2:
+				m_k.planarToYuy2(rows[0].y, rows[0].u, rows[0].v, m_planes[0] + r * m_pitches[0], m_width);
+				break;
+			default:
+				{
+					unsigned char* dst = m_planes[0] + r * m_pitches[0];
+					if(m_rgbDesc.bpp == 4 && m_rgbDesc.b == 0 && m_rgbDesc.g == 1 && m_rgbDesc.r == 2)
+					{
+						convertYUVRowToBGRA(rows[0].y, rows[0].u, rows[0].v, dst, m_width, YUV_MATRIX_BT601_LIMITED);
+					}
+					else
+					{
+						unsigned char* bgra = &m_buffer[0];
+						convertYUVRowToBGRA(rows[0].y, rows[0].u, rows[0].v, bgra, m_width, YUV_MATRIX_BT601_LIMITED);
+						if(m_rgbDesc.bpp == 3)
+							m_k.shuffle4to3(bgra, dst, m_width, m_fromBGRA);
+						else
+							m_k.shuffle4to4(bgra, dst, m_width, m_fromBGRA);
+					}
+				}
+				break;
+			}
+		}
+
+	private:
+		void writeLuma(int r, const YUVRow* rows, int count)
+		{
+			for(int i = 0; i < count; i++)
+				memcpy(m_planes[0] + (r + i) * m_pitches[0], rows[i].y, m_width);
+		}
+
+		void writeChroma(const YUVRow* rows, int count, unsigned char* dst, bool isU)
+		{
+			const unsigned char* c0 = isU ? rows[0].u : rows[0].v;
+			const unsigned char* c1 = (count > 1) ? (isU ? rows[1].u : rows[1].v) : c0;
+			if(c0 == c1)
+				memcpy(dst, c0, m_chromaWidth);
+			else
+				m_k.averageRow(c0, c1, dst, m_chromaWidth);
+		}
+
+	private:
+		const ConvertKernels& m_k;
+		PIXFormat m_fmt;
+		unsigned char* m_planes[3];
+		int m_pitches[3];
+		int m_width;
+		int m_chromaWidth;
+		PackedRGBDesc m_rgbDesc;
+		ShuffleDesc m_fromBGRA;
+		std::vector<unsigned char> m_buffer;
+	};
+}
+
+bool zRender::isPixelFormatConvertSupported(PIXFormat srcFmt, PIXFormat dstFmt)
+{
+	PackedRGBDesc desc;
+	const bool srcKnown = isYUVFormat(srcFmt) || getPackedRGBDesc(srcFmt, desc);
+	const bool dstKnown = isYUVFormat(dstFmt) || getPackedRGBDesc(dstFmt, desc);
+	return srcKnown && dstKnown;
+}
+
+int zRender::convertPixelFormat(PIXFormat srcFmt, const unsigned char* const srcPlanes[3], const int srcPitches[3],
+								PIXFormat dstFmt, unsigned char* const dstPlanes[3], const int dstPitches[3],
+								int width, int height)
+{
+	if(!isPixelFormatConvertSupported(srcFmt, dstFmt))
+		return -1;
+	if(width <= 0 || height <= 0 || srcPlanes == NULL || srcPitches == NULL || dstPlanes == NULL || dstPitches == NULL)
+		return -2;
+	const PixelFormatDesc& srcPixDesc = PixelFormatDescs[srcFmt];
+	const PixelFormatDesc& dstPixDesc = PixelFormatDescs[dstFmt];
+	for(int i = 0; i < srcPixDesc.planeCount; i++)
+	{
+		if(srcPlanes[i] == NULL || srcPitches[i] < getPlaneRowBytes(srcPixDesc.planes[i], width))
+			return -3;
+	}
+	for(int i = 0; i < dstPixDesc.planeCount; i++)
+	{
+		if(dstPlanes[i] == NULL || dstPitches[i] < getPlaneRowBytes(dstPixDesc.planes[i], width))
+			return -3;
+	}
+
+	const ConvertKernels& k = getKernels();
+
+	if(srcFmt == dstFmt)
+	{
+		for(int i = 0; i < srcPixDesc.planeCount; i++)
+		{
+			copyPlane(srcPlanes[i], srcPitches[i], dstPlanes[i], dstPitches[i],
+					  getPlaneRowBytes(srcPixDesc.planes[i], width), getPlaneRows(srcPixDesc.planes[i], height));
+		}
+		return 0;
+	}
+
+	PackedRGBDesc srcDesc, dstDesc;
+	if(getPackedRGBDesc(srcFmt, srcDesc) && getPackedRGBDesc(dstFmt, dstDesc))
+	{
+		ShuffleDesc shuf;
+		buildShuffleDesc(srcDesc, dstDesc, shuf);
+		for(int r = 0; r < height; r++)
+		{
+			convertPackedRow(k, srcDesc, dstDesc, shuf, srcPlanes[0] + r * srcPitches[0],
+							 dstPlanes[0] + r * dstPitches[0], width);
+		}
+		return 0;
+	}
+
+	if((srcFmt == PIXFMT_YUV420P && dstFmt == PIXFMT_YV12) || (srcFmt == PIXFMT_YV12 && dstFmt == PIXFMT_YUV420P))
+	{
+		//same planes, U and V swapped
+		const int chromaWidth = (width + 1) >> 1;
+		const int chromaHeight = (height + 1) >> 1;
+		copyPlane(srcPlanes[0], srcPitches[0], dstPlanes[0], dstPitches[0], width, height);
+		copyPlane(srcPlanes[1], srcPitches[1], dstPlanes[2], dstPitches[2], chromaWidth, chromaHeight);
+		copyPlane(srcPlanes[2], srcPitches[2], dstPlanes[1], dstPitches[1], chromaWidth, chromaHeight);
+		return 0;
+	}
+
+	if(isYUVFormat(srcFmt) && (dstFmt == PIXFMT_B8G8R8A8 || dstFmt == PIXFMT_B8G8R8X8 || dstFmt == PIXFMT_X8R8G8B8))
+	{
+		//the fused kernels read NV12/YUY2 chroma in place
+		return convertYUVToBGRA(srcFmt, srcPlanes, srcPitches, dstPlanes[0], dstPitches[0], width, height, YUV_MATRIX_BT601_LIMITED);
+	}
+
+	YUVRowReader reader(k, srcFmt, srcPlanes, srcPitches, width);
+	YUVRowWriter writer(k, dstFmt, dstPlanes, dstPitches, width);
+	const int step = writer.rowsPerStep();
+	YUVRow rows[2];
+	for(int r = 0; r < height; r += step)
+	{
+		const int count = (height - r) < step ? (height - r) : step;
+		for(int i = 0; i < count; i++)
+			rows[i] = reader.read(r + i, i);
+		writer.write(r, rows, count);
+	}
+	return 0;
+}
+
+int zRender::convertPixelFormat(PIXFormat srcFmt, const unsigned char* src, int srcPitch,
+								PIXFormat dstFmt, unsigned char* dst, int dstPitch,
+								int width, int height)
+{
+	if(!isPixelFormatConvertSupported(srcFmt, dstFmt))
+		return -1;
+	if(src == NULL || dst == NULL || width <= 0 || height <= 0)
+		return -2;
+	//chroma planes of I420/YV12 have half the pitch of the Y plane, the UV plane of NV12 the same pitch
+	const int srcChromaPitch = srcFmt == PIXFMT_NV12 ? srcPitch : (srcPitch >> 1);
+	const int dstChromaPitch = dstFmt == PIXFMT_NV12 ? dstPitch : (dstPitch >> 1);
+	FrameLayout srcLayout = FrameLayout::create(srcFmt, width, height, srcPitch, srcChromaPitch, srcChromaPitch);
+	FrameLayout dstLayout = FrameLayout::create(dstFmt, width, height, dstPitch, dstChromaPitch, dstChromaPitch);
+	if(!srcLayout.valid() || !dstLayout.valid())
+		return -3;
+	const unsigned char* srcPlanes[3];
+	unsigned char* dstPlanes[3];
+	srcLayout.getPlanes(src, srcPlanes);
+	dstLayout.getPlanes(dst, dstPlanes);
+	return convertPixelFormat(srcFmt, srcPlanes, srcLayout.pitches(), dstFmt, dstPlanes, dstLayout.pitches(), width, height);
+}
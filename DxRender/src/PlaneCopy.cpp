@@ -0,0 +1,209 @@
+#include "inc/PlaneCopy.h"
+#include "inc/CpuFeatures.h"
+#include <string.h>
+#include <emmintrin.h>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <thread>
+#endif
+
+using namespace zRender;
+
+namespace
+{
+	const int MAX_WORKER_COUNT = 16;
+	const int DEFAULT_SPLIT_THRESHOLD = 4 * 1024 * 1024;
+
+	//written by setPlaneCopyWorkerCount() only, a copy may see the old or the new value
+	volatile int s_workerCount = 1;
+	volatile int s_splitThreshold = DEFAULT_SPLIT_THRESHOLD;
+
+	struct PlaneCopyTask
+	{
+		const unsigned char* src;
+		int srcPitch;
+		unsigned char* dst;
+		int dstPitch;
+		int rowBytes;
+		int rows;
+		bool streaming;
+#ifdef _WIN32
+		volatile LONG* pending;
+		HANDLE done;
+#endif
+	};
+
+	/**
+	 *	@brief	copy one row with non-temporal stores, dst is aligned to 16 bytes by copying the head with memcpy
+	 **/
+	void streamRow(const unsigned char* src, unsigned char* dst, int bytes)
+	{
+		const int head = (int)((16 - ((size_t)dst & 15)) & 15);
+		if(head >= bytes)
+		{
+			memcpy(dst, src, bytes);
+			return;
+		}
+		memcpy(dst, src, head);
+		src += head;
+		dst += head;
+		bytes -= head;
+		int i = 0;
+		for(; i + 64 <= bytes; i += 64)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + i + 16));
+			__m128i c = _mm_loadu_si128((const __m128i*)(src + i + 32));
+			__m128i d = _mm_loadu_si128((const __m128i*)(src + i + 48));
+			_mm_stream_si128((__m128i*)(dst + i), a);
+			_mm_stream_si128((__m128i*)(dst + i + 16), b);
+			_mm_stream_si128((__m128i*)(dst + i + 32), c);
+			_mm_stream_si128((__m128i*)(dst + i + 48), d);
+		}
+		for(; i + 16 <= bytes; i += 16)
+			_mm_stream_si128((__m128i*)(dst + i), _mm_loadu_si128((const __m128i*)(src + i)));
+		if(i < bytes)
+			memcpy(dst + i, src + i, bytes - i);
+	}
+
+	void copyRows(const PlaneCopyTask& task)
+	{
+		const unsigned char* src = task.src;
+		unsigned char* dst = task.dst;
+		int rowBytes = task.rowBytes;
+		int rows = task.rows;
+		if(task.srcPitch == rowBytes && task.dstPitch == rowBytes)
+		{
+			//no padding on either side, the plane is one block
+			rowBytes *= rows;
+			rows = 1;
+		}
+		if(!task.streaming)
+		{
+			for(int i = 0; i < rows; i++)
+			{
+				memcpy(dst, src, rowBytes);
+				src += task.srcPitch;
+				dst += task.dstPitch;
+			}
+			return;
+		}
+		for(int i = 0; i < rows; i++)
+		{
+			streamRow(src, dst, rowBytes);
+			src += task.srcPitch;
+			dst += task.dstPitch;
+		}
+		//make the streamed data visible before the caller unmaps the texture or another thread reads it
+		_mm_sfence();
+	}
+
+#ifdef _WIN32
+	void CALLBACK planeCopyWork(PTP_CALLBACK_INSTANCE instance, PVOID context)
+	{
+		PlaneCopyTask* task = (PlaneCopyTask*)context;
+		copyRows(*task);
+		if(0 == InterlockedDecrement(task->pending))
+			SetEvent(task->done);
+	}
+
+	/**
+	 *	@brief	copy tasks[0] on the calling thread and the other ones on the process thread pool
+	 **/
+	void runTasks(PlaneCopyTask* tasks, int count)
+	{
+		HANDLE done = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if(done == NULL)
+		{
+			for(int i = 0; i < count; i++)
+				copyRows(tasks[i]);
+			return;
+		}
+		volatile LONG pending = count - 1;
+		for(int i = 1; i < count; i++)
+		{
+			tasks[i].pending = &pending;
+			tasks[i].done = done;
+			if(!TrySubmitThreadpoolCallback(planeCopyWork, &tasks[i], NULL))
+				planeCopyWork(NULL, &tasks[i]);
+		}
+		copyRows(tasks[0]);
+		WaitForSingleObject(done, INFINITE);
+		CloseHandle(done);
+	}
+#else
+	/**
+	 *	@brief	copy tasks[0] on the calling thread and the other ones on threads of their own,
+	 *			there is no process thread pool outside of Windows
+	 **/
+	void runTasks(PlaneCopyTask* tasks, int count)
+	{
+		std::thread workers[MAX_WORKER_COUNT];
+		for(int i = 1; i < count; i++)
+			workers[i] = std::thread(copyRows, tasks[i]);
+		copyRows(tasks[0]);
+		for(int i = 1; i < count; i++)
+			workers[i].join();
+	}
+#endif
+}
+
+int zRender::copyPlane(const unsigned char* src, int srcPitch, unsigned char* dst, int dstPitch, int rowBytes, int rows)
+{
+	if(src == NULL || dst == NULL || rowBytes < 0 || rows < 0 || (rows > 1 && (srcPitch < rowBytes || dstPitch < rowBytes)))
+		return -1;
+	if(rowBytes == 0 || rows == 0)
+		return 0;
+
+	const long long bytes = (long long)rowBytes * rows;
+	PlaneCopyTask task;
+	task.src = src;
+	task.srcPitch = srcPitch;
+	task.dst = dst;
+	task.dstPitch = dstPitch;
+	task.rowBytes = rowBytes;
+	task.rows = rows;
+	//reading src and writing dst through the cache would touch twice the plane size
+	task.streaming = (getCpuFeatures() & CPU_FEATURE_SSE2) != 0 && bytes * 2 > getLastLevelCacheSize();
+
+	int workerCount = s_workerCount;
+	if(workerCount > rows)
+		workerCount = rows;
+	if(workerCount <= 1 || bytes < s_splitThreshold)
+	{
+		copyRows(task);
+		return 0;
+	}
+
+	//bands of whole rows, the calling thread copies the first one
+	PlaneCopyTask tasks[MAX_WORKER_COUNT];
+	int rowStart = 0;
+	for(int i = 0; i < workerCount; i++)
+	{
+		const int rowEnd = (int)((long long)rows * (i + 1) / workerCount);
+		tasks[i] = task;
+		tasks[i].src = src + (long long)rowStart * srcPitch;
+		tasks[i].dst = dst + (long long)rowStart * dstPitch;
+		tasks[i].rows = rowEnd - rowStart;
+		rowStart = rowEnd;
+	}
+	runTasks(tasks, workerCount);
+	return 0;
+}
+
+void zRender::setPlaneCopyWorkerCount(int count, int splitThreshold)
+{
+	if(count < 1)
+		count = 1;
+	if(count > MAX_WORKER_COUNT)
+		count = MAX_WORKER_COUNT;
+	s_workerCount = count;
+	if(splitThreshold > 0)
+		s_splitThreshold = splitThreshold;
+}
+
+int zRender::getPlaneCopyWorkerCount()
+{
+	return s_workerCount;
+}
@@ -1,5 +1,7 @@
 #include "inc/RawFrameTextureBase.h"
 #include "inc/TextureResource.h"
+#include "inc/FrameView.h"
+#include "inc/PlaneCopy.h"
 
 using namespace zRender;
 
@@ -66,11 +68,13 @@ RawFrameTextureBase::~RawFrameTextureBase()
 	return 0;
 }
 
-int zRender::RawFrameTextureBase::copyTexture(const IRawFrameTexture * srcTexture)
+int zRender::RawFrameTextureBase::copyTexture(const IRawFrameTexture * srcTexture, const RECT* regions, int regionCount)
 {
 	if (NULL == srcTexture)	return -1;
 	if (m_pixfmt != srcTexture->getPixelFormat())	return -2;
 	if (!isValid())	return -3;
+	if (NULL != regions && (regionCount < 0 || PixelFormatDescs[m_pixfmt].planeCount != 1))
+		return -7;
 	int texCount = 8;
 	TextureResource* texArray[8] = { NULL };
 	if (0 != srcTexture->getTextureResources(texArray, texCount))
@@ -79,6 +83,13 @@ int zRender::RawFrameTextureBase::copyTexture(const IRawFrameTexture * srcTextur
 	}
 	if (texCount != m_textureCount)
 		return -5;
+	if (NULL != regions)
+	{
+		if (texArray[0] == NULL || m_textureArray[0] == NULL)
+			return -6;
+		//the other textures of a single plane format hold constants, e.g. the YUY2 parity
+		return m_textureArray[0]->copyRegions(texArray[0], regions, regionCount);
+	}
 	for (int i = 0; i < texCount; i++)
 	{
 		TextureResource* src = texArray[i];
@@ -90,6 +101,128 @@ int zRender::RawFrameTextureBase::copyTexture(const IRawFrameTexture * srcTextur
 	return 0;
 }
 
+int zRender::RawFrameTextureBase::updateResourceRegions(const unsigned char* pData, int dataLen, int pitch, int width, int height,
+	const std::vector<RECT>& regions)
+{
+	if (!isValid())	return -3;
+	if (NULL == pData || width <= 0 || height <= 0 || pitch < FRAMEPITCH(width, m_pixfmt)
+		|| dataLen < pitch * (height - 1) + FRAMEPITCH(width, m_pixfmt))
+		return -1;
+	//only one plane whose pixels are the texels of the first texture, e.g. BGRA or YUY2 in R8G8
+	const PlaneFormatDesc& plane = PixelFormatDescs[m_pixfmt].planes[0];
+	if (PixelFormatDescs[m_pixfmt].planeCount != 1 || plane.blockBytes / plane.blockWidth != m_textureArray[0]->texelBytes())
+		return -7;
+	if (regions.empty())
+		return 0;
+	return m_textureArray[0]->updateRegions(pData, pitch, width, height, &regions[0], (int)regions.size());
+}
+
+int zRender::RawFrameTextureBase::prepareRegions(const RECT* regions, int regionCount, int width, int height, bool coalesce, std::vector<RECT>& out) const
+{
+	out.clear();
+	if (NULL == regions || 0 > regionCount)
+		return -1;
+	int alignX = 1;
+	int alignY = 1;
+	FrameView::getCropAlignment(m_pixfmt, alignX, alignY);
+	for (int i = 0; i < regionCount; i++)
+	{
+		RECT rect = regions[i];
+		if (rect.left < 0 || rect.top < 0 || rect.right > width || rect.bottom > height
+			|| rect.right <= rect.left || rect.bottom <= rect.top)
+			return -1;
+		FrameView::alignCropRect(m_pixfmt, rect);
+		rect.right = (rect.right + alignX - 1) & ~(alignX - 1);
+		rect.bottom = (rect.bottom + alignY - 1) & ~(alignY - 1);
+		if (rect.right > width)	rect.right = width;
+		if (rect.bottom > height)	rect.bottom = height;
+		out.push_back(rect);
+	}
+	if (!coalesce)
+		return 0;
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (size_t i = 0; i < out.size() && !merged; i++)
+		{
+			for (size_t j = i + 1; j < out.size(); j++)
+			{
+				RECT& a = out[i];
+				const RECT& b = out[j];
+				const bool inside = b.left >= a.left && b.right <= a.right && b.top >= a.top && b.bottom <= a.bottom;
+				const bool outside = a.left >= b.left && a.right <= b.right && a.top >= b.top && a.bottom <= b.bottom;
+				const bool sameRows = a.top == b.top && a.bottom == b.bottom && a.left <= b.right && b.left <= a.right;
+				const bool sameColumns = a.left == b.left && a.right == b.right && a.top <= b.bottom && b.top <= a.bottom;
+				if (!inside && !outside && !sameRows && !sameColumns)
+					continue;
+				//the union of the two is a rectangle
+				if (b.left < a.left)	a.left = b.left;
+				if (b.top < a.top)	a.top = b.top;
+				if (b.right > a.right)	a.right = b.right;
+				if (b.bottom > a.bottom)	a.bottom = b.bottom;
+				out.erase(out.begin() + j);
+				merged = true;
+				break;
+			}
+		}
+	}
+	return 0;
+}
+
+int zRender::RawFrameTextureBase::uploadPlaneRegions(ID3D11DeviceContext* context, ID3D11Texture2D* stage, ID3D11Texture2D* tex,
+	const unsigned char* plane, int pitch, const PlaneFormatDesc& desc, int texelBytes, const std::vector<RECT>& regions)
+{
+	if (NULL == context || NULL == stage || NULL == tex || NULL == plane || 0 >= texelBytes)
+		return -1;
+	if (regions.empty())
+		return 0;
+	D3D11_TEXTURE2D_DESC texDesc;
+	stage->GetDesc(&texDesc);
+	const int texRowBytes = (int)texDesc.Width * texelBytes;
+	const int texRows = (int)texDesc.Height;
+	D3D11_MAPPED_SUBRESOURCE mappedRes;
+	ZeroMemory(&mappedRes, sizeof(mappedRes));
+	//D3D11_MAP_WRITE keeps the texels outside of the regions
+	if (S_OK != context->Map(stage, 0, D3D11_MAP_WRITE, 0, &mappedRes))
+		return -2;
+	unsigned char* dst = (unsigned char*)mappedRes.pData;
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		const RECT& rect = regions[i];
+		const int offsetX = ((rect.left >> desc.shiftX) / desc.blockWidth) * desc.blockBytes;
+		const int offsetY = rect.top >> desc.shiftY;
+		int rowBytes = getPlaneRowBytes(desc, rect.right - rect.left);
+		int rows = getPlaneRows(desc, rect.bottom - rect.top);
+		//the last block of an odd width frame may be wider than the texture
+		if (offsetX + rowBytes > texRowBytes)	rowBytes = texRowBytes - offsetX;
+		if (offsetY + rows > texRows)	rows = texRows - offsetY;
+		if (rowBytes <= 0 || rows <= 0)
+			continue;
+		copyPlane(plane + offsetY * pitch + offsetX, pitch, dst + offsetY * mappedRes.RowPitch + offsetX, mappedRes.RowPitch, rowBytes, rows);
+	}
+	context->Unmap(stage, 0);
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		const RECT& rect = regions[i];
+		const int offsetX = ((rect.left >> desc.shiftX) / desc.blockWidth) * desc.blockBytes;
+		const int offsetY = rect.top >> desc.shiftY;
+		D3D11_BOX box;
+		box.front = 0;
+		box.back = 1;
+		box.left = offsetX / texelBytes;
+		box.top = offsetY;
+		box.right = box.left + (getPlaneRowBytes(desc, rect.right - rect.left) + texelBytes - 1) / texelBytes;
+		box.bottom = box.top + getPlaneRows(desc, rect.bottom - rect.top);
+		if (box.right > texDesc.Width)	box.right = texDesc.Width;
+		if (box.bottom > texDesc.Height)	box.bottom = texDesc.Height;
+		if (box.right <= box.left || box.bottom <= box.top)
+			continue;
+		context->CopySubresourceRegion(tex, 0, box.left, box.top, 0, stage, 0, &box);
+	}
+	return 0;
+}
+
 bool zRender::RawFrameTextureBase::isValid() const
 {
 	if (m_textureCount <= 0 || m_textureArray == NULL)	return false;
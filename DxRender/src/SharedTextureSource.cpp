@@ -1,19 +1,111 @@
 #include "inc/SharedTextureSource.h"
 #include "DxRender.h"
 #include "IRawFrameTexture.h"
+#include "inc/FrameLayout.h"
+#include "inc/FrameView.h"
+#include <D3D11.h>
 
 using namespace zRender;
 
+namespace
+{
+	//more pieces of damage are uploaded as their bounding box
+	const int MAX_DIRTY_RECTS = 32;
+
+	/**
+	 *	@brief	the params of IRawFrameTexture::update() for a frame whose planes follow each other as FrameLayout::create() puts them
+	 *	@return	false when the frame is invalid or its planes are elsewhere, e.g. a crop
+	 **/
+	bool getUpdateParams(const FrameView& frame, int& dataLen, int& yPitch, int& uPitch, int& vPitch)
+	{
+		if (!frame.valid())
+			return false;
+		const FrameLayout packed = FrameLayout::create(frame.pixfmt(), frame.width(), frame.height());
+		const int planeOfU = packed.planeOfU();
+		const int planeOfV = packed.planeOfV();
+		yPitch = frame.pitch(0);
+		uPitch = planeOfU > 0 ? frame.pitch(planeOfU) : 0;
+		vPitch = planeOfV > 0 ? frame.pitch(planeOfV) : 0;
+		const FrameLayout layout = FrameLayout::create(frame.pixfmt(), frame.width(), frame.height(), yPitch, uPitch, vPitch);
+		if (!layout.valid())
+			return false;
+		for (int i = 1; i < layout.planeCount(); i++)
+		{
+			if (frame.plane(i) != frame.plane(0) + layout.offset(i))
+				return false;
+		}
+		dataLen = layout.size();
+		return true;
+	}
+
+	/**
+	 *	@brief	one D3D11_QUERY_EVENT per slot, ended after the copy out of the slot is queued on the immediate context
+	 **/
+	class QueryStagingFence : public IStagingFence
+	{
+	public:
+		QueryStagingFence() : m_context(NULL) {}
+		~QueryStagingFence()
+		{
+			for (size_t i = 0; i < m_queries.size(); i++)
+				ReleaseCOM(m_queries[i]);
+			ReleaseCOM(m_context);
+		}
+
+		int create(ID3D11Device* device, int slotCount)
+		{
+			if (NULL == device || slotCount <= 0)
+				return -1;
+			D3D11_QUERY_DESC desc;
+			desc.Query = D3D11_QUERY_EVENT;
+			desc.MiscFlags = 0;
+			m_queries.assign(slotCount, (ID3D11Query*)NULL);
+			for (int i = 0; i < slotCount; i++)
+			{
+				if (FAILED(device->CreateQuery(&desc, &m_queries[i])))
+					return -2;
+			}
+			device->GetImmediateContext(&m_context);
+			return m_context ? 0 : -3;
+		}
+
+		virtual void signal(int slot)
+		{
+			m_context->End(m_queries[slot]);
+		}
+
+		virtual bool isSignaled(int slot)
+		{
+			//without D3D11_ASYNC_GETDATA_DONOTFLUSH the commands before the query are sent to the GPU, the wait always ends
+			return S_OK == m_context->GetData(m_queries[slot], NULL, 0, 0);
+		}
+
+	private:
+		std::vector<ID3D11Query*> m_queries;
+		ID3D11DeviceContext* m_context;
+	};
+}
+
 SharedTextureSource::SharedTextureSource(DxRender * render)
 	: m_dxrender(render)
-	, m_texShared(NULL), m_texStaging(NULL)
-	, m_isUpdatedIdentify(0)
-	, m_cacheData(NULL)
+	, m_texShared(NULL), m_texSharedRefs(0), m_texGeneration(0)
+	, m_stagingFence(NULL), m_stagingDepth(DEFAULT_STAGING_DEPTH)
+	, m_isUpdatedIdentify(0), m_uploadedIdentify(-1)
+	, m_damageReported(false), m_detectDamage(false)
+	, m_fingerprintMode(FINGERPRINT_NONE), m_lastFingerprint(0)
+	, m_skippedFrames(0), m_uploadedFrames(0)
 {
+	InitializeCriticalSection(&m_lock);
 }
 
 SharedTextureSource::~SharedTextureSource()
 {
+	//a DisplayElement still holding one would open a texture of a source that is gone, they are released anyway
+	for (size_t i = 0; i < m_texRetired.size(); i++)
+	{
+		m_dxrender->releaseTexture(&m_texRetired[i].texture);
+	}
+	DeleteCriticalSection(&m_lock);
 }
 
 bool SharedTextureSource::isUpdated(int identify) const
@@ -23,76 +115,48 @@ bool SharedTextureSource::isUpdated(int identify) const
 
 int SharedTextureSource::getTextureProfile(const RECT_f & textureReg, int & dataLen, int & yPitch, int & uPitch, int & vPitch, int & width, int & height, PIXFormat & pixelFmt)
 {
-	if (NULL == m_texStaging)
+	EnterCriticalSection(&m_lock);
+	int w_full = m_texShared ? m_texShared->getWidth() : 0;
+	int h_full = m_texShared ? m_texShared->getHeight() : 0;
+	pixelFmt = m_texShared ? m_texShared->getPixelFormat() : PIXFMT_UNKNOW;
+	const bool created = NULL != m_texShared;
+	LeaveCriticalSection(&m_lock);
+	if (!created)
 		return -1;
-	int w_full = m_texStaging->getWidth();
-	int h_full = m_texStaging->getHeight();
-	pixelFmt = m_texStaging->getPixelFormat();
 	if (w_full <= 0 || h_full <= 0)
 		return -2;
 	width = w_full * (textureReg.width());
 	height = h_full * (textureReg.height());
-	switch (pixelFmt)
-	{
-	case PIXFMT_A8R8G8B8:
-	case PIXFMT_B8G8R8A8:
-	case PIXFMT_B8G8R8X8:
-	case PIXFMT_R8G8B8A8:
-	case PIXFMT_X8R8G8B8:
-		yPitch = width * 4;
-		uPitch = 0;
-		vPitch = 0;
-		dataLen = yPitch * height;
-		break;
-	case PIXFMT_R8G8B8:
-		yPitch = width * 3;
-		uPitch = 0;
-		yPitch = 0;
-		dataLen = yPitch * height;
-		break;
-	case PIXFMT_NV12:
-	case PIXFMT_YV12:
-		yPitch = width;
-		uPitch = width;
-		vPitch = 0;
-		dataLen = yPitch * height + uPitch * (height >> 1);
-		break;
-	case PIXFMT_YUV420P:
-		yPitch = width;
-		uPitch = width >> 1;
-		vPitch = width >> 1;
-		dataLen = yPitch * height + uPitch * (height >> 1) + vPitch * (height >> 1);
-		break;
-	case PIXFMT_YUY2:
-		yPitch = width * 2;
-		uPitch = 0;
-		vPitch = 0;
-		dataLen = yPitch * height;
-		break;
-	case PIXFMT_UNKNOW:
-	default:
+	FrameLayout layout = FrameLayout::create(pixelFmt, width, height);
+	if (!layout.valid())
 		return -3;
-	}
+	yPitch = layout.pitch(0);
+	//the pitches of the planes as IRawFrameTexture::update() takes them, NV12 has no V plane of its own
+	uPitch = layout.planeOfU() > 0 ? layout.pitch(layout.planeOfU()) : 0;
+	vPitch = layout.planeOfV() > 0 && layout.planeOfV() != layout.planeOfU() ? layout.pitch(layout.planeOfV()) : 0;
+	dataLen = layout.size();
 	return 0;
 }
 
 //no use
 unsigned char * SharedTextureSource::getData(int & dataLen, int & yPitch, int & uPitch, int & vPitch, int & width, int & height, PIXFormat & pixelFmt, RECT & effectReg, int & identify)
 {
-	if (m_cacheData == NULL)
+	//only valid until the next cacheFrame, copyDataToTexture uploads the frame cached at that time
+	EnterCriticalSection(&m_lock);
+	const FrameView frame = m_cacheFrame;
+	const int updatedIdentify = m_isUpdatedIdentify;
+	LeaveCriticalSection(&m_lock);
+	if (!getUpdateParams(frame, dataLen, yPitch, uPitch, vPitch))
 		return NULL;
-	dataLen = m_cache_pitch * m_cache_height;
-	yPitch = m_cache_pitch;
-	uPitch = 0;
-	vPitch = 0;
-	width = m_cache_width;
-	height = m_cache_height;
-	pixelFmt = m_texStaging->getPixelFormat();
+	width = frame.width();
+	height = frame.height();
+	pixelFmt = frame.pixfmt();
 	effectReg.left = 0;
 	effectReg.top = 0;
 	effectReg.right = width;
 	effectReg.bottom = height;
-	return m_cacheData;
+	identify = updatedIdentify;
+	return const_cast<unsigned char*>(frame.plane(0));
 }
 
 //no use
@@ -103,31 +167,182 @@ SharedTexture * SharedTextureSource::getSharedTexture(RECT & effectReg, int & id
 
 IRawFrameTexture * SharedTextureSource::getTexture()
 {
-	return m_texShared;
+	EnterCriticalSection(&m_lock);
+	IRawFrameTexture* texture = m_texShared;
+	LeaveCriticalSection(&m_lock);
+	return texture;
+}
+
+IRawFrameTexture * SharedTextureSource::acquireTexture(int & generation)
+{
+	EnterCriticalSection(&m_lock);
+	IRawFrameTexture* texture = m_texShared;
+	if (texture)
+		m_texSharedRefs++;
+	generation = m_texGeneration;
+	LeaveCriticalSection(&m_lock);
+	return texture;
+}
+
+void SharedTextureSource::releaseAcquiredTexture(IRawFrameTexture * texture)
+{
+	if (NULL == texture)
+		return;
+	EnterCriticalSection(&m_lock);
+	if (texture == m_texShared)
+	{
+		m_texSharedRefs--;
+	}
+	else
+	{
+		for (size_t i = 0; i < m_texRetired.size(); i++)
+		{
+			if (m_texRetired[i].texture != texture)
+				continue;
+			//the last DisplayElement that opened it is done with it
+			if (--m_texRetired[i].refs == 0)
+			{
+				m_dxrender->releaseTexture(&m_texRetired[i].texture);
+				m_texRetired.erase(m_texRetired.begin() + i);
+			}
+			break;
+		}
+	}
+	LeaveCriticalSection(&m_lock);
+}
+
+int SharedTextureSource::getTextureGeneration() const
+{
+	EnterCriticalSection(&m_lock);
+	const int generation = m_texGeneration;
+	LeaveCriticalSection(&m_lock);
+	return generation;
 }
 
 int SharedTextureSource::copyDataToTexture(const RECT_f & textureReg, unsigned char * dstTextureData, int pitch, int height, int & identify)
 {
-	if (NULL == m_texStaging)
+	//one render thread uploads, the staging ring and the trackers are used by one thread at a time. The immediate context of
+	//m_dxrender is also used by the other sources on it and by its render thread, the device serializes the calls on it
+	EnterCriticalSection(&m_lock);
+	int ret = 0;
+	if (m_uploadedIdentify == m_isUpdatedIdentify)
+	{
+		//the frame cached last is in the shared texture already, uploaded for another render thread
+		identify = m_isUpdatedIdentify;
+		ret = 1;
+	}
+	else
+	{
+		ret = m_cacheFrame.valid() ? upload(m_cacheFrame, identify) : -1;
+	}
+	LeaveCriticalSection(&m_lock);
+	return ret;
+}
+
+int SharedTextureSource::getFrameView(const RECT_f & textureReg, FrameView & view, int & identify)
+{
+	EnterCriticalSection(&m_lock);
+	const FrameView frame = m_cacheFrame;
+	identify = m_isUpdatedIdentify;
+	LeaveCriticalSection(&m_lock);
+	RECT outer = { 0, 0, frame.width(), frame.height() };
+	RECT rect = { 0 };
+	if (!frame.valid())
+		return -1;
+	if (!FrameView::toPixelRect(textureReg, outer, rect))
+		return -2;
+	view = frame.crop(rect);
+	return view.valid() ? 0 : -3;
+}
+
+bool SharedTextureSource::detectChanges(const FrameView& frame)
+{
+	if (m_fingerprintMode != FINGERPRINT_NONE && !m_damageReported)
+	{
+		const unsigned long long fingerprint = computeFrameFingerprint(frame, m_fingerprintMode);
+		const bool same = fingerprint != 0 && fingerprint == m_lastFingerprint;
+		m_lastFingerprint = fingerprint;
+		//same frame as the one cached before, the tile hashes would not change either
+		if (same)
+			return false;
+	}
+	else
+	{
+		m_lastFingerprint = 0;
+	}
+	return detectDamage(frame);
+}
+
+bool SharedTextureSource::detectDamage(const FrameView& frame)
+{
+	if (m_damageReported)
+	{
+		//the producer reported the damage of this frame, the tiles are not hashed
+		m_damageReported = false;
+		return true;
+	}
+	if (!m_detectDamage || !frame.valid() || 0 > m_dirtyTracker.detectChanges(frame))
+	{
+		m_dirtyTracker.markAllDirty();
+		return true;
+	}
+	//the damage of the frames not uploaded yet is still marked
+	return m_dirtyTracker.isDirty();
+}
+
+int SharedTextureSource::upload(const FrameView& frame, int& identify)
+{
+	if (m_texStagings.empty() || NULL == m_texShared)
 	{
 		return -1;
 	}
-	int w_full = m_texStaging->getWidth();
-	int h_full = m_texStaging->getHeight();
-	RECT updateReg = { 0 };
-	updateReg.left = textureReg.left * w_full;
-	updateReg.right = textureReg.right * w_full;
-	updateReg.top = textureReg.top * h_full;
-	updateReg.bottom = textureReg.bottom * h_full;
-	if (0 != m_texStaging->update(dstTextureData, pitch * height, pitch, 0, 0, w_full, height, updateReg, NULL))
+	const int w_full = m_texShared->getWidth();
+	const int h_full = m_texShared->getHeight();
+	int dataLen = 0, yPitch = 0, uPitch = 0, vPitch = 0;
+	if (frame.width() != w_full || frame.height() != h_full || !getUpdateParams(frame, dataLen, yPitch, uPitch, vPitch))
 	{
+		return -5;
+	}
+	const unsigned char* data = frame.plane(0);
+
+	//the texels outside of the dirty regions in the slot are stale, only the regions written now are copied out of it
+	const int slot = m_stagingRing.acquire();
+	if (slot < 0)
+		return -4;
+	IRawFrameTexture* texStaging = m_texStagings[slot];
+	RECT dirtyRects[MAX_DIRTY_RECTS];
+	int dirtyCount = m_dirtyTracker.isAllDirty() ? 0 : m_dirtyTracker.getDirtyRects(dirtyRects, MAX_DIRTY_RECTS);
+	//the tiles are on the chroma grid already, not coalesced so the copy takes the same rectangles as the staging texture.
+	//The staging textures are TextureResources, their batched update does not use a device context
+	if (dirtyCount > 0
+		&& 0 == texStaging->update(data, dataLen, yPitch, uPitch, vPitch, w_full, h_full, dirtyRects, dirtyCount, false, NULL)
+		&& 0 == m_texShared->copyTexture(texStaging, dirtyRects, dirtyCount))
+	{
+		m_stagingRing.submit(slot);
+		m_dirtyTracker.clear();
+		InterlockedIncrement(&m_uploadedFrames);
+		m_isUpdatedIdentify++;
+		m_uploadedIdentify = m_isUpdatedIdentify;
+		identify = m_isUpdatedIdentify;
+		return 0;
+	}
+
+	RECT updateReg = { 0, 0, w_full, h_full };
+	if (0 != texStaging->update(data, dataLen, yPitch, uPitch, vPitch, w_full, h_full, updateReg, NULL))
+	{
+		m_stagingRing.abandon(slot);
 		return -2;
 	}
-	if (0 != m_texShared->copyTexture(m_texStaging))
+	if (0 != m_texShared->copyTexture(texStaging))
 	{
+		m_stagingRing.abandon(slot);
 		return -3;
 	}
+	m_stagingRing.submit(slot);
+	m_dirtyTracker.clear();
+	InterlockedIncrement(&m_uploadedFrames);
 	m_isUpdatedIdentify++;
+	m_uploadedIdentify = m_isUpdatedIdentify;
 	identify = m_isUpdatedIdentify;
 	return 0;
 }
@@ -135,42 +350,148 @@ int SharedTextureSource::copyDataToTexture(const RECT_f & textureReg, unsigned c
 int SharedTextureSource::createTexture(PIXFormat pixfmt, int w, int h)
 {
 	if (m_dxrender == NULL)	return -1;
+	EnterCriticalSection(&m_lock);
+	const int ret = createTextures(pixfmt, w, h);
+	LeaveCriticalSection(&m_lock);
+	return ret;
+}
+
+void SharedTextureSource::releaseTexture()
+{
+	if (NULL == m_dxrender)
+		return;
+	EnterCriticalSection(&m_lock);
+	releaseTextures();
+	LeaveCriticalSection(&m_lock);
+}
+
+int SharedTextureSource::createTextures(PIXFormat pixfmt, int w, int h)
+{
+	//created again when the producer changes format or size. The DisplayElements that opened the old shared texture keep it
+	//until they see the new generation and reopen, see retireSharedTexture
+	releaseTextures();
+	m_texGeneration++;
 	IRawFrameTexture* sharedTex = m_dxrender->createTexture(pixfmt, w, h, TEXTURE_USAGE_DEFAULT, true, NULL, 0, 0);
 	if (NULL == sharedTex)
 	{
 		return -2;
 	}
 	m_texShared = sharedTex;
-	IRawFrameTexture* stagingTex = m_dxrender->createTexture(pixfmt, w, h, TEXTURE_USAGE_STAGE, false, NULL, 0, 0);
-	if (NULL == stagingTex)
+	for (int i = 0; i < m_stagingDepth; i++)
+	{
+		IRawFrameTexture* stagingTex = m_dxrender->createTexture(pixfmt, w, h, TEXTURE_USAGE_STAGE, false, NULL, 0, 0);
+		if (NULL == stagingTex)
+			break;
+		m_texStagings.push_back(stagingTex);
+	}
+	//fewer slots than asked for only cost more waits for the GPU
+	if (m_texStagings.empty())
 	{
 		return -3;
 	}
-	m_texStaging = stagingTex;
+	if (m_texStagings.size() > 1)
+	{
+		QueryStagingFence* fence = new QueryStagingFence();
+		if (0 == fence->create((ID3D11Device*)m_dxrender->getDevice(), (int)m_texStagings.size()))
+			m_stagingFence = fence;
+		else
+			delete fence;
+	}
+	//without a fence the Map of a slot still read by the GPU waits in the driver
+	m_stagingRing.init((int)m_texStagings.size(), m_stagingFence);
+	m_dirtyTracker.reset(w, h);
+	m_damageReported = false;
+	m_lastFingerprint = 0;
 	m_isUpdatedIdentify++;
 	return 0;
 }
 
-void SharedTextureSource::releaseTexture()
+void SharedTextureSource::releaseTextures()
 {
-	if (NULL == m_dxrender)
+	m_stagingRing.reset();
+	delete m_stagingFence;
+	m_stagingFence = NULL;
+	for (size_t i = 0; i < m_texStagings.size(); i++)
+	{
+		m_dxrender->releaseTexture(&m_texStagings[i]);
+	}
+	m_texStagings.clear();
+	retireSharedTexture();
+}
+
+void SharedTextureSource::retireSharedTexture()
+{
+	if (NULL == m_texShared)
 		return;
-	if (m_texStaging)
+	if (m_texSharedRefs > 0)
 	{
-		m_dxrender->releaseTexture(&m_texStaging);
+		RetiredTexture retired = { m_texShared, m_texSharedRefs };
+		m_texRetired.push_back(retired);
+		m_texShared = NULL;
 	}
-	if (m_texShared)
+	else
 	{
 		m_dxrender->releaseTexture(&m_texShared);
 	}
+	m_texSharedRefs = 0;
 }
 
-void zRender::SharedTextureSource::cacheData(const RECT_f & textureReg, unsigned char * dstTextureData, int pitch, int width, int height)
+void zRender::SharedTextureSource::cacheFrame(const FrameView& frame)
 {
-	m_cacheData = dstTextureData;
-	m_cache_width = width;
-	m_cache_height = height;
-	m_cache_pitch = pitch;
-	m_cache_textureReg = textureReg;
-	m_isUpdatedIdentify++;
+	//waits for an upload of the frame before, the producer may reuse or unmap its memory once this returns
+	EnterCriticalSection(&m_lock);
+	m_cacheFrame = frame;
+	//hashed here on the thread of the producer, a frame without damage does not wake the render threads
+	if (detectChanges(frame))
+		m_isUpdatedIdentify++;
+	else
+		InterlockedIncrement(&m_skippedFrames);
+	LeaveCriticalSection(&m_lock);
+}
+
+void zRender::SharedTextureSource::addDirtyRect(const RECT & rect)
+{
+	EnterCriticalSection(&m_lock);
+	m_dirtyTracker.markDirty(rect);
+	m_damageReported = true;
+	LeaveCriticalSection(&m_lock);
+}
+
+void zRender::SharedTextureSource::enableDamageDetection(bool enable)
+{
+	EnterCriticalSection(&m_lock);
+	m_detectDamage = enable;
+	if (enable && m_texShared)
+	{
+		//the hashes of the frame in the texture are unknown, the next frame is uploaded whole
+		m_dirtyTracker.reset(m_texShared->getWidth(), m_texShared->getHeight());
+	}
+	LeaveCriticalSection(&m_lock);
+}
+
+void zRender::SharedTextureSource::setFingerprintMode(FINGERPRINT_MODE mode)
+{
+	EnterCriticalSection(&m_lock);
+	m_fingerprintMode = mode;
+	//a fingerprint of another mode never matches, the next frame is uploaded
+	m_lastFingerprint = 0;
+	LeaveCriticalSection(&m_lock);
+}
+
+int zRender::SharedTextureSource::setStagingDepth(int depth)
+{
+	if (depth < 1 || depth > StagingRing::MAX_DEPTH)
+		return -1;
+	EnterCriticalSection(&m_lock);
+	m_stagingDepth = depth;
+	LeaveCriticalSection(&m_lock);
+	return 0;
+}
+
+StagingRingStats zRender::SharedTextureSource::getStagingStats() const
+{
+	EnterCriticalSection(&m_lock);
+	const StagingRingStats stats = m_stagingRing.getStats();
+	LeaveCriticalSection(&m_lock);
+	return stats;
 }
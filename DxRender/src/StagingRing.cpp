@@ -0,0 +1,102 @@
+#include "inc/StagingRing.h"
+#include <string.h>
+
+using namespace zRender;
+
+StagingRing::StagingRing()
+	: m_fence(NULL), m_next(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+int StagingRing::init(int depth, IStagingFence* fence)
+{
+	if (depth < 1 || depth > MAX_DEPTH)
+		return -1;
+	m_states.assign(depth, STAGING_SLOT_FREE);
+	m_fence = fence;
+	m_next = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+	return 0;
+}
+
+void StagingRing::reset()
+{
+	m_states.clear();
+	m_fence = NULL;
+	m_next = 0;
+}
+
+int StagingRing::acquire(DWORD timeoutMs)
+{
+	if (m_states.empty() || m_states[m_next] == STAGING_SLOT_WRITING)
+		return -1;
+	const int slot = m_next;
+	if (m_states[slot] == STAGING_SLOT_IN_FLIGHT && !gpuDone(slot))
+	{
+		if (0 == timeoutMs)
+		{
+			m_stats.timeouts++;
+			return -2;
+		}
+		m_stats.stalls++;
+		const DWORD waitStart = GetTickCount();
+		while (!gpuDone(slot))
+		{
+			if (timeoutMs != INFINITE && GetTickCount() - waitStart >= timeoutMs)
+			{
+				m_stats.timeouts++;
+				return -2;
+			}
+			//the copy of a frame takes a fraction of a ms, the other threads run meanwhile
+			Sleep(0);
+		}
+	}
+	m_states[slot] = STAGING_SLOT_WRITING;
+	m_next = (slot + 1) % (int)m_states.size();
+	m_stats.acquired++;
+	return slot;
+}
+
+int StagingRing::submit(int slot)
+{
+	if (slot < 0 || slot >= depth() || m_states[slot] != STAGING_SLOT_WRITING)
+		return -1;
+	if (m_fence)
+	{
+		m_fence->signal(slot);
+		m_states[slot] = STAGING_SLOT_IN_FLIGHT;
+	}
+	else
+	{
+		m_states[slot] = STAGING_SLOT_FREE;
+	}
+	m_stats.submitted++;
+	return 0;
+}
+
+int StagingRing::abandon(int slot)
+{
+	if (slot < 0 || slot >= depth() || m_states[slot] != STAGING_SLOT_WRITING)
+		return -1;
+	m_states[slot] = STAGING_SLOT_FREE;
+	//handed out again first, the slots after it stay in the order they were submitted
+	m_next = slot;
+	m_stats.abandoned++;
+	return 0;
+}
+
+STAGING_SLOT_STATE StagingRing::state(int slot) const
+{
+	if (slot < 0 || slot >= depth())
+		return STAGING_SLOT_FREE;
+	return m_states[slot];
+}
+
+bool StagingRing::gpuDone(int slot)
+{
+	if (m_fence && !m_fence->isSignaled(slot))
+		return false;
+	m_states[slot] = STAGING_SLOT_FREE;
+	return true;
+}
@@ -1,4 +1,5 @@
 #include "inc/TextureResource.h"
+#include "inc/PlaneCopy.h"
 
 using namespace zRender;
 
@@ -261,6 +262,105 @@ int TextureResource::update(const unsigned char* pData, int dataLen, int dataPit
 	return 0;
 }
 
+int TextureResource::updateRegions(const unsigned char* pData, int dataPitch, int width, int height, const RECT* rects, int rectCount)
+{
+	if (NULL == pData || 0 >= width || 0 >= height || NULL == rects || 0 > rectCount)
+		return -1;
+	if (NULL == m_texture || m_device == NULL || m_context == NULL)
+		return -2;
+	if (TEXTURE_USAGE_DEFAULT == m_usage)
+		return -3;
+	const int bytes = texelBytes();
+	if (width != m_width || height != m_height || bytes <= 0 || dataPitch < width * bytes)
+		return -4;
+	for (int i = 0; i < rectCount; i++)
+	{
+		if (rects[i].left < 0 || rects[i].top < 0 || rects[i].right > width || rects[i].bottom > height
+			|| rects[i].right <= rects[i].left || rects[i].bottom <= rects[i].top)
+			return -1;
+	}
+	if (rectCount == 0)
+		return 0;
+	if (m_resMutex)
+	{
+		DWORD syncResult = m_resMutex->AcquireSync(0, INFINITE);
+		if (syncResult != WAIT_OBJECT_0)
+			return -6;
+	}
+	D3D11_MAPPED_SUBRESOURCE mappedRes;
+	ZeroMemory(&mappedRes, sizeof(mappedRes));
+	//D3D11_MAP_WRITE keeps the texels outside of the rectangles
+	if (S_OK != m_context->Map(m_texture, 0, D3D11_MAP_WRITE, 0, &mappedRes))
+	{
+		if (m_resMutex)
+			m_resMutex->ReleaseSync(0);
+		return -5;
+	}
+	unsigned char* dst = (unsigned char*)mappedRes.pData;
+	for (int i = 0; i < rectCount; i++)
+	{
+		const RECT& rect = rects[i];
+		copyPlane(pData + rect.top * dataPitch + rect.left * bytes, dataPitch,
+			dst + rect.top * mappedRes.RowPitch + rect.left * bytes, mappedRes.RowPitch,
+			(rect.right - rect.left) * bytes, rect.bottom - rect.top);
+	}
+	m_context->Unmap(m_texture, 0);
+	if (m_resMutex)
+	{
+		m_resMutex->ReleaseSync(0);
+	}
+	return 0;
+}
+
+int TextureResource::copyRegions(const TextureResource* res, const RECT* rects, int rectCount)
+{
+	if (res == NULL || !res->valid() || !valid() || rects == NULL || rectCount < 0)
+		return -1;
+	if (res->m_width != m_width || res->m_height != m_height || res->m_dxgifmt != m_dxgifmt)
+		return -2;
+	if (isShared())
+	{
+		acquireSync(0, INFINITE);
+	}
+	for (int i = 0; i < rectCount; i++)
+	{
+		const RECT& rect = rects[i];
+		if (rect.left < 0 || rect.top < 0 || rect.right > m_width || rect.bottom > m_height
+			|| rect.right <= rect.left || rect.bottom <= rect.top)
+			continue;
+		D3D11_BOX box;
+		box.front = 0;
+		box.back = 1;
+		box.left = rect.left;
+		box.right = rect.right;
+		box.top = rect.top;
+		box.bottom = rect.bottom;
+		m_context->CopySubresourceRegion(m_texture, 0, rect.left, rect.top, 0, res->m_texture, 0, &box);
+	}
+	if (isShared())
+	{
+		releaseSync(0);
+	}
+	return 0;
+}
+
+int TextureResource::texelBytes() const
+{
+	switch (m_dxgifmt)
+	{
+	case DXGI_FORMAT_R8_UNORM:
+		return 1;
+	case DXGI_FORMAT_R8G8_UNORM:
+		return 2;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
 int zRender::TextureResource::acquireSync(int key, unsigned int timeout)
 {
 	if (m_resMutex)
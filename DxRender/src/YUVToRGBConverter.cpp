@@ -0,0 +1,354 @@
+#include "inc/YUVToRGBConverter.h"
+#include "inc/CpuFeatures.h"
+#include <string.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+using namespace zRender;
+
+namespace
+{
+	/**
+	 *	@brief	rows R, G, B of the 4x4 color matrices, applied to float4(y, u, v, 1) with y,u,v in [0, 1].
+	 *			The BT.601 limited range row is copied from matYUV2RGB in DefaultVideo.fx, do not round it.
+	 **/
+	const float s_colorMatrices[4][3][4] = {
+		//YUV_MATRIX_BT601_LIMITED
+		{	{1.164383f,  0.0f,       1.596027f, -0.874202f},
+			{1.164383f, -0.391762f, -0.812968f,  0.531668f},
+			{1.164383f,  2.017232f,  0.0f,      -1.085631f} },
+		//YUV_MATRIX_BT709_LIMITED
+		{	{1.164383f,  0.0f,       1.792741f, -0.972945f},
+			{1.164383f, -0.213249f, -0.532909f,  0.301483f},
+			{1.164383f,  2.112402f,  0.0f,      -1.133402f} },
+		//YUV_MATRIX_BT601_FULL
+		{	{1.0f,       0.0f,       1.402000f, -0.703749f},
+			{1.0f,      -0.344136f, -0.714136f,  0.531211f},
+			{1.0f,       1.772000f,  0.0f,      -0.889475f} },
+		//YUV_MATRIX_BT709_FULL
+		{	{1.0f,       0.0f,       1.574800f, -0.790488f},
+			{1.0f,      -0.187324f, -0.468124f,  0.329009f},
+			{1.0f,       1.855600f,  0.0f,      -0.931438f} },
+	};
+
+	const float (*getMatrix(YUV_COLOR_MATRIX matrix))[4]
+	{
+		const int index = (matrix >= YUV_MATRIX_BT601_LIMITED && matrix <= YUV_MATRIX_BT709_FULL) ? (int)matrix : 0;
+		return s_colorMatrices[index];
+	}
+
+	//float --> UNORM8 the way the output merger stores the pixel shader result
+	inline unsigned char toUnorm8(float c)
+	{
+		c = c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+		return (unsigned char)(int)(c * 255.0f + 0.5f);
+	}
+
+	/**
+	 *	@brief	the reference, every SIMD kernel evaluates exactly these float operations in this order
+	 **/
+	inline void yuvToBGRA_C(const float m[3][4], int Y, int U, int V, unsigned char* out)
+	{
+		const float y = (float)Y / 255.0f;
+		const float u = (float)U / 255.0f;
+		const float v = (float)V / 255.0f;
+		out[0] = toUnorm8(m[2][0] * y + m[2][1] * u + m[2][2] * v + m[2][3]);
+		out[1] = toUnorm8(m[1][0] * y + m[1][1] * u + m[1][2] * v + m[1][3]);
+		out[2] = toUnorm8(m[0][0] * y + m[0][1] * u + m[0][2] * v + m[0][3]);
+		out[3] = 0xff;
+	}
+
+	void planarRow_C(const float m[3][4], const unsigned char* y, const unsigned char* u, const unsigned char* v,
+					 unsigned char* dst, int x, int width)
+	{
+		for(; x < width; x++)
+			yuvToBGRA_C(m, y[x], u[x >> 1], v[x >> 1], dst + 4 * x);
+	}
+
+	void nv12Row_C(const float m[3][4], const unsigned char* y, const unsigned char* uv, unsigned char* dst, int x, int width)
+	{
+		for(; x < width; x++)
+			yuvToBGRA_C(m, y[x], uv[(x >> 1) * 2], uv[(x >> 1) * 2 + 1], dst + 4 * x);
+	}
+
+	void yuy2Row_C(const float m[3][4], const unsigned char* src, unsigned char* dst, int x, int width)
+	{
+		for(; x < width; x++)
+			yuvToBGRA_C(m, src[2 * x], src[(x >> 1) * 4 + 1], src[(x >> 1) * 4 + 3], dst + 4 * x);
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// SSE2, 4 pixels per call of the core
+	//----------------------------------------------------------------------------------------------
+	struct MatrixSSE2
+	{
+		__m128 m[3][4];
+
+		explicit MatrixSSE2(const float src[3][4])
+		{
+			for(int r = 0; r < 3; r++)
+				for(int c = 0; c < 4; c++)
+					m[r][c] = _mm_set1_ps(src[r][c]);
+		}
+	};
+
+	inline __m128i channel_SSE2(const __m128* row, __m128 y, __m128 u, __m128 v)
+	{
+		__m128 c = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(row[0], y), _mm_mul_ps(row[1], u)), _mm_mul_ps(row[2], v)), row[3]);
+		c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+	}
+
+	inline __m128i pixels4_SSE2(const MatrixSSE2& mat, __m128i y32, __m128i u32, __m128i v32)
+	{
+		const __m128 k255 = _mm_set1_ps(255.0f);
+		const __m128 y = _mm_div_ps(_mm_cvtepi32_ps(y32), k255);
+		const __m128 u = _mm_div_ps(_mm_cvtepi32_ps(u32), k255);
+		const __m128 v = _mm_div_ps(_mm_cvtepi32_ps(v32), k255);
+		const __m128i r = channel_SSE2(mat.m[0], y, u, v);
+		const __m128i g = channel_SSE2(mat.m[1], y, u, v);
+		const __m128i b = channel_SSE2(mat.m[2], y, u, v);
+		const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+		return _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), alpha));
+	}
+
+	inline __m128i loadChroma4_SSE2(const unsigned char* p)
+	{
+		int c = 0;
+		memcpy(&c, p, 4);
+		return _mm_cvtsi32_si128(c);
+	}
+
+	void planarRow_SSE2(const float m[3][4], const unsigned char* y, const unsigned char* u, const unsigned char* v,
+						unsigned char* dst, int width)
+	{
+		const MatrixSSE2 mat(m);
+		const __m128i zero = _mm_setzero_si128();
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + x)), zero);
+			__m128i u8 = loadChroma4_SSE2(u + (x >> 1));
+			__m128i v8 = loadChroma4_SSE2(v + (x >> 1));
+			const __m128i u16 = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u8, u8), zero);
+			const __m128i v16 = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v8, v8), zero);
+			_mm_storeu_si128((__m128i*)(dst + 4 * x), pixels4_SSE2(mat, _mm_unpacklo_epi16(y16, zero),
+								_mm_unpacklo_epi16(u16, zero), _mm_unpacklo_epi16(v16, zero)));
+			_mm_storeu_si128((__m128i*)(dst + 4 * x + 16), pixels4_SSE2(mat, _mm_unpackhi_epi16(y16, zero),
+								_mm_unpackhi_epi16(u16, zero), _mm_unpackhi_epi16(v16, zero)));
+		}
+		planarRow_C(m, y, u, v, dst, x, width);
+	}
+
+	void nv12Row_SSE2(const float m[3][4], const unsigned char* y, const unsigned char* uv, unsigned char* dst, int width)
+	{
+		const MatrixSSE2 mat(m);
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lowWord = _mm_set1_epi32(0xffff);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + x)), zero);
+			//U0 V0 U1 V1 U2 V2 U3 V3 as 16 bit --> U and V as 32 bit, each one used by 2 pixels
+			const __m128i uv16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(uv + x)), zero);
+			const __m128i u32 = _mm_and_si128(uv16, lowWord);
+			const __m128i v32 = _mm_srli_epi32(uv16, 16);
+			_mm_storeu_si128((__m128i*)(dst + 4 * x), pixels4_SSE2(mat, _mm_unpacklo_epi16(y16, zero),
+								_mm_unpacklo_epi32(u32, u32), _mm_unpacklo_epi32(v32, v32)));
+			_mm_storeu_si128((__m128i*)(dst + 4 * x + 16), pixels4_SSE2(mat, _mm_unpackhi_epi16(y16, zero),
+								_mm_unpackhi_epi32(u32, u32), _mm_unpackhi_epi32(v32, v32)));
+		}
+		nv12Row_C(m, y, uv, dst, x, width);
+	}
+
+	void yuy2Row_SSE2(const float m[3][4], const unsigned char* src, unsigned char* dst, int width)
+	{
+		const MatrixSSE2 mat(m);
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lowWord = _mm_set1_epi32(0xffff);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m128i p = _mm_loadu_si128((const __m128i*)(src + 2 * x));
+			//Y0 U0 Y1 V0 ... as 16 bit, every 32 bit holds one Y and one chroma sample
+			const __m128i lo = _mm_unpacklo_epi8(p, zero);
+			const __m128i hi = _mm_unpackhi_epi8(p, zero);
+			const __m128i cLo = _mm_srli_epi32(lo, 16);
+			const __m128i cHi = _mm_srli_epi32(hi, 16);
+			_mm_storeu_si128((__m128i*)(dst + 4 * x), pixels4_SSE2(mat, _mm_and_si128(lo, lowWord),
+								_mm_shuffle_epi32(cLo, _MM_SHUFFLE(2, 2, 0, 0)), _mm_shuffle_epi32(cLo, _MM_SHUFFLE(3, 3, 1, 1))));
+			_mm_storeu_si128((__m128i*)(dst + 4 * x + 16), pixels4_SSE2(mat, _mm_and_si128(hi, lowWord),
+								_mm_shuffle_epi32(cHi, _MM_SHUFFLE(2, 2, 0, 0)), _mm_shuffle_epi32(cHi, _MM_SHUFFLE(3, 3, 1, 1))));
+		}
+		yuy2Row_C(m, src, dst, x, width);
+	}
+
+	//----------------------------------------------------------------------------------------------
+	// AVX2, 8 pixels per call of the core
+	//----------------------------------------------------------------------------------------------
+	struct MatrixAVX2
+	{
+		__m256 m[3][4];
+
+		ZRENDER_TARGET_AVX2 explicit MatrixAVX2(const float src[3][4])
+		{
+			for(int r = 0; r < 3; r++)
+				for(int c = 0; c < 4; c++)
+					m[r][c] = _mm256_set1_ps(src[r][c]);
+		}
+	};
+
+	ZRENDER_TARGET_AVX2 inline __m256i channel_AVX2(const __m256* row, __m256 y, __m256 u, __m256 v)
+	{
+		__m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(row[0], y), _mm256_mul_ps(row[1], u)), _mm256_mul_ps(row[2], v)), row[3]);
+		c = _mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+	}
+
+	/**
+	 *	@brief	the three inputs are 8 bytes each, one byte per pixel
+	 **/
+	ZRENDER_TARGET_AVX2 inline __m256i pixels8_AVX2(const MatrixAVX2& mat, __m128i y8, __m128i u8, __m128i v8)
+	{
+		const __m256 k255 = _mm256_set1_ps(255.0f);
+		const __m256 y = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(y8)), k255);
+		const __m256 u = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(u8)), k255);
+		const __m256 v = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v8)), k255);
+		const __m256i r = channel_AVX2(mat.m[0], y, u, v);
+		const __m256i g = channel_AVX2(mat.m[1], y, u, v);
+		const __m256i b = channel_AVX2(mat.m[2], y, u, v);
+		const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+		return _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), alpha));
+	}
+
+	ZRENDER_TARGET_AVX2 void planarRow_AVX2(const float m[3][4], const unsigned char* y, const unsigned char* u, const unsigned char* v,
+						unsigned char* dst, int width)
+	{
+		const MatrixAVX2 mat(m);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m128i u8 = loadChroma4_SSE2(u + (x >> 1));
+			const __m128i v8 = loadChroma4_SSE2(v + (x >> 1));
+			_mm256_storeu_si256((__m256i*)(dst + 4 * x), pixels8_AVX2(mat, _mm_loadl_epi64((const __m128i*)(y + x)),
+								_mm_unpacklo_epi8(u8, u8), _mm_unpacklo_epi8(v8, v8)));
+		}
+		planarRow_C(m, y, u, v, dst, x, width);
+	}
+
+	ZRENDER_TARGET_AVX2 void nv12Row_AVX2(const float m[3][4], const unsigned char* y, const unsigned char* uv, unsigned char* dst, int width)
+	{
+		const MatrixAVX2 mat(m);
+		const __m128i uDup = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i vDup = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m128i c = _mm_loadl_epi64((const __m128i*)(uv + x));
+			_mm256_storeu_si256((__m256i*)(dst + 4 * x), pixels8_AVX2(mat, _mm_loadl_epi64((const __m128i*)(y + x)),
+								_mm_shuffle_epi8(c, uDup), _mm_shuffle_epi8(c, vDup)));
+		}
+		nv12Row_C(m, y, uv, dst, x, width);
+	}
+
+	ZRENDER_TARGET_AVX2 void yuy2Row_AVX2(const float m[3][4], const unsigned char* src, unsigned char* dst, int width)
+	{
+		const MatrixAVX2 mat(m);
+		const __m128i ySel = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i uDup = _mm_setr_epi8(1, 1, 5, 5, 9, 9, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i vDup = _mm_setr_epi8(3, 3, 7, 7, 11, 11, 15, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+		int x = 0;
+		for(; x + 8 <= width; x += 8)
+		{
+			const __m128i p = _mm_loadu_si128((const __m128i*)(src + 2 * x));
+			_mm256_storeu_si256((__m256i*)(dst + 4 * x), pixels8_AVX2(mat, _mm_shuffle_epi8(p, ySel),
+								_mm_shuffle_epi8(p, uDup), _mm_shuffle_epi8(p, vDup)));
+		}
+		yuy2Row_C(m, src, dst, x, width);
+	}
+
+	void planarRow(unsigned int features, const float m[3][4], const unsigned char* y, const unsigned char* u,
+				   const unsigned char* v, unsigned char* dst, int width)
+	{
+		if(features & CPU_FEATURE_AVX2)
+			planarRow_AVX2(m, y, u, v, dst, width);
+		else if(features & CPU_FEATURE_SSE2)
+			planarRow_SSE2(m, y, u, v, dst, width);
+		else
+			planarRow_C(m, y, u, v, dst, 0, width);
+	}
+}
+
+void zRender::convertYUVPixelToBGRA(unsigned char y, unsigned char u, unsigned char v, YUV_COLOR_MATRIX matrix, unsigned char* outBGRA)
+{
+	if(outBGRA == NULL)
+		return;
+	yuvToBGRA_C(getMatrix(matrix), y, u, v, outBGRA);
+}
+
+void zRender::convertYUVRowToBGRA(const unsigned char* y, const unsigned char* u, const unsigned char* v,
+								  unsigned char* dst, int width, YUV_COLOR_MATRIX matrix)
+{
+	if(y == NULL || u == NULL || v == NULL || dst == NULL || width <= 0)
+		return;
+	planarRow(getCpuFeatures(), getMatrix(matrix), y, u, v, dst, width);
+}
+
+int zRender::convertYUVToBGRA(PIXFormat srcFmt, const unsigned char* const srcPlanes[3], const int srcPitches[3],
+							  unsigned char* dst, int dstPitch, int width, int height, YUV_COLOR_MATRIX matrix)
+{
+	if(srcPlanes == NULL || srcPitches == NULL || dst == NULL || width <= 0 || height <= 0 || dstPitch < width * 4)
+		return -1;
+	const int chromaWidth = (width + 1) >> 1;
+	const float (*m)[4] = getMatrix(matrix);
+	const unsigned int features = getCpuFeatures();
+	switch(srcFmt)
+	{
+	case PIXFMT_YUV420P:
+	case PIXFMT_YV12:
+		{
+			const int ui = (srcFmt == PIXFMT_YUV420P) ? 1 : 2;
+			const int vi = 3 - ui;
+			if(srcPlanes[0] == NULL || srcPlanes[1] == NULL || srcPlanes[2] == NULL
+				|| srcPitches[0] < width || srcPitches[1] < chromaWidth || srcPitches[2] < chromaWidth)
+				return -2;
+			for(int r = 0; r < height; r++)
+			{
+				planarRow(features, m, srcPlanes[0] + r * srcPitches[0], srcPlanes[ui] + (r >> 1) * srcPitches[ui],
+						  srcPlanes[vi] + (r >> 1) * srcPitches[vi], dst + r * dstPitch, width);
+			}
+		}
+		return 0;
+	case PIXFMT_NV12:
+		if(srcPlanes[0] == NULL || srcPlanes[1] == NULL || srcPitches[0] < width || srcPitches[1] < chromaWidth * 2)
+			return -2;
+		for(int r = 0; r < height; r++)
+		{
+			const unsigned char* y = srcPlanes[0] + r * srcPitches[0];
+			const unsigned char* uv = srcPlanes[1] + (r >> 1) * srcPitches[1];
+			if(features & CPU_FEATURE_AVX2)
+				nv12Row_AVX2(m, y, uv, dst + r * dstPitch, width);
+			else if(features & CPU_FEATURE_SSE2)
+				nv12Row_SSE2(m, y, uv, dst + r * dstPitch, width);
+			else
+				nv12Row_C(m, y, uv, dst + r * dstPitch, 0, width);
+		}
+		return 0;
+	case PIXFMT_YUY2:
+		if(srcPlanes[0] == NULL || srcPitches[0] < chromaWidth * 4)
+			return -2;
+		for(int r = 0; r < height; r++)
+		{
+			const unsigned char* src = srcPlanes[0] + r * srcPitches[0];
+			if(features & CPU_FEATURE_AVX2)
+				yuy2Row_AVX2(m, src, dst + r * dstPitch, width);
+			else if(features & CPU_FEATURE_SSE2)
+				yuy2Row_SSE2(m, src, dst + r * dstPitch, width);
+			else
+				yuy2Row_C(m, src, dst + r * dstPitch, 0, width);
+		}
+		return 0;
+	default:
+		return -3;
+	}
+}
@@ -0,0 +1,138 @@
+/**
+ *	@name		FramePoolTest.cpp
+ *	@brief		FramePool reuse, alignment, the idle limit and the statistics, buffers shared by several threads,
+ *				and a FrameBuffer of a static object given back after the process wide instance is gone
+ */
+
+#include "inc/FramePool.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <vector>
+
+using namespace zRender;
+
+namespace
+{
+	//destroyed after the static instance of the pool created in main(), its buffer is given back at exit
+	FrameBuffer s_lateBuffer;
+
+	void testReuse()
+	{
+		FramePool& pool = FramePool::instance();
+		const FramePoolStats before = pool.getStats();
+		unsigned char* first = pool.acquire(PIXFMT_YUV420P, 64, 48);
+		CHECK(first != NULL);
+		CHECK(((size_t)first % FramePool::BUFFER_ALIGN) == 0);
+		CHECK(pool.release(first) == 0);
+		unsigned char* second = pool.acquire(PIXFMT_YUV420P, 64, 48);
+		CHECK(second == first);
+		//another key does not get the idle buffer
+		unsigned char* other = pool.acquire(PIXFMT_YUV420P, 64, 50);
+		CHECK(other != NULL && other != first);
+		FramePoolStats stats = pool.getStats();
+		CHECK(stats.hits == before.hits + 1 && stats.misses == before.misses + 2);
+		CHECK(stats.bytesOutstanding == before.bytesOutstanding + FRAMESIZE(64, 48, PIXFMT_YUV420P) + FRAMESIZE(64, 50, PIXFMT_YUV420P));
+		CHECK(pool.release(second) == 0);
+		CHECK(pool.release(other) == 0);
+		stats = pool.getStats();
+		CHECK(stats.bytesOutstanding == before.bytesOutstanding);
+	}
+
+	void testPageAlign()
+	{
+		FramePool& pool = FramePool::instance();
+		unsigned char* buffer = pool.acquire(3 * FramePool::PAGE_ALIGN + 17);
+		CHECK(buffer != NULL);
+		CHECK(((size_t)buffer % FramePool::PAGE_ALIGN) == 0);
+		CHECK(pool.release(buffer) == 0);
+	}
+
+	void testForeignAndDoubleRelease()
+	{
+		FramePool& pool = FramePool::instance();
+		unsigned char local[16];
+		CHECK(pool.release(local) < 0);
+		CHECK(pool.release(NULL) < 0);
+		unsigned char* buffer = pool.acquire(1000);
+		CHECK(pool.release(buffer) == 0);
+		CHECK(pool.release(buffer) < 0);
+	}
+
+	void testIdleLimit()
+	{
+		FramePool& pool = FramePool::instance();
+		pool.trim();
+		const int count = FramePool::MAX_IDLE_PER_KEY + 3;
+		std::vector<unsigned char*> buffers;
+		for(int i = 0; i < count; i++)
+			buffers.push_back(pool.acquire(PIXFMT_R8G8B8A8, 32, 32));
+		for(int i = 0; i < count; i++)
+			CHECK(pool.release(buffers[i]) == 0);
+		CHECK(pool.getStats().bytesPooled == (long long)FramePool::MAX_IDLE_PER_KEY * FRAMESIZE(32, 32, PIXFMT_R8G8B8A8));
+		pool.trim();
+		CHECK(pool.getStats().bytesPooled == 0);
+	}
+
+	void testFrameBuffer()
+	{
+		const long long outstanding = FramePool::instance().getStats().bytesOutstanding;
+		{
+			FrameBuffer a(PIXFMT_YUY2, 40, 20);
+			FrameBuffer b(256);
+			CHECK(a.valid() && a.size() == FRAMESIZE(40, 20, PIXFMT_YUY2));
+			CHECK(b.valid() && b.size() == 256);
+			unsigned char* data = a.data();
+			a.swap(b);
+			CHECK(b.data() == data && a.size() == 256);
+			b.reset();
+			CHECK(!b.valid() && b.size() == 0);
+		}
+		CHECK(FramePool::instance().getStats().bytesOutstanding == outstanding);
+	}
+
+	DWORD WINAPI churnThread(LPVOID param)
+	{
+		volatile LONG* failures = (volatile LONG*)param;
+		for(int i = 0; i < 5000; i++)
+		{
+			FrameBuffer buffer(PIXFMT_NV12, 64 + (i % 3) * 16, 32);
+			if(!buffer.valid())
+			{
+				InterlockedIncrement(failures);
+				continue;
+			}
+			buffer.data()[0] = (unsigned char)i;
+			buffer.data()[buffer.size() - 1] = (unsigned char)i;
+		}
+		return 0;
+	}
+
+	void testThreads()
+	{
+		const long long outstanding = FramePool::instance().getStats().bytesOutstanding;
+		volatile LONG failures = 0;
+		HANDLE threads[4];
+		for(int i = 0; i < 4; i++)
+			threads[i] = CreateThread(NULL, 0, churnThread, (LPVOID)&failures, 0, NULL);
+		for(int i = 0; i < 4; i++)
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+		CHECK(failures == 0);
+		CHECK(FramePool::instance().getStats().bytesOutstanding == outstanding);
+	}
+}
+
+int main()
+{
+	testReuse();
+	testPageAlign();
+	testForeignAndDoubleRelease();
+	testIdleLimit();
+	testFrameBuffer();
+	testThreads();
+	//the instance is created above, after s_lateBuffer, so it is destroyed first at exit
+	CHECK(s_lateBuffer.allocate(PIXFMT_YUV420P, 128, 72));
+	return finishTest();
+}
@@ -0,0 +1,193 @@
+/**
+ *	@name		FrameQueueStressTest.cpp
+ *	@brief		FrameQueue with one producer thread and one consumer at full speed: the order of the frames, no frame lost
+ *				by FRAME_QUEUE_BLOCK, no frame taken twice when FRAME_QUEUE_DROP_OLDEST races pop(), every frame released once,
+ *				and consumers taking turns behind a lock the way the partitions of a VideoTextureDataSource do.
+ *				--quick runs fewer frames, the default is the real stress run
+ */
+
+#include "inc/FrameQueue.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace zRender;
+
+namespace
+{
+	//the frames share one buffer, the pts numbers them and the hook counts the releases
+	unsigned char s_buffer[4 * 4 * 4];
+	volatile LONG s_released = 0;
+
+	void countRelease(unsigned char* data, void* context)
+	{
+		InterlockedIncrement(&s_released);
+	}
+
+	FrameRef makeFrame(long long pts)
+	{
+		FrameLayout layout = FrameLayout::create(PIXFMT_R8G8B8A8, 4, 4);
+		return FrameRef::wrap(s_buffer, sizeof(s_buffer), layout, pts, countRelease, NULL);
+	}
+
+	struct Run
+	{
+		FrameQueue* queue;
+		long frames;
+		volatile LONG pushFailures;
+	};
+
+	DWORD WINAPI producerThread(LPVOID param)
+	{
+		Run* run = (Run*)param;
+		for(long i = 0; i < run->frames; i++)
+		{
+			if(run->queue->push(makeFrame(i)) < 0)
+				InterlockedIncrement(&run->pushFailures);
+		}
+		return 0;
+	}
+
+	/**
+	 *	@brief	the consumer is the calling thread, it yields now and then when slow so the producer fills the queue
+	 **/
+	void stress(FRAME_QUEUE_OVERFLOW overflow, int capacity, long frames, bool slowConsumer)
+	{
+		s_released = 0;
+		{
+			FrameQueue queue(capacity, overflow);
+			Run run = { &queue, frames, 0 };
+			HANDLE producer = CreateThread(NULL, 0, producerThread, &run, 0, NULL);
+			long long last = -1;
+			long got = 0;
+			int outOfOrder = 0;
+			int lost = 0;
+			while(last != frames - 1)
+			{
+				FrameRef frame;
+				if(!queue.pop(frame))
+					continue;
+				if(frame.pts() <= last)
+					outOfOrder++;
+				if(overflow == FRAME_QUEUE_BLOCK && frame.pts() != last + 1)
+					lost++;
+				last = frame.pts();
+				got++;
+				if(slowConsumer && (got % 64) == 0)
+					SwitchToThread();
+			}
+			WaitForSingleObject(producer, INFINITE);
+			CloseHandle(producer);
+			CHECK(run.pushFailures == 0);
+			CHECK(outOfOrder == 0);
+			CHECK(lost == 0);
+			const FrameQueueStats stats = queue.getStats();
+			CHECK(stats.pushed == frames);
+			CHECK(stats.popped == got);
+			CHECK(stats.popped + stats.dropped + queue.size() == frames);
+			if(overflow == FRAME_QUEUE_BLOCK)
+				CHECK(stats.dropped == 0);
+			printf("overflow=%d capacity=%d frames=%ld popped=%ld dropped=%ld\n", (int)overflow, capacity, frames, stats.popped, stats.dropped);
+		}
+		//the frames left in the queue are released by its destructor
+		CHECK(s_released == frames);
+	}
+
+	struct TakingTurns
+	{
+		FrameQueue* queue;
+		CRITICAL_SECTION lock;
+		long long last;
+		volatile LONG got;
+		volatile LONG outOfOrder;
+		long frames;
+	};
+
+	DWORD WINAPI turnConsumerThread(LPVOID param)
+	{
+		TakingTurns* turns = (TakingTurns*)param;
+		for(;;)
+		{
+			FrameRef frame;
+			EnterCriticalSection(&turns->lock);
+			const bool done = turns->last == turns->frames - 1;
+			if(!done && turns->queue->pop(frame))
+			{
+				if(frame.pts() != turns->last + 1)
+					InterlockedIncrement(&turns->outOfOrder);
+				turns->last = frame.pts();
+				InterlockedIncrement(&turns->got);
+			}
+			LeaveCriticalSection(&turns->lock);
+			if(done)
+				return 0;
+		}
+	}
+
+	void stressTakingTurns(long frames)
+	{
+		s_released = 0;
+		{
+			FrameQueue queue(4, FRAME_QUEUE_BLOCK);
+			TakingTurns turns;
+			turns.queue = &queue;
+			InitializeCriticalSection(&turns.lock);
+			turns.last = -1;
+			turns.got = 0;
+			turns.outOfOrder = 0;
+			turns.frames = frames;
+			Run run = { &queue, frames, 0 };
+			HANDLE threads[4];
+			threads[0] = CreateThread(NULL, 0, producerThread, &run, 0, NULL);
+			for(int i = 1; i < 4; i++)
+				threads[i] = CreateThread(NULL, 0, turnConsumerThread, &turns, 0, NULL);
+			for(int i = 0; i < 4; i++)
+			{
+				WaitForSingleObject(threads[i], INFINITE);
+				CloseHandle(threads[i]);
+			}
+			DeleteCriticalSection(&turns.lock);
+			CHECK(run.pushFailures == 0);
+			CHECK(turns.outOfOrder == 0);
+			CHECK(turns.got == frames);
+			CHECK(queue.size() == 0);
+		}
+		CHECK(s_released == frames);
+	}
+
+	void testLimits()
+	{
+		FrameRef frame = makeFrame(0);
+		FrameQueue blocking(2, FRAME_QUEUE_BLOCK);
+		CHECK(blocking.push(frame) == 0);
+		CHECK(blocking.push(frame) == 0);
+		CHECK(blocking.push(frame, 10) == -2);
+		CHECK(frame.useCount() == 3);
+		CHECK(blocking.getStats().timeouts == 1);
+		CHECK(blocking.push(FrameRef()) == -1);
+
+		FrameQueue dropping(2);
+		CHECK(dropping.push(frame) == 0);
+		CHECK(dropping.push(frame) == 0);
+		CHECK(dropping.push(frame) == 1);
+		CHECK(dropping.size() == 2);
+		CHECK(dropping.getStats().dropped == 1);
+		dropping.clear();
+		blocking.clear();
+		CHECK(frame.useCount() == 1);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	const long frames = quick ? 200000 : 3000000;
+	testLimits();
+	stress(FRAME_QUEUE_BLOCK, 1, frames / 10, false);
+	stress(FRAME_QUEUE_BLOCK, 64, frames, false);
+	stress(FRAME_QUEUE_DROP_OLDEST, 1, frames / 3, true);
+	stress(FRAME_QUEUE_DROP_OLDEST, 3, frames, true);
+	stress(FRAME_QUEUE_DROP_OLDEST, 1024, frames, false);
+	stressTakingTurns(frames / 10);
+	return finishTest();
+}
@@ -0,0 +1,148 @@
+/**
+ *	@name		FrameRefTest.cpp
+ *	@brief		FrameRef sharing and release: the hook is called once by the last reference, the blocks are reused,
+ *				pooled frames go back to the FramePool, and copies made and dropped on several threads
+ */
+
+#include "inc/FrameRef.h"
+#include "inc/FramePool.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <vector>
+
+using namespace zRender;
+
+namespace
+{
+	//a frame of the caller released by the hook
+	struct Producer
+	{
+		unsigned char buffer[64 * 32 * 4];
+		volatile LONG released;
+	};
+
+	void countRelease(unsigned char* data, void* context)
+	{
+		Producer* producer = (Producer*)context;
+		if(data == producer->buffer)
+			InterlockedIncrement(&producer->released);
+	}
+
+	FrameRef wrapProducer(Producer& producer)
+	{
+		FrameLayout layout = FrameLayout::create(PIXFMT_R8G8B8A8, 64, 32);
+		return FrameRef::wrap(producer.buffer, sizeof(producer.buffer), layout, 40, countRelease, &producer);
+	}
+
+	void testWrap()
+	{
+		Producer producer;
+		producer.released = 0;
+		FrameLayout layout = FrameLayout::create(PIXFMT_R8G8B8A8, 64, 32);
+		//too small, the hook is not called
+		CHECK(!FrameRef::wrap(producer.buffer, layout.size() - 1, layout, 0, countRelease, &producer).valid());
+		CHECK(!FrameRef::wrap(NULL, layout.size(), layout, 0, countRelease, &producer).valid());
+		CHECK(producer.released == 0);
+
+		FrameRef a = wrapProducer(producer);
+		CHECK(a.valid() && a.useCount() == 1 && a.pts() == 40);
+		CHECK(a.mutableData() == producer.buffer);
+		{
+			FrameRef b = a;
+			FrameRef c;
+			c = b;
+			CHECK(a.useCount() == 3);
+			//shared, nobody may write it
+			CHECK(a.mutableData() == NULL);
+			c = c;
+			CHECK(a.useCount() == 3);
+		}
+		CHECK(a.useCount() == 1 && producer.released == 0);
+		FrameView view = a.view();
+		CHECK(view.valid() && view.width() == 64 && view.height() == 32);
+		a.reset();
+		CHECK(!a.valid() && producer.released == 1);
+	}
+
+	void testBlockReuse()
+	{
+		Producer producer;
+		producer.released = 0;
+		for(int i = 0; i < 1000; i++)
+		{
+			FrameRef frame = wrapProducer(producer);
+			FrameRef copy = frame;
+			CHECK(copy.data() == producer.buffer);
+		}
+		CHECK(producer.released == 1000);
+		//more frames alive than the free list keeps, the blocks over the limit are deleted when released
+		std::vector<FrameRef> frames(FrameRef::MAX_FREE_BLOCKS * 2);
+		for(size_t i = 0; i < frames.size(); i++)
+			frames[i] = wrapProducer(producer);
+		frames.clear();
+		CHECK(producer.released == 1000 + FrameRef::MAX_FREE_BLOCKS * 2);
+	}
+
+	void testAllocate()
+	{
+		const long long outstanding = FramePool::instance().getStats().bytesOutstanding;
+		{
+			FrameRef frame = FrameRef::allocate(PIXFMT_YUV420P, 32, 16, 7);
+			CHECK(frame.valid() && frame.size() == FRAMESIZE(32, 16, PIXFMT_YUV420P) && frame.pts() == 7);
+			CHECK(frame.mutableData() != NULL);
+			FrameRef copy = frame;
+			CHECK(FramePool::instance().getStats().bytesOutstanding == outstanding + frame.size());
+		}
+		CHECK(FramePool::instance().getStats().bytesOutstanding == outstanding);
+	}
+
+	struct Shared
+	{
+		FrameRef frame;
+		volatile LONG failures;
+	};
+
+	DWORD WINAPI copyThread(LPVOID param)
+	{
+		Shared* shared = (Shared*)param;
+		for(int i = 0; i < 20000; i++)
+		{
+			FrameRef copy = shared->frame;
+			FrameRef other;
+			other = copy;
+			if(other.data() != shared->frame.data())
+				InterlockedIncrement(&shared->failures);
+		}
+		return 0;
+	}
+
+	void testThreads()
+	{
+		Producer producer;
+		producer.released = 0;
+		Shared shared;
+		shared.frame = wrapProducer(producer);
+		shared.failures = 0;
+		HANDLE threads[4];
+		for(int i = 0; i < 4; i++)
+			threads[i] = CreateThread(NULL, 0, copyThread, &shared, 0, NULL);
+		for(int i = 0; i < 4; i++)
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+		CHECK(shared.failures == 0);
+		CHECK(shared.frame.useCount() == 1 && producer.released == 0);
+		shared.frame.reset();
+		CHECK(producer.released == 1);
+	}
+}
+
+int main()
+{
+	testWrap();
+	testBlockReuse();
+	testAllocate();
+	testThreads();
+	return finishTest();
+}
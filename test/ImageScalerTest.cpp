@@ -0,0 +1,231 @@
+/**
+ *	@name		ImageScalerTest.cpp
+ *	@brief		conformance of the scaleImage kernels and their throughput.
+ *				1. every filter, format and kernel level against the scalar kernels byte for byte, shrinking and enlarging
+ *				   odd sizes with padded rows, and the rows shared by several threads against one thread
+ *				2. an image of one color keeps its color, the same size with the bilinear filter is a copy
+ *				3. Mpixel/s of every filter and kernel level shrinking 4K to 1080p, a small frame with --quick
+ *				Usage: ImageScalerTest [--quick]
+ */
+
+#include "inc/ImageScaler.h"
+#include "inc/FrameLayout.h"
+#include "inc/CpuFeatures.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+using namespace zRender;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const unsigned int LEVELS[] = { CPU_FEATURE_NONE, CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3, 0xffffffff };
+	const char* LEVEL_NAMES[] = { "C", "SSE2", "SSSE3", "AVX2" };
+	const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+	const PIXFormat FORMATS[] = { PIXFMT_YUV420P, PIXFMT_NV12, PIXFMT_YUY2, PIXFMT_R8G8B8, PIXFMT_B8G8R8A8 };
+	const char* FORMAT_NAMES[] = { "I420", "NV12", "YUY2", "RGB24", "BGRA" };
+	const int FORMAT_COUNT = sizeof(FORMATS) / sizeof(FORMATS[0]);
+
+	const SCALE_FILTER FILTERS[] = { SCALE_FILTER_BILINEAR, SCALE_FILTER_AREA, SCALE_FILTER_LANCZOS };
+	const char* FILTER_NAMES[] = { "bilinear", "area", "lanczos" };
+	const int FILTER_COUNT = sizeof(FILTERS) / sizeof(FILTERS[0]);
+
+	/**
+	 *	@brief	planes of one image, every row padded by some bytes so the kernels can not rely on packed rows
+	 **/
+	struct Image
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> planes[3];
+		int pitches[3];
+
+		Image(PIXFormat fmt, int w, int h, int padding)
+			: width(w), height(h)
+		{
+			FrameLayout layout = FrameLayout::create(fmt, w, h);
+			for(int i = 0; i < 3; i++)
+			{
+				pitches[i] = 0;
+				if(i >= layout.planeCount())
+					continue;
+				pitches[i] = layout.pitch(i) + padding;
+				planes[i].assign((size_t)pitches[i] * layout.planeRows(i), 0xcd);
+			}
+		}
+
+		void fill()
+		{
+			for(int i = 0; i < 3; i++)
+				for(size_t b = 0; b < planes[i].size(); b++)
+					planes[i][b] = (unsigned char)rand();
+		}
+
+		void fill(unsigned char value)
+		{
+			for(int i = 0; i < 3; i++)
+				if(!planes[i].empty())
+					memset(&planes[i][0], value, planes[i].size());
+		}
+
+		void pointers(const unsigned char* out[3]) const
+		{
+			for(int i = 0; i < 3; i++)
+				out[i] = planes[i].empty() ? NULL : &planes[i][0];
+		}
+
+		void pointers(unsigned char* out[3])
+		{
+			for(int i = 0; i < 3; i++)
+				out[i] = planes[i].empty() ? NULL : &planes[i][0];
+		}
+
+		bool operator==(const Image& other) const
+		{
+			for(int i = 0; i < 3; i++)
+				if(planes[i] != other.planes[i])
+					return false;
+			return true;
+		}
+	};
+
+	int scale(PIXFormat fmt, const Image& src, Image& dst, SCALE_FILTER filter, int threadCount)
+	{
+		const unsigned char* srcPlanes[3];
+		unsigned char* dstPlanes[3];
+		src.pointers(srcPlanes);
+		dst.pointers(dstPlanes);
+		return scaleImage(fmt, srcPlanes, src.pitches, src.width, src.height,
+						  dstPlanes, dst.pitches, dst.width, dst.height, filter, threadCount);
+	}
+
+	/**
+	 *	@return	count of the cases whose SIMD or multi-threaded output differs from the scalar output
+	 **/
+	int checkKernels()
+	{
+		//source and destination sizes: shrinking, enlarging, one direction only, the filter wider than the source
+		const int sizes[][4] = {
+			{ 1, 1, 3, 2 }, { 7, 5, 3, 2 }, { 33, 17, 64, 40 }, { 101, 67, 37, 23 },
+			{ 128, 9, 128, 31 }, { 2, 80, 45, 80 }, { 640, 360, 213, 119 },
+		};
+		int fails = 0;
+		for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		for(int f = 0; f < FORMAT_COUNT; f++)
+		{
+			Image src(FORMATS[f], sizes[s][0], sizes[s][1], 13);
+			src.fill();
+			for(int k = 0; k < FILTER_COUNT; k++)
+			{
+				Image ref(FORMATS[f], sizes[s][2], sizes[s][3], 7);
+				setCpuFeaturesMask(LEVELS[0]);
+				if(0 != scale(FORMATS[f], src, ref, FILTERS[k], 1))
+				{
+					printf("%s %s %dx%d -> %dx%d failed\n", FORMAT_NAMES[f], FILTER_NAMES[k],
+						sizes[s][0], sizes[s][1], sizes[s][2], sizes[s][3]);
+					fails++;
+					continue;
+				}
+				for(int l = 0; l < LEVEL_COUNT; l++)
+				{
+					setCpuFeaturesMask(LEVELS[l]);
+					//the scalar level runs on several threads only, against itself on one thread
+					for(int threads = l == 0 ? 4 : 1; threads <= 4; threads += 3)
+					{
+						Image out(FORMATS[f], sizes[s][2], sizes[s][3], 7);
+						if(0 != scale(FORMATS[f], src, out, FILTERS[k], threads) || !(out == ref))
+						{
+							printf("%s %s %dx%d -> %dx%d: %s on %d threads differs from C\n", FORMAT_NAMES[f], FILTER_NAMES[k],
+								sizes[s][0], sizes[s][1], sizes[s][2], sizes[s][3], LEVEL_NAMES[l], threads);
+							fails++;
+						}
+					}
+				}
+			}
+		}
+		setCpuFeaturesMask(0xffffffff);
+		return fails;
+	}
+
+	/**
+	 *	@return	count of the cases where a flat image changes or the bilinear filter at the same size is not a copy
+	 **/
+	int checkInvariants()
+	{
+		int fails = 0;
+		for(int f = 0; f < FORMAT_COUNT; f++)
+		for(int k = 0; k < FILTER_COUNT; k++)
+		{
+			Image flat(FORMATS[f], 61, 43, 5);
+			flat.fill(0x5a);
+			Image out(FORMATS[f], 29, 97, 0);
+			Image expected(FORMATS[f], 29, 97, 0);
+			expected.fill(0x5a);
+			if(0 != scale(FORMATS[f], flat, out, FILTERS[k], 1) || !(out == expected))
+			{
+				printf("%s %s: a flat image changes\n", FORMAT_NAMES[f], FILTER_NAMES[k]);
+				fails++;
+			}
+		}
+		for(int f = 0; f < FORMAT_COUNT; f++)
+		{
+			//even width, the second Y of the last YUY2 pair of an odd row is not a pixel and is not kept
+			Image src(FORMATS[f], 54, 31, 0);
+			src.fill();
+			Image out(FORMATS[f], 54, 31, 0);
+			if(0 != scale(FORMATS[f], src, out, SCALE_FILTER_BILINEAR, 1) || !(out == src))
+			{
+				printf("%s: bilinear at the same size is not a copy\n", FORMAT_NAMES[f]);
+				fails++;
+			}
+		}
+		return fails;
+	}
+
+	void benchmark(int srcWidth, int srcHeight, int dstWidth, int dstHeight, int loops)
+	{
+		printf("%-16s", "Mpixel/s");
+		for(int l = 0; l < LEVEL_COUNT; l++)
+			printf("%9s", LEVEL_NAMES[l]);
+		printf("\n");
+		for(int f = 0; f < FORMAT_COUNT; f++)
+		{
+			Image src(FORMATS[f], srcWidth, srcHeight, 0);
+			src.fill();
+			Image dst(FORMATS[f], dstWidth, dstHeight, 0);
+			for(int k = 0; k < FILTER_COUNT; k++)
+			{
+				printf("%-6s %-9s", FORMAT_NAMES[f], FILTER_NAMES[k]);
+				for(int l = 0; l < LEVEL_COUNT; l++)
+				{
+					setCpuFeaturesMask(LEVELS[l]);
+					const Clock::time_point start = Clock::now();
+					for(int n = 0; n < loops; n++)
+						scale(FORMATS[f], src, dst, FILTERS[k], 1);
+					const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+					printf("%9.1f", (double)dstWidth * dstHeight * loops / seconds / 1e6);
+				}
+				printf("\n");
+			}
+		}
+		setCpuFeaturesMask(0xffffffff);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	printf("cpu features 0x%x\n", getCpuFeatures());
+	const int fails = checkKernels() + checkInvariants();
+	if(quick)
+		benchmark(128, 72, 64, 36, 1);
+	else
+		benchmark(3840, 2160, 1920, 1080, 5);
+	printf("%s\n", fails ? "FAILED" : "OK");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,198 @@
+/**
+ *	@name		PixelFormatConverterBench.cpp
+ *	@brief		convertPixelFormat for every pair of the supported formats.
+ *				Checks the SSE2, SSSE3 and AVX2 kernels against the scalar ones byte for byte on odd sizes and pitches,
+ *				then prints the throughput of every kernel level in Mpixel/s.
+ *				Usage: PixelFormatConverterBench [--quick]
+ */
+
+#include "inc/PixelFormatConverter.h"
+#include "inc/FrameLayout.h"
+#include "inc/CpuFeatures.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+using namespace zRender;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const PIXFormat FORMATS[] = {
+		PIXFMT_YUV420P, PIXFMT_YV12, PIXFMT_NV12, PIXFMT_YUY2, PIXFMT_R8G8B8,
+		PIXFMT_A8R8G8B8, PIXFMT_X8R8G8B8, PIXFMT_R8G8B8A8, PIXFMT_B8G8R8A8, PIXFMT_B8G8R8X8
+	};
+	const int FORMAT_COUNT = sizeof(FORMATS) / sizeof(FORMATS[0]);
+
+	const char* formatName(PIXFormat fmt)
+	{
+		switch(fmt)
+		{
+		case PIXFMT_YUV420P:	return "I420";
+		case PIXFMT_YV12:		return "YV12";
+		case PIXFMT_NV12:		return "NV12";
+		case PIXFMT_YUY2:		return "YUY2";
+		case PIXFMT_R8G8B8:		return "RGB24";
+		case PIXFMT_A8R8G8B8:	return "ARGB";
+		case PIXFMT_X8R8G8B8:	return "XRGB";
+		case PIXFMT_R8G8B8A8:	return "RGBA";
+		case PIXFMT_B8G8R8A8:	return "BGRA";
+		case PIXFMT_B8G8R8X8:	return "BGRX";
+		default:				return "?";
+		}
+	}
+
+	/**
+	 *	@brief	planes of one frame, every row padded by some bytes so the kernels can not rely on packed rows
+	 **/
+	struct Frame
+	{
+		std::vector<unsigned char> planes[3];
+		int pitches[3];
+
+		Frame(PIXFormat fmt, int width, int height, int padding)
+		{
+			FrameLayout layout = FrameLayout::create(fmt, width, height);
+			for(int i = 0; i < 3; i++)
+			{
+				pitches[i] = 0;
+				if(i >= layout.planeCount())
+					continue;
+				pitches[i] = layout.pitch(i) + padding;
+				planes[i].assign((size_t)pitches[i] * layout.planeRows(i), 0xcd);
+			}
+		}
+
+		void fill()
+		{
+			for(int i = 0; i < 3; i++)
+				for(size_t b = 0; b < planes[i].size(); b++)
+					planes[i][b] = (unsigned char)rand();
+		}
+
+		void pointers(const unsigned char* out[3]) const
+		{
+			for(int i = 0; i < 3; i++)
+				out[i] = planes[i].empty() ? NULL : &planes[i][0];
+		}
+
+		void pointers(unsigned char* out[3])
+		{
+			for(int i = 0; i < 3; i++)
+				out[i] = planes[i].empty() ? NULL : &planes[i][0];
+		}
+
+		bool operator==(const Frame& other) const
+		{
+			for(int i = 0; i < 3; i++)
+				if(planes[i] != other.planes[i])
+					return false;
+			return true;
+		}
+	};
+
+	int convert(PIXFormat srcFmt, const Frame& src, PIXFormat dstFmt, Frame& dst, int width, int height)
+	{
+		const unsigned char* srcPlanes[3];
+		unsigned char* dstPlanes[3];
+		src.pointers(srcPlanes);
+		dst.pointers(dstPlanes);
+		return convertPixelFormat(srcFmt, srcPlanes, src.pitches, dstFmt, dstPlanes, dst.pitches, width, height);
+	}
+
+	const unsigned int LEVELS[] = { CPU_FEATURE_NONE, CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3, 0xffffffff };
+	const char* LEVEL_NAMES[] = { "C", "SSE2", "SSSE3", "AVX2" };
+	const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+	/**
+	 *	@return	count of the pairs whose SIMD output differs from the scalar output
+	 **/
+	int checkKernels()
+	{
+		const int sizes[][2] = { { 1, 1 }, { 3, 3 }, { 17, 5 }, { 64, 4 }, { 101, 7 }, { 333, 9 } };
+		int fails = 0;
+		for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			const int width = sizes[s][0];
+			const int height = sizes[s][1];
+			for(int i = 0; i < FORMAT_COUNT; i++)
+			{
+				Frame src(FORMATS[i], width, height, 13);
+				src.fill();
+				for(int o = 0; o < FORMAT_COUNT; o++)
+				{
+					if(!isPixelFormatConvertSupported(FORMATS[i], FORMATS[o]))
+						continue;
+					Frame ref(FORMATS[o], width, height, 7);
+					setCpuFeaturesMask(LEVELS[0]);
+					if(0 != convert(FORMATS[i], src, FORMATS[o], ref, width, height))
+					{
+						printf("%s -> %s %dx%d failed\n", formatName(FORMATS[i]), formatName(FORMATS[o]), width, height);
+						fails++;
+						continue;
+					}
+					for(int l = 1; l < LEVEL_COUNT; l++)
+					{
+						Frame out(FORMATS[o], width, height, 7);
+						setCpuFeaturesMask(LEVELS[l]);
+						if(0 != convert(FORMATS[i], src, FORMATS[o], out, width, height) || !(out == ref))
+						{
+							printf("%s -> %s %dx%d: %s differs from C\n", formatName(FORMATS[i]), formatName(FORMATS[o]),
+								width, height, LEVEL_NAMES[l]);
+							fails++;
+						}
+					}
+				}
+			}
+		}
+		setCpuFeaturesMask(0xffffffff);
+		return fails;
+	}
+
+	void benchmark(int width, int height, int loops)
+	{
+		printf("%-14s", "Mpixel/s");
+		for(int l = 0; l < LEVEL_COUNT; l++)
+			printf("%9s", LEVEL_NAMES[l]);
+		printf("\n");
+		for(int i = 0; i < FORMAT_COUNT; i++)
+		{
+			Frame src(FORMATS[i], width, height, 0);
+			src.fill();
+			for(int o = 0; o < FORMAT_COUNT; o++)
+			{
+				if(i == o || !isPixelFormatConvertSupported(FORMATS[i], FORMATS[o]))
+					continue;
+				Frame dst(FORMATS[o], width, height, 0);
+				printf("%5s -> %-5s ", formatName(FORMATS[i]), formatName(FORMATS[o]));
+				for(int l = 0; l < LEVEL_COUNT; l++)
+				{
+					setCpuFeaturesMask(LEVELS[l]);
+					const Clock::time_point start = Clock::now();
+					for(int n = 0; n < loops; n++)
+						convert(FORMATS[i], src, FORMATS[o], dst, width, height);
+					const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+					printf("%9.1f", (double)width * height * loops / seconds / 1e6);
+				}
+				printf("\n");
+			}
+		}
+		setCpuFeaturesMask(0xffffffff);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	printf("cpu features 0x%x\n", getCpuFeatures());
+	const int fails = checkKernels();
+	if(quick)
+		benchmark(64, 36, 1);
+	else
+		benchmark(3840, 2160, 5);
+	printf("%s\n", fails ? "FAILED" : "OK");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+/**
+ *	@name		PlaneCopyBench.cpp
+ *	@brief		throughput of copyPlane against memcpy row by row, for padded and packed planes and 1 to 4 workers.
+ *				Every copy is checked against the source, the program returns nonzero on a mismatch.
+ *				Usage: PlaneCopyBench [--quick]
+ */
+
+#include "inc/PlaneCopy.h"
+#include "inc/CpuFeatures.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+using namespace zRender;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Plane
+	{
+		int rowBytes;
+		int rows;
+		int srcPitch;
+		int dstPitch;
+		const char* name;
+	};
+
+	void copyRowsMemcpy(const unsigned char* src, int srcPitch, unsigned char* dst, int dstPitch, int rowBytes, int rows)
+	{
+		for(int i = 0; i < rows; i++)
+			memcpy(dst + (size_t)i * dstPitch, src + (size_t)i * srcPitch, rowBytes);
+	}
+
+	bool samePlane(const Plane& plane, const unsigned char* src, const unsigned char* dst)
+	{
+		for(int i = 0; i < plane.rows; i++)
+		{
+			if(0 != memcmp(src + (size_t)i * plane.srcPitch, dst + (size_t)i * plane.dstPitch, plane.rowBytes))
+				return false;
+		}
+		return true;
+	}
+
+	double gbPerSecond(const Plane& plane, int loops, Clock::time_point start)
+	{
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		return (double)plane.rowBytes * plane.rows * loops / seconds / 1e9;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	const int width = quick ? 320 : 3840;
+	const int height = quick ? 180 : 2160;
+	const int loops = quick ? 2 : 50;
+	const Plane planes[] = {
+		{ width * 4, height, width * 4, width * 4, "BGRA packed" },
+		{ width * 4, height, width * 4 + 64, width * 4 + 256, "BGRA padded" },
+		{ width, height, width + 32, width + 64, "Y padded" },
+		{ width * 4 - 3, height, width * 4 + 13, width * 4 + 7, "odd row" },
+	};
+	const int workers[] = { 1, 2, 4 };
+
+	printf("cpu features 0x%x, last level cache %d KB\n", getCpuFeatures(), getLastLevelCacheSize() / 1024);
+	int fails = 0;
+	for(size_t p = 0; p < sizeof(planes) / sizeof(planes[0]); p++)
+	{
+		const Plane& plane = planes[p];
+		std::vector<unsigned char> src((size_t)plane.srcPitch * plane.rows);
+		std::vector<unsigned char> dst((size_t)plane.dstPitch * plane.rows);
+		for(size_t i = 0; i < src.size(); i++)
+			src[i] = (unsigned char)rand();
+
+		Clock::time_point start = Clock::now();
+		for(int l = 0; l < loops; l++)
+			copyRowsMemcpy(&src[0], plane.srcPitch, &dst[0], plane.dstPitch, plane.rowBytes, plane.rows);
+		printf("%-12s memcpy             %6.2f GB/s\n", plane.name, gbPerSecond(plane, loops, start));
+
+		for(size_t w = 0; w < sizeof(workers) / sizeof(workers[0]); w++)
+		{
+			//split every plane of the benchmark, the default threshold would keep the small ones on one thread
+			setPlaneCopyWorkerCount(workers[w], 1);
+			memset(&dst[0], 0, dst.size());
+			start = Clock::now();
+			for(int l = 0; l < loops; l++)
+			{
+				if(0 != copyPlane(&src[0], plane.srcPitch, &dst[0], plane.dstPitch, plane.rowBytes, plane.rows))
+					fails++;
+			}
+			const double speed = gbPerSecond(plane, loops, start);
+			const bool same = samePlane(plane, &src[0], &dst[0]);
+			printf("%-12s copyPlane %d worker %6.2f GB/s%s\n", plane.name, workers[w], speed, same ? "" : "  MISMATCH");
+			if(!same)
+				fails++;
+		}
+	}
+	setPlaneCopyWorkerCount(1);
+	unsigned char small[16] = { 0 };
+	//invalid params are refused
+	if(0 == copyPlane(NULL, 0, small, 16, 16, 1) || 0 == copyPlane(small, 2, small + 8, 4, 4, 2))
+		fails++;
+	printf("%s\n", fails ? "FAILED" : "OK");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+/**
+ *	@name		RegionCoverTest.cpp
+ *	@brief		subtractRegion and isRegionCovered: pieces left by an occluder, a region covered partly, exactly by one or
+ *				several occluders sharing edges, and across gaps narrower or wider than COVER_EPSILON.
+ *				Random occluders on a raster are checked against the centers of the raster cells
+ */
+
+#include "RegionCover.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+using namespace SOA::Mirror::Render;
+using zRender::RECT_f;
+
+namespace
+{
+	float area(const std::vector<RECT_f>& pieces)
+	{
+		float sum = 0;
+		for (size_t i = 0; i < pieces.size(); i++)
+			sum += pieces[i].width() * pieces[i].height();
+		return sum;
+	}
+
+	bool overlaps(const RECT_f& a, const RECT_f& b)
+	{
+		return !(a.left >= b.right || b.left >= a.right || a.top >= b.bottom || b.top >= a.bottom);
+	}
+
+	bool sameRect(const RECT_f& a, const RECT_f& b)
+	{
+		return a.left == b.left && a.right == b.right && a.top == b.top && a.bottom == b.bottom;
+	}
+
+	/**
+	 *	@brief	the pieces lie in region, apart from each other and apart from occluder, and fill the rest of region
+	 **/
+	void checkPieces(const RECT_f& region, const RECT_f& occluder, size_t expectedCount)
+	{
+		std::vector<RECT_f> pieces;
+		subtractRegion(region, occluder, pieces);
+		CHECK(pieces.size() == expectedCount);
+		float covered = 0;
+		if (overlaps(region, occluder))
+		{
+			const float w = (occluder.right < region.right ? occluder.right : region.right) - (occluder.left > region.left ? occluder.left : region.left);
+			const float h = (occluder.bottom < region.bottom ? occluder.bottom : region.bottom) - (occluder.top > region.top ? occluder.top : region.top);
+			covered = w * h;
+		}
+		CHECK(fabs(area(pieces) + covered - region.width() * region.height()) < 1e-6f);
+		for (size_t i = 0; i < pieces.size(); i++)
+		{
+			CHECK(pieces[i].width() > 0 && pieces[i].height() > 0);
+			CHECK(pieces[i].left >= region.left && pieces[i].right <= region.right);
+			CHECK(pieces[i].top >= region.top && pieces[i].bottom <= region.bottom);
+			CHECK(!overlaps(pieces[i], occluder));
+			for (size_t k = i + 1; k < pieces.size(); k++)
+				CHECK(!overlaps(pieces[i], pieces[k]));
+		}
+	}
+
+	void testSubtract()
+	{
+		const RECT_f region(0.2f, 0.6f, 0.2f, 0.6f);
+		//apart and sharing an edge, half open regions do not overlap
+		checkPieces(region, RECT_f(0.7f, 0.9f, 0.7f, 0.9f), 1);
+		checkPieces(region, RECT_f(0.6f, 0.9f, 0.2f, 0.6f), 1);
+		checkPieces(region, RECT_f(0, 0.2f, 0, 1), 1);
+		std::vector<RECT_f> pieces;
+		subtractRegion(region, RECT_f(0.6f, 0.9f, 0.2f, 0.6f), pieces);
+		CHECK(pieces.size() == 1 && sameRect(pieces[0], region));
+
+		//inside, across one side, across a corner, across two opposite sides, over all of it
+		checkPieces(region, RECT_f(0.3f, 0.4f, 0.3f, 0.4f), 4);
+		checkPieces(region, RECT_f(0.5f, 0.9f, 0.1f, 0.9f), 1);
+		checkPieces(region, RECT_f(0.5f, 0.9f, 0.5f, 0.9f), 2);
+		checkPieces(region, RECT_f(0, 1, 0.3f, 0.4f), 2);
+		checkPieces(region, RECT_f(0.2f, 0.6f, 0.2f, 0.6f), 0);
+		checkPieces(region, RECT_f(0, 1, 0, 1), 0);
+	}
+
+	std::vector<RECT_f> occluders(const RECT_f& a)
+	{
+		return std::vector<RECT_f>(1, a);
+	}
+
+	std::vector<RECT_f> occluders(const RECT_f& a, const RECT_f& b)
+	{
+		std::vector<RECT_f> out(1, a);
+		out.push_back(b);
+		return out;
+	}
+
+	void testCovered()
+	{
+		const RECT_f region(0.25f, 0.75f, 0.25f, 0.75f);
+		CHECK(!isRegionCovered(region, std::vector<RECT_f>()));
+
+		//partial
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0, 0.5f, 0, 1))));
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0.25f, 0.75f, 0.25f, 0.7f))));
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0, 0.5f, 0, 1), RECT_f(0.5f, 1, 0, 0.5f))));
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0.3f, 0.7f, 0.3f, 0.7f))));
+
+		//exact, by itself, by a larger one, by halves sharing an edge, by overlapping ones
+		CHECK(isRegionCovered(region, occluders(region)));
+		CHECK(isRegionCovered(region, occluders(RECT_f(0, 1, 0, 1))));
+		CHECK(isRegionCovered(region, occluders(RECT_f(0.25f, 0.5f, 0.25f, 0.75f), RECT_f(0.5f, 0.75f, 0.25f, 0.75f))));
+		CHECK(isRegionCovered(region, occluders(RECT_f(0, 0.6f, 0, 1), RECT_f(0.4f, 1, 0, 1))));
+		std::vector<RECT_f> quarters;
+		quarters.push_back(RECT_f(0.25f, 0.5f, 0.25f, 0.5f));
+		quarters.push_back(RECT_f(0.5f, 0.75f, 0.25f, 0.5f));
+		quarters.push_back(RECT_f(0.25f, 0.5f, 0.5f, 0.75f));
+		CHECK(!isRegionCovered(region, quarters));
+		quarters.push_back(RECT_f(0.5f, 0.75f, 0.5f, 0.75f));
+		CHECK(isRegionCovered(region, quarters));
+
+		//a gap narrower than COVER_EPSILON between the windows is rounding, a wider one shows the region
+		const float narrow = COVER_EPSILON / 2;
+		const float wide = COVER_EPSILON * 10;
+		CHECK(isRegionCovered(region, occluders(RECT_f(0, 0.5f, 0, 1), RECT_f(0.5f + narrow, 1, 0, 1))));
+		CHECK(isRegionCovered(region, occluders(RECT_f(0, 1, 0, 0.5f), RECT_f(0, 1, 0.5f + narrow, 1))));
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0, 0.5f, 0, 1), RECT_f(0.5f + wide, 1, 0, 1))));
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0, 1, 0, 0.5f), RECT_f(0, 1, 0.5f + wide, 1))));
+		//short of the border of the region by less and by more than COVER_EPSILON
+		CHECK(isRegionCovered(region, occluders(RECT_f(0.25f + narrow, 0.75f, 0.25f, 0.75f - narrow))));
+		CHECK(!isRegionCovered(region, occluders(RECT_f(0.25f + wide, 0.75f, 0.25f, 0.75f))));
+	}
+
+	/**
+	 *	@brief	occluders on a raster of 1/16, the region is covered when the center of each of its raster cells is
+	 **/
+	void testAgainstRaster(int rounds)
+	{
+		const int STEPS = 16;
+		int mismatches = 0;
+		for (int round = 0; round < rounds; round++)
+		{
+			int c0 = rand() % STEPS, c1 = rand() % STEPS, r0 = rand() % STEPS, r1 = rand() % STEPS;
+			if (c0 > c1) { int t = c0; c0 = c1; c1 = t; }
+			if (r0 > r1) { int t = r0; r0 = r1; r1 = t; }
+			const RECT_f region((float)c0 / STEPS, (float)(c1 + 1) / STEPS, (float)r0 / STEPS, (float)(r1 + 1) / STEPS);
+			std::vector<RECT_f> occluding;
+			const int count = rand() % 8;
+			for (int i = 0; i < count; i++)
+			{
+				int l = rand() % STEPS, r = rand() % STEPS, t = rand() % STEPS, b = rand() % STEPS;
+				if (l > r) { int s = l; l = r; r = s; }
+				if (t > b) { int s = t; t = b; b = s; }
+				occluding.push_back(RECT_f((float)l / STEPS, (float)(r + 1) / STEPS, (float)t / STEPS, (float)(b + 1) / STEPS));
+			}
+			bool covered = true;
+			for (int y = r0; y <= r1 && covered; y++)
+			{
+				for (int x = c0; x <= c1 && covered; x++)
+				{
+					const float cx = (x + 0.5f) / STEPS, cy = (y + 0.5f) / STEPS;
+					bool hit = false;
+					for (size_t i = 0; i < occluding.size() && !hit; i++)
+						hit = cx >= occluding[i].left && cx < occluding[i].right && cy >= occluding[i].top && cy < occluding[i].bottom;
+					covered = hit;
+				}
+			}
+			if (isRegionCovered(region, occluding) != covered)
+				mismatches++;
+		}
+		CHECK(mismatches == 0);
+		printf("rounds=%d mismatches=%d\n", rounds, mismatches);
+	}
+}
+
+int main()
+{
+	srand(11);
+	testSubtract();
+	testCovered();
+	testAgainstRaster(20000);
+	return finishTest();
+}
@@ -0,0 +1,256 @@
+/**
+ *	@name		RegionGridTest.cpp
+ *	@brief		RegionGrid against its rules: regions are half open so regions sharing an edge do not overlap,
+ *				an item covering several cells is reported once, the regions outside of the bounds are kept by the
+ *				cells of the border, and the cells follow update() and remove().
+ *				Random regions and queries, many of them on the lines of the grid, are checked against a plain scan
+ */
+
+#include "RegionGrid.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace SOA::Mirror::Render;
+using zRender::RECT_f;
+
+namespace
+{
+	typedef RegionGrid<int> Grid;
+
+	bool overlaps(const RECT_f& a, const RECT_f& b)
+	{
+		return !(a.left >= b.right || b.left >= a.right || a.top >= b.bottom || b.top >= a.bottom);
+	}
+
+	bool containsPoint(const RECT_f& reg, float x, float y)
+	{
+		return x >= reg.left && x < reg.right && y >= reg.top && y < reg.bottom;
+	}
+
+	std::vector<int> sorted(std::vector<int> items)
+	{
+		std::sort(items.begin(), items.end());
+		return items;
+	}
+
+	std::vector<int> overlapsOf(const Grid& grid, const RECT_f& region)
+	{
+		std::vector<int> out;
+		CHECK(grid.queryOverlaps(region, out) == (int)out.size());
+		return sorted(out);
+	}
+
+	std::vector<int> hitsOf(const Grid& grid, float x, float y)
+	{
+		std::vector<int> out;
+		CHECK(grid.hitTest(x, y, out) == (int)out.size());
+		return sorted(out);
+	}
+
+	std::vector<int> items(int a, int b = -1, int c = -1, int d = -1)
+	{
+		const int all[] = { a, b, c, d };
+		std::vector<int> out;
+		for (int i = 0; i < 4 && all[i] >= 0; i++)
+			out.push_back(all[i]);
+		return sorted(out);
+	}
+
+	struct StopAfterFirst
+	{
+		StopAfterFirst() : calls(0) {}
+		bool operator()(int, const RECT_f&) { calls++; return false; }
+		int calls;
+	};
+
+	void testEdges()
+	{
+		Grid grid;
+		CHECK(grid.reset(RECT_f(0, 1, 0, 1), 4, 4) == 0);
+		//side by side and one below, all three edges are on lines of the grid
+		CHECK(grid.insert(1, RECT_f(0, 0.5f, 0, 0.5f)) == 0);
+		CHECK(grid.insert(2, RECT_f(0.5f, 1, 0, 0.5f)) == 0);
+		CHECK(grid.insert(3, RECT_f(0, 0.5f, 0.5f, 1)) == 0);
+
+		CHECK(overlapsOf(grid, RECT_f(0, 0.5f, 0, 0.5f)) == items(1));
+		CHECK(overlapsOf(grid, RECT_f(0.5f, 1, 0, 0.5f)) == items(2));
+		CHECK(overlapsOf(grid, RECT_f(0, 0.5f, 0.5f, 1)) == items(3));
+		CHECK(overlapsOf(grid, RECT_f(0.5f, 1, 0.5f, 1)).empty());
+		CHECK(overlapsOf(grid, RECT_f(0.25f, 0.75f, 0.25f, 0.75f)) == items(1, 2, 3));
+
+		//the shared edge belongs to the region on its right and below
+		CHECK(hitsOf(grid, 0.5f, 0.25f) == items(2));
+		CHECK(hitsOf(grid, 0.25f, 0.5f) == items(3));
+		CHECK(hitsOf(grid, 0.4999f, 0.25f) == items(1));
+		CHECK(hitsOf(grid, 0.5f, 0.5f).empty());
+		CHECK(hitsOf(grid, 0, 0) == items(1));
+
+		//an empty query overlaps nothing, even inside a region
+		CHECK(overlapsOf(grid, RECT_f(0.25f, 0.25f, 0.1f, 0.2f)).empty());
+	}
+
+	void testOnce()
+	{
+		Grid grid;
+		CHECK(grid.reset(RECT_f(0, 1, 0, 1), 8, 8) == 0);
+		//every cell lists it, every query reports it once
+		CHECK(grid.insert(1, RECT_f(0, 1, 0, 1)) == 0);
+		CHECK(grid.insert(2, RECT_f(0.1f, 0.9f, 0.3f, 0.7f)) == 0);
+		CHECK(overlapsOf(grid, RECT_f(0, 1, 0, 1)) == items(1, 2));
+		CHECK(overlapsOf(grid, RECT_f(0.2f, 0.3f, 0.6f, 0.95f)) == items(1, 2));
+		CHECK(overlapsOf(grid, RECT_f(0.95f, 1, 0, 0.1f)) == items(1));
+
+		StopAfterFirst stop;
+		CHECK(grid.forEachOverlap(RECT_f(0, 1, 0, 1), stop) == 1);
+		CHECK(stop.calls == 1);
+	}
+
+	void testOutside()
+	{
+		Grid grid;
+		CHECK(grid.reset(RECT_f(0, 1, 0, 1), 4, 4) == 0);
+		CHECK(grid.insert(1, RECT_f(-0.5f, -0.2f, -0.5f, -0.2f)) == 0);
+		CHECK(grid.insert(2, RECT_f(1.2f, 1.5f, 0.4f, 0.6f)) == 0);
+		CHECK(grid.insert(3, RECT_f(-1, 2, -1, 2)) == 0);
+		CHECK(grid.insert(4, RECT_f(0.9f, 1.1f, 0.9f, 1.1f)) == 0);
+
+		CHECK(hitsOf(grid, -0.3f, -0.3f) == items(1, 3));
+		CHECK(hitsOf(grid, 1.3f, 0.5f) == items(2, 3));
+		CHECK(hitsOf(grid, 1.05f, 1.05f) == items(3, 4));
+		//in the border cells but not in the regions
+		CHECK(hitsOf(grid, -0.1f, -0.1f) == items(3));
+		CHECK(hitsOf(grid, 1.6f, 0.5f) == items(3));
+		CHECK(hitsOf(grid, 1.9f, 1.9f) == items(3));
+		CHECK(hitsOf(grid, 5, 5).empty());
+
+		CHECK(overlapsOf(grid, RECT_f(-0.4f, -0.3f, -0.4f, -0.3f)) == items(1, 3));
+		CHECK(overlapsOf(grid, RECT_f(-2, 3, -2, 3)) == items(1, 2, 3, 4));
+		CHECK(overlapsOf(grid, RECT_f(1.25f, 1.3f, -1, 3)) == items(2, 3));
+		CHECK(overlapsOf(grid, RECT_f(0.95f, 3, 0.95f, 3)) == items(3, 4));
+		CHECK(overlapsOf(grid, RECT_f(2.5f, 3, 2.5f, 3)).empty());
+	}
+
+	void testUpdateRemove()
+	{
+		Grid grid;
+		CHECK(grid.insert(1, RECT_f(0, 1, 0, 1)) == -1);
+		CHECK(grid.reset(RECT_f(0, 1, 0, 1), 0, 4) == -1);
+		CHECK(grid.reset(RECT_f(0, 0, 0, 1), 4, 4) == -1);
+		CHECK(grid.reset(RECT_f(0, 1, 0, 1), 4, 4) == 0);
+
+		CHECK(grid.insert(1, RECT_f(0, 0.25f, 0, 0.25f)) == 0);
+		CHECK(grid.insert(1, RECT_f(0.5f, 1, 0.5f, 1)) == -2);
+		CHECK(grid.insert(2, RECT_f(0.5f, 0.5f, 0, 1)) == -1);
+		CHECK(grid.insert(2, RECT_f(0.1f, 0.6f, 0.1f, 0.6f)) == 0);
+		CHECK(grid.size() == 2);
+
+		//moved across several cells, the cells of the old region forget it
+		CHECK(grid.update(1, RECT_f(0.75f, 1, 0.75f, 1)) == 0);
+		CHECK(hitsOf(grid, 0.05f, 0.05f).empty());
+		CHECK(hitsOf(grid, 0.8f, 0.8f) == items(1));
+		CHECK(overlapsOf(grid, RECT_f(0, 0.5f, 0, 0.5f)) == items(2));
+		RECT_f region;
+		CHECK(grid.getRegion(1, region) && region.left == 0.75f && region.bottom == 1);
+
+		CHECK(grid.update(3, RECT_f(0, 1, 0, 1)) == -1);
+		CHECK(grid.update(1, RECT_f(0.2f, 0.1f, 0, 1)) == -1);
+		CHECK(grid.getRegion(1, region) && region.left == 0.75f);
+		CHECK(!grid.contains(3));
+
+		CHECK(grid.remove(2) == 0);
+		CHECK(grid.remove(2) == -1);
+		CHECK(!grid.contains(2));
+		CHECK(hitsOf(grid, 0.3f, 0.3f).empty());
+		CHECK(overlapsOf(grid, RECT_f(0, 1, 0, 1)) == items(1));
+		CHECK(grid.size() == 1);
+
+		grid.clear();
+		CHECK(grid.size() == 0);
+		CHECK(overlapsOf(grid, RECT_f(0, 1, 0, 1)).empty());
+		CHECK(grid.insert(1, RECT_f(0, 1, 0, 1)) == 0);
+	}
+
+	//on a 1/20 step most of the values fall on the lines of a 5 x 4 grid, the rest in between
+	float randomCoord()
+	{
+		return (rand() % 33 - 6) / 20.0f;
+	}
+
+	RECT_f randomRegion()
+	{
+		float l = randomCoord(), r = randomCoord(), t = randomCoord(), b = randomCoord();
+		if (l > r)
+			std::swap(l, r);
+		if (t > b)
+			std::swap(t, b);
+		return RECT_f(l, r + 0.05f, t, b + 0.05f);
+	}
+
+	/**
+	 *	@brief	inserts, updates and removes at random, every query against a scan of all the regions
+	 **/
+	void testAgainstScan(int rounds)
+	{
+		Grid grid;
+		CHECK(grid.reset(RECT_f(0, 1, 0, 1), 5, 4) == 0);
+		std::map<int, RECT_f> regions;
+		int mismatches = 0;
+		for (int round = 0; round < rounds; round++)
+		{
+			const int item = rand() % 40;
+			const bool present = regions.find(item) != regions.end();
+			const RECT_f region = randomRegion();
+			switch (rand() % 4)
+			{
+			case 0:
+				CHECK(grid.insert(item, region) == (present ? -2 : 0));
+				if (!present)
+					regions[item] = region;
+				break;
+			case 1:
+				CHECK(grid.update(item, region) == (present ? 0 : -1));
+				if (present)
+					regions[item] = region;
+				break;
+			case 2:
+				CHECK(grid.remove(item) == (present ? 0 : -1));
+				regions.erase(item);
+				break;
+			default:
+				break;
+			}
+			CHECK(grid.size() == (int)regions.size());
+
+			const RECT_f query = randomRegion();
+			const float x = randomCoord(), y = randomCoord();
+			std::vector<int> overlapping, hits;
+			for (std::map<int, RECT_f>::const_iterator iter = regions.begin(); iter != regions.end(); ++iter)
+			{
+				if (overlaps(iter->second, query))
+					overlapping.push_back(iter->first);
+				if (containsPoint(iter->second, x, y))
+					hits.push_back(iter->first);
+			}
+			//sorted and compared as lists, an item reported twice does not match
+			if (overlapsOf(grid, query) != overlapping || hitsOf(grid, x, y) != hits)
+				mismatches++;
+		}
+		CHECK(mismatches == 0);
+		printf("rounds=%d items=%d mismatches=%d\n", rounds, (int)regions.size(), mismatches);
+	}
+}
+
+int main()
+{
+	srand(7);
+	testEdges();
+	testOnce();
+	testOutside();
+	testUpdateRemove();
+	testAgainstScan(20000);
+	return finishTest();
+}
@@ -0,0 +1,197 @@
+/**
+ *	@name		RenderCommandMailboxStressTest.cpp
+ *	@brief		RenderCommandMailbox with many producer threads and the render thread taking at full speed: the commands of
+ *				each producer come out in the order it posted them, none lost and none taken twice, and the commands left
+ *				when the mailbox dies are dropped without touching their partitions.
+ *				--quick runs fewer commands, the default is the real stress run
+ */
+
+#include "RenderCommandMailbox.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace SOA::Mirror::Render;
+
+namespace
+{
+	//the partitions are never dereferenced by the mailbox, each producer posts its number as the partition
+	//and numbers its commands in zIndex
+	BigViewportPartition* producerPartition(int producer)
+	{
+		return (BigViewportPartition*)(size_t)(producer + 1);
+	}
+
+	int partitionProducer(const BigViewportPartition* partition)
+	{
+		return (int)(size_t)partition - 1;
+	}
+
+	struct Producer
+	{
+		RenderCommandMailbox* mailbox;
+		int index;
+		long commands;
+		volatile LONG postFailures;
+	};
+
+	DWORD WINAPI producerThread(LPVOID param)
+	{
+		Producer* producer = (Producer*)param;
+		for(long i = 0; i < producer->commands; i++)
+		{
+			RenderCommand command;
+			command.type = RENDER_COMMAND_SET_ZINDEX;
+			command.partition = producerPartition(producer->index);
+			command.zIndex = (int)i;
+			command.view = NULL;
+			if(producer->mailbox->post(command) != 0)
+				InterlockedIncrement(&producer->postFailures);
+			//a producer stopped between its exchange and its link hides the commands after it, take() must wait for the link
+			if((i % 1024) == 0)
+				SwitchToThread();
+		}
+		return 0;
+	}
+
+	/**
+	 *	@brief	the render thread is the calling thread, it takes until every command of every producer came out
+	 **/
+	void stress(int producers, long commandsEach)
+	{
+		RenderCommandMailbox mailbox;
+		std::vector<Producer> runs(producers);
+		std::vector<HANDLE> threads(producers);
+		for(int p = 0; p < producers; p++)
+		{
+			runs[p].mailbox = &mailbox;
+			runs[p].index = p;
+			runs[p].commands = commandsEach;
+			runs[p].postFailures = 0;
+		}
+		for(int p = 0; p < producers; p++)
+			threads[p] = CreateThread(NULL, 0, producerThread, &runs[p], 0, NULL);
+
+		const long total = producers * commandsEach;
+		std::vector<long> next(producers, 0);
+		long taken = 0;
+		int outOfOrder = 0;
+		int unknown = 0;
+		while(taken < total)
+		{
+			RenderCommand command;
+			if(!mailbox.take(command))
+			{
+				SwitchToThread();
+				continue;
+			}
+			taken++;
+			const int p = partitionProducer(command.partition);
+			if(p < 0 || p >= producers || command.type != RENDER_COMMAND_SET_ZINDEX)
+			{
+				unknown++;
+				continue;
+			}
+			if(command.zIndex != next[p])
+				outOfOrder++;
+			next[p] = command.zIndex + 1;
+		}
+		for(int p = 0; p < producers; p++)
+		{
+			WaitForSingleObject(threads[p], INFINITE);
+			CloseHandle(threads[p]);
+			CHECK(runs[p].postFailures == 0);
+			CHECK(next[p] == commandsEach);
+		}
+		CHECK(unknown == 0);
+		CHECK(outOfOrder == 0);
+		RenderCommand extra;
+		CHECK(!mailbox.take(extra));
+		const RenderCommandMailboxStats stats = mailbox.getStats();
+		CHECK(stats.posted == total);
+		CHECK(stats.taken == total);
+		printf("producers=%d commands=%ld taken=%ld\n", producers, total, taken);
+	}
+
+	/**
+	 *	@brief	posting while nobody takes, the way commands reach a stopped RenderDrawing, then the mailbox dies with them
+	 **/
+	void stressLeftovers(int producers, long commandsEach)
+	{
+		RenderCommandMailbox* mailbox = new RenderCommandMailbox();
+		std::vector<Producer> runs(producers);
+		std::vector<HANDLE> threads(producers);
+		for(int p = 0; p < producers; p++)
+		{
+			runs[p].mailbox = mailbox;
+			runs[p].index = p;
+			runs[p].commands = commandsEach;
+			runs[p].postFailures = 0;
+			threads[p] = CreateThread(NULL, 0, producerThread, &runs[p], 0, NULL);
+		}
+		for(int p = 0; p < producers; p++)
+		{
+			WaitForSingleObject(threads[p], INFINITE);
+			CloseHandle(threads[p]);
+			CHECK(runs[p].postFailures == 0);
+		}
+		//take a few the way a render thread stopped mid frame does, the rest go with the mailbox
+		RenderCommand command;
+		for(int i = 0; i < 16; i++)
+			CHECK(mailbox->take(command));
+		const RenderCommandMailboxStats stats = mailbox->getStats();
+		CHECK(stats.posted == producers * commandsEach);
+		CHECK(stats.taken == 16);
+		delete mailbox;
+	}
+
+	void testLimits()
+	{
+		RenderCommandMailbox mailbox;
+		RenderCommand command;
+		CHECK(!mailbox.take(command));
+
+		command.type = RENDER_COMMAND_ADD_PARTITION;
+		command.partition = NULL;
+		command.zIndex = 0;
+		command.view = NULL;
+		CHECK(mailbox.post(command) == -1);
+		CHECK(mailbox.getStats().posted == 0);
+
+		//one producer, the stub goes back in the queue every time it empties
+		for(int round = 0; round < 3; round++)
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				command.type = (RENDER_COMMAND_TYPE)i;
+				command.partition = producerPartition(0);
+				command.zIndex = round * 3 + i;
+				CHECK(mailbox.post(command) == 0);
+			}
+			for(int i = 0; i < 3; i++)
+			{
+				RenderCommand out;
+				CHECK(mailbox.take(out));
+				CHECK(out.type == (RENDER_COMMAND_TYPE)i);
+				CHECK(out.zIndex == round * 3 + i);
+			}
+			CHECK(!mailbox.take(command));
+		}
+		const RenderCommandMailboxStats stats = mailbox.getStats();
+		CHECK(stats.posted == 9);
+		CHECK(stats.taken == 9);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	const long commands = quick ? 200000 : 3000000;
+	testLimits();
+	stress(1, commands);
+	stress(4, commands / 4);
+	stress(16, commands / 16);
+	stressLeftovers(8, commands / 80);
+	return finishTest();
+}
@@ -0,0 +1,301 @@
+/**
+ *	@name		SceneStateStressTest.cpp
+ *	@brief		SceneState with one control thread publishing, several render threads reading and the frame clock ticking,
+ *				all at full speed: a reader never sees a snapshot while it is written, every field of the snapshot it holds
+ *				stays the same until it releases it, and the snapshots come in the order they were published.
+ *				Every other update is edited again while pending, the others are adopted and the next update waits for
+ *				the readers of the old front snapshot. The same paths run once step by step before the stress run.
+ *				--quick runs fewer updates, the default is the real stress run
+ */
+
+#include "SceneState.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace SOA::Mirror::Render;
+using zRender::RECT_f;
+
+namespace
+{
+	const int VIEWPORTS = 12;
+
+	//the viewports are never dereferenced by SceneState, they are numbered
+	const BigViewport* viewportKey(int index)
+	{
+		return (const BigViewport*)(size_t)(index + 1);
+	}
+
+	/**
+	 *	@brief	every field of viewport index written from the version of the update, a snapshot written halfway mixes versions
+	 **/
+	SceneViewport layoutOf(int index, long version)
+	{
+		SceneViewport layout;
+		layout.viewport = viewportKey(index);
+		layout.regOfScreen = RECT_f((float)version, (float)version + 1, (float)index, (float)index + 1);
+		layout.zIndex = index;
+		layout.view = (BigView*)(size_t)version;
+		layout.crop = RECT_f(0, 1, 0, (float)(version % 7 + 1) / 8);
+		return layout;
+	}
+
+	/**
+	 *	@return	long the version every viewport of the snapshot was written by, 0 for the first empty snapshot, -1 when they differ
+	 **/
+	long versionOf(const SceneSnapshot* snapshot)
+	{
+		const int count = snapshot->getViewportCount();
+		if (count == 0)
+			return 1 == snapshot->getEpoch() ? 0 : -1;
+		if (count != VIEWPORTS)
+			return -1;
+		const long version = (long)(size_t)snapshot->getViewport(0).view;
+		for (int i = 0; i < count; i++)
+		{
+			const SceneViewport& read = snapshot->getViewport(i);
+			const SceneViewport expected = layoutOf(i, version);
+			if (read.viewport != expected.viewport || read.zIndex != expected.zIndex || read.view != expected.view
+				|| 0 != memcmp(&read.regOfScreen, &expected.regOfScreen, sizeof(RECT_f))
+				|| 0 != memcmp(&read.crop, &expected.crop, sizeof(RECT_f)))
+				return -1;
+		}
+		return version;
+	}
+
+	DWORD WINAPI beginUpdateThread(LPVOID param);
+
+	struct Waiting
+	{
+		SceneState* scene;
+		volatile LONG begun;
+	};
+
+	void testSteps()
+	{
+		SceneState scene(2);
+		CHECK(scene.registerReader() == 0);
+		CHECK(scene.registerReader() == 1);
+		CHECK(scene.registerReader() == -1);
+		CHECK(NULL == scene.acquire(2));
+		CHECK(NULL == scene.acquire(-1));
+		CHECK(scene.endUpdate() == -1);
+
+		const SceneSnapshot* front = scene.acquire(0);
+		CHECK(front->getEpoch() == 1 && front->getViewportCount() == 0);
+		scene.release(0);
+
+		//nested updates publish once, at the outermost endUpdate()
+		SceneSnapshot* back = scene.beginUpdate();
+		CHECK(back->getEpoch() == 2);
+		CHECK(scene.beginUpdate() == back);
+		CHECK(back->setViewport(layoutOf(0, 1)) == 0);
+		CHECK(back->setViewport(layoutOf(1, 1)) == 0);
+		CHECK(scene.endUpdate() == 1);
+		CHECK(scene.endUpdate() == 0);
+		//published, not adopted: the readers still get the old front
+		CHECK(scene.acquire(0) == front);
+		scene.release(0);
+
+		//the pending snapshot is edited again with its epoch, no reader has seen it
+		CHECK(scene.beginUpdate() == back);
+		CHECK(back->getEpoch() == 2);
+		CHECK(back->getViewportCount() == 2);
+		for (int i = 0; i < VIEWPORTS; i++)
+			CHECK(back->setViewport(layoutOf(i, 2)) == 0);
+		CHECK(back->removeViewport(viewportKey(VIEWPORTS)) == -1);
+		CHECK(scene.endUpdate() == 0);
+		CHECK(scene.tick() == 2);
+		CHECK(scene.tick() == 2);
+		const SceneSnapshot* held = scene.acquire(0);
+		CHECK(held == back && versionOf(held) == 2);
+
+		//the old front is written again while reader 0 holds the new one, then adopted
+		back = scene.beginUpdate();
+		CHECK(back == front && back->getEpoch() == 3);
+		for (int i = 0; i < VIEWPORTS; i++)
+			CHECK(back->setViewport(layoutOf(i, 3)) == 0);
+		CHECK(scene.endUpdate() == 0);
+		CHECK(scene.tick() == 3);
+
+		//the next update writes the snapshot reader 0 still holds, it waits for the release
+		Waiting waiting = { &scene, 0 };
+		HANDLE writer = CreateThread(NULL, 0, beginUpdateThread, &waiting, 0, NULL);
+		Sleep(50);
+		CHECK(waiting.begun == 0);
+		CHECK(versionOf(held) == 2 && held->getEpoch() == 2);
+		scene.release(0);
+		WaitForSingleObject(writer, INFINITE);
+		CloseHandle(writer);
+		CHECK(waiting.begun == 1);
+		CHECK(scene.tick() == 4);
+		CHECK(versionOf(scene.acquire(1)) == 3);
+		scene.release(1);
+	}
+
+	DWORD WINAPI beginUpdateThread(LPVOID param)
+	{
+		Waiting* waiting = (Waiting*)param;
+		SceneSnapshot* back = waiting->scene->beginUpdate();
+		InterlockedExchange(&waiting->begun, 1);
+		back->removeViewport(viewportKey(0));
+		back->setViewport(layoutOf(0, 3));
+		waiting->scene->endUpdate();
+		return 0;
+	}
+
+	struct Shared
+	{
+		SceneState* scene;
+		long updates;
+		volatile LONG stop;
+		volatile LONG ticks;
+		volatile LONG reedited;
+	};
+
+	struct Reader
+	{
+		Shared* shared;
+		int slot;
+		long acquires;
+		long epochs;		//snapshots of a new epoch seen
+		long torn;			//versions mixed in one snapshot
+		long changed;		//the snapshot held changed between two reads
+		long backwards;		//an older snapshot after a newer one, or one epoch with two contents
+	};
+
+	DWORD WINAPI readerThread(LPVOID param)
+	{
+		Reader* reader = (Reader*)param;
+		SceneState* scene = reader->shared->scene;
+		LONG lastEpoch = 0;
+		long lastVersion = -1;
+		while (0 == reader->shared->stop)
+		{
+			const SceneSnapshot* snapshot = scene->acquire(reader->slot);
+			const LONG epoch = snapshot->getEpoch();
+			const long version = versionOf(snapshot);
+			//held across a few turns of the writer, a snapshot it should not touch would show its next version here
+			long again = version;
+			for (int turn = 0; turn < 4 && again == version; turn++)
+			{
+				SwitchToThread();
+				again = versionOf(snapshot);
+			}
+			const LONG epochAgain = snapshot->getEpoch();
+			scene->release(reader->slot);
+			reader->acquires++;
+			if (version < 0 || again < 0)
+			{
+				reader->torn++;
+				continue;
+			}
+			if (version != again || epoch != epochAgain)
+				reader->changed++;
+			if (epoch < lastEpoch || version < lastVersion || (epoch == lastEpoch && version != lastVersion))
+				reader->backwards++;
+			if (epoch != lastEpoch)
+				reader->epochs++;
+			lastEpoch = epoch;
+			lastVersion = version;
+		}
+		return 0;
+	}
+
+	DWORD WINAPI tickThread(LPVOID param)
+	{
+		Shared* shared = (Shared*)param;
+		while (0 == shared->stop)
+		{
+			shared->scene->tick();
+			InterlockedIncrement(&shared->ticks);
+			SwitchToThread();
+		}
+		return 0;
+	}
+
+	/**
+	 *	@brief	the writer is the calling thread, it publishes a new version of every viewport per update
+	 **/
+	void stress(int readers, long updates)
+	{
+		SceneState scene(readers);
+		Shared shared = { &scene, updates, 0, 0, 0 };
+		std::vector<Reader> runs(readers);
+		std::vector<HANDLE> threads;
+		for (int r = 0; r < readers; r++)
+		{
+			Reader run = { &shared, scene.registerReader(), 0, 0, 0, 0, 0 };
+			CHECK(run.slot == r);
+			runs[r] = run;
+		}
+		for (int r = 0; r < readers; r++)
+			threads.push_back(CreateThread(NULL, 0, readerThread, &runs[r], 0, NULL));
+		threads.push_back(CreateThread(NULL, 0, tickThread, &shared, 0, NULL));
+
+		LONG lastEpoch = 1;
+		for (long version = 1; version <= updates; version++)
+		{
+			SceneSnapshot* back = scene.beginUpdate();
+			//the clock has not adopted the last one yet
+			if (back->getEpoch() == lastEpoch)
+				shared.reedited++;
+			const bool nested = (version % 3) == 0;
+			if (nested)
+				CHECK(scene.beginUpdate() == back);
+			for (int i = 0; i < VIEWPORTS; i++)
+			{
+				CHECK(back->setViewport(layoutOf(i, version)) == 0);
+				if ((i % 4) == 0)
+					SwitchToThread();
+			}
+			if (nested)
+				CHECK(scene.endUpdate() == 1);
+			lastEpoch = back->getEpoch();
+			CHECK(scene.endUpdate() == 0);
+			//every other update waits for the clock to adopt it, the others are edited again while pending
+			if ((version % 2) == 0)
+			{
+				const LONG ticks = shared.ticks;
+				while (shared.ticks - ticks < 2)
+					SwitchToThread();
+			}
+		}
+		InterlockedExchange(&shared.stop, 1);
+		for (size_t t = 0; t < threads.size(); t++)
+		{
+			WaitForSingleObject(threads[t], INFINITE);
+			CloseHandle(threads[t]);
+		}
+		//the last update is adopted by the next tick
+		scene.tick();
+		const SceneSnapshot* last = scene.acquire(0);
+		CHECK(versionOf(last) == updates);
+		CHECK(last->getEpoch() == lastEpoch);
+		scene.release(0);
+
+		long acquires = 0, epochs = 0;
+		for (int r = 0; r < readers; r++)
+		{
+			CHECK(runs[r].torn == 0);
+			CHECK(runs[r].changed == 0);
+			CHECK(runs[r].backwards == 0);
+			acquires += runs[r].acquires;
+			epochs += runs[r].epochs;
+		}
+		printf("readers=%d updates=%ld ticks=%ld reedited=%ld acquires=%ld epochs seen=%ld\n",
+			readers, updates, (long)shared.ticks, (long)shared.reedited, acquires, epochs);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	const long updates = quick ? 20000 : 500000;
+	testSteps();
+	stress(1, updates);
+	stress(4, updates);
+	stress(8, updates / 2);
+	return finishTest();
+}
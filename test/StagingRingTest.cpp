@@ -0,0 +1,222 @@
+/**
+ *	@name		StagingRingTest.cpp
+ *	@brief		StagingRing over a mock fence: slot order, the waits for the GPU, abandon, timeouts and the statistics,
+ *				then several threads sharing one ring behind a lock the way the render threads share a SharedTextureSource
+ */
+
+#include "inc/StagingRing.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace zRender;
+
+namespace
+{
+	/**
+	 *	@brief	the GPU is done with a slot when the test says so, or after a count of polls when autoComplete > 0
+	 **/
+	class MockFence : public IStagingFence
+	{
+	public:
+		explicit MockFence(int autoComplete = 0) : m_autoComplete(autoComplete)
+		{
+			for(int i = 0; i < StagingRing::MAX_DEPTH; i++)
+			{
+				m_done[i] = 1;
+				m_polls[i] = 0;
+				m_signals[i] = 0;
+			}
+		}
+
+		virtual void signal(int slot)
+		{
+			InterlockedExchange(&m_done[slot], 0);
+			m_polls[slot] = 0;
+			m_signals[slot]++;
+		}
+
+		virtual bool isSignaled(int slot)
+		{
+			if(m_autoComplete > 0 && ++m_polls[slot] >= m_autoComplete)
+				InterlockedExchange(&m_done[slot], 1);
+			return m_done[slot] != 0;
+		}
+
+		void complete(int slot) { InterlockedExchange(&m_done[slot], 1); }
+		long signals(int slot) const { return m_signals[slot]; }
+
+	private:
+		int m_autoComplete;
+		volatile LONG m_done[StagingRing::MAX_DEPTH];
+		int m_polls[StagingRing::MAX_DEPTH];
+		long m_signals[StagingRing::MAX_DEPTH];
+	};
+
+	void testInit()
+	{
+		StagingRing ring;
+		MockFence fence;
+		CHECK(ring.acquire(0) == -1);
+		CHECK(ring.init(0, &fence) == -1);
+		CHECK(ring.init(StagingRing::MAX_DEPTH + 1, &fence) == -1);
+		CHECK(ring.init(3, &fence) == 0);
+		CHECK(ring.depth() == 3);
+		for(int i = 0; i < 3; i++)
+			CHECK(ring.state(i) == STAGING_SLOT_FREE);
+		ring.reset();
+		CHECK(ring.depth() == 0);
+		CHECK(ring.acquire(0) == -1);
+	}
+
+	void testRoundRobin()
+	{
+		StagingRing ring;
+		MockFence fence;
+		ring.init(3, &fence);
+		for(int frame = 0; frame < 9; frame++)
+		{
+			const int slot = ring.acquire(0);
+			CHECK(slot == frame % 3);
+			CHECK(ring.state(slot) == STAGING_SLOT_WRITING);
+			CHECK(ring.submit(slot) == 0);
+			CHECK(ring.state(slot) == STAGING_SLOT_IN_FLIGHT);
+			CHECK(fence.signals(slot) == frame / 3 + 1);
+			//the GPU keeps up, one frame behind
+			if(frame > 0)
+				fence.complete((frame - 1) % 3);
+		}
+		const StagingRingStats stats = ring.getStats();
+		CHECK(stats.acquired == 9 && stats.submitted == 9 && stats.stalls == 0 && stats.timeouts == 0);
+	}
+
+	void testWaitForGpu()
+	{
+		StagingRing ring;
+		MockFence fence;
+		ring.init(2, &fence);
+		CHECK(ring.submit(ring.acquire(0)) == 0);
+		CHECK(ring.submit(ring.acquire(0)) == 0);
+		//both slots in flight, slot 0 is the next one
+		CHECK(ring.acquire(0) == -2);
+		CHECK(ring.acquire(5) == -2);
+		StagingRingStats stats = ring.getStats();
+		CHECK(stats.timeouts == 2 && stats.stalls == 1);
+		CHECK(ring.state(0) == STAGING_SLOT_IN_FLIGHT);
+
+		//the GPU finishes slot 0 while acquire waits
+		std::thread gpu([&fence] { Sleep(20); fence.complete(0); });
+		CHECK(ring.acquire() == 0);
+		gpu.join();
+		stats = ring.getStats();
+		CHECK(stats.stalls == 2 && stats.timeouts == 2);
+		CHECK(ring.state(1) == STAGING_SLOT_IN_FLIGHT);
+	}
+
+	void testWritingSlot()
+	{
+		StagingRing ring;
+		MockFence fence;
+		ring.init(1, &fence);
+		const int slot = ring.acquire(0);
+		CHECK(slot == 0);
+		//the only slot is being written, a second writer is refused instead of sharing it
+		CHECK(ring.acquire(0) == -1);
+		CHECK(ring.submit(slot) == 0);
+		CHECK(ring.submit(slot) == -1);
+		CHECK(ring.abandon(slot) == -1);
+		CHECK(ring.submit(-1) == -1 && ring.submit(1) == -1);
+	}
+
+	void testAbandon()
+	{
+		StagingRing ring;
+		MockFence fence;
+		ring.init(3, &fence);
+		CHECK(ring.submit(ring.acquire(0)) == 0);
+		const int slot = ring.acquire(0);
+		CHECK(slot == 1);
+		CHECK(ring.abandon(slot) == 0);
+		CHECK(ring.state(slot) == STAGING_SLOT_FREE);
+		//the abandoned slot is handed out again first, nothing was signaled for it
+		CHECK(ring.acquire(0) == 1);
+		CHECK(fence.signals(1) == 0);
+		CHECK(ring.getStats().abandoned == 1);
+	}
+
+	void testNoFence()
+	{
+		StagingRing ring;
+		ring.init(2, NULL);
+		for(int frame = 0; frame < 4; frame++)
+		{
+			const int slot = ring.acquire(0);
+			CHECK(slot == frame % 2);
+			CHECK(ring.submit(slot) == 0);
+			//the Map of the slot waits for the GPU instead
+			CHECK(ring.state(slot) == STAGING_SLOT_FREE);
+		}
+		CHECK(ring.getStats().stalls == 0);
+	}
+
+	struct SharedRing
+	{
+		StagingRing ring;
+		CRITICAL_SECTION lock;
+		volatile LONG failures;
+		volatile LONG uploads;
+	};
+
+	DWORD WINAPI uploadThread(LPVOID param)
+	{
+		SharedRing* shared = (SharedRing*)param;
+		for(int i = 0; i < 2000; i++)
+		{
+			EnterCriticalSection(&shared->lock);
+			const int slot = shared->ring.acquire();
+			if(slot < 0 || shared->ring.state(slot) != STAGING_SLOT_WRITING || 0 != shared->ring.submit(slot))
+				InterlockedIncrement(&shared->failures);
+			else
+				InterlockedIncrement(&shared->uploads);
+			LeaveCriticalSection(&shared->lock);
+		}
+		return 0;
+	}
+
+	void testSharedBehindLock()
+	{
+		//every slot is read by the GPU for 3 polls
+		MockFence fence(3);
+		SharedRing shared;
+		InitializeCriticalSection(&shared.lock);
+		shared.failures = 0;
+		shared.uploads = 0;
+		shared.ring.init(3, &fence);
+		HANDLE threads[4];
+		for(int i = 0; i < 4; i++)
+			threads[i] = CreateThread(NULL, 0, uploadThread, &shared, 0, NULL);
+		for(int i = 0; i < 4; i++)
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+		DeleteCriticalSection(&shared.lock);
+		CHECK(shared.failures == 0);
+		CHECK(shared.uploads == 8000);
+		const StagingRingStats stats = shared.ring.getStats();
+		CHECK(stats.acquired == 8000 && stats.submitted == 8000 && stats.timeouts == 0);
+	}
+}
+
+int main()
+{
+	testInit();
+	testRoundRobin();
+	testWaitForGpu();
+	testWritingSlot();
+	testAbandon();
+	testNoFence();
+	testSharedBehindLock();
+	return finishTest();
+}
@@ -0,0 +1,30 @@
+/**
+ *	@name		TestCheck.h
+ *	@brief		the checks shared by the unit and stress tests: CHECK(cond) reports the failed condition with its line
+ *				and counts it, any thread may check. main() ends with return finishTest(), which prints OK or FAILED
+ */
+
+#pragma once
+#ifndef _ZRENDER_TEST_CHECK_H_
+#define _ZRENDER_TEST_CHECK_H_
+
+#include <stdio.h>
+#include <atomic>
+
+namespace
+{
+	std::atomic<int> s_fails(0);
+
+	/**
+	 *	@return	int exit code of the test, 0 when no check failed
+	 **/
+	inline int finishTest()
+	{
+		printf("%s\n", s_fails ? "FAILED" : "OK");
+		return s_fails ? 1 : 0;
+	}
+}
+
+#define CHECK(cond) do { if(!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); s_fails++; } } while(0)
+
+#endif //_ZRENDER_TEST_CHECK_H_
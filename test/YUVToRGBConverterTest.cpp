@@ -0,0 +1,264 @@
+/**
+ *	@name		YUVToRGBConverterTest.cpp
+ *	@brief		conformance of the CPU YUV --> BGRA kernels and their throughput.
+ *				1. convertYUVPixelToBGRA for every Y,U,V against a float implementation of matYUV2RGB in DefaultVideo.fx (exact)
+ *				   and against a double precision matrix derived from Kr/Kb for every YUV_COLOR_MATRIX (+-1)
+ *				2. convertYUVToBGRA of I420/YV12/NV12/YUY2 frames against convertYUVPixelToBGRA, for every kernel level
+ *				3. Mpixel/s of every format and kernel level on a 4K frame, a small one with --quick
+ *				Usage: YUVToRGBConverterTest [--quick]
+ */
+
+#include "inc/YUVToRGBConverter.h"
+#include "inc/CpuFeatures.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+using namespace zRender;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const unsigned int LEVELS[] = { CPU_FEATURE_NONE, CPU_FEATURE_SSE2, 0xffffffff };
+	const char* LEVEL_NAMES[] = { "C", "SSE2", "AVX2" };
+	const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+	//matYUV2RGB of FX/DefaultVideo.fx
+	const float SHADER_MATRIX[3][4] = {
+		{ 1.164383f,  0.0f,       1.596027f, -0.874202f },
+		{ 1.164383f, -0.391762f, -0.812968f,  0.531668f },
+		{ 1.164383f,  2.017232f,  0.0f,      -1.085631f },
+	};
+
+	unsigned char shaderUnorm(float c)
+	{
+		c = c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+		return (unsigned char)(int)(c * 255.0f + 0.5f);
+	}
+
+	/**
+	 *	@brief	the YUV --> RGB matrix from its definition: E'r = Y' + 2(1-Kr)Cr, E'b = Y' + 2(1-Kb)Cb
+	 **/
+	void referenceBGRA(YUV_COLOR_MATRIX matrix, int Y, int U, int V, int out[3])
+	{
+		const bool bt709 = matrix == YUV_MATRIX_BT709_LIMITED || matrix == YUV_MATRIX_BT709_FULL;
+		const bool limited = matrix == YUV_MATRIX_BT601_LIMITED || matrix == YUV_MATRIX_BT709_LIMITED;
+		const double kr = bt709 ? 0.2126 : 0.299;
+		const double kb = bt709 ? 0.0722 : 0.114;
+		const double kg = 1.0 - kr - kb;
+		const double y = limited ? (Y - 16) / 219.0 : Y / 255.0;
+		const double cb = limited ? (U - 128) / 224.0 : (U - 128) / 255.0;
+		const double cr = limited ? (V - 128) / 224.0 : (V - 128) / 255.0;
+		const double rgb[3] = {
+			y + 2.0 * (1.0 - kr) * cr,
+			y - 2.0 * (1.0 - kb) * kb / kg * cb - 2.0 * (1.0 - kr) * kr / kg * cr,
+			y + 2.0 * (1.0 - kb) * cb,
+		};
+		for(int c = 0; c < 3; c++)
+		{
+			const double clamped = rgb[c] < 0.0 ? 0.0 : (rgb[c] > 1.0 ? 1.0 : rgb[c]);
+			out[2 - c] = (int)floor(clamped * 255.0 + 0.5);
+		}
+	}
+
+	int checkPixels()
+	{
+		int fails = 0;
+		for(int Y = 0; Y < 256; Y++)
+		for(int U = 0; U < 256; U++)
+		for(int V = 0; V < 256; V++)
+		{
+			unsigned char out[4];
+			convertYUVPixelToBGRA((unsigned char)Y, (unsigned char)U, (unsigned char)V, YUV_MATRIX_BT601_LIMITED, out);
+			const float y = Y / 255.0f;
+			const float u = U / 255.0f;
+			const float v = V / 255.0f;
+			for(int c = 0; c < 3; c++)
+			{
+				const float* row = SHADER_MATRIX[c];
+				if(out[2 - c] != shaderUnorm(row[0] * y + row[1] * u + row[2] * v + row[3]))
+					fails++;
+			}
+			if(out[3] != 0xff)
+				fails++;
+			for(int m = YUV_MATRIX_BT601_LIMITED; m <= YUV_MATRIX_BT709_FULL; m++)
+			{
+				int ref[3];
+				referenceBGRA((YUV_COLOR_MATRIX)m, Y, U, V, ref);
+				convertYUVPixelToBGRA((unsigned char)Y, (unsigned char)U, (unsigned char)V, (YUV_COLOR_MATRIX)m, out);
+				for(int c = 0; c < 3; c++)
+					if(abs(out[c] - ref[c]) > 1)
+						fails++;
+			}
+		}
+		if(fails)
+			printf("convertYUVPixelToBGRA: %d channels off the reference\n", fails);
+		return fails;
+	}
+
+	/**
+	 *	@brief	a random YUV frame, the Y rows and the chroma rows padded by some bytes
+	 **/
+	struct YUVFrame
+	{
+		PIXFormat pixfmt;
+		int width;
+		int height;
+		std::vector<unsigned char> buffer;
+		const unsigned char* planes[3];
+		int pitches[3];
+
+		YUVFrame(PIXFormat fmt, int w, int h, int padding)
+			: pixfmt(fmt), width(w), height(h)
+		{
+			const int chromaWidth = (w + 1) / 2;
+			const int chromaRows = (h + 1) / 2;
+			int sizes[3] = { 0, 0, 0 };
+			pitches[0] = pitches[1] = pitches[2] = 0;
+			if(fmt == PIXFMT_YUY2)
+			{
+				pitches[0] = chromaWidth * 4 + padding;
+				sizes[0] = pitches[0] * h;
+			}
+			else
+			{
+				pitches[0] = w + padding;
+				sizes[0] = pitches[0] * h;
+				pitches[1] = (fmt == PIXFMT_NV12 ? chromaWidth * 2 : chromaWidth) + padding;
+				sizes[1] = pitches[1] * chromaRows;
+				if(fmt != PIXFMT_NV12)
+				{
+					pitches[2] = chromaWidth + padding;
+					sizes[2] = pitches[2] * chromaRows;
+				}
+			}
+			buffer.resize(sizes[0] + sizes[1] + sizes[2]);
+			for(size_t i = 0; i < buffer.size(); i++)
+				buffer[i] = (unsigned char)rand();
+			planes[0] = &buffer[0];
+			planes[1] = sizes[1] ? planes[0] + sizes[0] : NULL;
+			planes[2] = sizes[2] ? planes[1] + sizes[1] : NULL;
+		}
+
+		//the Y, U, V samples of the pixel, the chroma of a 2x2 (4:2:0) or 2x1 (YUY2) block is shared
+		void sample(int x, int y, int& Y, int& U, int& V) const
+		{
+			if(pixfmt == PIXFMT_YUY2)
+			{
+				const unsigned char* pair = planes[0] + y * pitches[0] + (x / 2) * 4;
+				Y = pair[(x & 1) * 2];
+				U = pair[1];
+				V = pair[3];
+				return;
+			}
+			Y = planes[0][y * pitches[0] + x];
+			const int cx = x / 2;
+			const int cy = y / 2;
+			if(pixfmt == PIXFMT_NV12)
+			{
+				U = planes[1][cy * pitches[1] + cx * 2];
+				V = planes[1][cy * pitches[1] + cx * 2 + 1];
+				return;
+			}
+			//YV12 stores V before U
+			const unsigned char* u = pixfmt == PIXFMT_YV12 ? planes[2] : planes[1];
+			const unsigned char* v = pixfmt == PIXFMT_YV12 ? planes[1] : planes[2];
+			U = u[cy * pitches[1] + cx];
+			V = v[cy * pitches[2] + cx];
+		}
+	};
+
+	const PIXFormat FORMATS[] = { PIXFMT_YUV420P, PIXFMT_YV12, PIXFMT_NV12, PIXFMT_YUY2 };
+	const char* FORMAT_NAMES[] = { "I420", "YV12", "NV12", "YUY2" };
+	const int FORMAT_COUNT = sizeof(FORMATS) / sizeof(FORMATS[0]);
+
+	int checkFrames()
+	{
+		const int sizes[][2] = { { 1, 1 }, { 7, 3 }, { 8, 2 }, { 9, 5 }, { 33, 4 }, { 640, 3 } };
+		int fails = 0;
+		for(int f = 0; f < FORMAT_COUNT; f++)
+		for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			const YUVFrame frame(FORMATS[f], sizes[s][0], sizes[s][1], 11);
+			const int dstPitch = frame.width * 4 + 20;
+			for(int m = YUV_MATRIX_BT601_LIMITED; m <= YUV_MATRIX_BT709_FULL; m++)
+			for(int l = 0; l < LEVEL_COUNT; l++)
+			{
+				std::vector<unsigned char> dst((size_t)dstPitch * frame.height, 0xcd);
+				setCpuFeaturesMask(LEVELS[l]);
+				if(0 != convertYUVToBGRA(frame.pixfmt, frame.planes, frame.pitches, &dst[0], dstPitch,
+										frame.width, frame.height, (YUV_COLOR_MATRIX)m))
+				{
+					printf("%s %dx%d: convertYUVToBGRA failed\n", FORMAT_NAMES[f], frame.width, frame.height);
+					fails++;
+					continue;
+				}
+				int wrong = 0;
+				for(int y = 0; y < frame.height; y++)
+				for(int x = 0; x < frame.width; x++)
+				{
+					int Y, U, V;
+					frame.sample(x, y, Y, U, V);
+					unsigned char ref[4];
+					convertYUVPixelToBGRA((unsigned char)Y, (unsigned char)U, (unsigned char)V, (YUV_COLOR_MATRIX)m, ref);
+					if(0 != memcmp(ref, &dst[(size_t)y * dstPitch + x * 4], 4))
+						wrong++;
+				}
+				//the padding of the rows is not written
+				for(int y = 0; y < frame.height; y++)
+					for(int b = frame.width * 4; b < dstPitch; b++)
+						if(dst[(size_t)y * dstPitch + b] != 0xcd)
+							wrong++;
+				if(wrong)
+				{
+					printf("%s %dx%d matrix %d %s: %d pixels differ\n", FORMAT_NAMES[f], frame.width, frame.height, m, LEVEL_NAMES[l], wrong);
+					fails++;
+				}
+			}
+		}
+		setCpuFeaturesMask(0xffffffff);
+		return fails;
+	}
+
+	void benchmark(int width, int height, int loops)
+	{
+		printf("%-8s", "Mpixel/s");
+		for(int l = 0; l < LEVEL_COUNT; l++)
+			printf("%9s", LEVEL_NAMES[l]);
+		printf("\n");
+		std::vector<unsigned char> dst((size_t)width * 4 * height);
+		for(int f = 0; f < FORMAT_COUNT; f++)
+		{
+			const YUVFrame frame(FORMATS[f], width, height, 0);
+			printf("%-8s", FORMAT_NAMES[f]);
+			for(int l = 0; l < LEVEL_COUNT; l++)
+			{
+				setCpuFeaturesMask(LEVELS[l]);
+				const Clock::time_point start = Clock::now();
+				for(int n = 0; n < loops; n++)
+					convertYUVToBGRA(frame.pixfmt, frame.planes, frame.pitches, &dst[0], width * 4, width, height);
+				const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+				printf("%9.1f", (double)width * height * loops / seconds / 1e6);
+			}
+			printf("\n");
+		}
+		setCpuFeaturesMask(0xffffffff);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = argc > 1 && 0 == strcmp(argv[1], "--quick");
+	printf("cpu features 0x%x\n", getCpuFeatures());
+	const int fails = checkPixels() + checkFrames();
+	if(quick)
+		benchmark(64, 36, 1);
+	else
+		benchmark(3840, 2160, 10);
+	printf("%s\n", fails ? "FAILED" : "OK");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+/**
+ *	@name		Windows.h
+ *	@brief		the part of the Win32 API used by the thread safe containers of DxRender and BigScreenDisplayEngine,
+ *				over the C++11 threads and the GCC atomic builtins, so their tests build outside of Windows.
+ *				Test only, on Windows the real header is used.
+ */
+
+#pragma once
+#ifndef _ZRENDER_TEST_COMPAT_WINDOWS_H_
+#define _ZRENDER_TEST_COMPAT_WINDOWS_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+typedef int BOOL;
+typedef long LONG;
+typedef unsigned long DWORD;
+typedef unsigned int UINT;
+typedef long long LONGLONG;
+typedef void* PVOID;
+typedef void* LPVOID;
+typedef char TCHAR;
+typedef union _LARGE_INTEGER { LONGLONG QuadPart; } LARGE_INTEGER;
+typedef struct tagRECT { LONG left; LONG top; LONG right; LONG bottom; } RECT;
+
+#define WINAPI
+#define CALLBACK
+#define TRUE 1
+#define FALSE 0
+#define INFINITE 0xFFFFFFFF
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+#define WAIT_FAILED 0xFFFFFFFF
+#ifndef _T
+#define _T(x) x
+#define TEXT(x) x
+#endif
+
+//----------------------------------------------------------------------------------------------
+// interlocked, full barriers as on x86
+//----------------------------------------------------------------------------------------------
+inline LONG InterlockedIncrement(volatile LONG* p) { return __sync_add_and_fetch(p, 1); }
+inline LONG InterlockedDecrement(volatile LONG* p) { return __sync_sub_and_fetch(p, 1); }
+inline LONG InterlockedExchangeAdd(volatile LONG* p, LONG v) { return __sync_fetch_and_add(p, v); }
+inline LONG InterlockedCompareExchange(volatile LONG* p, LONG exchange, LONG comparand) { return __sync_val_compare_and_swap(p, comparand, exchange); }
+//full barriers like the Win32 ones, __sync_lock_test_and_set is only an acquire
+inline LONG InterlockedExchange(volatile LONG* p, LONG v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+inline PVOID InterlockedExchangePointer(PVOID volatile* p, PVOID v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+inline PVOID InterlockedCompareExchangePointer(PVOID volatile* p, PVOID exchange, PVOID comparand) { return __sync_val_compare_and_swap(p, comparand, exchange); }
+inline void MemoryBarrier() { __sync_synchronize(); }
+inline void YieldProcessor() {}
+
+//----------------------------------------------------------------------------------------------
+// critical section, recursive as the Win32 one
+//----------------------------------------------------------------------------------------------
+typedef std::recursive_mutex CRITICAL_SECTION;
+inline void InitializeCriticalSection(CRITICAL_SECTION*) {}
+inline void DeleteCriticalSection(CRITICAL_SECTION*) {}
+inline void EnterCriticalSection(CRITICAL_SECTION* cs) { cs->lock(); }
+inline void LeaveCriticalSection(CRITICAL_SECTION* cs) { cs->unlock(); }
+
+//----------------------------------------------------------------------------------------------
+// events and threads. A thread handle is signaled when the thread has ended
+//----------------------------------------------------------------------------------------------
+struct CompatHandle
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool signaled;
+	bool manualReset;
+	std::thread* thread;
+	CompatHandle() : signaled(false), manualReset(false), thread(NULL) {}
+};
+typedef CompatHandle* HANDLE;
+#define INVALID_HANDLE_VALUE ((HANDLE)(ptrdiff_t)-1)
+
+inline HANDLE CreateEvent(void*, BOOL manualReset, BOOL initialState, const TCHAR*)
+{
+	HANDLE event = new CompatHandle();
+	event->manualReset = manualReset != FALSE;
+	event->signaled = initialState != FALSE;
+	return event;
+}
+inline BOOL SetEvent(HANDLE event)
+{
+	std::lock_guard<std::mutex> lock(event->mutex);
+	event->signaled = true;
+	event->cond.notify_all();
+	return TRUE;
+}
+inline BOOL ResetEvent(HANDLE event)
+{
+	std::lock_guard<std::mutex> lock(event->mutex);
+	event->signaled = false;
+	return TRUE;
+}
+inline DWORD WaitForSingleObject(HANDLE handle, DWORD timeoutMs)
+{
+	if(handle->thread)
+	{
+		handle->thread->join();
+		delete handle->thread;
+		handle->thread = NULL;
+		handle->signaled = true;
+		handle->manualReset = true;
+	}
+	std::unique_lock<std::mutex> lock(handle->mutex);
+	if(timeoutMs == INFINITE)
+		handle->cond.wait(lock, [handle] { return handle->signaled; });
+	else if(!handle->cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [handle] { return handle->signaled; }))
+		return WAIT_TIMEOUT;
+	if(!handle->manualReset)
+		handle->signaled = false;
+	return WAIT_OBJECT_0;
+}
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID);
+inline HANDLE CreateThread(void*, size_t, LPTHREAD_START_ROUTINE start, LPVOID param, DWORD, DWORD*)
+{
+	HANDLE thread = new CompatHandle();
+	thread->thread = new std::thread(start, param);
+	return thread;
+}
+inline BOOL CloseHandle(HANDLE handle)
+{
+	if(handle->thread)
+	{
+		handle->thread->detach();
+		delete handle->thread;
+	}
+	delete handle;
+	return TRUE;
+}
+
+//----------------------------------------------------------------------------------------------
+// thread pool, every callback gets a thread of its own
+//----------------------------------------------------------------------------------------------
+typedef struct _TP_CALLBACK_INSTANCE* PTP_CALLBACK_INSTANCE;
+typedef struct _TP_CALLBACK_ENVIRON* PTP_CALLBACK_ENVIRON;
+typedef void (CALLBACK *PTP_SIMPLE_CALLBACK)(PTP_CALLBACK_INSTANCE, PVOID);
+inline BOOL TrySubmitThreadpoolCallback(PTP_SIMPLE_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON)
+{
+	std::thread(callback, (PTP_CALLBACK_INSTANCE)NULL, context).detach();
+	return TRUE;
+}
+
+//----------------------------------------------------------------------------------------------
+// time
+//----------------------------------------------------------------------------------------------
+inline void Sleep(DWORD ms)
+{
+	if(ms == 0)
+		std::this_thread::yield();
+	else
+		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+inline BOOL SwitchToThread() { std::this_thread::yield(); return TRUE; }
+inline DWORD GetTickCount()
+{
+	return (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* freq) { freq->QuadPart = 1000000000LL; return TRUE; }
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* counter)
+{
+	counter->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	return TRUE;
+}
+
+//----------------------------------------------------------------------------------------------
+// memory. No large pages, VirtualAlloc always fails so the callers take their fallback
+//----------------------------------------------------------------------------------------------
+#define MEM_COMMIT 0x1000
+#define MEM_RESERVE 0x2000
+#define MEM_RELEASE 0x8000
+#define MEM_LARGE_PAGES 0x20000000
+#define PAGE_READWRITE 0x04
+inline void* _aligned_malloc(size_t size, size_t alignment)
+{
+	void* p = NULL;
+	return 0 == posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) ? p : NULL;
+}
+inline void _aligned_free(void* p) { free(p); }
+inline LPVOID VirtualAlloc(LPVOID, size_t, DWORD, DWORD) { return NULL; }
+inline BOOL VirtualFree(LPVOID, size_t, DWORD) { return TRUE; }
+inline size_t GetLargePageMinimum() { return 0; }
+
+#define ERROR_SUCCESS 0
+#define TOKEN_ADJUST_PRIVILEGES 0x0020
+#define TOKEN_QUERY 0x0008
+#define SE_PRIVILEGE_ENABLED 0x00000002
+#define SE_LOCK_MEMORY_NAME "SeLockMemoryPrivilege"
+typedef struct _LUID { DWORD LowPart; LONG HighPart; } LUID;
+typedef struct _LUID_AND_ATTRIBUTES { LUID Luid; DWORD Attributes; } LUID_AND_ATTRIBUTES;
+typedef struct _TOKEN_PRIVILEGES { DWORD PrivilegeCount; LUID_AND_ATTRIBUTES Privileges[1]; } TOKEN_PRIVILEGES;
+inline HANDLE GetCurrentProcess() { return NULL; }
+inline BOOL OpenProcessToken(HANDLE, DWORD, HANDLE*) { return FALSE; }
+inline BOOL LookupPrivilegeValue(const TCHAR*, const TCHAR*, LUID*) { return FALSE; }
+inline BOOL AdjustTokenPrivileges(HANDLE, BOOL, TOKEN_PRIVILEGES*, DWORD, void*, void*) { return FALSE; }
+inline DWORD GetLastError() { return 0; }
+
+inline void SetRectEmpty(RECT* rect) { rect->left = rect->top = rect->right = rect->bottom = 0; }
+
+#endif //_ZRENDER_TEST_COMPAT_WINDOWS_H_